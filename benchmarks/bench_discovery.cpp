@@ -0,0 +1,129 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "bench_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_bench;
+
+// Discovery convergence: time from launching N peer nodes on this host until
+// this node has fetched the NodeInfo of all of them, i.e. until every peer's
+// service resolves. Each peer is a real process with its own multicast
+// sender and receiver.
+
+namespace
+{
+std::string serviceName(const std::string &suffix, const std::string &run,
+                        const std::string &index)
+{
+  return "bench/" + suffix + "/" + run + "/peer" + index;
+}
+
+Empty ping(const Empty &)
+{
+  return Empty{};
+}
+
+int runPeer(const std::vector<std::string> &args)
+{
+  const std::string &suffix = args[0];
+  const std::string &run = args[1];
+  const std::string &index = args[2];
+
+  zlc::init("bench_discovery_peer_" + suffix + "_" + run + "_" + index, "127.0.0.1");
+  Logger::setLevel(LogLevel::WARN);
+  zlc::registerServiceHandler(serviceName(suffix, run, index), ping);
+  waitForParent();
+  zlc::shutdown();
+  return 0;
+}
+
+std::string suffix;
+
+void BM_DiscoveryConvergence(benchmark::State &state)
+{
+  static int run_counter = 0;
+  const int64_t peers = state.range(0);
+  auto &metrics = MetricsRegistry::global().discovery();
+
+  for (auto _ : state)
+  {
+    const std::string run = std::to_string(run_counter++);
+    const uint64_t fetches_before = metrics.node_fetches.value();
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<PeerProcess>> processes;
+    for (int64_t i = 0; i < peers; ++i)
+    {
+      processes.push_back(
+          std::make_unique<PeerProcess>(std::vector<std::string>{suffix, run,
+                                                                 std::to_string(i)}));
+    }
+
+    const bool converged = waitUntil(
+        [&]()
+        {
+          for (int64_t i = 0; i < peers; ++i)
+          {
+            if (ZeroLanComNode::instance().nodeInfoManager().getServiceInfo(
+                    serviceName(suffix, run, std::to_string(i))) == nullptr)
+              return false;
+          }
+          return true;
+        },
+        std::chrono::seconds(60));
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    state.SetIterationTime(elapsed.count());
+    state.counters["node_fetches"] =
+        static_cast<double>(metrics.node_fetches.value() - fetches_before);
+
+    processes.clear(); // peers shut down outside the measured time
+    if (!converged)
+    {
+      state.SkipWithError("Peers not discovered within 60 s");
+      break;
+    }
+  }
+  state.counters["peers"] = static_cast<double>(peers);
+}
+} // namespace
+
+BENCHMARK(BM_DiscoveryConvergence)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(32)
+    ->Iterations(3)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv)
+{
+  if (isPeer(argc, argv))
+  {
+    const auto args = peerArgs(argc, argv);
+    return args.size() < 3 ? 1 : runPeer(args);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  suffix = std::to_string(getpid());
+  zlc::init("bench_discovery_" + suffix, "127.0.0.1");
+  Logger::setLevel(LogLevel::WARN);
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  zlc::shutdown();
+  return 0;
+}
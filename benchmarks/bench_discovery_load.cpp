@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "bench_utils.hpp"
+#include "discovery_simulator.hpp"
+
+using namespace zlc;
+using namespace zlc_bench;
+using namespace zlc_test;
+
+// Discovery under load: hundreds of simulated peers (see DiscoverySimulator)
+// join one real node, then 10% of them leave and 10% new ones join. Reported
+// per run:
+//   convergence_ms   all initial peers fetched (also the iteration time)
+//   churn_join_ms    all replacement peers fetched
+//   eviction_ms      all departed peers removed
+//   false_evictions  live peers removed at any point (must be 0)
+//   cpu_percent      CPU of the node itself, simulator threads excluded,
+//                    averaged over a steady-state window
+//   rss_delta_kb     resident memory growth of the process
+//   fetches          get_node_info requests served
+
+namespace
+{
+constexpr std::chrono::seconds STEADY_STATE{5};
+constexpr std::chrono::seconds PHASE_TIMEOUT{60};
+
+double processCpuSeconds()
+{
+  timespec ts{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+int64_t residentKb()
+{
+  std::ifstream statm("/proc/self/statm");
+  int64_t size = 0;
+  int64_t resident = 0;
+  statm >> size >> resident;
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                   start)
+      .count();
+}
+
+bool allKnown(const DiscoveryObserver &observer, const std::vector<UUID> &ids)
+{
+  return waitUntil([&]() { return observer.knownCount(ids) == ids.size(); },
+                   PHASE_TIMEOUT);
+}
+
+bool noneKnown(const DiscoveryObserver &observer, const std::vector<UUID> &ids)
+{
+  return waitUntil([&]() { return observer.knownCount(ids) == 0; }, PHASE_TIMEOUT);
+}
+
+void BM_DiscoveryLoad(benchmark::State &state)
+{
+  static int run_counter = 0;
+  const auto peers = static_cast<size_t>(state.range(0));
+  const size_t churn = peers / 10;
+
+  for (auto _ : state)
+  {
+    DiscoverySimulatorOptions options;
+    options.port = 7721; // off the default port, so live nodes are not loaded
+    options.group_name = "bench_discovery_load_" + std::to_string(getpid()) + "_" +
+                         std::to_string(run_counter++);
+    DiscoverySimulator simulator(options);
+
+    const int64_t rss_before = residentKb();
+    zlc::init(options.group_name, options.ip, options.group, options.port,
+              options.group_name);
+    Logger::setLevel(LogLevel::WARN);
+    DiscoveryObserver observer(ZeroLanComNode::instance().nodeInfoManager(), simulator);
+
+    // Join
+    auto start = std::chrono::steady_clock::now();
+    const auto initial = simulator.addPeers(peers);
+    bool ok = allKnown(observer, initial);
+    const double convergence_ms = elapsedMs(start);
+    state.SetIterationTime(convergence_ms / 1000.0);
+
+    // Steady state: heartbeats only
+    const double cpu_before = processCpuSeconds() - simulator.cpuSeconds();
+    start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(STEADY_STATE);
+    const double cpu_used = processCpuSeconds() - simulator.cpuSeconds() - cpu_before;
+    const double steady_ms = elapsedMs(start);
+
+    // Churn
+    const std::vector<UUID> leaving(initial.begin(), initial.begin() + churn);
+    for (const auto &id : leaving)
+    {
+      simulator.removePeer(id);
+    }
+    start = std::chrono::steady_clock::now();
+    const auto joining = simulator.addPeers(churn);
+    ok = ok && allKnown(observer, joining);
+    const double churn_join_ms = elapsedMs(start);
+    ok = ok && noneKnown(observer, leaving);
+    const double eviction_ms = elapsedMs(start);
+
+    state.counters["convergence_ms"] = convergence_ms;
+    state.counters["churn_join_ms"] = churn_join_ms;
+    state.counters["eviction_ms"] = eviction_ms;
+    state.counters["false_evictions"] = static_cast<double>(observer.falseEvictions());
+    state.counters["cpu_percent"] = 100.0 * cpu_used * 1000.0 / steady_ms;
+    state.counters["rss_delta_kb"] = static_cast<double>(residentKb() - rss_before);
+    state.counters["fetches"] = static_cast<double>(simulator.fetchesServed());
+
+    zlc::shutdown(); // before the observer, which the node's events point to
+    if (!ok)
+    {
+      state.SkipWithError("Discovery did not converge within 60 s");
+      break;
+    }
+  }
+  state.counters["peers"] = static_cast<double>(peers);
+}
+} // namespace
+
+BENCHMARK(BM_DiscoveryLoad)
+    ->Arg(100)
+    ->Arg(250)
+    ->Arg(500)
+    ->Iterations(1)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
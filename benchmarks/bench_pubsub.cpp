@@ -0,0 +1,250 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "bench_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_bench;
+
+// Publish throughput and pub->sub latency against a peer process on loopback.
+//
+// Throughput: the benchmark publishes on `data`; after every window of
+// messages it publishes a short sync token on the same topic and waits for
+// the peer to answer on `ack`. ZMQ keeps per-connection order, so the ack
+// means everything before it was received, and at most one window of
+// payloads is ever queued.
+//
+// Latency: `ping/<size>` is echoed back on `pong`. Round-trip percentiles are
+// measured here; ping topics are traced, so the peer's metrics hold the exact
+// one-way publish-to-callback latency, which is fetched over get_metrics.
+
+namespace
+{
+constexpr size_t SYNC_TOKEN_MAX = 32; // payloads are at least 64 bytes
+constexpr int64_t THROUGHPUT_WINDOW_BYTES = 64 * 1024 * 1024;
+constexpr std::chrono::seconds REPLY_TIMEOUT{10};
+
+std::string topicName(const std::string &suffix, const std::string &name)
+{
+  return "bench/" + suffix + "/" + name;
+}
+
+std::string peerName(const std::string &suffix)
+{
+  return "bench_pubsub_peer_" + suffix;
+}
+
+/* ================= Peer ================= */
+
+Publisher<std::string> *pong_publisher = nullptr;
+Publisher<std::string> *ack_publisher = nullptr;
+
+void onPing(const std::string &msg)
+{
+  pong_publisher->publish(msg);
+}
+
+void onData(const std::string &msg)
+{
+  if (msg.size() <= SYNC_TOKEN_MAX)
+  {
+    ack_publisher->publish(msg);
+  }
+}
+
+int runPeer(const std::string &suffix)
+{
+  zlc::init(peerName(suffix), "127.0.0.1");
+  Logger::setLevel(LogLevel::WARN);
+
+  {
+    Publisher<std::string> pong(topicName(suffix, "pong"));
+    Publisher<std::string> ack(topicName(suffix, "ack"));
+    pong_publisher = &pong;
+    ack_publisher = &ack;
+
+    zlc::registerSubscriberHandler(topicName(suffix, "data"), onData);
+    for (int64_t size : payloadSizeList())
+    {
+      zlc::registerSubscriberHandler(topicName(suffix, "ping/" + std::to_string(size)),
+                                     onPing);
+    }
+
+    waitForParent();
+  }
+
+  zlc::shutdown();
+  return 0;
+}
+
+/* ================= Benchmarks ================= */
+
+std::string suffix;
+std::unique_ptr<Publisher<std::string>> data_publisher;
+std::map<int64_t, std::unique_ptr<Publisher<std::string>>> ping_publishers;
+ReplyCounter pongs;
+ReplyCounter acks;
+
+void onPong(const std::string &)
+{
+  pongs.notify();
+}
+
+void onAck(const std::string &)
+{
+  acks.notify();
+}
+
+// Publish a sync token until the peer acknowledges it
+bool sync(std::chrono::milliseconds timeout)
+{
+  const uint64_t target = acks.count() + 1;
+  data_publisher->publish("sync");
+  return acks.waitFor(target, timeout);
+}
+
+bool ping(Publisher<std::string> &publisher, const std::string &payload,
+          std::chrono::milliseconds timeout)
+{
+  const uint64_t target = pongs.count() + 1;
+  publisher.publish(payload);
+  return pongs.waitFor(target, timeout);
+}
+
+// Wait until the peer has discovered us and we have discovered it
+bool waitForPeer()
+{
+  auto connected = [&]()
+  {
+    if (!sync(std::chrono::milliseconds(100)))
+      return false;
+    return std::all_of(ping_publishers.begin(), ping_publishers.end(),
+                       [](const auto &entry)
+                       {
+                         return ping(*entry.second, "hello",
+                                     std::chrono::milliseconds(100));
+                       });
+  };
+  return waitUntil(connected, std::chrono::seconds(30));
+}
+
+void BM_PublishThroughput(benchmark::State &state)
+{
+  const int64_t size = state.range(0);
+  const std::string payload(static_cast<size_t>(size), 'x');
+  const int64_t window = std::clamp<int64_t>(THROUGHPUT_WINDOW_BYTES / size, 1, 1024);
+
+  int64_t sent = 0;
+  for (auto _ : state)
+  {
+    data_publisher->publish(payload);
+    if (++sent % window == 0 && !sync(REPLY_TIMEOUT))
+    {
+      state.SkipWithError("Peer stopped acknowledging");
+      break;
+    }
+  }
+  sync(REPLY_TIMEOUT);
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * size);
+  state.counters["window"] = static_cast<double>(window);
+}
+
+void BM_PubSubLatency(benchmark::State &state)
+{
+  const int64_t size = state.range(0);
+  const std::string payload(static_cast<size_t>(size), 'x');
+  Publisher<std::string> &publisher = *ping_publishers.at(size);
+  LatencyHistogram rtt;
+
+  for (auto _ : state)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    if (!ping(publisher, payload, REPLY_TIMEOUT))
+    {
+      state.SkipWithError("Peer stopped answering");
+      break;
+    }
+    rtt.record(std::chrono::steady_clock::now() - start);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * size);
+  reportLatency(state, "rtt", rtt);
+
+  // One-way latency as recorded by the peer (all runs of this size so far)
+  MetricsSnapshot remote;
+  if (zlc::requestMetrics(peerName(suffix), remote) == ResponseStatus::SUCCESS)
+  {
+    const std::string topic = topicName(suffix, "ping/" + std::to_string(size));
+    for (const auto &t : remote.topics)
+    {
+      if (t.name != topic)
+        continue;
+      state.counters["one_way_p50_us"] = static_cast<double>(t.latency.p50_ns) / 1000.0;
+      state.counters["one_way_p99_us"] = static_cast<double>(t.latency.p99_ns) / 1000.0;
+    }
+  }
+}
+} // namespace
+
+BENCHMARK(BM_PublishThroughput)->Apply(payloadSizes)->UseRealTime();
+BENCHMARK(BM_PubSubLatency)->Apply(payloadSizes)->UseRealTime();
+
+int main(int argc, char **argv)
+{
+  if (isPeer(argc, argv))
+  {
+    const auto args = peerArgs(argc, argv);
+    return args.empty() ? 1 : runPeer(args[0]);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  suffix = std::to_string(getpid());
+  PeerProcess peer({suffix});
+
+  zlc::init("bench_pubsub_" + suffix, "127.0.0.1");
+  Logger::setLevel(LogLevel::WARN);
+
+  PublisherOptions traced;
+  traced.trace.enabled = true;
+  traced.trace.clock = TraceClock::MONOTONIC; // both ends are on this host
+
+  data_publisher = std::make_unique<Publisher<std::string>>(topicName(suffix, "data"));
+  for (int64_t size : payloadSizeList())
+  {
+    ping_publishers[size] = std::make_unique<Publisher<std::string>>(
+        topicName(suffix, "ping/" + std::to_string(size)), false, traced);
+  }
+  zlc::registerSubscriberHandler(topicName(suffix, "pong"), onPong);
+  zlc::registerSubscriberHandler(topicName(suffix, "ack"), onAck);
+
+  int rc = 0;
+  if (waitForPeer())
+  {
+    benchmark::RunSpecifiedBenchmarks();
+  }
+  else
+  {
+    zlc::error("[bench_pubsub] Peer did not connect within 30 s");
+    rc = 1;
+  }
+  benchmark::Shutdown();
+
+  data_publisher.reset();
+  ping_publishers.clear();
+  zlc::shutdown();
+  return rc;
+}
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zerolancom/serialization/serializer.hpp"
+
+#include "bench_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_bench;
+
+namespace
+{
+// Typical structured message: a header plus a float array
+struct PointCloud
+{
+  int64_t stamp_ns{0};
+  std::string frame_id;
+  std::vector<float> points;
+  MSGPACK_DEFINE_MAP(stamp_ns, frame_id, points)
+};
+
+template <typename T> T makeMessage(size_t bytes);
+
+template <> std::string makeMessage<std::string>(size_t bytes)
+{
+  return std::string(bytes, 'x');
+}
+
+template <> Bytes makeMessage<Bytes>(size_t bytes)
+{
+  return Bytes(bytes, 0x5a);
+}
+
+template <> std::vector<float> makeMessage<std::vector<float>>(size_t bytes)
+{
+  return std::vector<float>(bytes / sizeof(float), 1.5f);
+}
+
+template <> PointCloud makeMessage<PointCloud>(size_t bytes)
+{
+  return PointCloud{1700000000000000000, "lidar",
+                    makeMessage<std::vector<float>>(bytes)};
+}
+
+template <typename T> void BM_Encode(benchmark::State &state)
+{
+  const T msg = makeMessage<T>(static_cast<size_t>(state.range(0)));
+  ByteBuffer out;
+
+  for (auto _ : state)
+  {
+    encode(msg, out);
+    benchmark::DoNotOptimize(out.data);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+  state.counters["encoded_bytes"] = static_cast<double>(out.size);
+}
+
+template <typename T> void BM_Decode(benchmark::State &state)
+{
+  const T msg = makeMessage<T>(static_cast<size_t>(state.range(0)));
+  ByteBuffer out;
+  encode(msg, out);
+  const ByteView view{out.data, out.size};
+
+  for (auto _ : state)
+  {
+    T decoded;
+    decode(view, decoded);
+    benchmark::DoNotOptimize(decoded);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Encode, std::string)->Apply(payloadSizes);
+BENCHMARK_TEMPLATE(BM_Decode, std::string)->Apply(payloadSizes);
+BENCHMARK_TEMPLATE(BM_Encode, Bytes)->Apply(payloadSizes);
+BENCHMARK_TEMPLATE(BM_Decode, Bytes)->Apply(payloadSizes);
+BENCHMARK_TEMPLATE(BM_Encode, std::vector<float>)->Apply(payloadSizes);
+BENCHMARK_TEMPLATE(BM_Decode, std::vector<float>)->Apply(payloadSizes);
+BENCHMARK_TEMPLATE(BM_Encode, PointCloud)->Apply(payloadSizes);
+BENCHMARK_TEMPLATE(BM_Decode, PointCloud)->Apply(payloadSizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,124 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <string>
+#include <unistd.h>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "bench_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_bench;
+
+// RPC round-trip latency and throughput against an echo service in a peer
+// process on loopback. Concurrent clients are benchmark threads; the
+// items_per_second counter of those runs is the QPS.
+
+namespace
+{
+std::string serviceName(const std::string &suffix)
+{
+  return "bench/" + suffix + "/echo";
+}
+
+std::string echo(const std::string &request)
+{
+  return request;
+}
+
+int runPeer(const std::string &suffix)
+{
+  zlc::init("bench_service_peer_" + suffix, "127.0.0.1");
+  Logger::setLevel(LogLevel::WARN);
+  zlc::registerServiceHandler(serviceName(suffix), echo);
+  waitForParent();
+  zlc::shutdown();
+  return 0;
+}
+
+std::string service_name;
+std::string service_url;
+
+void runRequests(benchmark::State &state, int64_t size)
+{
+  const std::string request(static_cast<size_t>(size), 'x');
+  std::string response;
+  LatencyHistogram latency;
+
+  for (auto _ : state)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    ResponseStatus status =
+        Client::zlcRequest(service_name, service_url, request, response);
+    latency.record(std::chrono::steady_clock::now() - start);
+    if (status != ResponseStatus::SUCCESS)
+    {
+      state.SkipWithError("Echo request failed");
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * size * 2);
+  reportLatency(state, "rtt", latency);
+}
+
+void BM_ServiceRoundTrip(benchmark::State &state)
+{
+  runRequests(state, state.range(0));
+}
+
+void BM_ServiceConcurrentClients(benchmark::State &state)
+{
+  runRequests(state, 64);
+}
+} // namespace
+
+BENCHMARK(BM_ServiceRoundTrip)->Apply(payloadSizes)->UseRealTime();
+BENCHMARK(BM_ServiceConcurrentClients)->ThreadRange(1, 16)->UseRealTime();
+
+int main(int argc, char **argv)
+{
+  if (isPeer(argc, argv))
+  {
+    const auto args = peerArgs(argc, argv);
+    return args.empty() ? 1 : runPeer(args[0]);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  const std::string suffix = std::to_string(getpid());
+  PeerProcess peer({suffix});
+
+  zlc::init("bench_service_" + suffix, "127.0.0.1");
+  Logger::setLevel(LogLevel::WARN);
+  service_name = serviceName(suffix);
+
+  // Resolve once; the benchmark measures requests, not discovery
+  const bool found = waitUntil(
+      [&]()
+      {
+        service_url =
+            ZeroLanComNode::instance().nodeInfoManager().getServiceURL(service_name);
+        return !service_url.empty();
+      },
+      std::chrono::seconds(30));
+
+  int rc = 0;
+  if (found)
+  {
+    benchmark::RunSpecifiedBenchmarks();
+  }
+  else
+  {
+    zlc::error("[bench_service] Service '{}' not discovered within 30 s", service_name);
+    rc = 1;
+  }
+  benchmark::Shutdown();
+
+  zlc::shutdown();
+  return rc;
+}
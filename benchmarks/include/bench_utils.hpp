@@ -0,0 +1,215 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <mutex>
+#include <signal.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "zerolancom/utils/metrics.hpp"
+
+namespace zlc_bench
+{
+
+// Command-line flag that turns a benchmark binary into one of its peers
+inline constexpr const char *PEER_FLAG = "--zlc-peer";
+
+/**
+ * @brief A peer node running as a separate process.
+ *
+ * Every remote end of a benchmark runs in its own process, so the numbers
+ * include a real process boundary: a re-executed copy of the benchmark binary
+ * (`<exe> --zlc-peer <args>`). The peer's stdin is a pipe from the parent: it
+ * should shut down once stdin reaches EOF (see waitForParent), which also
+ * happens if the parent dies.
+ */
+class PeerProcess
+{
+public:
+  explicit PeerProcess(const std::vector<std::string> &args)
+  {
+    // Build argv before forking: the child of a multithreaded process may
+    // only make async-signal-safe calls until exec
+    std::vector<std::string> argv_storage{"/proc/self/exe", PEER_FLAG};
+    argv_storage.insert(argv_storage.end(), args.begin(), args.end());
+    std::vector<char *> argv;
+    for (auto &arg : argv_storage)
+    {
+      argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    // Close-on-exec, so later peers do not hold this peer's pipe open
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0)
+    {
+      return;
+    }
+
+    pid_ = fork();
+    if (pid_ == 0)
+    {
+      dup2(fds[0], STDIN_FILENO);
+      close(fds[0]);
+      close(fds[1]);
+      execv("/proc/self/exe", argv.data());
+      _exit(127);
+    }
+
+    close(fds[0]);
+    stdin_fd_ = fds[1];
+  }
+
+  ~PeerProcess()
+  {
+    if (stdin_fd_ >= 0)
+    {
+      close(stdin_fd_);
+    }
+    if (pid_ <= 0)
+    {
+      return;
+    }
+
+    // Give the peer a moment to shut down cleanly before killing it
+    for (int i = 0; i < 50; ++i)
+    {
+      if (waitpid(pid_, nullptr, WNOHANG) == pid_)
+      {
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    kill(pid_, SIGKILL);
+    waitpid(pid_, nullptr, 0);
+  }
+
+  PeerProcess(const PeerProcess &) = delete;
+  PeerProcess &operator=(const PeerProcess &) = delete;
+
+  bool started() const
+  {
+    return pid_ > 0;
+  }
+
+private:
+  pid_t pid_{-1};
+  int stdin_fd_{-1};
+};
+
+// Block a peer until its parent closes our stdin
+inline void waitForParent()
+{
+  char byte;
+  while (read(STDIN_FILENO, &byte, 1) > 0)
+  {
+  }
+}
+
+// Whether this process was started as a PeerProcess
+inline bool isPeer(int argc, char **argv)
+{
+  return argc > 1 && std::strcmp(argv[1], PEER_FLAG) == 0;
+}
+
+// Arguments a PeerProcess was started with
+inline std::vector<std::string> peerArgs(int argc, char **argv)
+{
+  return isPeer(argc, argv) ? std::vector<std::string>(argv + 2, argv + argc)
+                            : std::vector<std::string>{};
+}
+
+// Poll `ready` every millisecond until it returns true or `timeout` expires
+inline bool waitUntil(const std::function<bool()> &ready,
+                      std::chrono::milliseconds timeout)
+{
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!ready())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+/**
+ * @brief Counts replies delivered by a subscriber callback and lets the
+ * benchmark thread wait for the next one.
+ */
+class ReplyCounter
+{
+public:
+  void notify()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++count_;
+    cv_.notify_all();
+  }
+
+  uint64_t count() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+  }
+
+  // Wait until at least `target` replies have arrived
+  bool waitFor(uint64_t target, std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [&] { return count_ >= target; });
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  uint64_t count_{0};
+};
+
+/**
+ * @brief Add p50/p90/p99/p999 and max counters, in microseconds, to a run.
+ *
+ * Counters are averaged over benchmark threads.
+ */
+inline void reportLatency(benchmark::State &state, const std::string &prefix,
+                          const zlc::LatencyHistogram &hist)
+{
+  const zlc::LatencySummary s = hist.summary();
+  const auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+  const auto avg = benchmark::Counter::kAvgThreads;
+
+  state.counters[prefix + "_p50_us"] = benchmark::Counter(us(s.p50_ns), avg);
+  state.counters[prefix + "_p90_us"] = benchmark::Counter(us(s.p90_ns), avg);
+  state.counters[prefix + "_p99_us"] = benchmark::Counter(us(s.p99_ns), avg);
+  state.counters[prefix + "_p999_us"] = benchmark::Counter(us(s.p999_ns), avg);
+  state.counters[prefix + "_max_us"] = benchmark::Counter(us(s.max_ns), avg);
+}
+
+// Payload sizes benchmarked by default, 64 B to 16 MB
+inline const std::vector<int64_t> &payloadSizeList()
+{
+  static const std::vector<int64_t> sizes{
+      64, 1024, 16 * 1024, 256 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024};
+  return sizes;
+}
+
+inline void payloadSizes(benchmark::internal::Benchmark *bench)
+{
+  for (int64_t size : payloadSizeList())
+  {
+    bench->Arg(size);
+  }
+}
+
+} // namespace zlc_bench
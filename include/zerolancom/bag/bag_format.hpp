@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace zlc
+{
+
+/*
+ * Recording ("bag") file layout, little-endian, written by BagWriter:
+ *
+ *   [BagFileHeader, padded to BAG_FILE_HEADER_SIZE]
+ *   [chunk][chunk]...
+ *   [summary][BagFooter]
+ *
+ * A chunk is a BagChunkHeader followed by `data_size` bytes of records. Each
+ * chunk starts on a page boundary and is `chunk_size` bytes long on disk; the
+ * space after the records is pre-allocated and zero until the chunk is
+ * closed, after which the file is truncated behind the last record.
+ *
+ * A record is a BagRecordHeader followed by `size` bytes, padded to 8 bytes:
+ * - TOPIC records bind a topic ID to its name. Every chunk repeats the binding
+ *   before the first message of a topic, so chunks can be read on their own.
+ * - MESSAGE records carry the encoded payload exactly as it was received.
+ * - INDEX records close a chunk: one BagIndexEntry per message, so a reader
+ *   can pick messages by time and topic without touching the others.
+ *
+ * The summary is written on close (version 2): a BagSummaryHeader, then
+ * `chunk_count` BagSummaryChunk, `chunk_topic_count` BagSummaryChunkTopic (the
+ * topics of each chunk) and `topic_count` BagSummaryTopic, each followed by
+ * its name padded to 8 bytes. The BagFooter in the last 16 bytes points at it.
+ *
+ * A writer that dies mid-chunk leaves a readable file without a summary:
+ * `data_size` is updated after every record, and readers fall back to walking
+ * the chunks.
+ */
+
+constexpr char BAG_MAGIC[8] = {'Z', 'L', 'C', 'B', 'A', 'G', '\0', '\0'};
+constexpr uint32_t BAG_VERSION = 2; // 1: no INDEX records, no summary
+constexpr uint64_t BAG_FILE_HEADER_SIZE = 4096; // one page, keeps chunks aligned
+constexpr uint32_t BAG_CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+constexpr uint64_t BAG_FOOTER_MAGIC = 0x52544f4f46434c5a; // "ZLCFOOTR"
+
+struct BagFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t created_ns; // wall clock
+};
+
+struct BagChunkHeader
+{
+  uint32_t magic;
+  uint32_t reserved;
+  uint64_t chunk_size; // bytes on disk, header included; the next chunk follows
+  uint64_t data_size;  // bytes of records after the header
+  uint64_t start_ns;   // first and last message timestamp
+  uint64_t end_ns;
+  uint64_t message_count;
+};
+
+enum class BagOp : uint8_t
+{
+  TOPIC = 1,
+  MESSAGE = 2,
+  INDEX = 3
+};
+
+struct BagRecordHeader
+{
+  uint8_t op;
+  uint8_t reserved;
+  uint16_t topic_id;
+  uint32_t size;         // bytes after this header, before padding
+  uint64_t timestamp_ns; // receive time, wall clock; 0 for TOPIC records
+};
+
+struct BagIndexEntry
+{
+  uint64_t timestamp_ns;
+  uint64_t offset; // of the MESSAGE record, from the first record of the chunk
+  uint16_t topic_id;
+  uint16_t reserved;
+  uint32_t size;
+};
+
+struct BagSummaryHeader
+{
+  uint64_t chunk_count;
+  uint64_t chunk_topic_count;
+  uint32_t topic_count;
+  uint32_t reserved;
+  uint64_t message_count;
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+struct BagSummaryChunk
+{
+  uint64_t offset;       // of the BagChunkHeader
+  uint64_t index_offset; // of the first BagIndexEntry
+  uint64_t index_count;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  uint64_t message_count;
+};
+
+struct BagSummaryChunkTopic
+{
+  uint64_t chunk; // position in the BagSummaryChunk table
+  uint16_t topic_id;
+  uint16_t reserved;
+  uint32_t message_count;
+};
+
+struct BagSummaryTopic
+{
+  uint16_t topic_id;
+  uint16_t reserved;
+  uint32_t name_size;
+  uint64_t message_count;
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+struct BagFooter
+{
+  uint64_t summary_offset;
+  uint64_t magic;
+};
+
+// `size` rounded up to the 8-byte record alignment
+constexpr uint64_t bagPadded(uint64_t size)
+{
+  return (size + 7) & ~uint64_t{7};
+}
+
+// Bytes a record of `size` payload bytes occupies, header and padding included
+constexpr uint64_t bagRecordSize(uint64_t size)
+{
+  return sizeof(BagRecordHeader) + bagPadded(size);
+}
+
+} // namespace zlc
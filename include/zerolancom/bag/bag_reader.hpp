@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zerolancom/bag/bag_format.hpp"
+#include "zerolancom/serialization/binary_codec.hpp"
+
+namespace zlc
+{
+
+struct BagMessage
+{
+  uint16_t topic_id{0};
+  const std::string *topic{nullptr};
+  uint64_t timestamp_ns{0};
+  ByteView data; // points into the mapped file, valid while the reader lives
+};
+
+struct BagTopicInfo
+{
+  std::string name; // empty for IDs without messages
+  uint64_t message_count{0};
+  uint64_t start_ns{0};
+  uint64_t end_ns{0};
+};
+
+/**
+ * @brief Messages to visit: a set of topics and a time window.
+ */
+struct BagQuery
+{
+  std::vector<std::string> topics; // empty = all topics
+  uint64_t start_ns{0};            // inclusive
+  uint64_t end_ns{std::numeric_limits<uint64_t>::max()}; // inclusive
+};
+
+/**
+ * @brief Read-only view of a recording written by BagWriter.
+ *
+ * Design notes:
+ * - The whole file is mapped once; messages are handed out as views into the
+ *   mapping, so reading copies nothing.
+ * - open() reads the summary at the end of the file and nothing else. Queries
+ *   skip chunks by their time range and topic list, then pick messages from
+ *   the chunk's index, so only the selected payloads are paged in.
+ * - Files without a summary (version 1, or a crashed recorder) are walked
+ *   once on open and read up to their last complete record.
+ */
+class BagReader
+{
+public:
+  using Callback = std::function<bool(const BagMessage &)>;
+
+  // nullptr if the file cannot be opened or is not a recording
+  static std::unique_ptr<BagReader> open(const std::string &path);
+
+  ~BagReader();
+
+  BagReader(const BagReader &) = delete;
+  BagReader &operator=(const BagReader &) = delete;
+
+  // Topics by ID
+  const std::vector<BagTopicInfo> &topics() const
+  {
+    return topics_;
+  }
+
+  uint64_t messageCount() const
+  {
+    return message_count_;
+  }
+
+  // Timestamps of the first and last message, 0 for an empty recording
+  uint64_t startNs() const
+  {
+    return start_ns_;
+  }
+
+  uint64_t endNs() const
+  {
+    return end_ns_;
+  }
+
+  size_t chunkCount() const
+  {
+    return chunks_.size();
+  }
+
+  // True if the file had a summary, false if it was walked on open
+  bool indexed() const
+  {
+    return indexed_;
+  }
+
+  // Visit messages in file order; return false from the callback to stop
+  void forEach(const Callback &callback) const;
+  void forEach(const BagQuery &query, const Callback &callback) const;
+
+  /**
+   * @brief Visit matching messages on `threads` threads (0 = one per core).
+   *
+   * Each chunk is handled by one thread in file order, but chunks run
+   * concurrently, so the callback must be thread-safe. Returning false stops
+   * all threads; an exception from the callback is rethrown here.
+   */
+  void forEachParallel(const BagQuery &query, const Callback &callback,
+                       unsigned threads = 0) const;
+
+private:
+  struct Chunk
+  {
+    const uint8_t *data{nullptr}; // first record
+    uint64_t data_size{0};
+    uint64_t start_ns{0};
+    uint64_t end_ns{0};
+    uint64_t message_count{0};
+    const BagIndexEntry *index{nullptr};
+    uint64_t index_count{0};
+    std::vector<uint16_t> topics; // IDs with messages in this chunk
+  };
+
+  struct Filter
+  {
+    bool all_topics{true};
+    std::vector<bool> topics; // by ID, unless all_topics
+    uint64_t start_ns{0};
+    uint64_t end_ns{0};
+
+    bool matches(uint16_t topic_id, uint64_t timestamp_ns) const;
+    bool matches(const Chunk &chunk) const;
+  };
+
+  BagReader(const uint8_t *map, size_t size);
+
+  // Load the summary; false if there is none or it is damaged
+  bool readSummary();
+  // Walk the chunks, collecting topics, bounds and any INDEX records
+  void scan();
+
+  Filter makeFilter(const BagQuery &query) const;
+  // False if the callback asked to stop or `stop` was set
+  bool visit(const Chunk &chunk, const Filter &filter, const Callback &callback,
+             const std::atomic<bool> *stop) const;
+  BagMessage message(const Chunk &chunk, uint64_t offset) const;
+
+  const uint8_t *map_;
+  size_t size_;
+
+  std::vector<Chunk> chunks_;
+  std::vector<BagTopicInfo> topics_;
+  uint64_t message_count_{0};
+  uint64_t start_ns_{0};
+  uint64_t end_ns_{0};
+  bool indexed_{false};
+};
+
+} // namespace zlc
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "zerolancom/bag/bag_format.hpp"
+#include "zerolancom/serialization/binary_codec.hpp"
+#include "zerolancom/utils/mpmc_queue.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
+#include "zerolancom/utils/zmq_utils.hpp"
+
+namespace zlc
+{
+
+struct BagWriterOptions
+{
+  // Bytes pre-allocated and mapped at a time; larger messages get a chunk of
+  // their own
+  uint64_t chunk_size{64ull << 20};
+
+  // Messages waiting for the writer thread, bounded by count and by bytes;
+  // write() drops a message when either limit is reached
+  size_t queue_messages{65536};
+  size_t queue_bytes{1ull << 30};
+
+  // Placement of the writer thread ("zlc-bag-write")
+  ThreadOptions thread;
+};
+
+struct BagWriterStats
+{
+  uint64_t messages{0};
+  uint64_t bytes{0};   // payload bytes written
+  uint64_t dropped{0}; // queue full or disk full
+  uint64_t chunks{0};
+};
+
+/**
+ * @brief Append-only recorder of raw topic payloads (see bag_format.hpp).
+ *
+ * Design notes:
+ * - write() queues the payload on a lock-free queue and returns; a single
+ *   writer thread drains it, so callers (subscriber threads) never touch the
+ *   disk. A received zmq::message_t is queued as is, without a copy.
+ * - The writer thread sleeps on a condition variable while the queue is
+ *   empty; write() only takes the lock to wake it.
+ * - close() waits for write() calls in progress before the last drain, so a
+ *   message is either recorded or counted as dropped.
+ * - The writer pre-allocates each chunk with posix_fallocate, maps it and
+ *   copies records into the mapping. A full disk is detected when a chunk is
+ *   allocated, not by SIGBUS on a store.
+ * - Closed chunks are handed to kernel writeback right away, which keeps the
+ *   amount of dirty page cache flat at sustained rates.
+ * - Each chunk ends with an index of its messages; close() appends the
+ *   summary that lets BagReader seek without scanning the file.
+ */
+class BagWriter
+{
+public:
+  // nullptr if the file cannot be created
+  static std::unique_ptr<BagWriter> create(const std::string &path,
+                                           const BagWriterOptions &options = {});
+
+  ~BagWriter();
+
+  BagWriter(const BagWriter &) = delete;
+  BagWriter &operator=(const BagWriter &) = delete;
+
+  // ID of a topic for write(); the same name always gets the same ID
+  uint16_t addTopic(const std::string &name);
+
+  /**
+   * @brief Queue one message; thread-safe and non-blocking.
+   *
+   * @return false if the message was dropped because the queue is full
+   */
+  bool write(uint16_t topic_id, uint64_t timestamp_ns, const ByteView &payload);
+  // Same, taking over a received frame instead of copying it
+  bool write(uint16_t topic_id, uint64_t timestamp_ns, zmq::message_t &&payload);
+
+  // Write everything still queued, finish the last chunk, append the summary
+  // and close the file
+  void close();
+
+  BagWriterStats stats() const;
+
+private:
+  struct Entry
+  {
+    uint16_t topic_id{0};
+    uint64_t timestamp_ns{0};
+    zmq::message_t payload;
+  };
+
+  BagWriter(int fd, const std::string &path, const BagWriterOptions &options);
+
+  void run();
+  // Wake the writer thread if it is waiting for messages
+  void wake();
+  void append(const Entry &entry);
+  // append() an entry taken off the queue and release its payload
+  void appendQueued(Entry &entry);
+  void appendRecord(BagOp op, uint16_t topic_id, uint64_t timestamp_ns,
+                    const uint8_t *data, size_t size);
+
+  // Map a new chunk with room for at least `min_data` bytes of records
+  bool beginChunk(uint64_t min_data);
+  // Write the chunk's index and unmap it; `last` trims it to its records
+  void endChunk(bool last);
+  void writeSummary();
+
+  BagWriterOptions options_;
+  std::string path_;
+  int fd_;
+
+  // Topic names by ID; appended under topics_mutex_, read by the writer thread
+  std::mutex topics_mutex_;
+  std::unordered_map<std::string, uint16_t> topic_ids_;
+  std::vector<std::string> topic_names_;
+
+  MpmcQueue<Entry> queue_;
+  std::atomic<size_t> queued_bytes_{0};
+
+  // Writer thread state
+  uint64_t file_end_{BAG_FILE_HEADER_SIZE};
+  uint8_t *chunk_{nullptr}; // mapping of the current chunk
+  uint64_t chunk_offset_{0};
+  uint64_t chunk_capacity_{0};
+  std::vector<uint32_t> chunk_topics_; // messages per topic in the current chunk
+  std::vector<BagIndexEntry> chunk_index_;
+  bool disk_full_{false};
+
+  // Summary of the closed chunks and of all topics (by ID)
+  std::vector<BagSummaryChunk> summary_chunks_;
+  std::vector<BagSummaryChunkTopic> summary_chunk_topics_;
+  std::vector<BagSummaryTopic> summary_topics_;
+
+  std::atomic<uint64_t> messages_{0};
+  std::atomic<uint64_t> bytes_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> chunks_{0};
+
+  std::atomic<bool> running_{true};
+  std::atomic<int> writers_{0}; // write() calls in progress
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  std::atomic<bool> idle_{false}; // writer thread waits on wake_cv_
+  std::thread thread_;
+};
+
+} // namespace zlc
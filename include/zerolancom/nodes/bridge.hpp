@@ -0,0 +1,123 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zerolancom/nodes/zerolancom_node.hpp"
+#include "zerolancom/serialization/compression.hpp"
+#include "zerolancom/sockets/publisher.hpp"
+#include "zerolancom/utils/zmq_utils.hpp"
+
+namespace zlc
+{
+
+/**
+ * @brief One network of a bridge: the local IP on it and its discovery group.
+ */
+struct BridgeSide
+{
+  std::string ip{"127.0.0.1"};
+  NodeOptions node;
+};
+
+struct BridgeOptions
+{
+  // The bridge runs one node per side, named "<name>_a" and "<name>_b"
+  std::string name{"zlc_bridge"};
+  BridgeSide a;
+  BridgeSide b;
+
+  // Publishers of relayed topics (compression, HWM, ...) on the far side
+  PublisherOptions publisher;
+
+  // Subscriptions to relayed topics on the near side (HWM, buffers, ...)
+  SocketOptions subscriber;
+
+  // Compression of relayed service responses on the far side
+  CompressionConfig service_compression;
+
+  // How long a relayed request waits for the service; -1 waits forever
+  int service_timeout_ms{5000};
+
+  // Relayed requests run on worker threads: this many at once per service,
+  // with this many more queued before the far side answers OVERLOADED
+  ServiceLimits service_limits{8, 64};
+};
+
+enum class BridgeDirection
+{
+  A_TO_B,
+  B_TO_A
+};
+
+/**
+ * @brief Relays topics and services between two discovery domains, e.g. two
+ * subnets or multicast groups.
+ *
+ * Design notes:
+ * - Each side is a full node. A relayed topic is subscribed once on the near
+ *   side and republished once on the far side, so remote subscribers share one
+ *   stream across the link instead of each connecting through it.
+ * - Messages are forwarded as encoded bytes, never decoded. Compressed input
+ *   is decompressed on receipt; `publisher.compression` recompresses for the
+ *   far side.
+ * - A relayed service is advertised on the far side and forwards each request
+ *   to a provider on the near side, passing its status back. Providers are
+ *   chosen by the near node's LoadBalancer, and requests run on the far
+ *   node's service workers (`service_limits`), not on its polling thread.
+ * - A topic or service is relayed in one direction only; relaying it both
+ *   ways would loop.
+ */
+class Bridge
+{
+public:
+  explicit Bridge(const BridgeOptions &options);
+  ~Bridge();
+
+  Bridge(const Bridge &) = delete;
+  Bridge &operator=(const Bridge &) = delete;
+
+  // Republish a topic of the source side on the other side; false if it is
+  // already relayed the other way
+  bool relayTopic(const std::string &topic, BridgeDirection direction);
+
+  // Offer a service of the source side on the other side; false if it is
+  // already relayed the other way or the far node rejects `service_limits`
+  bool relayService(const std::string &service, BridgeDirection direction);
+
+  ZeroLanComNode &nodeA()
+  {
+    return *a_;
+  }
+
+  ZeroLanComNode &nodeB()
+  {
+    return *b_;
+  }
+
+private:
+  // Source and destination node of a direction
+  ZeroLanComNode &from(BridgeDirection direction);
+  ZeroLanComNode &to(BridgeDirection direction);
+
+  // False if `name` is already relayed in the opposite direction
+  bool claim(std::unordered_map<std::string, BridgeDirection> &relayed,
+             const std::string &name, BridgeDirection direction, bool &added);
+
+  BridgeOptions options_;
+  std::unique_ptr<ZeroLanComNode> a_;
+  std::unique_ptr<ZeroLanComNode> b_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, BridgeDirection> topics_;
+  std::unordered_map<std::string, BridgeDirection> services_;
+
+  // Publishers on the far side; subscriber callbacks hold raw pointers, so they
+  // are destroyed only after both nodes are stopped
+  std::vector<std::unique_ptr<Publisher<Bytes>>> publishers_;
+};
+
+} // namespace zlc
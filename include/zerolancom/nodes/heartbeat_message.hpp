@@ -18,7 +18,8 @@ constexpr int32_t ZLC_VERSION_PATCH = 2;
 /**
  * @brief Lightweight heartbeat message for node discovery.
  *
- * This message is sent periodically via multicast to announce node presence.
+ * This message is sent periodically via multicast (or unicast, see
+ * UnicastDiscovery) to announce node presence.
  * When a receiver detects a new node or info_id change, it fetches full
  * NodeInfo via the service port.
  *
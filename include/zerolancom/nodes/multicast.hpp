@@ -10,18 +10,26 @@
 
 #include "zerolancom/nodes/heartbeat_message.hpp"
 #include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/utils/network.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
 
 namespace zlc
 {
 
-class MulticastSender : public Singleton<MulticastSender>
+// Sends heartbeats out of every interface in `interfaces`
+class MulticastSender
 {
 public:
-  MulticastSender(const std::string &group, int port, const std::string &localIP,
-                  const std::string &groupName);
+  // `ttl` > 1 lets heartbeats cross multicast routers
+  MulticastSender(NodeInfoManager &nodeInfoManager, const std::string &group, int port,
+                  const std::vector<NetworkInterface> &interfaces,
+                  const std::string &groupName, int ttl = 1);
   ~MulticastSender();
 
-  void start();
+  MulticastSender(const MulticastSender &) = delete;
+  MulticastSender &operator=(const MulticastSender &) = delete;
+
+  void start(const ThreadOptions &thread = {});
   void stop();
 
 private:
@@ -29,26 +37,34 @@ private:
   void sendHeartbeat(const Bytes &msg);
   int sock_;
   sockaddr_in addr_{};
+  std::vector<in_addr> interfaces_;
   std::thread thread_;
   std::atomic<bool> running_{false};
   NodeInfoManager *nodeInfoManager_;
   std::string groupName_;
 };
 
-class MulticastReceiver : public Singleton<MulticastReceiver>
+// Joins the group on every interface in `interfaces` and accepts heartbeats
+// from their subnets
+class MulticastReceiver
 {
 public:
-  MulticastReceiver(const std::string &group, int port, const std::string &localIP,
+  MulticastReceiver(NodeInfoManager &nodeInfoManager, const std::string &group,
+                    int port, const std::vector<NetworkInterface> &interfaces,
                     const std::string &groupName);
   ~MulticastReceiver();
 
-  void start();
+  MulticastReceiver(const MulticastReceiver &) = delete;
+  MulticastReceiver &operator=(const MulticastReceiver &) = delete;
+
+  void start(const ThreadOptions &thread = {});
   void stop();
 
 private:
   void run();
+  bool fromOwnSubnet(const std::string &nodeIP) const;
   int sock_;
-  std::string localIP_;
+  std::vector<NetworkInterface> interfaces_;
   std::string groupName_;
   std::thread thread_;
   std::atomic<bool> running_{false};
@@ -18,8 +18,15 @@ struct SocketInfo
   std::string name;
   std::string ip;
   uint16_t port;
+  std::string shm; // shared-memory segment for same-host subscribers, if any
+  std::string ipc; // ipc:// endpoint for same-host peers, if any
 
-  MSGPACK_DEFINE_MAP(name, ip, port)
+  MSGPACK_DEFINE_MAP(name, ip, port, shm, ipc)
+
+  std::string tcpURL() const;
+
+  // ipc:// endpoint when it is reachable from this process, tcp:// otherwise
+  std::string url() const;
 };
 
 /* ================= NodeInfo ================= */
@@ -30,12 +37,31 @@ struct NodeInfo
   uint32_t infoID;
   std::string name;
   std::string ip;
+  std::string hostID; // equal for nodes that can share ipc:// and shm segments
   std::vector<SocketInfo> topics;
   std::vector<SocketInfo> services;
+  // Further IPs the node's service socket answers on (multi-interface nodes)
+  std::vector<std::string> interfaces;
 
-  MSGPACK_DEFINE_MAP(nodeID, infoID, name, ip, topics, services)
+  MSGPACK_DEFINE_MAP(nodeID, infoID, name, ip, hostID, topics, services, interfaces)
 
   void printNodeInfo() const;
+
+  // Clear the ipc:// and shm fields, which only work on the publishing host
+  void dropHostLocalEndpoints();
+
+  // Reach the node's services through `ip`, the address it was discovered on,
+  // if that is one of its interfaces
+  void useInterface(const std::string &ip);
 };
 
+/**
+ * @brief Identify this host for same-host transport selection.
+ *
+ * Combines the kernel boot ID with the mount namespace, so containers that do
+ * not share /tmp and /dev/shm with each other get different IDs. Returns an
+ * empty string if neither is available.
+ */
+std::string localHostID();
+
 } // namespace zlc
@@ -1,24 +1,43 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "zerolancom/nodes/heartbeat_message.hpp"
 #include "zerolancom/nodes/node_info.hpp"
 #include "zerolancom/utils/event.hpp"
-#include "zerolancom/utils/singleton.hpp"
+#include "zerolancom/utils/zmq_utils.hpp"
 
 namespace zlc
 {
 
-class NodeInfoManager : public Singleton<NodeInfoManager>
+/**
+ * @brief Discovery state of one node: its own NodeInfo, which it announces in
+ * heartbeats, and the NodeInfo of every remote node it has heard from.
+ */
+class NodeInfoManager
 {
+public:
+  // A node is removed when it has not sent a heartbeat for this long
+  static constexpr int HEARTBEAT_TIMEOUT_MS = 3000;
+
+  // Give up on a get_node_info request after this long; the next heartbeat
+  // retries it
+  static constexpr int NODE_FETCH_TIMEOUT_MS = 1000;
+
+  // Checking a node known only from the discovery cache gives up after this
+  // long, since the node may be gone
+  static constexpr int TENTATIVE_REQUEST_TIMEOUT_MS = 500;
+
 private:
   // Remote nodes data
   mutable std::shared_mutex data_mutex_;
@@ -26,25 +45,50 @@ private:
   std::unordered_map<std::string, uint32_t> nodes_info_id_;
   std::unordered_map<std::string, std::chrono::steady_clock::time_point>
       nodes_heartbeat_;
+  // Nodes loaded from the discovery cache that have not sent a heartbeat yet
+  std::unordered_set<std::string> tentative_;
+  // This node's share of the process-wide `nodes` gauge
+  int64_t counted_nodes_{0};
+
+  // Context for get_node_info requests
+  ZMQContext &context_;
 
-  // Local node data
+  // Local node data. Code that needs both locks takes data_mutex_ first
   mutable std::mutex local_mutex_;
   NodeInfo localNodeInfo_;
   std::string groupName_;
   int32_t servicePort_{0};
+  std::string cachePath_; // empty = no discovery cache
+
+  // Bumped and broadcast on every discovery change, for waitUntil()
+  mutable std::mutex wait_mutex_;
+  mutable std::condition_variable discovery_cv_;
+  uint64_t discovery_generation_{0};
+  void notifyDiscovery();
 
   // internal helpers (require external locking)
   void updateNodeUnlocked(const std::string &nodeID, const NodeInfo &info);
+  // Move this node's share of the discovery `nodes` gauge to nodes_info_.size()
+  void countNodesUnlocked();
   bool checkNodeIDUnlocked(const std::string &nodeID) const;
   bool checkNodeInfoIDUnlocked(const std::string &nodeID, uint32_t infoID) const;
+  // Provider of a service, preferring confirmed nodes over tentative ones;
+  // `nodeID` is empty for a local service. Requires data_mutex_ and local_mutex_
+  const SocketInfo *findServiceUnlocked(const std::string &serviceName,
+                                        std::string &nodeID) const;
 
-  // Fetch full NodeInfo from remote node
-  std::optional<NodeInfo> fetchNodeInfo(const std::string &ip, int32_t servicePort);
+  // Fetch full NodeInfo from the remote node serving at `url`
+  std::optional<NodeInfo> fetchNodeInfo(const std::string &url,
+                                        int timeout_ms = NODE_FETCH_TIMEOUT_MS);
 
 public:
-  NodeInfoManager(const std::string &name, const std::string &ip);
+  NodeInfoManager(const std::string &name, const std::string &ip, ZMQContext &context);
+  ~NodeInfoManager();
+
+  NodeInfoManager(const NodeInfoManager &) = delete;
+  NodeInfoManager &operator=(const NodeInfoManager &) = delete;
 
-  // event for node updates
+  // event for node updates; also raised for this node when it adds a topic
   Event<const NodeInfo &> node_update_event;
   Event<const NodeInfo &> node_remove_event;
 
@@ -52,21 +96,75 @@ public:
   bool checkNodeID(const std::string &nodeID) const;
   bool checkNodeInfoID(const std::string &nodeID, uint32_t infoID) const;
   void removeNode(const std::string &nodeID);
+  // Remote nodes this node currently knows, tentative ones included
+  size_t knownNodeCount() const;
 
   std::vector<SocketInfo> getPublisherInfo(const std::string &topicName) const;
+  // Whether a publisher returned by getPublisherInfo belongs to this node
+  bool isLocalTopic(const SocketInfo &info) const;
+  // Only for null checks: the entry may be removed once the call returns
   const SocketInfo *getServiceInfo(const std::string &serviceName) const;
+  // URL of the provider getServiceInfo() would pick, copied under the lock;
+  // empty if the service is unknown
+  std::string getServiceURL(const std::string &serviceName) const;
+  // Every provider of a service, this node's included; tentative providers
+  // only if there is no other
+  std::vector<SocketInfo> getServiceProviders(const std::string &serviceName) const;
 
+  /**
+   * @brief Block until `ready()` returns true or `deadline` passes.
+   *
+   * `ready` is checked again after every discovery change (a node added or
+   * updated, the cache loaded, a local topic or service registered) rather
+   * than on a timer, so waiters wake as soon as what they need appears.
+   * @return The last result of `ready()`.
+   */
+  bool waitUntil(const std::function<bool()> &ready,
+                 std::chrono::steady_clock::time_point deadline) const;
+
+  // Remove nodes silent for HEARTBEAT_TIMEOUT_MS; node_remove_event fires
+  // after the node table is unlocked
   void checkHeartbeats();
   void processHeartbeat(const HeartbeatMessage &heartbeat, const std::string &nodeIP);
 
+  /**
+   * @brief Discovery cache: the known nodes, kept in a file across restarts.
+   *
+   * loadCache() adds the saved nodes as tentative entries, so topics and
+   * services resolve at once. A tentative node is confirmed by its first
+   * heartbeat, or by confirmTentativeService(), and evicted like any silent
+   * node after HEARTBEAT_TIMEOUT_MS, or earlier when it cannot be confirmed.
+   */
+  // Add the nodes saved in `path` for this group; false if there are none
+  bool loadCache(const std::string &path);
+  // Save the known nodes to `path` whenever they change (atomic rename)
+  void setCachePath(const std::string &path);
+  bool saveCache() const;
+  bool isTentative(const std::string &nodeID) const;
+  // Whether `serviceName` resolves to a tentative node
+  bool isTentativeService(const std::string &serviceName) const;
+  // Drop the tentative node that provides `serviceName`, if any
+  void evictTentativeService(const std::string &serviceName);
+  // Ask the tentative provider of `serviceName` for its get_node_info: it is
+  // confirmed if the reply carries the cached node ID, and evicted if it does
+  // not answer or another node now has its port. True if the service then
+  // resolves to a confirmed provider
+  bool confirmTentativeService(const std::string &serviceName);
+
   // Local node management
   const UUID &nodeID() const;
   void setGroupName(const std::string &name);
   void setServicePort(int32_t port);
+  // Further IPs the service socket answers on, advertised in NodeInfo
+  void setInterfaces(const std::vector<std::string> &ips);
   HeartbeatMessage createHeartbeat() const;
   NodeInfo getLocalNodeInfo() const;
-  void registerLocalTopic(const std::string &name, uint16_t port);
-  void registerLocalService(const std::string &name, uint16_t port);
+  // `ip` is the address the topic's socket is bound to; empty = the node's IP
+  void registerLocalTopic(const std::string &name, uint16_t port,
+                          const std::string &shm = {}, const std::string &ipc = {},
+                          const std::string &ip = {});
+  void registerLocalService(const std::string &name, uint16_t port,
+                            const std::string &ipc = {});
 };
 
 } // namespace zlc
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "zerolancom/nodes/heartbeat_message.hpp"
+#include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
+
+namespace zlc
+{
+
+/**
+ * @brief Discovery over unicast UDP, for networks that drop multicast.
+ */
+struct UnicastDiscoveryOptions
+{
+  // UDP port of this node's heartbeat socket: 0 picks a free one, which is
+  // enough for a node that only sends to `peers`; -1 disables unicast
+  // discovery unless `peers` or `rendezvous` is set
+  int port{-1};
+
+  // "host:port" of nodes to send heartbeats to, e.g. a rendezvous node
+  std::vector<std::string> peers;
+
+  // Relay every heartbeat received from a peer to the other peers of its group,
+  // so nodes that only know this one discover each other
+  bool rendezvous{false};
+
+  // Keep multicast discovery running alongside
+  bool multicast{true};
+
+  // Most peers learned from incoming heartbeats; senders beyond this are not
+  // answered or relayed to until others go silent
+  size_t max_peers{256};
+
+  bool enabled() const
+  {
+    return port >= 0 || !peers.empty() || rendezvous;
+  }
+};
+
+/**
+ * @brief Sends heartbeats to a list of peers and feeds the ones it receives
+ * into NodeInfoManager::processHeartbeat, like MulticastReceiver.
+ *
+ * Design notes:
+ * - Datagrams are HeartbeatMessages, as on multicast. A node that hears from
+ *   an address it does not know answers it from then on (until it goes
+ *   silent), so one side listing the other is enough.
+ * - A rendezvous node forwards each heartbeat to its other peers of the same
+ *   group, prefixed with the sender's IP (RELAY_MAGIC), so node info is
+ *   fetched from the sender directly. Relayed heartbeats are never relayed
+ *   again and do not make their sender a peer. They are only accepted from
+ *   configured peers, since they make this node contact the embedded address.
+ * - Learned peers are capped (`max_peers`) and expire after the heartbeat
+ *   timeout. A peer's heartbeats are relayed at most once per half heartbeat
+ *   interval (tolerating send jitter), so each peer, spoofed or not, costs at
+ *   most two relays per interval, each sent to the other peers of its group:
+ *   at most 2 * (peers - 1) datagrams per interval per sender, with peers
+ *   bounded by the configured ones plus `max_peers`.
+ * - No subnet filter: peers are configured explicitly and may be routed.
+ * - One thread sends and receives; the peer table needs no lock.
+ */
+class UnicastDiscovery
+{
+public:
+  // Prefix of a relayed heartbeat: magic, then the sender's IPv4 address
+  static constexpr uint32_t RELAY_MAGIC = 0x5a4c4352; // "ZLCR"
+
+  UnicastDiscovery(NodeInfoManager &nodeInfoManager, const std::string &groupName,
+                   const UnicastDiscoveryOptions &options);
+  ~UnicastDiscovery();
+
+  UnicastDiscovery(const UnicastDiscovery &) = delete;
+  UnicastDiscovery &operator=(const UnicastDiscovery &) = delete;
+
+  // Bound UDP port, 0 if the socket could not be bound
+  uint16_t port() const
+  {
+    return port_;
+  }
+
+  // False (logged) if the UDP socket could not be created
+  bool start(const ThreadOptions &thread = {});
+  void stop();
+
+private:
+  struct Peer
+  {
+    sockaddr_in addr{};
+    std::string group_name; // empty until heard from
+    std::chrono::steady_clock::time_point last_seen;
+    std::chrono::steady_clock::time_point last_relayed;
+    bool configured{false}; // from options.peers; never expires
+  };
+
+  void run();
+  void sendHeartbeats();
+  void receive(const uint8_t *data, size_t size, const sockaddr_in &src);
+  void relay(const uint8_t *data, size_t size, const sockaddr_in &src,
+             const std::string &groupName);
+  void expirePeers();
+  // Known or newly learned peer at `addr`; nullptr if the table is full
+  Peer *peer(const sockaddr_in &addr);
+  bool isConfiguredPeer(const sockaddr_in &addr) const;
+
+  int sock_{-1};
+  uint16_t port_{0};
+  std::string groupName_;
+  bool rendezvous_;
+  size_t maxPeers_;
+  std::vector<Peer> peers_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  NodeInfoManager *nodeInfoManager_;
+};
+
+} // namespace zlc
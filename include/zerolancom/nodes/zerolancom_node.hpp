@@ -1,34 +1,341 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/network.hpp"
 #include "zerolancom/utils/singleton.hpp"
-#include "zerolancom/utils/thread_pool.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
+#include "zerolancom/utils/zmq_utils.hpp"
 
 #include "zerolancom/nodes/multicast.hpp"
 #include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/nodes/unicast_discovery.hpp"
+#include "zerolancom/sockets/client.hpp"
+#include "zerolancom/sockets/load_balancer.hpp"
 #include "zerolancom/sockets/service_manager.hpp"
 #include "zerolancom/sockets/subscriber_manager.hpp"
 
 namespace zlc
 {
 
+/**
+ * @brief Settings of a node (see zlc::init and ZeroLanComNode).
+ */
+struct NodeOptions
+{
+  // Multicast discovery: group address, UDP port and logical group name
+  std::string group{"224.0.0.1"};
+  int group_port{7720};
+  std::string group_name{"zlc_default_group_name"};
+  // Multicast TTL of heartbeats; 1 keeps them on the local network
+  int multicast_ttl{1};
+
+  // Subnet of peers accepted on the node's IP, as a prefix length (24 =
+  // 255.255.255.0); -1 takes the interface's own mask (getifaddrs)
+  int subnet_prefix{-1};
+
+  // Further interfaces to discover on, e.g. a separate control NIC: an IP or
+  // interface name, optionally with "/prefix" (see resolveNetworkInterface).
+  // Services answer on all of them; topics bind to the node's IP unless
+  // PublisherOptions::bind_interface says otherwise.
+  std::vector<std::string> interfaces;
+
+  // Unicast heartbeats to static peers or a rendezvous node, for networks that
+  // drop multicast; disabled by default
+  UnicastDiscoveryOptions unicast;
+
+  // File that keeps the discovered nodes across restarts, so short-lived
+  // processes can call services without waiting for heartbeats; empty = none
+  // (see NodeInfoManager::loadCache)
+  std::string discovery_cache;
+
+  // ZMQ context (I/O threads and their CPUs) and default socket options
+  ZMQOptions zmq;
+
+  // CPU affinity and real-time priority of the node's own threads
+  NodeThreadOptions threads;
+};
+
+/**
+ * @brief One ZeroLanCom node: a ZMQ context, discovery state, multicast
+ * heartbeats, a service socket and the topic subscriptions, all owned by this
+ * object.
+ *
+ * Design notes:
+ * - Any number of nodes can live in one process, each with its own name,
+ *   ports and threads. Nodes in the same process discover each other over
+ *   multicast like nodes in different processes.
+ * - The free functions in zerolancom.hpp act on the default node created by
+ *   zlc::init() (ZeroLanComNode::instance()); Publisher, StreamPublisher and
+ *   Client take a node or context explicitly, or fall back to the default.
+ * - Metrics stay process-wide: nodes in one process share the registry.
+ * - Logging is process-wide too; zlc::init() sets it up, a node created
+ *   directly does not (see Logger::init).
+ * - Template functions must remain header-only.
+ */
 class ZeroLanComNode : public Singleton<ZeroLanComNode>
 {
 public:
   ZeroLanComNode(const std::string &name, const std::string &ip,
-                 const std::string &group, int groupPort);
+                 const NodeOptions &options);
   ZeroLanComNode(const std::string &name, const std::string &ip,
-                 const std::string &group, int groupPort, const std::string &groupName);
+                 const std::string &group = "224.0.0.1", int groupPort = 7720,
+                 const std::string &groupName = "zlc_default_group_name");
   ~ZeroLanComNode();
 
+  // Stop all threads and release the node's sockets; idempotent
   void stop();
   bool isRunning() const;
 
+  // UDP port of unicast discovery (see NodeOptions::unicast), 0 if disabled
+  uint16_t unicastDiscoveryPort() const;
+
+  const std::string &name() const
+  {
+    return name_;
+  }
+
+  // Components; throw std::logic_error once the node is stopped
+  ZMQContext &context() const
+  {
+    return component(context_);
+  }
+  NodeInfoManager &nodeInfoManager() const
+  {
+    return component(nodeInfoManager_);
+  }
+  ServiceManager &serviceManager() const
+  {
+    return component(serviceManager_);
+  }
+  SubscriberManager &subscriberManager() const
+  {
+    return component(subscriberManager_);
+  }
+  LoadBalancer &loadBalancer() const
+  {
+    return component(loadBalancer_);
+  }
+
+  /* ================= Services ================= */
+
+  template <typename HandlerT>
+  void registerServiceHandler(const std::string &service_name, HandlerT handler)
+  {
+    ServiceManager &services = serviceManager();
+    services.registerHandler(service_name, std::function(handler));
+    nodeInfoManager().registerLocalService(service_name, services.service_port,
+                                           services.service_ipc);
+
+    zlc::info("Service {} registered at port {}", service_name, services.service_port);
+  }
+
+  template <typename HandlerT, typename ClassT>
+  void registerServiceHandler(const std::string &service_name, HandlerT handler,
+                              ClassT *instance)
+  {
+    ServiceManager &services = serviceManager();
+    services.registerHandler(service_name, handler, instance);
+    nodeInfoManager().registerLocalService(service_name, services.service_port,
+                                           services.service_ipc);
+  }
+
+  /**
+   * @brief Register a chunked service handler for large responses.
+   *
+   * Handler signature: `uint64_t handler(const RequestType &, uint64_t offset,
+   * size_t max_len, Bytes &chunk)` returning the total blob size.
+   */
+  template <typename HandlerT>
+  void registerStreamServiceHandler(const std::string &service_name, HandlerT handler)
+  {
+    ServiceManager &services = serviceManager();
+    services.registerStreamHandler(service_name, std::function(handler));
+    nodeInfoManager().registerLocalService(service_name, services.service_port,
+                                           services.service_ipc);
+  }
+
+  // Serve a service with a handler on encoded bytes (see
+  // ServiceManager::registerRawHandler)
+  void registerRawServiceHandler(const std::string &service_name,
+                                 const ServiceCallback &handler);
+
+  // Compress responses of a local service (see CompressionConfig)
+  void setServiceCompression(const std::string &service_name,
+                             const CompressionConfig &config);
+
+  // Admission control for a local service (see ServiceLimits); false (logged)
+  // if the limits are invalid or already set
+  bool setServiceLimits(const std::string &service_name, const ServiceLimits &limits);
+
+  // How request() spreads calls to a service over its providers
+  void setLoadBalancing(const std::string &service_name,
+                        const LoadBalancerOptions &options);
+
+  // Block until the service becomes available or timeout expires; woken by
+  // discovery. false (logged) on timeout
+  bool waitForService(const std::string &service_name, int max_wait_ms = 1000) const;
+  // Deprecated: there is no polling any more, so `check_interval_ms` has no
+  // effect; will be removed
+  [[deprecated("check_interval_ms has no effect; call waitForService(name, "
+               "max_wait_ms)")]] bool
+  waitForService(const std::string &service_name, int max_wait_ms,
+                 int check_interval_ms) const;
+  // Block until a publisher of the topic is known or timeout expires
+  bool waitForTopic(const std::string &topic_name, int max_wait_ms = 1000) const;
+  // Block until every service is available or `deadline` passes; false (logged
+  // with the missing ones) on timeout
+  bool waitForAll(const std::vector<std::string> &service_names,
+                  std::chrono::steady_clock::time_point deadline) const;
+
+  template <typename RequestType, typename ResponseType>
+  ResponseStatus request(const std::string &service_name, const RequestType &req,
+                         ResponseType &res)
+  {
+    if (!waitForService(service_name))
+    {
+      return ResponseStatus::NOSERVICE;
+    }
+    NodeInfoManager &nodes = nodeInfoManager();
+
+    // A provider known only from the discovery cache may be gone, or its port
+    // taken by another process: confirm it by node ID, and wait for discovery
+    // if that fails
+    if (nodes.isTentativeService(service_name) &&
+        !nodes.confirmTentativeService(service_name) && !waitForService(service_name))
+    {
+      return ResponseStatus::NOSERVICE;
+    }
+
+    // Spread calls over every provider (see setLoadBalancing); an OVERLOADED
+    // provider is skipped for a moment, so the call is retried on the others
+    LoadBalancer &balancer = loadBalancer();
+    const std::vector<SocketInfo> providers = nodes.getServiceProviders(service_name);
+    const int timeout_ms = balancer.options(service_name).request_timeout_ms;
+    ResponseStatus status = ResponseStatus::NOSERVICE;
+    for (size_t attempt = 0; attempt < std::max<size_t>(providers.size(), 1); ++attempt)
+    {
+      LoadBalancer::Call call(balancer, service_name, providers);
+      if (call.url().empty())
+      {
+        zlc::error("Service {} is not available", service_name);
+        return ResponseStatus::NOSERVICE;
+      }
+      status = call.finish(Client::zlcRequest<RequestType, ResponseType>(
+          context(), service_name, call.url(), req, res, timeout_ms));
+      if (status != ResponseStatus::OVERLOADED)
+      {
+        break;
+      }
+    }
+    return status;
+  }
+
+  template <typename RequestType>
+  ResponseStatus requestStream(const std::string &service_name, const RequestType &req,
+                               const StreamCallback &callback,
+                               uint32_t chunk_size = DEFAULT_STREAM_CHUNK_SIZE,
+                               int chunk_timeout_ms = DEFAULT_STREAM_CHUNK_TIMEOUT_MS)
+  {
+    if (!waitForService(service_name))
+    {
+      return ResponseStatus::NOSERVICE;
+    }
+    NodeInfoManager &nodes = nodeInfoManager();
+
+    // Confirm a provider known only from the discovery cache, as request() does
+    if (nodes.isTentativeService(service_name) &&
+        !nodes.confirmTentativeService(service_name) && !waitForService(service_name))
+    {
+      return ResponseStatus::NOSERVICE;
+    }
+
+    LoadBalancer::Call call(loadBalancer(), service_name,
+                            nodes.getServiceProviders(service_name));
+    if (call.url().empty())
+    {
+      zlc::error("Service {} is not available", service_name);
+      return ResponseStatus::NOSERVICE;
+    }
+    // A provider that stops answering mid-stream is ejected like a timed-out one
+    return call.finish(Client::zlcRequestStream<RequestType>(
+        context(), service_name, call.url(), req, callback, chunk_size,
+        chunk_timeout_ms));
+  }
+
+  /* ================= Topics ================= */
+
+  template <typename HandlerT>
+  void registerSubscriberHandler(const std::string &name, HandlerT callback)
+  {
+    subscriberManager().registerTopicSubscriber(name, callback);
+  }
+
+  template <typename HandlerT, typename ClassT>
+  void registerSubscriberHandler(const std::string &name, HandlerT callback,
+                                 ClassT *instance)
+  {
+    subscriberManager().registerTopicSubscriber(name, callback, instance);
+  }
+
+  // Receive every message of a topic as encoded bytes (see RawCallback)
+  void registerRawSubscriber(const std::string &name, const RawCallback &callback);
+  // Same, handing over the received frame (see RawMessageCallback)
+  void registerRawSubscriber(const std::string &name,
+                             const RawMessageCallback &callback);
+
+  // ZMQ socket options for subscriptions to a topic registered afterwards
+  void setSubscriberSocketOptions(const std::string &name,
+                                  const SocketOptions &options);
+
+  // Receive every chunk published by a StreamPublisher on a topic
+  void registerStreamSubscriber(const std::string &name, const StreamCallback &callback,
+                                int window = DEFAULT_STREAM_WINDOW);
+
+  /* ================= Metrics ================= */
+
+  // Process metrics, labelled with this node's name
+  MetricsSnapshot getMetrics() const;
+
+  // Fetch the metrics of another node through its `<node>/get_metrics` service
+  ResponseStatus requestMetrics(const std::string &node_name, MetricsSnapshot &metrics);
+
 private:
+  template <typename T> static T &component(const std::unique_ptr<T> &ptr)
+  {
+    if (!ptr)
+    {
+      throw std::logic_error("ZeroLanComNode is stopped.");
+    }
+    return *ptr;
+  }
+
   void registerGetNodeInfoService();
+  void registerGetMetricsService();
+
+  std::string name_;
   bool running;
+
+  // Declared in dependency order; stop() releases them in reverse
+  std::unique_ptr<ZMQContext> context_;
+  std::unique_ptr<NodeInfoManager> nodeInfoManager_;
+  std::unique_ptr<LoadBalancer> loadBalancer_;
+  std::unique_ptr<ServiceManager> serviceManager_;
+  std::unique_ptr<MulticastReceiver> multicastReceiver_; // null if unicast only
+  std::unique_ptr<MulticastSender> multicastSender_;
+  std::unique_ptr<UnicastDiscovery> unicastDiscovery_; // null if not configured
+  std::unique_ptr<SubscriberManager> subscriberManager_;
 };
 
+// Nodes are independent objects; ZeroLanComNode is kept as the original name
+using Node = ZeroLanComNode;
+
 } // namespace zlc
@@ -33,9 +33,19 @@ struct ByteBuffer
   size_t size{0};
   size_t capacity{0};
 
+  ByteBuffer() = default;
   ~ByteBuffer();
 
+  // Move-only: the buffer owns a malloc'd block
+  ByteBuffer(const ByteBuffer &) = delete;
+  ByteBuffer &operator=(const ByteBuffer &) = delete;
+  ByteBuffer(ByteBuffer &&other) noexcept;
+  ByteBuffer &operator=(ByteBuffer &&other) noexcept;
+
   void write(const char *buf, size_t len);
+
+  // Give up ownership of the block; the caller must std::free() it
+  uint8_t *release();
 };
 
 // =======================
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "zerolancom/serialization/binary_codec.hpp"
+#include "zerolancom/serialization/message_header.hpp"
+
+namespace zlc
+{
+
+// Default cap on the size a received payload may decompress to
+constexpr uint64_t DEFAULT_MAX_DECOMPRESSED_SIZE = 256 * 1024 * 1024; // 256 MiB
+
+/**
+ * @brief Per-topic / per-service compression settings.
+ *
+ * Payloads smaller than `threshold` bytes are always sent uncompressed, and a
+ * payload whose compressed form is not smaller than the original is sent raw.
+ */
+struct CompressionConfig
+{
+  CompressionCodec codec{CompressionCodec::NONE};
+  int level{0};              // 0 selects the codec default
+  size_t threshold{4096};    // minimum payload size in bytes
+  Bytes dictionary;          // optional zstd dictionary (see trainCompressionDictionary)
+};
+
+/**
+ * @brief Plain copy of compression counters.
+ */
+struct CompressionStatsSnapshot
+{
+  uint64_t messages{0};         // payloads that went through the codec
+  uint64_t skipped{0};          // payloads sent raw (below threshold / incompressible)
+  uint64_t raw_bytes{0};        // bytes before compression
+  uint64_t compressed_bytes{0}; // bytes after compression
+  uint64_t cpu_ns{0};           // time spent inside the codec
+
+  // compressed / raw, 1.0 when nothing was compressed
+  double ratio() const
+  {
+    return raw_bytes == 0 ? 1.0
+                          : static_cast<double>(compressed_bytes) /
+                                static_cast<double>(raw_bytes);
+  }
+};
+
+/**
+ * @brief Lock-free compression counters, safe to read from any thread.
+ */
+struct CompressionStats
+{
+  std::atomic<uint64_t> messages{0};
+  std::atomic<uint64_t> skipped{0};
+  std::atomic<uint64_t> raw_bytes{0};
+  std::atomic<uint64_t> compressed_bytes{0};
+  std::atomic<uint64_t> cpu_ns{0};
+
+  void record(uint64_t raw, uint64_t compressed, uint64_t ns);
+  CompressionStatsSnapshot snapshot() const;
+};
+
+/**
+ * @brief Check whether a codec was compiled into this build.
+ */
+bool isCodecAvailable(CompressionCodec codec);
+
+const char *codecName(CompressionCodec codec);
+
+/**
+ * @brief Stateful compressor bound to one topic or service.
+ *
+ * Design notes:
+ * - Reuses codec contexts between calls; not thread-safe, like the socket it
+ *   feeds.
+ * - Falls back to CompressionCodec::NONE (with a warning) when the requested
+ *   codec is not available in this build.
+ */
+class Compressor
+{
+public:
+  Compressor();
+  explicit Compressor(const CompressionConfig &config);
+  ~Compressor();
+
+  Compressor(const Compressor &) = delete;
+  Compressor &operator=(const Compressor &) = delete;
+
+  bool enabled() const;
+
+  /**
+   * @brief Compress a payload when it is worth it.
+   *
+   * @param in Encoded payload
+   * @param out Receives the compressed payload
+   * @param header Receives FLAG_COMPRESSED, codec and raw size on success
+   * @return true if `out` should be sent instead of `in`
+   */
+  bool compress(const ByteView &in, Bytes &out, MessageHeader &header);
+
+  CompressionStatsSnapshot stats() const;
+
+private:
+  struct Impl;
+
+  CompressionConfig config_;
+  CompressionStats stats_;
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief Decompress a payload described by a header.
+ *
+ * @param header Header received with the payload (must have FLAG_COMPRESSED)
+ * @param in Compressed payload
+ * @param out Destination buffer of exactly `header.raw_size` bytes
+ * @param stats Optional counters to update
+ * @throws DecodeException on unknown codec, missing dictionary or corrupt data
+ */
+void decompress(const MessageHeader &header, const ByteView &in, uint8_t *out,
+                CompressionStats *stats = nullptr);
+
+/**
+ * @brief Check a received header's `raw_size` before allocating for it.
+ *
+ * `raw_size` comes from the peer, so it is rejected when it exceeds
+ * maxDecompressedSize() or cannot be produced from `in` by the header's codec
+ * (lz4 expands at most 255x; zstd frames record their content size).
+ * decompress() runs the same check.
+ *
+ * @throws DecodeException if the payload must not be decompressed
+ */
+void checkDecompressedSize(const MessageHeader &header, const ByteView &in);
+
+/**
+ * @brief Set the process-wide cap checked by checkDecompressedSize().
+ */
+void setMaxDecompressedSize(uint64_t bytes);
+uint64_t maxDecompressedSize();
+
+/**
+ * @brief Make a zstd dictionary known to the decompression side.
+ *
+ * Dictionaries are looked up by the ID embedded in each zstd frame, so every
+ * receiver must register the dictionaries its publishers use.
+ */
+void registerCompressionDictionary(const Bytes &dictionary);
+
+/**
+ * @brief Train a zstd dictionary on representative payloads.
+ * @throws std::runtime_error if zstd is unavailable or training fails
+ */
+Bytes trainCompressionDictionary(const std::vector<Bytes> &samples,
+                                 size_t dictionary_size = 16 * 1024);
+
+} // namespace zlc
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "zerolancom/serialization/binary_codec.hpp"
+
+namespace zlc
+{
+
+/**
+ * @brief Payload compression codec identifiers (wire values).
+ */
+enum class CompressionCodec : uint8_t
+{
+  NONE = 0,
+  LZ4 = 1,
+  ZSTD = 2
+};
+
+/**
+ * @brief Clock used for trace timestamps (wire values).
+ *
+ * MONOTONIC readings are only comparable between processes on one host;
+ * REALTIME works across hosts whose clocks are synchronized (PTP, NTP).
+ */
+enum class TraceClock : uint8_t
+{
+  MONOTONIC = 0,
+  REALTIME = 1
+};
+
+// Current time on `clock`, in nanoseconds
+uint64_t traceClockNow(TraceClock clock);
+
+/**
+ * @brief Per-topic latency tracing settings.
+ *
+ * When enabled, every message carries a sequence number and its publish and
+ * send timestamps (29 extra header bytes), and subscribers record where the
+ * time went. Cheap enough to leave on in production.
+ */
+struct TraceOptions
+{
+  bool enabled{false};
+  TraceClock clock{TraceClock::REALTIME};
+};
+
+/**
+ * @brief Optional envelope header sent as its own frame ahead of a payload.
+ *
+ * Topic messages carry the header frame only when at least one flag is set,
+ * so a single-frame topic message is always a plain payload. Service responses
+ * always carry the frame, which is empty when no flag is set.
+ *
+ * Binary format (network byte order / big-endian):
+ *   - flags: uint8
+ *   - if FLAG_COMPRESSED: codec uint8, raw_size uint64
+ *   - if FLAG_CHUNKED: stream_id uint64, offset uint64, total_size uint64,
+ *     chunk_size uint32
+ *   - if FLAG_SEQUENCED: publisher_id uint32, seq uint64
+ *   - if FLAG_TIMESTAMPED: clock uint8, publish_ns uint64, send_ns uint64
+ *
+ * A header without flags encodes to zero bytes.
+ */
+struct MessageHeader
+{
+  // 0x01 is reserved for Response::FLAG_HAS_DETAIL
+  static constexpr uint8_t FLAG_COMPRESSED = 0x02;
+  static constexpr uint8_t FLAG_CHUNKED = 0x04;
+  static constexpr uint8_t FLAG_SEQUENCED = 0x08;
+  static constexpr uint8_t FLAG_TIMESTAMPED = 0x10;
+
+  uint8_t flags{0};
+  CompressionCodec codec{CompressionCodec::NONE};
+  uint64_t raw_size{0}; // payload size before compression
+
+  // Chunked transfer: the payload is bytes [offset, offset + size) of a blob.
+  // In a chunk request, offset and chunk_size describe the wanted range.
+  uint64_t stream_id{0};
+  uint64_t offset{0};
+  uint64_t total_size{0};
+  uint32_t chunk_size{0};
+
+  // Sequenced: per-publisher counter, starting at 1 for the first message sent
+  uint32_t publisher_id{0};
+  uint64_t seq{0};
+
+  // Timestamped: publish() entry and hand-off to ZMQ, on `clock`
+  TraceClock clock{TraceClock::MONOTONIC};
+  uint64_t publish_ns{0};
+  uint64_t send_ns{0};
+
+  bool empty() const
+  {
+    return flags == 0;
+  }
+
+  bool compressed() const
+  {
+    return (flags & FLAG_COMPRESSED) != 0;
+  }
+
+  bool chunked() const
+  {
+    return (flags & FLAG_CHUNKED) != 0;
+  }
+
+  bool sequenced() const
+  {
+    return (flags & FLAG_SEQUENCED) != 0;
+  }
+
+  bool timestamped() const
+  {
+    return (flags & FLAG_TIMESTAMPED) != 0;
+  }
+
+  /**
+   * @brief Serialize header to bytes (network byte order).
+   */
+  Bytes encode() const;
+
+  /**
+   * @brief Deserialize header from bytes.
+   * @param data Raw header frame (may be null when size is 0)
+   * @param size Size of the header frame
+   * @throws DecodeException if data is truncated
+   */
+  static MessageHeader decode(const uint8_t *data, size_t size);
+};
+
+} // namespace zlc
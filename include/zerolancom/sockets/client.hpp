@@ -1,12 +1,18 @@
 #pragma once
 
+#include <chrono>
+#include <random>
 #include <string>
 
 #include <zmq.hpp>
 
 #include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/serialization/compression.hpp"
 #include "zerolancom/serialization/serializer.hpp"
+#include "zerolancom/sockets/stream.hpp"
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/request_result.hpp"
 #include "zerolancom/utils/zmq_utils.hpp"
 
 namespace zlc
@@ -18,31 +24,74 @@ namespace zlc
  * Design notes:
  * - Non-template functions are declared here and defined in client.cpp.
  * - Template functions must remain header-only.
- * - This class relies on ZMQContext singleton being initialized.
+ * - Requests run on the ZMQContext passed in. Overloads without one use the
+ *   context and discovery state of the default node (zlc::init).
  */
 class Client
 {
 public:
-  // Send a multipart request (service name + payload)
+  // Send a multipart request (service name [+ header] + payload)
   static void sendRequest(const std::string &service_name, const ByteView &payload,
-                          ZMQSocket &socket);
-  // Receive multipart response and extract payload
-  static void receiveResponse(ZMQSocket &socket, zmq::message_t &payloadMsg,
-                              const std::string &service_name);
+                          ZMQSocket &socket, const MessageHeader &header = {});
+  // Receive multipart response and extract (decompressed) payload
+  static ResponseStatus receiveResponse(ZMQSocket &socket, zmq::message_t &payloadMsg,
+                                        const std::string &service_name,
+                                        MessageHeader *header = nullptr);
+
+  // Decompression counters for all service responses received by this process
+  static CompressionStatsSnapshot decompressionStats();
+
+  // Count a finished call and its round-trip latency; the metrics entry is
+  // looked up once per thread and service, without the registry lock
+  static void recordCall(const std::string &service_name, ResponseStatus status,
+                         std::chrono::steady_clock::time_point start);
+
+  // URL of a discovered service (ipc:// on this host, TCP otherwise), or an
+  // empty string if `nodes` does not know it
+  static std::string serviceURL(const NodeInfoManager &nodes,
+                                const std::string &service_name);
+
+  /**
+   * @brief Blocking request with an already-encoded payload; the (decompressed)
+   * response payload is left undecoded in `response`.
+   */
+  static ResponseStatus zlcRequestRaw(ZMQContext &context,
+                                      const std::string &service_name,
+                                      const std::string &service_url,
+                                      const ByteView &request, zmq::message_t &response,
+                                      int timeout_ms = -1);
+
+  // Context and discovery state of the default node
+  static ZMQContext &defaultContext();
+  static const NodeInfoManager &defaultNodeInfoManager();
 
   /**
    * @brief Perform a blocking service request.
    *
    * Requirements:
    * - RequestType and ResponseType must be serializable via encode/decode.
-   * - This function blocks until a response is received or an error occurs.
+   * - This function blocks until a response is received, an error occurs or
+   *   `timeout_ms` expires (ResponseStatus::SERVICE_TIMEOUT; -1 waits forever).
+   *
+   * @return the status reported by the service; `response` is only written on
+   *         ResponseStatus::SUCCESS
    */
   template <typename RequestType, typename ResponseType>
-  static void zlcRequest(const std::string service_name, const std::string &service_url,
-                         const RequestType &request, ResponseType &response)
+  static ResponseStatus zlcRequest(ZMQContext &context, const std::string service_name,
+                                   const std::string &service_url,
+                                   const RequestType &request, ResponseType &response,
+                                   int timeout_ms = -1)
   {
+    auto start = std::chrono::steady_clock::now();
+
     // Create a REQ socket for this request
-    ZMQSocket req_socket = ZMQContext::createTempSocket(zmq::socket_type::req);
+    ZMQSocket req_socket = context.createTempSocket(zmq::socket_type::req);
+    if (timeout_ms >= 0)
+    {
+      // Do not let an unanswered request hold up close()
+      req_socket.set(zmq::sockopt::rcvtimeo, timeout_ms);
+      req_socket.set(zmq::sockopt::linger, 0);
+    }
 
     // Resolve service and connect
     req_socket.connect(service_url);
@@ -56,17 +105,30 @@ public:
 
     // Receive response payload
     zmq::message_t payloadMsg;
-    receiveResponse(req_socket, payloadMsg, service_name);
+    ResponseStatus status = receiveResponse(req_socket, payloadMsg, service_name);
 
     // Deserialize response
     ByteView payload{static_cast<const uint8_t *>(payloadMsg.data()),
                      payloadMsg.size()};
-    if (payload.size != 0)
+    if (!is_error(status) && payload.size != 0)
     {
       decode(payload, response);
     }
     req_socket.close();
-    zlc::info("[Client] Received response from service '{}'", service_name);
+    zlc::trace("[Client] Received response from service '{}'", service_name);
+    recordCall(service_name, status, start);
+    return status;
+  }
+
+  template <typename RequestType, typename ResponseType>
+  static ResponseStatus zlcRequest(const std::string service_name,
+                                   const std::string &service_url,
+                                   const RequestType &request, ResponseType &response,
+                                   int timeout_ms = -1)
+  {
+    return zlcRequest<RequestType, ResponseType>(defaultContext(), service_name,
+                                                 service_url, request, response,
+                                                 timeout_ms);
   }
 
   /**
@@ -77,21 +139,128 @@ public:
    * - This function blocks until a response is received or an error occurs.
    */
   template <typename RequestType, typename ResponseType>
-  static void zlcRequest(const std::string &service_name, const RequestType &request,
-                         ResponseType &response)
+  static ResponseStatus zlcRequest(const std::string &service_name,
+                                   const RequestType &request, ResponseType &response)
+  {
+    const std::string service_url = serviceURL(defaultNodeInfoManager(), service_name);
+    if (service_url.empty())
+    {
+      return ResponseStatus::NOSERVICE;
+    }
+    return zlcRequest<RequestType, ResponseType>(defaultContext(), service_name,
+                                                 service_url, request, response);
+  }
+
+  /**
+   * @brief Pull a large response from a stream handler chunk by chunk.
+   *
+   * Each round trip fetches the next `chunk_size` bytes, so only one chunk is
+   * in memory at a time. `callback` runs on the calling thread. Each chunk
+   * must arrive within `chunk_timeout_ms` (-1 waits forever), so a service
+   * that goes away mid-stream ends the call with SERVICE_TIMEOUT.
+   *
+   * @return ResponseStatus::SUCCESS once the last chunk was delivered
+   */
+  template <typename RequestType>
+  static ResponseStatus
+  zlcRequestStream(ZMQContext &context, const std::string &service_name,
+                   const std::string &service_url, const RequestType &request,
+                   const StreamCallback &callback,
+                   uint32_t chunk_size = DEFAULT_STREAM_CHUNK_SIZE,
+                   int chunk_timeout_ms = DEFAULT_STREAM_CHUNK_TIMEOUT_MS)
   {
-    auto serviceInfoPtr = NodeInfoManager::instance().getServiceInfo(service_name);
+    ZMQSocket req_socket = context.createTempSocket(zmq::socket_type::req);
+    if (chunk_timeout_ms >= 0)
+    {
+      req_socket.set(zmq::sockopt::rcvtimeo, chunk_timeout_ms);
+      req_socket.set(zmq::sockopt::linger, 0);
+    }
+    req_socket.connect(service_url);
+
+    ByteBuffer out;
+    encode(request, out);
+
+    MessageHeader request_header;
+    request_header.flags = MessageHeader::FLAG_CHUNKED;
+    request_header.stream_id = std::random_device{}();
+    request_header.chunk_size = chunk_size;
 
-    if (serviceInfoPtr == nullptr)
+    ResponseStatus status = ResponseStatus::SUCCESS;
+    bool complete = false;
+    while (!complete)
     {
-      zlc::error("Service {} is not available", service_name);
-      return;
+      sendRequest(service_name, ByteView{out.data, out.size}, req_socket,
+                  request_header);
+
+      zmq::message_t payloadMsg;
+      MessageHeader response_header;
+      status = receiveResponse(req_socket, payloadMsg, service_name, &response_header);
+      if (is_error(status))
+      {
+        break;
+      }
+
+      if (!response_header.chunked() || response_header.offset != request_header.offset)
+      {
+        zlc::error("[Client] Service '{}' returned no chunk for offset {}",
+                   service_name, request_header.offset);
+        status = ResponseStatus::INVALID_RESPONSE;
+        break;
+      }
+
+      StreamChunk chunk{response_header.stream_id, response_header.offset,
+                        response_header.total_size,
+                        ByteView{static_cast<const uint8_t *>(payloadMsg.data()),
+                                 payloadMsg.size()}};
+      callback(chunk);
+
+      complete = chunk.last();
+      if (!complete && payloadMsg.size() == 0)
+      {
+        zlc::error("[Client] Service '{}' returned an empty chunk at offset {}",
+                   service_name, request_header.offset);
+        status = ResponseStatus::INVALID_RESPONSE;
+        break;
+      }
+      request_header.offset += payloadMsg.size();
     }
 
-    const SocketInfo &serviceInfo = *serviceInfoPtr;
-    const std::string service_url =
-        "tcp://" + serviceInfo.ip + ":" + std::to_string(serviceInfo.port);
-    zlcRequest<RequestType, ResponseType>(service_name, service_url, request, response);
+    req_socket.close();
+    return status;
+  }
+
+  template <typename RequestType>
+  static ResponseStatus
+  zlcRequestStream(const std::string &service_name, const std::string &service_url,
+                   const RequestType &request, const StreamCallback &callback,
+                   uint32_t chunk_size = DEFAULT_STREAM_CHUNK_SIZE,
+                   int chunk_timeout_ms = DEFAULT_STREAM_CHUNK_TIMEOUT_MS)
+  {
+    return zlcRequestStream<RequestType>(defaultContext(), service_name, service_url,
+                                         request, callback, chunk_size,
+                                         chunk_timeout_ms);
+  }
+
+  /**
+   * @brief Pull a stream from the first known provider of `service_name`.
+   *
+   * @return ResponseStatus::NOSERVICE when no provider is known
+   */
+  template <typename RequestType>
+  static ResponseStatus
+  zlcRequestStream(const std::string &service_name, const RequestType &request,
+                   const StreamCallback &callback,
+                   uint32_t chunk_size = DEFAULT_STREAM_CHUNK_SIZE,
+                   int chunk_timeout_ms = DEFAULT_STREAM_CHUNK_TIMEOUT_MS)
+  {
+    const std::string service_url = serviceURL(defaultNodeInfoManager(), service_name);
+    if (service_url.empty())
+    {
+      return ResponseStatus::NOSERVICE;
+    }
+    return zlcRequestStream<RequestType>(defaultContext(), service_name, service_url,
+                                         request, callback, chunk_size,
+                                         chunk_timeout_ms);
   }
 };
 
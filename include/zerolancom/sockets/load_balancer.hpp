@@ -0,0 +1,140 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zerolancom/nodes/node_info.hpp"
+#include "zerolancom/utils/request_result.hpp"
+
+namespace zlc
+{
+
+enum class LoadBalancePolicy : uint8_t
+{
+  ROUND_ROBIN,       // providers in turn
+  LEAST_OUTSTANDING, // provider with the fewest calls in flight from this node
+  EWMA,              // lowest smoothed latency, weighted by calls in flight
+};
+
+/**
+ * @brief How a node spreads calls to a service over its providers.
+ */
+struct LoadBalancerOptions
+{
+  LoadBalancePolicy policy{LoadBalancePolicy::ROUND_ROBIN};
+
+  // Response timeout of balanced requests; a provider that does not answer in
+  // time is ejected. -1 waits forever, so a provider that hangs blocks the
+  // caller and is never ejected
+  int request_timeout_ms{5000};
+
+  // A provider that times out or cannot be reached is skipped this long
+  int eject_ms{5000};
+
+  // A provider that answers OVERLOADED is skipped this long
+  int overload_backoff_ms{100};
+
+  // Weight of the newest latency sample in the EWMA policy
+  double ewma_alpha{0.3};
+};
+
+/**
+ * @brief Client-side choice between the providers of a service.
+ *
+ * Design notes:
+ * - Providers are passed in on every call (NodeInfoManager::getServiceProviders),
+ *   so the balancer holds no discovery state; statistics of providers that are
+ *   gone are dropped.
+ * - Providers are identified by their URL.
+ * - If every provider is ejected, all of them are tried again rather than
+ *   failing the call.
+ */
+class LoadBalancer
+{
+public:
+  /**
+   * @brief One balanced call: acquires a provider on construction and
+   * releases it on destruction, also when the call throws.
+   */
+  class Call
+  {
+  public:
+    Call(LoadBalancer &balancer, const std::string &service_name,
+         const std::vector<SocketInfo> &providers)
+        : balancer_(balancer), service_name_(service_name),
+          url_(balancer.acquire(service_name, providers)),
+          start_(std::chrono::steady_clock::now())
+    {
+    }
+    ~Call()
+    {
+      if (!url_.empty())
+      {
+        balancer_.release(service_name_, url_, status_,
+                          std::chrono::steady_clock::now() - start_);
+      }
+    }
+
+    Call(const Call &) = delete;
+    Call &operator=(const Call &) = delete;
+
+    // Empty if the service has no provider
+    const std::string &url() const
+    {
+      return url_;
+    }
+
+    // Outcome passed to release(); a call that throws counts as UNKNOWN_ERROR
+    ResponseStatus finish(ResponseStatus status)
+    {
+      status_ = status;
+      return status;
+    }
+
+  private:
+    LoadBalancer &balancer_;
+    std::string service_name_;
+    std::string url_;
+    std::chrono::steady_clock::time_point start_;
+    ResponseStatus status_{ResponseStatus::UNKNOWN_ERROR};
+  };
+
+  void setOptions(const std::string &service_name, const LoadBalancerOptions &options);
+  LoadBalancerOptions options(const std::string &service_name) const;
+
+  // Pick a provider and count the call as in flight; empty if there is none.
+  // Every non-empty result must be passed to release()
+  std::string acquire(const std::string &service_name,
+                      const std::vector<SocketInfo> &providers);
+  // Finish a call: update latency, and eject the provider on timeout, if it
+  // could not be reached, or briefly if it is overloaded
+  void release(const std::string &service_name, const std::string &url,
+               ResponseStatus status, std::chrono::nanoseconds latency);
+
+  // Whether `url` is currently skipped for `service_name`
+  bool isEjected(const std::string &service_name, const std::string &url) const;
+
+private:
+  struct Endpoint
+  {
+    int outstanding{0};
+    double ewma_ns{0.0}; // 0 until the first successful call
+    std::chrono::steady_clock::time_point ejected_until;
+  };
+
+  struct ServiceState
+  {
+    LoadBalancerOptions options;
+    uint64_t next{0}; // round-robin position
+    std::unordered_map<std::string, Endpoint> endpoints;
+  };
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, ServiceState> services_;
+};
+
+} // namespace zlc
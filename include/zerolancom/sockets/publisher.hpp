@@ -1,49 +1,116 @@
 #pragma once
 
 #include <memory>
+#include <random>
 #include <string>
+#include <utility>
 
 #include <zmq.hpp>
 
 #include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/nodes/zerolancom_node.hpp"
+#include "zerolancom/serialization/compression.hpp"
+#include "zerolancom/serialization/message_header.hpp"
 #include "zerolancom/serialization/serializer.hpp"
+#include "zerolancom/sockets/shm_transport.hpp"
+#include "zerolancom/sockets/subscriber_manager.hpp"
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/network.hpp"
 #include "zerolancom/utils/zmq_utils.hpp"
 
 namespace zlc
 {
 
+/**
+ * @brief Per-topic publisher settings.
+ */
+struct PublisherOptions
+{
+  // Payload compression; disabled by default
+  CompressionConfig compression;
+
+  // Same-host shared-memory transport; disabled by default
+  SharedMemoryOptions shm;
+
+  // Per-publisher sequence numbers for loss accounting; disabled by default
+  // because 2.0.x subscribers cannot read the header frame. Tracing implies it.
+  bool sequence{false};
+
+  // Sequence numbers and timestamps for latency tracing; disabled by default
+  TraceOptions trace;
+
+  // ZMQ socket options, merged over the node's ZMQOptions::socket
+  SocketOptions socket;
+
+  // Interface to bind and advertise the topic on, as an IP or interface name
+  // (e.g. a high-bandwidth NIC); empty = the node's IP
+  std::string bind_interface;
+};
+
 /**
  * @brief Publisher is a templated PUB socket wrapper.
  *
  * Design notes:
  * - This is a template class and MUST remain header-only.
  * - All methods are defined inline to allow template instantiation.
- * - Each Publisher owns its own ZMQ PUB socket.
+ * - Each Publisher owns its own ZMQ XPUB socket; subscription messages tell
+ *   it whether anyone outside this node is listening.
+ * - Subscribers on the same node get the message object itself through
+ *   SubscriberManager::publishLocal(), without serialization.
+ * - Nothing is encoded when there is no subscriber at all.
+ * - Sequenced topics number each network message per publisher, so
+ *   subscribers can tell lost, reordered and duplicated messages apart.
+ * - Traced topics also stamp the publish() and send times; subscribers turn
+ *   them into latency histograms.
  */
 template <typename T> class Publisher
 {
 public:
   /**
-   * @brief Construct a publisher for a given topic.
+   * @brief Construct a publisher for a given topic on `node`.
    *
+   * @param node Node that advertises the topic
    * @param topic_name Logical topic name
    * @param with_local_namespace If true, prefix with "lc.local."
+   * @param options Per-topic settings (compression, ...)
    *
    * Behavior:
-   * - Binds to tcp://<local_ip>:0 (ephemeral port)
-   * - Registers the topic with ZeroLanComNode
+   * - Binds to tcp://<local_ip>:0 (ephemeral port), plus an ipc:// endpoint
+   *   for subscribers on the same host
+   * - Creates a shared-memory ring if `options.shm` is enabled
+   * - Registers the topic with the node's NodeInfoManager
    */
-  explicit Publisher(const std::string &topic_name, bool with_local_namespace = false)
+  Publisher(ZeroLanComNode &node, const std::string &topic_name,
+            bool with_local_namespace = false, const PublisherOptions &options = {})
+      : topic_name_(with_local_namespace ? "lc.local." + topic_name : topic_name),
+        subscribers_(&node.subscriberManager()),
+        metrics_(&MetricsRegistry::global().topic(topic_name_)),
+        compressor_(options.compression),
+        sequence_(options.sequence || options.trace.enabled), trace_(options.trace),
+        publisher_id_(std::random_device{}())
   {
-    const std::string full_topic_name =
-        with_local_namespace ? "lc.local." + topic_name : topic_name;
+    const std::string &full_topic_name = topic_name_;
+    NodeInfoManager &nodeInfoManager = node.nodeInfoManager();
 
-    // Create PUB socket
-    socket_ = ZMQContext::createSocket(zmq::socket_type::pub);
+    // Create XPUB socket (PUB that reports subscriptions)
+    socket_ = node.context().createSocket(zmq::socket_type::xpub, options.socket);
 
     // Bind to an ephemeral port
-    const std::string address = NodeInfoManager::instance().getLocalNodeInfo().ip;
+    std::string address = nodeInfoManager.getLocalNodeInfo().ip;
+    if (!options.bind_interface.empty())
+    {
+      auto interface = resolveNetworkInterface(options.bind_interface);
+      if (interface)
+      {
+        address = interface->ip;
+      }
+      else
+      {
+        zlc::warn("[Publisher] Topic '{}' binds to the node's IP {} instead",
+                  full_topic_name, address);
+      }
+    }
 
     socket_->bind("tcp://" + address + ":0");
 
@@ -53,9 +120,28 @@ public:
     zlc::info("[Publisher] Publisher for topic '{}' bound to port {}", full_topic_name,
               port_);
 
+    const std::string ipc = bindIpcEndpoint(*socket_);
+
+    // Same-host subscribers read from shared memory; TCP serves everyone else
+    if (options.shm.enabled)
+    {
+      shm_ = ShmRingWriter::create(makeShmSegmentName(), options.shm);
+      if (!shm_)
+      {
+        zlc::warn("[Publisher] Topic '{}' falls back to TCP only", full_topic_name);
+      }
+    }
+
     // Register topic in node discovery
-    NodeInfoManager::instance().registerLocalTopic(full_topic_name,
-                                                   static_cast<uint16_t>(port_));
+    nodeInfoManager.registerLocalTopic(full_topic_name, static_cast<uint16_t>(port_),
+                                       shm_ ? shm_->name() : "", ipc, address);
+  }
+
+  // Publisher on the default node (zlc::init)
+  explicit Publisher(const std::string &topic_name, bool with_local_namespace = false,
+                     const PublisherOptions &options = {})
+      : Publisher(ZeroLanComNode::instance(), topic_name, with_local_namespace, options)
+  {
   }
 
   // Destructor
@@ -66,22 +152,208 @@ public:
    *
    * Requirements:
    * - T must be serializable via encode()
-   * - This call is non-blocking (ZMQ PUB semantics)
+   * - This call is non-blocking (ZMQ PUB semantics), except that subscribers
+   *   on this node run on the calling thread
+   *
+   * If this node subscribes to the topic, `msg` is copied once into a shared
+   * message for those subscribers; pass an rvalue, or a std::shared_ptr<const T>,
+   * to avoid the copy.
    */
   void publish(const T &msg)
   {
+    if (subscribers_->hasLocalSubscribers(topic_name_))
+    {
+      publish(std::make_shared<const T>(msg));
+      return;
+    }
+    publishRemote(msg);
+  }
+
+  // As above; local subscribers get `msg` moved into the shared message
+  void publish(T &&msg)
+  {
+    if (subscribers_->hasLocalSubscribers(topic_name_))
+    {
+      publish(std::make_shared<const T>(std::move(msg)));
+      return;
+    }
+    publishRemote(msg);
+  }
+
+  /**
+   * @brief Publish a shared message without copying it.
+   *
+   * Subscribers on this node receive `msg` itself; it is encoded once, and
+   * only if a remote subscriber or a subscriber of another type needs bytes.
+   */
+  void publish(const std::shared_ptr<const T> &msg)
+  {
+    const uint64_t publish_ns = traceNow();
     ByteBuffer out;
-    encode(msg, out);
+    bool encoded = false;
+    auto encodeOnce = [&]() -> ByteView
+    {
+      if (!encoded)
+      {
+        encode(*msg, out);
+        encoded = true;
+      }
+      return ByteView{out.data, out.size};
+    };
+
+    metrics_->published.add();
+    subscribers_->publishLocal(topic_name_, typeid(T), msg, encodeOnce);
+
+    if (hasNetworkSubscribers())
+    {
+      sendEncoded(encodeOnce(), publish_ns);
+    }
+  }
+
+  /**
+   * @brief Publish a message that is already encoded, as is (e.g. replayed
+   * from a recording). Local subscribers decode it like a network message.
+   */
+  void publishRaw(const ByteView &payload)
+  {
+    const uint64_t publish_ns = traceNow();
+    metrics_->published.add();
+    subscribers_->publishLocal(topic_name_, typeid(void), nullptr,
+                               [&payload]() { return payload; });
 
-    socket_->send(zmq::buffer(out.data, out.size), zmq::send_flags::none);
+    if (hasNetworkSubscribers())
+    {
+      sendEncoded(payload, publish_ns);
+    }
+  }
+
+  /**
+   * @brief Compression counters for this topic (ratio, CPU time).
+   */
+  CompressionStatsSnapshot compressionStats() const
+  {
+    return compressor_.stats();
+  }
+
+  /**
+   * @brief ID that subscribers key this publisher's sequence numbers by.
+   */
+  uint32_t publisherID() const
+  {
+    return publisher_id_;
   }
 
 private:
-  // Owned PUB socket
+  // publish() without subscribers on this node: encode only if someone listens
+  void publishRemote(const T &msg)
+  {
+    metrics_->published.add();
+    if (!hasNetworkSubscribers())
+    {
+      return;
+    }
+
+    const uint64_t publish_ns = traceNow();
+    ByteBuffer out;
+    encode(msg, out);
+    sendEncoded(ByteView{out.data, out.size}, publish_ns);
+  }
+
+  // Track XPUB subscription messages: 1 = first subscriber, 0 = last one left
+  bool hasNetworkSubscribers()
+  {
+    zmq::message_t event;
+    while (socket_->recv(event, zmq::recv_flags::dontwait))
+    {
+      if (event.size() > 0)
+      {
+        remote_subscribed_ = *static_cast<const uint8_t *>(event.data()) == 1;
+      }
+    }
+    return remote_subscribed_ || (shm_ && shm_->hasReaders());
+  }
+
+  // Trace clock reading, or 0 when the topic is not traced
+  uint64_t traceNow() const
+  {
+    return trace_.enabled ? traceClockNow(trace_.clock) : 0;
+  }
+
+  // Compress if configured, stamp trace fields if enabled, then send
+  void sendEncoded(ByteView payload, uint64_t publish_ns)
+  {
+    MessageHeader header;
+    if (compressor_.enabled() && compressor_.compress(payload, compressed_, header))
+    {
+      payload = ByteView{compressed_.data(), compressed_.size()};
+    }
+
+    if (sequence_)
+    {
+      header.flags |= MessageHeader::FLAG_SEQUENCED;
+      header.publisher_id = publisher_id_;
+      header.seq = ++seq_;
+    }
+
+    if (trace_.enabled)
+    {
+      header.flags |= MessageHeader::FLAG_TIMESTAMPED;
+      header.clock = trace_.clock;
+      header.publish_ns = publish_ns;
+      header.send_ns = traceClockNow(trace_.clock);
+    }
+
+    send(header, payload);
+  }
+
+  // Send [header][payload], or a bare payload frame when no header flag is set
+  void send(const MessageHeader &header, const ByteView &payload)
+  {
+    Bytes header_bytes = header.encode();
+    if (!header_bytes.empty())
+    {
+      socket_->send(zmq::buffer(header_bytes), zmq::send_flags::sndmore);
+    }
+    socket_->send(zmq::buffer(payload.data, payload.size), zmq::send_flags::none);
+    metrics_->published_bytes.add(header_bytes.size() + payload.size);
+
+    if (shm_)
+    {
+      shm_->write(ByteView{header_bytes.data(), header_bytes.size()}, payload);
+    }
+  }
+
+
+  // Full topic name (with namespace prefix)
+  std::string topic_name_;
+
+  // The owning node's subscriptions, for delivery within the node
+  SubscriberManager *subscribers_;
+
+  // Counters for this topic in the process-wide registry
+  TopicMetrics *metrics_;
+
+  // Owned XPUB socket
   ZMQSocket *socket_;
 
   // Bound port number
   int port_{0};
+
+  // Whether at least one network subscriber is connected
+  bool remote_subscribed_{false};
+
+  // Per-topic compression state and reusable output buffer
+  Compressor compressor_;
+  Bytes compressed_;
+
+  // Sequencing and tracing; the random ID tells this publisher's sequence apart
+  bool sequence_;
+  TraceOptions trace_;
+  uint32_t publisher_id_;
+  uint64_t seq_{0};
+
+  // Shared-memory ring for same-host subscribers (null when disabled)
+  std::unique_ptr<ShmRingWriter> shm_;
 };
 
 } // namespace zlc
@@ -1,45 +1,95 @@
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <zmq.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <thread>
 
+#include "zerolancom/serialization/compression.hpp"
 #include "zerolancom/serialization/serializer.hpp"
+#include "zerolancom/sockets/stream.hpp"
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
 #include "zerolancom/utils/request_result.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
 #include "zerolancom/utils/zmq_utils.hpp"
 
 namespace zlc
 {
 
-using ServiceCallback = std::function<Bytes(const ByteView &payload)>;
+// Decode the request in `payload` and encode the response into `out`
+using ServiceCallback = std::function<void(const ByteView &payload, ByteBuffer &out)>;
+
+// Copy at most max_len bytes of the blob at `offset` into chunk; return blob size
+using StreamServiceCallback = std::function<uint64_t(
+    const ByteView &payload, uint64_t offset, size_t max_len, Bytes &chunk)>;
+
+/**
+ * @brief Admission control for one service (see ServiceManager::setLimits).
+ *
+ * At most `max_concurrency` requests run at once and `max_queue` more wait;
+ * any request beyond that is answered at once with ResponseStatus::OVERLOADED.
+ */
+struct ServiceLimits
+{
+  int max_concurrency{1};
+  int max_queue{0};
+
+  // AIMD between 1 and max_concurrency: the limit shrinks by 10% whenever a
+  // handler runs longer than `latency_tolerance` times the fastest recent run,
+  // and otherwise grows by about one per `limit` requests
+  bool adaptive{false};
+  double latency_tolerance{2.0};
+};
 
 /**
  * @brief ServiceManager handles incoming RPC service requests.
  *
  * Design notes:
- * - Uses ZMQ REP socket for request handling with dedicated polling thread.
+ * - Uses a ZMQ ROUTER socket (REQ clients) with a dedicated polling thread.
+ *   The socket listens on TCP and, for clients on the same host, on ipc://.
+ * - Handlers run on the polling thread, one at a time, except for services
+ *   with ServiceLimits: their requests are queued to worker threads, and the
+ *   polling thread keeps reading so it can reject overload at once. Workers
+ *   hand their responses back through a queue and a wake-up pipe, since only
+ *   the polling thread may use the socket.
  * - Template registerHandler functions must remain header-only.
  * - Non-template functions are implemented in service_manager.cpp.
+ * - Responses are sent as [status][header][payload]. The status is a single
+ *   byte; the header frame is empty unless the payload is compressed or
+ *   chunked, or Response::FLAG_HAS_DETAIL adds a [detail] frame before the
+ *   payload.
+ * - Handlers encode straight into Response::payload, whose block is handed to
+ *   ZMQ without copying.
+ * - Requests are [service][payload], or [service][header][payload] for chunk
+ *   requests to stream handlers.
  */
-class ServiceManager : public Singleton<ServiceManager>
+class ServiceManager
 {
 public:
   int service_port{0};
+  std::string service_ipc; // ipc:// endpoint for same-host clients, may be empty
 
-  explicit ServiceManager(const std::string &ip);
+  ServiceManager(ZMQContext &context, const std::string &ip);
   ~ServiceManager();
 
-  void start();
+  void start(const ThreadOptions &thread = {});
   void stop();
 
+  // Also answer on `ip`, at the same port; false (logged) if it is taken there
+  bool bindInterface(const std::string &ip);
+
   /**
    * @brief Register a request-response handler.
    */
@@ -47,15 +97,14 @@ public:
   void registerHandler(const std::string &name,
                        const std::function<ResponseType(const RequestType &)> &func)
   {
-    handlers_[name] = [func](const ByteView &payload) -> Bytes
-    {
-      RequestType req;
-      decode(payload, req);
-      ResponseType resp = func(req);
-      ByteBuffer out;
-      encode(resp, out);
-      return Bytes(out.data, out.data + out.size);
-    };
+    addHandler(name,
+               [func](const ByteView &payload, ByteBuffer &out)
+               {
+                 RequestType req;
+                 decode(payload, req);
+                 ResponseType resp = func(req);
+                 encode(resp, out);
+               });
   }
 
   template <typename RequestType, typename ResponseType, typename ClassT>
@@ -63,43 +112,176 @@ public:
                        ResponseType (ClassT::*func)(const RequestType &),
                        ClassT *instance)
   {
-    handlers_[name] = [instance, func](const ByteView &payload) -> Bytes
-    {
-      RequestType req;
-      decode(payload, req);
-      ResponseType resp = (instance->*func)(req);
-      ByteBuffer out;
-      encode(resp, out);
-      return Bytes(out.data, out.data + out.size);
-    };
+    addHandler(name,
+               [instance, func](const ByteView &payload, ByteBuffer &out)
+               {
+                 RequestType req;
+                 decode(payload, req);
+                 ResponseType resp = (instance->*func)(req);
+                 encode(resp, out);
+               });
+  }
+
+  /**
+   * @brief Register a handler that works on encoded bytes (e.g. a relay).
+   *
+   * The handler may throw ServiceStatusException to answer with a status
+   * other than SERVICE_FAIL.
+   */
+  void registerRawHandler(const std::string &name, const ServiceCallback &func)
+  {
+    addHandler(name, func);
+  }
+
+  /**
+   * @brief Register a chunked (ranged) handler for large responses.
+   *
+   * The handler copies at most `max_len` bytes of the blob starting at
+   * `offset` into `chunk` and returns the total blob size. Clients pull one
+   * chunk per round trip (Client::zlcRequestStream), so memory on both sides is
+   * bounded by the chunk size rather than the blob size.
+   */
+  template <typename RequestType>
+  void registerStreamHandler(
+      const std::string &name,
+      const std::function<uint64_t(const RequestType &, uint64_t, size_t, Bytes &)>
+          &func)
+  {
+    addStreamHandler(name,
+                     [func](const ByteView &payload, uint64_t offset, size_t max_len,
+                            Bytes &chunk) -> uint64_t
+                     {
+                       RequestType req;
+                       decode(payload, req);
+                       return func(req, offset, max_len, chunk);
+                     });
   }
 
   void handleRequest(const std::string &service_name, const ByteView &payload,
                      Response &response);
 
+  void handleStreamRequest(const std::string &service_name,
+                           const MessageHeader &request_header, const ByteView &payload,
+                           Response &response, MessageHeader &response_header);
+
   void clearHandlers();
   void removeHandler(const std::string &name);
 
-  // Non-copyable, movable
+  /**
+   * @brief Limit how many requests of a service run and wait at once.
+   *
+   * Its handler then runs on `max_concurrency` worker threads, so it must be
+   * thread-safe when that is more than one. Limits are set once per service;
+   * false (logged) if they are invalid or already set.
+   */
+  bool setLimits(const std::string &name, const ServiceLimits &limits);
+  // Current concurrency limit of a service (moves if adaptive); 0 if unlimited
+  int concurrencyLimit(const std::string &name) const;
+
+  /**
+   * @brief Compress responses of a service above the configured threshold.
+   */
+  void setCompression(const std::string &name, const CompressionConfig &config);
+  CompressionStatsSnapshot compressionStats(const std::string &name) const;
+
+  // Non-copyable, non-movable (the polling thread holds `this`)
   ServiceManager(const ServiceManager &) = delete;
   ServiceManager &operator=(const ServiceManager &) = delete;
-  ServiceManager(ServiceManager &&) = default;
-  ServiceManager &operator=(ServiceManager &&) = default;
 
 private:
-  // Poll once for incoming service requests
+  // A request read off the socket, with the ROUTER identity to answer to
+  struct PendingRequest
+  {
+    zmq::message_t identity;
+    std::string service_name;
+    MessageHeader header;
+    bool valid_header{true};
+    zmq::message_t payload;
+    // Set for a malformed request, which is answered with INVALID_REQUEST
+    std::string error;
+  };
+
+  // A response from a worker, waiting for the polling thread to send it
+  struct CompletedResponse
+  {
+    zmq::message_t identity;
+    std::string service_name;
+    Response response;
+    MessageHeader header;
+  };
+
+  // Queue, workers and current limit of a service with ServiceLimits
+  struct Admission
+  {
+    ServiceLimits limits;
+    double limit{1.0};
+    double baseline_ns{0.0}; // fastest recent handler run, for AIMD
+    int inflight{0};
+    std::deque<PendingRequest> queue;
+    std::condition_variable ready;
+    std::vector<std::thread> workers;
+  };
+
+  // Store a handler and its registry entry (handlers_mutex_ taken)
+  void addHandler(const std::string &name, ServiceCallback handler);
+  void addStreamHandler(const std::string &name, StreamServiceCallback handler);
+  // Registry entry of a registered service, or nullptr
+  ServiceMetrics *findMetrics(const std::string &service_name) const;
+
+  // Poll once for incoming service requests and finished worker responses
   void pollOnce();
+  // Read one request without blocking; false if none is waiting
+  bool receiveRequest(PendingRequest &request);
+  // Run the request here, queue it for workers or reject it
+  void dispatch(PendingRequest &&request);
+  void process(const PendingRequest &request, Response &response,
+               MessageHeader &header);
+  void runWorker(Admission &admission);
+  // Update an adaptive limit after a handler run (admission_mutex_ held)
+  static void adapt(Admission &admission, std::chrono::nanoseconds latency);
+  void sendCompleted();
+  void wake();
+
+  // Count a handled request and its handler latency
+  void recordRequest(const std::string &service_name, const Response &response,
+                     std::chrono::steady_clock::time_point start);
+
+  // Send [identity][][status][header]([detail])[payload], handing the payload
+  // block to ZMQ
+  void sendResponse(zmq::message_t &identity, Response &response,
+                    MessageHeader &header, const std::string &service_name);
 
 private:
   void run();
 
 private:
-  std::unordered_map<std::string, std::function<Bytes(const ByteView &)>> handlers_;
+  // Handlers are registered from any thread while the polling thread and the
+  // workers look them up; a handler is copied out (shared) and run unlocked
+  mutable std::shared_mutex handlers_mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const ServiceCallback>> handlers_;
+  std::unordered_map<std::string, std::shared_ptr<const StreamServiceCallback>>
+      stream_handlers_;
+
+  // Registry entries of the registered services, looked up once at registration
+  std::unordered_map<std::string, ServiceMetrics *> metrics_;
+
+  // Per-service response compression
+  mutable std::mutex compression_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<Compressor>> compressors_;
+  Bytes compressed_;
 
   ZMQSocket *res_socket_;
   static constexpr int SOCKET_TIMEOUT_MS = 100;
 
+  // Admission control; also guards completed_ and stopping_
+  mutable std::mutex admission_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<Admission>> admissions_;
+  std::vector<CompletedResponse> completed_;
+  bool stopping_{false};
+  int wake_fds_[2]{-1, -1}; // workers write, the polling thread reads
+
   std::thread thread_;
+  ThreadOptions thread_options_; // also used for worker threads
   std::atomic<bool> running_{false};
 };
 
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "zerolancom/serialization/binary_codec.hpp"
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
+
+namespace zlc
+{
+
+/**
+ * @brief Shared-memory settings for a topic.
+ *
+ * When enabled, subscribers on the same host read messages in place from a
+ * shared ring instead of going through TCP loopback. Remote subscribers still
+ * receive the topic over ZMQ.
+ */
+struct SharedMemoryOptions
+{
+  bool enabled{false};
+  uint32_t slots{4}; // keep above the number of local subscribers + 1
+  size_t slot_size{4 * 1024 * 1024}; // grows automatically for larger messages
+};
+
+struct ShmRingHeader;
+struct ShmSlot;
+struct ShmReaderEntry;
+
+/**
+ * @brief A mapped POSIX shared-memory segment holding one ring.
+ */
+struct ShmMapping
+{
+  void *base{nullptr};
+  size_t size{0};
+
+  ShmMapping() = default;
+  ~ShmMapping();
+
+  ShmMapping(const ShmMapping &) = delete;
+  ShmMapping &operator=(const ShmMapping &) = delete;
+  ShmMapping(ShmMapping &&other) noexcept;
+  ShmMapping &operator=(ShmMapping &&other) noexcept;
+
+  ShmRingHeader *header() const;
+  ShmSlot *slot(uint32_t index) const;
+  uint8_t *slotData(uint32_t index) const;
+};
+
+/**
+ * @brief Publisher side of a same-host shared-memory topic.
+ *
+ * Design notes:
+ * - The ring holds the latest messages only, matching the latest-only delivery
+ *   of regular subscribers.
+ * - Each message is copied once into a free slot; slots still being read by a
+ *   subscriber are skipped, so readers can use the data in place.
+ * - Readers sleep on a futex and are only woken when someone is waiting.
+ * - A message larger than the slot size moves the ring to a bigger segment
+ *   (a new "generation"); readers follow automatically.
+ * - Readers register their pid in the ring header. About once a second the
+ *   writer drops readers whose process is gone and releases the slot they were
+ *   reading, so a crashed subscriber does not keep the ring busy. Readers must
+ *   therefore share the writer's PID namespace.
+ */
+class ShmRingWriter
+{
+public:
+  // Create and map the segment; returns nullptr (and logs) on failure
+  static std::unique_ptr<ShmRingWriter> create(const std::string &name,
+                                               const SharedMemoryOptions &options);
+
+  ~ShmRingWriter();
+
+  ShmRingWriter(const ShmRingWriter &) = delete;
+  ShmRingWriter &operator=(const ShmRingWriter &) = delete;
+
+  /**
+   * @brief Copy [header][payload] into a free slot and wake readers.
+   * @return false if every slot is still being read (message dropped)
+   */
+  bool write(const ByteView &header, const ByteView &payload);
+
+  // Name advertised to subscribers
+  const std::string &name() const
+  {
+    return name_;
+  }
+
+  uint64_t dropped() const
+  {
+    return dropped_;
+  }
+
+  // Whether any live reader has the ring open
+  bool hasReaders();
+
+  static constexpr int READER_CHECK_INTERVAL_MS = 1000;
+
+private:
+  ShmRingWriter() = default;
+
+  // Drop readers whose process has exited; rate-limited
+  void checkReaders();
+
+  // Move to a new generation whose slots fit `needed` bytes
+  bool grow(size_t needed);
+
+  std::string name_;
+  uint32_t slots_{0};
+  uint32_t generation_{0};
+  uint32_t next_slot_{0};
+  uint64_t seq_{0};
+  uint64_t dropped_{0};
+  std::chrono::steady_clock::time_point next_reader_check_;
+
+  ShmMapping first_;   // generation 0 stays mapped so late readers find the latest
+  ShmMapping current_; // empty while generation 0 is current
+};
+
+/**
+ * @brief Subscriber side of a same-host shared-memory topic.
+ */
+class ShmRingReader
+{
+public:
+  using Handler = std::function<void(const ByteView &header, const ByteView &payload)>;
+
+  // Map an existing segment; returns nullptr if it cannot be opened
+  static std::unique_ptr<ShmRingReader> open(const std::string &name);
+
+  ~ShmRingReader();
+
+  ShmRingReader(const ShmRingReader &) = delete;
+  ShmRingReader &operator=(const ShmRingReader &) = delete;
+
+  /**
+   * @brief Wait for a message newer than the last one read and pass it to
+   * `handler` in place. The views are only valid during the call.
+   *
+   * @return false on timeout or once the writer has closed the ring
+   */
+  bool readNext(const Handler &handler, int timeout_ms);
+
+  bool closed() const;
+
+  // Messages overwritten by the writer before this reader got to them
+  uint64_t skipped() const
+  {
+    return skipped_;
+  }
+
+private:
+  ShmRingReader() = default;
+
+  // Follow the writer to its current generation
+  bool followGeneration();
+
+  std::string name_;
+  uint32_t generation_{0};
+  uint64_t last_seq_{0};
+  uint64_t skipped_{0};
+  bool detached_{false};           // the writer's segments are gone
+  ShmReaderEntry *entry_{nullptr}; // row in the reader table of generation 0
+  ShmMapping root_;                // generation 0, where this reader is counted
+  ShmMapping mapping_;             // generation currently read
+};
+
+/**
+ * @brief Runs a ShmRingReader on its own thread until destroyed.
+ */
+class ShmSubscription
+{
+public:
+  // Skipped messages are added to `dropped`, if given
+  ShmSubscription(std::unique_ptr<ShmRingReader> reader, ShmRingReader::Handler handler,
+                  Counter *dropped = nullptr, const ThreadOptions &thread = {});
+  ~ShmSubscription();
+
+  ShmSubscription(const ShmSubscription &) = delete;
+  ShmSubscription &operator=(const ShmSubscription &) = delete;
+
+private:
+  std::unique_ptr<ShmRingReader> reader_;
+  ShmRingReader::Handler handler_;
+  Counter *dropped_;
+  std::atomic<bool> running_{true};
+  std::thread thread_;
+};
+
+// Unique segment name for a new shared-memory publisher in this process
+std::string makeShmSegmentName();
+
+} // namespace zlc
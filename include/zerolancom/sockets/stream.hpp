@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include "zerolancom/serialization/binary_codec.hpp"
+#include "zerolancom/serialization/compression.hpp"
+
+namespace zlc
+{
+
+constexpr uint32_t DEFAULT_STREAM_CHUNK_SIZE = 1024 * 1024; // 1 MiB
+constexpr int DEFAULT_STREAM_WINDOW = 8;                    // chunks in flight
+constexpr uint32_t MAX_STREAM_CHUNK_SIZE = 64 * 1024 * 1024; // cap for service chunks
+constexpr int DEFAULT_STREAM_CHUNK_TIMEOUT_MS = 5000;         // per service chunk
+
+/**
+ * @brief Settings for chunked topic streams.
+ *
+ * Peak memory on either side is roughly `chunk_size * window`, independent of
+ * the blob size.
+ */
+struct StreamOptions
+{
+  uint32_t chunk_size{DEFAULT_STREAM_CHUNK_SIZE};
+  int window{DEFAULT_STREAM_WINDOW}; // ZMQ high-water mark, in chunks
+  int send_timeout_ms{5000};         // give up when subscribers stall this long
+  CompressionConfig compression;     // applied per chunk
+};
+
+/**
+ * @brief One chunk of a streamed blob, as seen by a stream callback.
+ *
+ * `data` is only valid for the duration of the callback.
+ */
+struct StreamChunk
+{
+  uint64_t stream_id{0};
+  uint64_t offset{0};
+  uint64_t total_size{0};
+  ByteView data;
+
+  bool first() const
+  {
+    return offset == 0;
+  }
+
+  bool last() const
+  {
+    return offset + data.size >= total_size;
+  }
+};
+
+using StreamCallback = std::function<void(const StreamChunk &)>;
+
+/**
+ * @brief Reassembles streamed chunks into complete blobs.
+ *
+ * Can be passed directly as a StreamCallback. A stream with a missing or
+ * out-of-order chunk is dropped. Memory is bounded by the blob size, so use a
+ * plain chunk callback when blobs do not fit in memory.
+ */
+class StreamAssembler
+{
+public:
+  using CompleteCallback = std::function<void(uint64_t stream_id, Bytes &&blob)>;
+
+  explicit StreamAssembler(CompleteCallback on_complete,
+                           uint64_t max_blob_size = uint64_t(1) << 32);
+
+  void operator()(const StreamChunk &chunk);
+
+  size_t pendingStreams() const
+  {
+    return pending_.size();
+  }
+
+private:
+  CompleteCallback on_complete_;
+  uint64_t max_blob_size_;
+  std::unordered_map<uint64_t, Bytes> pending_;
+};
+
+} // namespace zlc
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+
+#include "zerolancom/serialization/compression.hpp"
+#include "zerolancom/sockets/stream.hpp"
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/zmq_utils.hpp"
+
+namespace zlc
+{
+
+class ZeroLanComNode;
+
+/**
+ * @brief StreamPublisher sends large blobs on a topic as fixed-size chunks.
+ *
+ * Design notes:
+ * - Each chunk is its own [header][chunk] message, so ZMQ never holds more
+ *   than `window` chunks per subscriber.
+ * - The PUB socket runs with ZMQ_XPUB_NODROP: when a subscriber's window is
+ *   full, publish() waits instead of dropping chunks (flow control).
+ * - Subscribe with zlc::registerStreamSubscriber().
+ */
+class StreamPublisher
+{
+public:
+  // Fill `len` bytes of the blob starting at `offset` into `dst`
+  using ChunkSource = std::function<void(uint64_t offset, uint8_t *dst, size_t len)>;
+
+  StreamPublisher(ZeroLanComNode &node, const std::string &topic_name,
+                  const StreamOptions &options = {});
+
+  // Stream publisher on the default node (zlc::init)
+  explicit StreamPublisher(const std::string &topic_name,
+                           const StreamOptions &options = {});
+
+  StreamPublisher(const StreamPublisher &) = delete;
+  StreamPublisher &operator=(const StreamPublisher &) = delete;
+
+  /**
+   * @brief Stream an in-memory blob. Chunks are sent from `blob` in place.
+   * @return false if subscribers stalled past `send_timeout_ms`
+   */
+  bool publish(const ByteView &blob);
+
+  /**
+   * @brief Stream `total_size` bytes read from `in`, one chunk at a time.
+   */
+  bool publish(std::istream &in, uint64_t total_size);
+
+  /**
+   * @brief Stream `total_size` bytes produced on demand by `source`.
+   */
+  bool publish(uint64_t total_size, const ChunkSource &source);
+
+  CompressionStatsSnapshot compressionStats() const
+  {
+    return compressor_.stats();
+  }
+
+private:
+  // Send [0, total_size) as chunks obtained from `next(offset, len)`
+  bool publishChunks(uint64_t total_size,
+                     const std::function<ByteView(uint64_t, size_t)> &next);
+  bool sendChunk(MessageHeader header, const ByteView &chunk);
+
+  ZMQSocket *socket_;
+  int port_{0};
+  std::string topic_name_;
+  StreamOptions options_;
+  uint64_t next_stream_id_;
+  TopicMetrics *metrics_;
+
+  Compressor compressor_;
+  Bytes compressed_;
+  Bytes chunk_buffer_;
+};
+
+} // namespace zlc
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <typeindex>
 #include <unordered_map>
 #include <vector>
 
@@ -14,27 +16,53 @@
 
 #include "zerolancom/nodes/node_info.hpp"
 #include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/serialization/compression.hpp"
+#include "zerolancom/serialization/message_header.hpp"
 #include "zerolancom/serialization/serializer.hpp"
+#include "zerolancom/sockets/shm_transport.hpp"
+#include "zerolancom/sockets/stream.hpp"
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/sequence_tracker.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
 #include "zerolancom/utils/zmq_utils.hpp"
 
 namespace zlc
 {
 
+// Encoded message bytes; only valid for the duration of the callback
+using RawCallback = std::function<void(const ByteView &payload)>;
+// Encoded message as received; the callback may move the frame out to keep it
+using RawMessageCallback = std::function<void(zmq::message_t &payload)>;
+
 /**
  * @brief SubscriberManager manages topic subscriptions and message dispatch.
  *
  * Design notes:
  * - Automatically discovers publishers via NodeInfoManager callbacks.
  * - Uses one SUB socket per topic.
+ * - Publishers on the same host that offer a shared-memory ring are read from
+ *   it in place (one reader thread each) instead of over TCP.
+ * - Publishers on the same node hand messages over directly (publishLocal)
+ *   without serialization; subscribers never connect to them over the network.
+ * - Callbacks of one subscriber never run concurrently, whichever transport
+ *   delivers the message.
+ * - Compressed payloads are decompressed before the callback runs.
+ * - Traced messages feed the topic's latency histograms.
+ * - Sequenced messages are accounted per publisher (lost, reordered,
+ *   duplicated) as they are read off a ZMQ socket, including those the
+ *   latest-only drain discards, so only transport losses count as lost.
  * - Template subscription API must remain header-only.
  */
-class SubscriberManager : public Singleton<SubscriberManager>
+class SubscriberManager
 {
 public:
-  explicit SubscriberManager();
+  SubscriberManager(ZMQContext &context, NodeInfoManager &nodeInfoManager);
   ~SubscriberManager();
 
+  SubscriberManager(const SubscriberManager &) = delete;
+  SubscriberManager &operator=(const SubscriberManager &) = delete;
+
   /**
    * @brief Register a subscriber callback for a topic.
    *
@@ -46,13 +74,17 @@ public:
   void registerTopicSubscriber(const std::string &topicName,
                                void (*callback)(const MessageType &))
   {
-    _registerTopicSubscriber(topicName,
-                             [callback](const ByteView &view)
-                             {
-                               MessageType msg;
-                               decode(view, msg);
-                               callback(msg);
-                             });
+    _registerTopicSubscriber(
+        topicName,
+        [callback](const ByteView &view)
+        {
+          MessageType msg;
+          decode(view, msg);
+          callback(msg);
+        },
+        typeid(MessageType),
+        [callback](const std::shared_ptr<const void> &msg)
+        { callback(*static_cast<const MessageType *>(msg.get())); });
   }
 
   template <typename MessageType, typename ClassT>
@@ -60,17 +92,75 @@ public:
                                void (ClassT::*callback)(const MessageType &),
                                ClassT *instance)
   {
-    _registerTopicSubscriber(topicName,
-                             [instance, callback](const ByteView &view)
-                             {
-                               MessageType msg;
-                               decode(view, msg);
-                               (instance->*callback)(msg);
-                             });
+    _registerTopicSubscriber(
+        topicName,
+        [instance, callback](const ByteView &view)
+        {
+          MessageType msg;
+          decode(view, msg);
+          (instance->*callback)(msg);
+        },
+        typeid(MessageType),
+        [instance, callback](const std::shared_ptr<const void> &msg)
+        { (instance->*callback)(*static_cast<const MessageType *>(msg.get())); });
+  }
+
+  /**
+   * @brief Register a callback that shares ownership of each message.
+   *
+   * Messages from publishers on this node arrive as the publisher's own
+   * shared_ptr, so the callback may keep them without copying.
+   */
+  template <typename MessageType>
+  void registerTopicSubscriber(
+      const std::string &topicName,
+      void (*callback)(const std::shared_ptr<const MessageType> &))
+  {
+    _registerTopicSubscriber(
+        topicName,
+        [callback](const ByteView &view)
+        {
+          auto msg = std::make_shared<MessageType>();
+          decode(view, *msg);
+          callback(msg);
+        },
+        typeid(MessageType),
+        [callback](const std::shared_ptr<const void> &msg)
+        { callback(std::static_pointer_cast<const MessageType>(msg)); });
   }
 
-  // Start polling thread
-  void start();
+  /**
+   * @brief Register a chunk callback for a topic fed by a StreamPublisher.
+   *
+   * Unlike regular subscribers, every chunk is delivered (no latest-only
+   * drain). `window` bounds the number of chunks queued on this side.
+   */
+  void registerStreamSubscriber(const std::string &topicName,
+                                const StreamCallback &callback,
+                                int window = DEFAULT_STREAM_WINDOW);
+
+  /**
+   * @brief Register a callback that receives every message of a topic as
+   * encoded bytes, without decoding (used for recording).
+   *
+   * Like stream subscribers, nothing is dropped by a latest-only drain and
+   * shared-memory rings are not used; compressed payloads are decompressed.
+   * Messages published on this node are delivered as well.
+   */
+  void registerRawSubscriber(const std::string &topicName, const RawCallback &callback);
+  // Same, handing over the received frame; compressed and local messages are
+  // copied into a new one
+  void registerRawSubscriber(const std::string &topicName,
+                             const RawMessageCallback &callback);
+
+  /**
+   * @brief ZMQ socket options for subscriptions to a topic, merged over the
+   * node's ZMQOptions::socket. Applies to subscriptions registered afterwards.
+   */
+  void setSocketOptions(const std::string &topicName, const SocketOptions &options);
+
+  // Start polling thread; `thread` also applies to shared-memory readers
+  void start(const ThreadOptions &thread = {});
 
   // Stop polling thread
   void stop();
@@ -81,10 +171,26 @@ public:
   // Called by NodeInfoManager when a node is removed
   void removeTopicSubscriber(const NodeInfo &nodeInfo);
 
-private:
-  // Find all publisher endpoints for a topic
-  std::vector<std::string> findTopicURLs(const std::string &topicName);
+  // Decompression counters (ratio, CPU time) aggregated over a topic's subscribers
+  CompressionStatsSnapshot decompressionStats(const std::string &topicName);
 
+  // Whether this node has regular subscribers for a topic
+  bool hasLocalSubscribers(const std::string &topicName);
+
+  /**
+   * @brief Deliver a message published on this node to local subscribers.
+   *
+   * Subscribers registered for `type` receive `msg` itself; others get the
+   * bytes produced by `encoded()`, which is called at most once. Callbacks run
+   * on the publishing thread, without the subscriber's dispatch lock, so they
+   * may publish on the same topic; they are not serialized with deliveries
+   * from other nodes.
+   */
+  void publishLocal(const std::string &topicName, std::type_index type,
+                    const std::shared_ptr<const void> &msg,
+                    const std::function<ByteView()> &encoded);
+
+private:
   // Poll once for incoming messages
   void pollOnce();
 
@@ -92,13 +198,52 @@ private:
   struct Subscriber
   {
     std::string topicName;
-    std::vector<std::string> publisherURLs;
+    std::vector<std::string> publisherURLs; // tcp://, ipc:// or shm://segment
     std::function<void(const ByteView &)> callback;
+    StreamCallback streamCallback;      // set for chunked stream subscriptions
+    RawMessageCallback messageCallback; // raw subscribers that keep the frame
+    bool everyMessage{false};           // no latest-only drain (streams, raw)
+    std::type_index localType{typeid(void)};
+    std::function<void(const std::shared_ptr<const void> &)> localCallback;
     ZMQSocket *socket;
+    std::shared_ptr<CompressionStats> decompressStats;
+    TopicMetrics *metrics{nullptr};
+    Bytes scratch;            // reusable decompression buffer
+    std::mutex dispatchMutex; // serializes the TCP poll thread and shm readers
+    SequenceTracker sequences; // loss accounting per publisher ID
+
+    // Declared last so reader threads stop before the state they use goes away
+    std::unordered_map<std::string, std::unique_ptr<ShmSubscription>> shmReaders;
   };
 
+  // Connect over shared memory or ipc:// when on the same host, TCP otherwise
+  void connectPublisher(Subscriber &sub, const SocketInfo &info);
+
+  // Returns the shm reader to destroy once mutex_ is released, if any
+  std::unique_ptr<ShmSubscription> disconnectPublisher(Subscriber &sub,
+                                                       const SocketInfo &info);
+
+  // Decode the envelope header, decompress if needed and invoke the callback.
+  // `received` is when the message was read off its socket or ring; `frame`
+  // holds `payload` when it was read off a socket.
+  void dispatch(Subscriber &sub, const ByteView &header, const ByteView &payload,
+                std::chrono::steady_clock::time_point received,
+                zmq::message_t *frame = nullptr);
+
+  // Decompress and hand a decoded message to the subscriber's callback
+  void deliver(Subscriber &sub, const MessageHeader &hdr, const ByteView &payload,
+               zmq::message_t *frame);
+
+  // Update per-publisher loss accounting, if the header carries a sequence
+  void trackSequence(Subscriber &sub, const ByteView &header);
+
 private:
-  std::vector<Subscriber> subscribers_;
+  ZMQContext &context_;
+  NodeInfoManager &nodeInfoManager_;
+
+  std::vector<std::unique_ptr<Subscriber>> subscribers_;
+  std::unordered_map<std::string, SocketOptions> socketOptions_; // per topic
+  ThreadOptions threadOptions_;
   std::mutex mutex_;
 
   std::thread thread_;
@@ -106,8 +251,14 @@ private:
 
   void run();
 
-  void _registerTopicSubscriber(const std::string &topicName,
-                                const std::function<void(const ByteView &)> &callback);
+  void _registerTopicSubscriber(
+      const std::string &topicName,
+      const std::function<void(const ByteView &)> &callback, std::type_index localType,
+      const std::function<void(const std::shared_ptr<const void> &)> &localCallback);
+
+  // Create the SUB socket, connect known publishers and store the subscriber
+  void addSubscriber(const std::string &topicName, std::unique_ptr<Subscriber> sub,
+                     int rcvhwm);
 };
 
 } // namespace zlc
@@ -1,6 +1,8 @@
 #pragma once
 #include <stdexcept>
 
+#include "zerolancom/utils/request_result.hpp"
+
 namespace zlc
 {
 
@@ -29,4 +31,23 @@ public:
   }
 };
 
+// Thrown by a service handler to answer with a specific status, e.g. a relay
+// passing on the status of the service it forwards to
+class ServiceStatusException : public std::runtime_error
+{
+public:
+  ServiceStatusException(ResponseStatus status, const std::string &msg)
+      : std::runtime_error(msg), status_(status)
+  {
+  }
+
+  ResponseStatus status() const
+  {
+    return status_;
+  }
+
+private:
+  ResponseStatus status_;
+};
+
 } // namespace zlc
\ No newline at end of file
@@ -1,8 +1,20 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <fmt/core.h>
 #include <spdlog/spdlog.h>
 #include <string>
 
+// Compile-time cutoff: calls below this level compile to nothing
+// (0 TRACE, 1 INFO, 2 WARN, 3 ERROR, 4 FATAL). CMake sets it from the cache
+// variable ZLC_LOG_LEVEL (cmake -DZLC_LOG_LEVEL=WARN); other builds define the
+// macro itself, e.g. -DZLC_LOG_ACTIVE_LEVEL=2, for the library and its users
+#ifndef ZLC_LOG_ACTIVE_LEVEL
+#define ZLC_LOG_ACTIVE_LEVEL 0
+#endif
+
 namespace zlc
 {
 
@@ -19,6 +31,31 @@ enum class LogLevel
   FATAL
 };
 
+constexpr bool logLevelActive(LogLevel lvl)
+{
+  return static_cast<int>(lvl) >= ZLC_LOG_ACTIVE_LEVEL;
+}
+
+// What the async logger does when its queue is full
+enum class LogOverflowPolicy
+{
+  BLOCK,      // the logging thread waits for room
+  DROP_OLDEST // the oldest queued message is overwritten
+};
+
+struct LoggerOptions
+{
+  // Format and write on a background thread ("zlc-log"); the caller only
+  // enqueues. Synchronous logging writes on the caller's thread.
+  bool async{true};
+  size_t queue_size{8192}; // messages
+  LogOverflowPolicy overflow{LogOverflowPolicy::BLOCK};
+
+  LogLevel level{LogLevel::INFO};
+  bool file_logging{false};
+  std::string log_dir{"logs"};
+};
+
 // =======================
 // Logger core
 // =======================
@@ -26,6 +63,7 @@ enum class LogLevel
 class Logger
 {
 public:
+  static void init(const LoggerOptions &options);
   static void init(bool enable_file_logging = false,
                    const std::string &log_dir = "logs");
 
@@ -35,9 +73,31 @@ public:
 
   static void setLevel(LogLevel lvl);
 
-private:
   static spdlog::level::level_enum toSpdLevel(LogLevel lvl);
-  static inline bool initialized_ = false;
+
+private:
+  static inline std::atomic<bool> initialized_{false};
+};
+
+/**
+ * @brief Lets one message through per interval and counts the rest.
+ *
+ * Use one per call site, typically a function-local static, with
+ * warnRateLimited() / errorRateLimited().
+ */
+class LogRateLimit
+{
+public:
+  explicit LogRateLimit(std::chrono::milliseconds interval = std::chrono::seconds(5));
+
+  // True if a message may be logged now; `suppressed` is set to the number of
+  // messages dropped since the last one that was let through
+  bool allow(uint64_t &suppressed);
+
+private:
+  const int64_t interval_ns_;
+  std::atomic<int64_t> next_ns_{0};
+  std::atomic<uint64_t> suppressed_{0};
 };
 
 // =======================
@@ -55,31 +115,47 @@ void fatal(const std::string &msg);
 // =======================
 
 template <typename... Args>
-inline void trace(fmt::format_string<Args...> fmt, Args &&...args)
+inline void trace([[maybe_unused]] fmt::format_string<Args...> fmt,
+                  [[maybe_unused]] Args &&...args)
 {
-  if (Logger::isInitialized())
-    spdlog::trace(fmt, std::forward<Args>(args)...);
+  if constexpr (logLevelActive(LogLevel::TRACE))
+  {
+    if (Logger::isInitialized())
+      spdlog::trace(fmt, std::forward<Args>(args)...);
+  }
 }
 
 template <typename... Args>
-inline void info(fmt::format_string<Args...> fmt, Args &&...args)
+inline void info([[maybe_unused]] fmt::format_string<Args...> fmt,
+                 [[maybe_unused]] Args &&...args)
 {
-  if (Logger::isInitialized())
-    spdlog::info(fmt, std::forward<Args>(args)...);
+  if constexpr (logLevelActive(LogLevel::INFO))
+  {
+    if (Logger::isInitialized())
+      spdlog::info(fmt, std::forward<Args>(args)...);
+  }
 }
 
 template <typename... Args>
-inline void warn(fmt::format_string<Args...> fmt, Args &&...args)
+inline void warn([[maybe_unused]] fmt::format_string<Args...> fmt,
+                 [[maybe_unused]] Args &&...args)
 {
-  if (Logger::isInitialized())
-    spdlog::warn(fmt, std::forward<Args>(args)...);
+  if constexpr (logLevelActive(LogLevel::WARN))
+  {
+    if (Logger::isInitialized())
+      spdlog::warn(fmt, std::forward<Args>(args)...);
+  }
 }
 
 template <typename... Args>
-inline void error(fmt::format_string<Args...> fmt, Args &&...args)
+inline void error([[maybe_unused]] fmt::format_string<Args...> fmt,
+                  [[maybe_unused]] Args &&...args)
 {
-  if (Logger::isInitialized())
-    spdlog::error(fmt, std::forward<Args>(args)...);
+  if constexpr (logLevelActive(LogLevel::ERROR))
+  {
+    if (Logger::isInitialized())
+      spdlog::error(fmt, std::forward<Args>(args)...);
+  }
 }
 
 template <typename... Args>
@@ -89,4 +165,46 @@ inline void fatal(fmt::format_string<Args...> fmt, Args &&...args)
     spdlog::critical(fmt, std::forward<Args>(args)...);
 }
 
+// =======================
+// Rate-limited helpers, for messages that may repeat per packet or request
+// =======================
+
+namespace detail
+{
+template <typename... Args>
+inline void logRateLimited(LogLevel lvl, LogRateLimit &limit,
+                           fmt::format_string<Args...> fmt, Args &&...args)
+{
+  const auto spd_lvl = Logger::toSpdLevel(lvl);
+  uint64_t suppressed = 0;
+  if (!Logger::isInitialized() || !spdlog::should_log(spd_lvl) ||
+      !limit.allow(suppressed))
+    return;
+
+  if (suppressed == 0)
+    spdlog::log(spd_lvl, fmt, std::forward<Args>(args)...);
+  else
+    spdlog::log(spd_lvl, "{} ({} similar messages suppressed)",
+                fmt::format(fmt, std::forward<Args>(args)...), suppressed);
+}
+} // namespace detail
+
+template <typename... Args>
+inline void warnRateLimited([[maybe_unused]] LogRateLimit &limit,
+                            [[maybe_unused]] fmt::format_string<Args...> fmt,
+                            [[maybe_unused]] Args &&...args)
+{
+  if constexpr (logLevelActive(LogLevel::WARN))
+    detail::logRateLimited(LogLevel::WARN, limit, fmt, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+inline void errorRateLimited([[maybe_unused]] LogRateLimit &limit,
+                             [[maybe_unused]] fmt::format_string<Args...> fmt,
+                             [[maybe_unused]] Args &&...args)
+{
+  if constexpr (logLevelActive(LogLevel::ERROR))
+    detail::logRateLimited(LogLevel::ERROR, limit, fmt, std::forward<Args>(args)...);
+}
+
 } // namespace zlc
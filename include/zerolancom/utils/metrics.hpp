@@ -0,0 +1,363 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <msgpack.hpp>
+
+namespace zlc
+{
+
+/* ================= Primitives ================= */
+
+/**
+ * @brief Monotonic counter; safe to bump from any thread without locking.
+ */
+class Counter
+{
+public:
+  void add(uint64_t n = 1)
+  {
+    value_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  uint64_t value() const
+  {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * @brief Value that can go up and down, such as the number of known nodes.
+ */
+class Gauge
+{
+public:
+  void set(int64_t value)
+  {
+    value_.store(value, std::memory_order_relaxed);
+  }
+
+  void add(int64_t n)
+  {
+    value_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  int64_t value() const
+  {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief Quantiles of a LatencyHistogram, in nanoseconds.
+ */
+struct LatencySummary
+{
+  uint64_t count{0};
+  uint64_t sum_ns{0};
+  uint64_t max_ns{0};
+  uint64_t p50_ns{0};
+  uint64_t p90_ns{0};
+  uint64_t p99_ns{0};
+  uint64_t p999_ns{0};
+
+  MSGPACK_DEFINE_MAP(count, sum_ns, max_ns, p50_ns, p90_ns, p99_ns, p999_ns)
+};
+
+/**
+ * @brief Log-bucketed latency histogram in the style of HdrHistogram.
+ *
+ * Every power of two is split into 8 linear sub-buckets, so a quantile is
+ * reported at most 12.5% above the true value over the full uint64 range.
+ * Recording is a handful of relaxed atomic operations and never allocates.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr unsigned SUB_BUCKET_BITS = 3;
+  static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+  static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  void record(uint64_t value_ns);
+
+  // Negative durations (clock skew between hosts) are recorded as 0
+  void record(std::chrono::nanoseconds elapsed)
+  {
+    auto ns = elapsed.count();
+    record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+  }
+
+  uint64_t count() const
+  {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t sum() const
+  {
+    return sum_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t max() const
+  {
+    return max_.load(std::memory_order_relaxed);
+  }
+
+  // Smallest bucket bound below which a fraction `q` of the samples fall
+  uint64_t quantile(double q) const;
+
+  LatencySummary summary() const;
+
+  uint64_t bucketCount(size_t index) const
+  {
+    return buckets_[index].load(std::memory_order_relaxed);
+  }
+
+  static size_t bucketIndex(uint64_t value);
+
+  // Largest value that lands in bucket `index`
+  static uint64_t bucketUpperBound(size_t index);
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+/* ================= Per-component metrics ================= */
+
+/**
+ * @brief Sequence accounting for one publisher of a topic, as seen by the
+ * subscribers in this process.
+ */
+struct PublisherSequenceMetrics
+{
+  Counter received;   // sequenced messages read off a ZMQ socket or shm ring
+  Counter gaps;       // sequence numbers skipped when a later message arrived
+  Counter reordered;  // arrived after a later message, filling a gap
+  Counter duplicated; // same sequence number seen twice
+  Gauge last_seen;    // steady_clock nanoseconds of the last message
+};
+
+/**
+ * @brief Counters for one topic, shared by its publishers and subscribers in
+ * this process.
+ *
+ * Design notes:
+ * - Publisher IDs are random per Publisher, so every restart of a publishing
+ *   node brings new ones. Per-publisher entries idle for longer than
+ *   PUBLISHER_IDLE_EXPIRY are folded into `other_publishers` when a new
+ *   publisher shows up, and at most MAX_PUBLISHERS entries are kept; messages
+ *   of publishers beyond that are counted in `other_publishers` as well.
+ */
+struct TopicMetrics
+{
+  static constexpr size_t MAX_PUBLISHERS = 64;
+  static constexpr std::chrono::minutes PUBLISHER_IDLE_EXPIRY{5};
+
+  Counter published;       // publish() calls
+  Counter published_bytes; // bytes handed to the network (after compression)
+  Counter received;        // messages delivered from the network or shm
+  Counter received_bytes;
+  Counter delivered_local; // messages handed over in-process (publishLocal)
+  Counter dropped;         // superseded by a newer message before delivery
+
+  // Traced messages only (PublisherOptions::trace), measured by subscribers
+  LatencyHistogram latency;          // publish() until the callback returns
+  LatencyHistogram encode_latency;   // publish() until handed to ZMQ
+  LatencyHistogram transit_latency;  // handed to ZMQ until read off the socket
+  LatencyHistogram drain_latency;    // read off the socket until dispatched
+  LatencyHistogram dispatch_latency; // decompression, decode and the callback
+
+  // Count one sequenced message in the entry of its publisher, created on
+  // first use; `now` is steady_clock time
+  void recordSequence(uint32_t publisher_id, uint64_t gap, bool late, bool duplicate,
+                      std::chrono::steady_clock::time_point now =
+                          std::chrono::steady_clock::now());
+
+  // Visit every per-publisher entry under a shared lock
+  template <typename Fn> void forEachPublisher(Fn fn) const
+  {
+    std::shared_lock lock(publishers_mutex_);
+    for (const auto &[id, metrics] : publishers_)
+    {
+      fn(id, *metrics);
+    }
+  }
+
+  // Expired publishers and those over MAX_PUBLISHERS, summed
+  const PublisherSequenceMetrics &otherPublishers() const
+  {
+    return other_publishers_;
+  }
+
+private:
+  mutable std::shared_mutex publishers_mutex_;
+  std::unordered_map<uint32_t, std::unique_ptr<PublisherSequenceMetrics>> publishers_;
+  PublisherSequenceMetrics other_publishers_;
+};
+
+/**
+ * @brief Counters for one service, as a server and as a client.
+ */
+struct ServiceMetrics
+{
+  Counter requests; // handled by this process
+  Counter failures; // handled with a non-SUCCESS status
+  Counter rejected; // answered OVERLOADED by admission control
+  LatencyHistogram handler_latency;
+
+  Counter calls; // issued by this process
+  Counter call_failures;
+  LatencyHistogram call_latency; // full round trip seen by the client
+};
+
+/**
+ * @brief Multicast discovery counters.
+ */
+struct DiscoveryMetrics
+{
+  Counter heartbeats_sent;
+  Counter heartbeats_received;
+  Counter heartbeat_errors; // undecodable datagrams
+  Counter node_fetches;     // get_node_info requests
+  Counter node_fetch_failures;
+  Counter nodes_added;
+  Counter nodes_removed;
+  Gauge nodes; // remote nodes currently known, summed over this process's nodes
+};
+
+/* ================= Snapshots ================= */
+
+struct PublisherSequenceSnapshot
+{
+  uint32_t publisher_id{0};
+  uint64_t received{0};
+  uint64_t lost{0}; // gaps not filled by late messages
+  uint64_t reordered{0};
+  uint64_t duplicated{0};
+
+  MSGPACK_DEFINE_MAP(publisher_id, received, lost, reordered, duplicated)
+};
+
+struct TopicMetricsSnapshot
+{
+  std::string name;
+  uint64_t published{0};
+  uint64_t published_bytes{0};
+  uint64_t received{0};
+  uint64_t received_bytes{0};
+  uint64_t delivered_local{0};
+  uint64_t dropped{0};
+  LatencySummary latency;
+  LatencySummary encode_latency;
+  LatencySummary transit_latency;
+  LatencySummary drain_latency;
+  LatencySummary dispatch_latency;
+  std::vector<PublisherSequenceSnapshot> publishers; // sequenced publishers only
+  PublisherSequenceSnapshot other_publishers; // expired or over the cap; no ID
+
+  MSGPACK_DEFINE_MAP(name, published, published_bytes, received, received_bytes,
+                     delivered_local, dropped, latency, encode_latency,
+                     transit_latency, drain_latency, dispatch_latency, publishers,
+                     other_publishers)
+};
+
+struct ServiceMetricsSnapshot
+{
+  std::string name;
+  uint64_t requests{0};
+  uint64_t failures{0};
+  LatencySummary handler_latency;
+  uint64_t calls{0};
+  uint64_t call_failures{0};
+  LatencySummary call_latency;
+  uint64_t rejected{0};
+
+  MSGPACK_DEFINE_MAP(name, requests, failures, handler_latency, calls, call_failures,
+                     call_latency, rejected)
+};
+
+struct DiscoveryMetricsSnapshot
+{
+  uint64_t heartbeats_sent{0};
+  uint64_t heartbeats_received{0};
+  uint64_t heartbeat_errors{0};
+  uint64_t node_fetches{0};
+  uint64_t node_fetch_failures{0};
+  uint64_t nodes_added{0};
+  uint64_t nodes_removed{0};
+  int64_t nodes{0};
+
+  MSGPACK_DEFINE_MAP(heartbeats_sent, heartbeats_received, heartbeat_errors,
+                     node_fetches, node_fetch_failures, nodes_added, nodes_removed,
+                     nodes)
+};
+
+/**
+ * @brief Point-in-time copy of every metric, as returned by `get_metrics`.
+ */
+struct MetricsSnapshot
+{
+  std::string node; // filled in by the node that answers get_metrics
+  std::vector<TopicMetricsSnapshot> topics;
+  std::vector<ServiceMetricsSnapshot> services;
+  DiscoveryMetricsSnapshot discovery;
+
+  MSGPACK_DEFINE_MAP(node, topics, services, discovery)
+};
+
+/* ================= Registry ================= */
+
+/**
+ * @brief Process-wide registry of topic, service and discovery metrics.
+ *
+ * Design notes:
+ * - Entries are created on first lookup and never removed, so components look
+ *   them up once and keep the reference; updates are then lock-free.
+ * - Lookups take a shared lock; only the first lookup of a name takes the
+ *   exclusive lock.
+ * - The registry outlives init()/shutdown(), so counters accumulate for the
+ *   lifetime of the process.
+ */
+class MetricsRegistry
+{
+public:
+  static MetricsRegistry &global();
+
+  TopicMetrics &topic(const std::string &name);
+  ServiceMetrics &service(const std::string &name);
+
+  DiscoveryMetrics &discovery()
+  {
+    return discovery_;
+  }
+
+  // Entries sorted by name
+  MetricsSnapshot snapshot() const;
+
+private:
+  MetricsRegistry() = default;
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, std::unique_ptr<TopicMetrics>> topics_;
+  std::unordered_map<std::string, std::unique_ptr<ServiceMetrics>> services_;
+  DiscoveryMetrics discovery_;
+};
+
+} // namespace zlc
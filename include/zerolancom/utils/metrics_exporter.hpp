@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/singleton.hpp"
+
+namespace zlc
+{
+
+enum class MetricsFormat
+{
+  PROMETHEUS_TEXT, // text format 0.0.4, as read by node_exporter's textfile collector
+  OPENMETRICS      // OpenMetrics 1.0 text
+};
+
+/**
+ * @brief Render a snapshot as Prometheus / OpenMetrics text.
+ *
+ * Every sample carries a `node` label. Latencies are exported as summaries in
+ * seconds with the p50/p90/p99/p999 quantiles.
+ */
+std::string formatMetrics(const MetricsSnapshot &snapshot,
+                          MetricsFormat format = MetricsFormat::OPENMETRICS);
+
+/**
+ * @brief Where MetricsExporter publishes metrics. Both outputs are off by default.
+ */
+struct MetricsExporterOptions
+{
+  // Serve GET /metrics over HTTP
+  bool serve_http{false};
+  std::string http_address{"127.0.0.1"};
+  uint16_t http_port{9464}; // 0 picks a free port (see MetricsExporter::httpPort)
+
+  // Rewrite this file atomically every `file_interval_ms` (empty disables)
+  std::string file_path;
+  int file_interval_ms{10000};
+};
+
+/**
+ * @brief Publishes the MetricsRegistry as text on a local HTTP port and/or a file.
+ *
+ * Design notes:
+ * - Runs on its own thread; snapshots only read the registry's atomics, so
+ *   publishers and services never wait on an export.
+ * - The HTTP endpoint answers one request per connection, which is all
+ *   Prometheus scrapers need. The format follows the Accept header.
+ * - Files are written to `<path>.tmp` and renamed, as the textfile collector
+ *   expects.
+ */
+class MetricsExporter : public Singleton<MetricsExporter>
+{
+public:
+  MetricsExporter(const std::string &node_name, const MetricsExporterOptions &options);
+  ~MetricsExporter();
+
+  void start();
+  void stop();
+
+  // Bound HTTP port, or 0 when HTTP is disabled or the bind failed
+  uint16_t httpPort() const
+  {
+    return http_port_;
+  }
+
+  // Write the metrics file now; returns false on I/O errors
+  bool writeFile() const;
+
+private:
+  void run();
+  void serveClient(int fd) const;
+  MetricsSnapshot snapshot() const;
+
+  std::string node_name_;
+  MetricsExporterOptions options_;
+  int listen_fd_{-1};
+  uint16_t http_port_{0};
+
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+};
+
+} // namespace zlc
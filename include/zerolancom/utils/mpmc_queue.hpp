@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace zlc
+{
+
+/**
+ * @brief Bounded lock-free multi-producer/multi-consumer queue.
+ *
+ * Design notes:
+ * - Dmitry Vyukov's array queue: every cell carries a sequence number that
+ *   tells producers and consumers whose turn it is, so a push or pop is one
+ *   CAS on the shared position plus a release store on the cell.
+ * - Capacity is rounded up to a power of two.
+ * - tryPush()/tryPop() never block; callers decide whether to retry, wait or
+ *   drop.
+ */
+template <typename T> class MpmcQueue
+{
+public:
+  explicit MpmcQueue(size_t capacity)
+  {
+    size_t size = 2;
+    while (size < capacity)
+    {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_ = std::make_unique<Cell[]>(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue &) = delete;
+  MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+  size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+  // False when the queue is full; `value` is left untouched then
+  bool tryPush(T &&value)
+  {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      Cell &cell = cells_[pos & mask_];
+      const size_t seq = cell.sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0)
+      {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          cell.value = std::move(value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false; // full
+      }
+      else
+      {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // False when the queue is empty
+  bool tryPop(T &value)
+  {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      Cell &cell = cells_[pos & mask_];
+      const size_t seq = cell.sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0)
+      {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          value = std::move(cell.value);
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false; // empty
+      }
+      else
+      {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence{0};
+    T value{};
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_{0};
+
+  // On separate cache lines, so producers and the consumer do not contend
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+} // namespace zlc
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "zerolancom/utils/zmq_utils.hpp"
+
+namespace zlc
+{
+
+/**
+ * @brief An IPv4 address of this host and the subnet it is on.
+ */
+struct NetworkInterface
+{
+  std::string name; // e.g. "eth0"; empty if the address is not on any interface
+  std::string ip;
+  uint32_t netmask{DEFAULT_SUBNET_MASK}; // host byte order
+
+  // Whether `peer_ip` is on this interface's subnet
+  bool contains(const std::string &peer_ip) const
+  {
+    return isInSameSubnet(ip, peer_ip, netmask);
+  }
+
+  // Prefix length of the netmask, e.g. 24 for 255.255.255.0
+  int prefixLength() const;
+};
+
+// IPv4 addresses of the interfaces that are up (getifaddrs)
+std::vector<NetworkInterface> listNetworkInterfaces();
+
+/**
+ * @brief Resolve an interface spec: an IP address or an interface name,
+ * optionally followed by "/prefix" to override the subnet mask.
+ *
+ * Examples: "eth1", "192.168.1.5", "10.0.0.5/16". Without a prefix the mask
+ * is the interface's own; an IP that is on no interface gets /24.
+ *
+ * @return std::nullopt for an unknown interface name or an invalid prefix
+ */
+std::optional<NetworkInterface> resolveNetworkInterface(const std::string &spec);
+
+} // namespace zlc
@@ -3,45 +3,47 @@
 #include <string>
 #include <vector>
 
+#include "zerolancom/serialization/binary_codec.hpp"
+
 namespace zlc
 {
 
-namespace ResponseStatus
+// Status codes travel as a single byte in the first response frame
+enum class ResponseStatus : uint8_t
 {
-using namespace std::string_view_literals;
-
-constexpr std::string_view SUCCESS = "SUCCESS"sv;
-constexpr std::string_view NOSERVICE = "NOSERVICE"sv;
-constexpr std::string_view INVALID_RESPONSE = "INVALID_RESPONSE"sv;
-constexpr std::string_view SERVICE_FAIL = "SERVICE_FAIL"sv;
-constexpr std::string_view SERVICE_TIMEOUT = "SERVICE_TIMEOUT"sv;
-constexpr std::string_view INVALID_REQUEST = "INVALID_REQUEST"sv;
-constexpr std::string_view UNKNOWN_ERROR = "UNKNOWN_ERROR"sv;
-
-// Helper to validate incoming status strings
-inline bool is_error(std::string_view status)
+  SUCCESS = 0,
+  NOSERVICE = 1,
+  INVALID_RESPONSE = 2,
+  SERVICE_FAIL = 3,
+  SERVICE_TIMEOUT = 4,
+  INVALID_REQUEST = 5,
+  UNKNOWN_ERROR = 6,
+  OVERLOADED = 7, // rejected by admission control; retry later or elsewhere
+};
+
+// Helper to validate incoming status codes
+inline bool is_error(ResponseStatus status)
 {
-  return status != SUCCESS;
+  return status != ResponseStatus::SUCCESS;
 }
-} // namespace ResponseStatus
 
 class Response
 {
 public:
-  // flag indicates payload contains a detail string
+  // flag indicates a detail frame follows the header frame
   static constexpr uint8_t FLAG_HAS_DETAIL = 0x01;
 
   Response() = default;
-  explicit Response(std::string code, Bytes payload = {})
-      : code(std::move(code)), payload(std::move(payload))
+  explicit Response(ResponseStatus code) : code(code)
   {
   }
 
   // Human-readable short description for the code
-  static const char *description(const std::string &code);
+  static const char *description(ResponseStatus code);
 
-  std::string code{std::string(ResponseStatus::SUCCESS)};
-  Bytes payload;
+  ResponseStatus code{ResponseStatus::SUCCESS};
+  std::string detail; // optional error detail, sent only when non-empty
+  ByteBuffer payload; // handed to ZMQ without copying
 };
 
 } // namespace zlc
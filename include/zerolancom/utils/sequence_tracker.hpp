@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace zlc
+{
+
+/**
+ * @brief Classifies sequenced messages per publisher as in order, after a gap,
+ * late (reordered) or duplicated.
+ *
+ * Design notes:
+ * - Keeps the highest sequence number seen per publisher ID plus a 64-bit
+ *   window of the numbers just below it; a message within the window is
+ *   either late (its number was counted as a gap before) or a duplicate.
+ * - Messages older than the window are reported as late.
+ * - The first message of a publisher starts its sequence; anything it sent
+ *   before we subscribed is not a loss.
+ * - Publisher IDs change whenever a publisher is recreated, so at most
+ *   MAX_PUBLISHERS are tracked; a new one evicts the one heard from least
+ *   recently, which starts a new sequence if it comes back.
+ * - Not thread-safe; SubscriberManager calls it under the dispatch mutex.
+ */
+class SequenceTracker
+{
+public:
+  static constexpr uint64_t WINDOW = 64;
+  static constexpr size_t MAX_PUBLISHERS = 64;
+
+  struct Event
+  {
+    uint64_t gap{0};   // sequence numbers skipped before this message
+    bool late{false};  // arrived after a later message (fills an earlier gap)
+    bool duplicate{false};
+  };
+
+  Event observe(uint32_t publisher_id, uint64_t seq);
+
+  size_t publisherCount() const
+  {
+    return publishers_.size();
+  }
+
+private:
+  struct State
+  {
+    uint64_t last{0};   // highest sequence number seen
+    uint64_t window{0}; // bit i set: message last - i was seen
+    uint64_t seen{0};   // observe() call count when last seen
+  };
+
+  std::unordered_map<uint32_t, State> publishers_;
+  uint64_t observed_{0};
+};
+
+} // namespace zlc
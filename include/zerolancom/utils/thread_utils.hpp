@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace zlc
+{
+
+/**
+ * @brief Placement and scheduling of one internal thread.
+ */
+struct ThreadOptions
+{
+  // CPUs the thread may run on; empty leaves it unpinned
+  std::vector<int> cpus;
+
+  // SCHED_FIFO priority (1-99); 0 keeps the default scheduler. Needs
+  // CAP_SYS_NICE or an rtprio limit (ulimit -r).
+  int fifo_priority{0};
+};
+
+/**
+ * @brief Thread settings of a node's internal threads.
+ *
+ * ZMQ's own I/O threads are configured in ZMQOptions.
+ */
+struct NodeThreadOptions
+{
+  ThreadOptions multicast_sender;   // heartbeats, "zlc-mc-send"
+  ThreadOptions multicast_receiver; // discovery, "zlc-mc-recv"
+  ThreadOptions unicast_discovery;  // unicast heartbeats, "zlc-uc-disc"
+  ThreadOptions service;            // service handlers, "zlc-service"
+  ThreadOptions subscriber;         // callbacks, "zlc-sub" and "zlc-shm-read"
+};
+
+/**
+ * @brief Name the calling thread and apply `options` to it.
+ *
+ * The name shows up in top, htop, perf and gdb; Linux truncates it to 15
+ * characters. Failures (e.g. no permission for SCHED_FIFO) are logged and the
+ * thread keeps running with its previous settings.
+ */
+void configureCurrentThread(const std::string &name, const ThreadOptions &options = {});
+
+} // namespace zlc
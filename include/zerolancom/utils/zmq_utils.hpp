@@ -1,9 +1,13 @@
 #pragma once
-#include "zerolancom/utils/singleton.hpp"
+#include "zerolancom/utils/logger.hpp"
 #include <arpa/inet.h>
 #include <cstdint>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <sched.h>
 #include <string>
+#include <vector>
 #include <zmq.hpp>
 
 namespace zlc
@@ -37,23 +41,177 @@ inline bool isInSameSubnet(const std::string &ip1, const std::string &ip2,
 
 using ZMQSocket = zmq::socket_t;
 
-class ZMQContext : public Singleton<ZMQContext>
+/**
+ * @brief ZMQ socket options; unset fields keep the ZMQ/OS default.
+ *
+ * Set node-wide in ZMQOptions::socket and overridden per topic (see
+ * PublisherOptions::socket and SubscriberManager::setSocketOptions). Options
+ * take effect for connections made after they are applied.
+ */
+struct SocketOptions
+{
+  std::optional<int> sndhwm;     // ZMQ_SNDHWM, in messages (ZMQ default 1000)
+  std::optional<int> rcvhwm;     // ZMQ_RCVHWM, in messages (ZMQ default 1000)
+  std::optional<int> sndbuf;     // ZMQ_SNDBUF, kernel buffer in bytes
+  std::optional<int> rcvbuf;     // ZMQ_RCVBUF, kernel buffer in bytes
+  std::optional<int> linger_ms;  // ZMQ_LINGER on close; -1 waits forever
+  std::optional<bool> immediate; // ZMQ_IMMEDIATE: queue only on live connections
+
+  // TCP keepalive: ZMQ_TCP_KEEPALIVE and its idle/interval (s) and probe count
+  std::optional<bool> tcp_keepalive;
+  std::optional<int> tcp_keepalive_idle_s;
+  std::optional<int> tcp_keepalive_intvl_s;
+  std::optional<int> tcp_keepalive_cnt;
+
+  // Options set in `overrides` win over this object's
+  SocketOptions merged(const SocketOptions &overrides) const
+  {
+    SocketOptions out = *this;
+    auto take = [](auto &dst, const auto &src)
+    {
+      if (src)
+        dst = src;
+    };
+    take(out.sndhwm, overrides.sndhwm);
+    take(out.rcvhwm, overrides.rcvhwm);
+    take(out.sndbuf, overrides.sndbuf);
+    take(out.rcvbuf, overrides.rcvbuf);
+    take(out.linger_ms, overrides.linger_ms);
+    take(out.immediate, overrides.immediate);
+    take(out.tcp_keepalive, overrides.tcp_keepalive);
+    take(out.tcp_keepalive_idle_s, overrides.tcp_keepalive_idle_s);
+    take(out.tcp_keepalive_intvl_s, overrides.tcp_keepalive_intvl_s);
+    take(out.tcp_keepalive_cnt, overrides.tcp_keepalive_cnt);
+    return out;
+  }
+};
+
+/**
+ * @brief Apply the set fields of `options` to `socket`.
+ *
+ * Invalid values are logged and skipped; the socket keeps its default.
+ */
+inline void applySocketOptions(ZMQSocket &socket, const SocketOptions &options)
+{
+  auto apply = [&socket](const char *name, auto opt, const auto &value)
+  {
+    if (!value)
+      return;
+    try
+    {
+      socket.set(opt, static_cast<int>(*value));
+    }
+    catch (const zmq::error_t &e)
+    {
+      zlc::warn("[ZMQ] Cannot set {} to {}: {}", name, static_cast<int>(*value),
+                e.what());
+    }
+  };
+  apply("ZMQ_SNDHWM", zmq::sockopt::sndhwm, options.sndhwm);
+  apply("ZMQ_RCVHWM", zmq::sockopt::rcvhwm, options.rcvhwm);
+  apply("ZMQ_SNDBUF", zmq::sockopt::sndbuf, options.sndbuf);
+  apply("ZMQ_RCVBUF", zmq::sockopt::rcvbuf, options.rcvbuf);
+  apply("ZMQ_LINGER", zmq::sockopt::linger, options.linger_ms);
+  apply("ZMQ_IMMEDIATE", zmq::sockopt::immediate, options.immediate);
+  apply("ZMQ_TCP_KEEPALIVE", zmq::sockopt::tcp_keepalive, options.tcp_keepalive);
+  apply("ZMQ_TCP_KEEPALIVE_IDLE", zmq::sockopt::tcp_keepalive_idle,
+        options.tcp_keepalive_idle_s);
+  apply("ZMQ_TCP_KEEPALIVE_INTVL", zmq::sockopt::tcp_keepalive_intvl,
+        options.tcp_keepalive_intvl_s);
+  apply("ZMQ_TCP_KEEPALIVE_CNT", zmq::sockopt::tcp_keepalive_cnt,
+        options.tcp_keepalive_cnt);
+}
+
+/**
+ * @brief Settings of a node's ZMQ context.
+ */
+struct ZMQOptions
+{
+  // Background I/O threads; one thread handles roughly 1 Gbps
+  int io_threads{1};
+
+  // CPUs the I/O threads may run on (ZMQ_THREAD_AFFINITY_CPU_ADD); empty
+  // leaves them unpinned
+  std::vector<int> io_thread_cpus;
+
+  // SCHED_FIFO priority of the I/O threads (ZMQ_THREAD_SCHED_POLICY and
+  // ZMQ_THREAD_PRIORITY); 0 keeps the default scheduler
+  int io_thread_fifo_priority{0};
+
+  // Defaults for every socket of the node
+  SocketOptions socket;
+};
+
+/**
+ * @brief ZMQ context of one node, plus the long-lived sockets created on it.
+ *
+ * Sockets from createSocket() live until the context is destroyed;
+ * createTempSocket() hands ownership to the caller. Both get the node-wide
+ * ZMQOptions::socket defaults, merged with the per-socket overrides.
+ */
+class ZMQContext
 {
 public:
-  ZMQContext() : context_(1)
+  explicit ZMQContext(const ZMQOptions &options = {}) : socketDefaults_(options.socket)
   {
+    // Context options only take effect before the first socket is created
+    int io_threads = options.io_threads;
+    if (io_threads < 1)
+    {
+      zlc::warn("[ZMQ] Invalid io_threads {}, using 1", io_threads);
+      io_threads = 1;
+    }
+    context_.set(zmq::ctxopt::io_threads, io_threads);
+
+    for (int cpu : options.io_thread_cpus)
+    {
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+      if (zmq_ctx_set(context_.handle(), ZMQ_THREAD_AFFINITY_CPU_ADD, cpu) != 0)
+      {
+        zlc::warn("[ZMQ] Cannot pin I/O threads to CPU {}", cpu);
+      }
+#else
+      zlc::warn("[ZMQ] libzmq lacks ZMQ_THREAD_AFFINITY_CPU_ADD, CPU {} ignored", cpu);
+#endif
+    }
+
+    if (options.io_thread_fifo_priority > 0)
+    {
+      // libzmq applies these when it starts the threads and only logs failures
+      void *handle = context_.handle();
+      const int priority = options.io_thread_fifo_priority;
+      if (zmq_ctx_set(handle, ZMQ_THREAD_SCHED_POLICY, SCHED_FIFO) != 0 ||
+          zmq_ctx_set(handle, ZMQ_THREAD_PRIORITY, priority) != 0)
+      {
+        zlc::warn("[ZMQ] Cannot set SCHED_FIFO priority {} for I/O threads",
+                  priority);
+      }
+    }
   }
-  static ZMQSocket *createSocket(zmq::socket_type type)
+
+  ZMQContext(const ZMQContext &) = delete;
+  ZMQContext &operator=(const ZMQContext &) = delete;
+
+  ZMQSocket *createSocket(zmq::socket_type type, const SocketOptions &overrides = {})
   {
-    assert(instance_ != nullptr);
-    return instance_->_createSocket(type);
+    std::lock_guard<std::mutex> lock(mutex_);
+    sockets_.emplace_back(std::make_unique<ZMQSocket>(context_, type));
+    applySocketOptions(*sockets_.back(), socketDefaults_.merged(overrides));
+    return sockets_.back().get();
+  }
+
+  ZMQSocket createTempSocket(zmq::socket_type type, const SocketOptions &overrides = {})
+  {
+    ZMQSocket socket(context_, type);
+    applySocketOptions(socket, socketDefaults_.merged(overrides));
+    return socket;
   }
 
-  static ZMQSocket createTempSocket(zmq::socket_type type)
+  const SocketOptions &socketDefaults() const
   {
-    assert(instance_ != nullptr);
-    return ZMQSocket(instance_->context_, type);
+    return socketDefaults_;
   }
+
   ~ZMQContext()
   {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -65,13 +223,7 @@ public:
   }
 
 private:
-  ZMQSocket *_createSocket(zmq::socket_type type)
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    sockets_.emplace_back(std::make_unique<ZMQSocket>(context_, type));
-    return sockets_.back().get();
-  }
-
+  const SocketOptions socketDefaults_;
   std::mutex mutex_;
   zmq::context_t context_;
   std::vector<std::unique_ptr<ZMQSocket>> sockets_;
@@ -91,4 +243,27 @@ inline int getBoundPort(ZMQSocket &socket)
   return std::stoi(endpoint.substr(pos + 1));
 }
 
-} // namespace zlc
\ No newline at end of file
+/**
+ * @brief Bind an additional ipc:// endpoint for peers on the same host.
+ *
+ * Call after getBoundPort(), which reads the last bound endpoint. ZMQ picks a
+ * unique socket file and removes it when the socket closes.
+ *
+ * @return the bound endpoint, or an empty string if IPC is unavailable
+ */
+inline std::string bindIpcEndpoint(ZMQSocket &socket)
+{
+  try
+  {
+    socket.bind("ipc://*");
+    return socket.get(zmq::sockopt::last_endpoint);
+  }
+  catch (const zmq::error_t &e)
+  {
+    zlc::warn("[ZMQ] Cannot bind an ipc endpoint, same-host peers use TCP: {}",
+              e.what());
+    return {};
+  }
+}
+
+} // namespace zlc
@@ -1,15 +1,22 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <string>
+#include <vector>
 
 // Core headers
 #include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/nodes/zerolancom_node.hpp"
 #include "zerolancom/sockets/client.hpp"
+#include "zerolancom/sockets/load_balancer.hpp"
 #include "zerolancom/sockets/publisher.hpp"
 #include "zerolancom/sockets/service_manager.hpp"
+#include "zerolancom/sockets/stream_publisher.hpp"
 #include "zerolancom/sockets/subscriber_manager.hpp"
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/metrics_exporter.hpp"
 
 namespace zlc
 {
@@ -18,71 +25,173 @@ namespace zlc
 // Non-template API (cpp)
 // =======================
 
+/**
+ * @brief Create the default node, which the free functions in this header act
+ * on. For several nodes in one process, construct ZeroLanComNode objects and
+ * use their member functions.
+ */
 void init(const std::string &node_name, const std::string &ip_address,
           const std::string &group = "224.0.0.1", int groupPort = 7720,
           const std::string &groupName = "zlc_default_group_name");
+void init(const std::string &node_name, const std::string &ip_address,
+          const NodeOptions &options);
 void shutdown();
 void sleep(int ms);
 void spin();
 
 /**
  * @brief Block until the service becomes available or timeout expires.
+ *
+ * Woken by discovery rather than polling.
+ * @return false (logged) on timeout.
+ */
+bool waitForService(const std::string &service_name, int max_wait_ms = 1000);
+
+/**
+ * @deprecated `check_interval_ms` has no effect since the wait stopped
+ * polling; use the two-argument overload. Will be removed.
+ */
+[[deprecated("check_interval_ms has no effect; call waitForService(name, "
+             "max_wait_ms)")]] bool
+waitForService(const std::string &service_name, int max_wait_ms,
+               int check_interval_ms);
+
+/**
+ * @brief Block until a publisher of the topic is known or timeout expires.
+ */
+bool waitForTopic(const std::string &topic_name, int max_wait_ms = 1000);
+
+/**
+ * @brief Block until every service is available or `deadline` passes.
+ * @return false (logged with the missing services) on timeout.
+ */
+bool waitForAll(const std::vector<std::string> &service_names,
+                std::chrono::steady_clock::time_point deadline);
+
+/**
+ * @brief Compress responses of a local service (see CompressionConfig).
+ */
+void setServiceCompression(const std::string &service_name,
+                           const CompressionConfig &config);
+
+/**
+ * @brief Admission control for a local service: requests beyond
+ * `limits.max_concurrency` running and `limits.max_queue` waiting are answered
+ * with ResponseStatus::OVERLOADED (see ServiceLimits).
+ */
+bool setServiceLimits(const std::string &service_name, const ServiceLimits &limits);
+
+/**
+ * @brief How zlc::request() spreads calls to a service over its providers
+ * (see LoadBalancerOptions).
+ */
+void setLoadBalancing(const std::string &service_name,
+                      const LoadBalancerOptions &options);
+
+/**
+ * @brief Receive every message of a topic as encoded bytes, without decoding.
+ */
+void registerRawSubscriber(const std::string &topic_name, const RawCallback &callback);
+
+/**
+ * @brief Same, handing over each received frame so it can be kept without a
+ * copy (see RawMessageCallback).
  */
-void waitForService(const std::string &service_name, int max_wait_ms = 1000,
-                    int check_interval_ms = 10);
+void registerRawSubscriber(const std::string &topic_name,
+                           const RawMessageCallback &callback);
+
+/**
+ * @brief ZMQ socket options (HWM, buffers, keepalive, ...) for subscriptions to
+ * a topic, merged over the node defaults. Call before registering the handler.
+ */
+void setSubscriberSocketOptions(const std::string &topic_name,
+                                const SocketOptions &options);
+
+/**
+ * @brief Snapshot of this process's topic, service and discovery metrics.
+ */
+MetricsSnapshot getMetrics();
+
+/**
+ * @brief Fetch the metrics of another node through its `<node>/get_metrics`
+ * service.
+ */
+ResponseStatus requestMetrics(const std::string &node_name, MetricsSnapshot &metrics);
+
+/**
+ * @brief Export this process's metrics as Prometheus/OpenMetrics text over HTTP
+ * and/or to a file (see MetricsExporterOptions). Stopped by shutdown().
+ */
+void startMetricsExporter(const MetricsExporterOptions &options);
+void stopMetricsExporter();
+
+/**
+ * @brief Receive every chunk published by a StreamPublisher on a topic.
+ */
+void registerStreamSubscriber(const std::string &name, const StreamCallback &callback,
+                              int window = DEFAULT_STREAM_WINDOW);
 
 template <typename HandlerT>
 void registerServiceHandler(const std::string &service_name, HandlerT handler)
 {
-  auto &nodeInfoManager = NodeInfoManager::instance();
-  auto &serviceManager = ServiceManager::instance();
-
-  serviceManager.registerHandler(service_name, std::function(handler));
-  nodeInfoManager.registerLocalService(service_name, serviceManager.service_port);
-
-  zlc::info("Service {} registered at port {}", service_name,
-            serviceManager.service_port);
+  ZeroLanComNode::instance().registerServiceHandler(service_name, handler);
 }
 
 template <typename HandlerT, typename ClassT>
 void registerServiceHandler(const std::string &service_name, HandlerT handler,
                             ClassT *instance)
 {
-  auto &serviceManager = ServiceManager::instance();
-
-  serviceManager.registerHandler(service_name, handler, instance);
+  ZeroLanComNode::instance().registerServiceHandler(service_name, handler, instance);
+}
 
-  uint16_t port = serviceManager.service_port;
-  NodeInfoManager::instance().registerLocalService(service_name, port);
+/**
+ * @brief Register a chunked service handler for large responses.
+ *
+ * Handler signature: `uint64_t handler(const RequestType &, uint64_t offset,
+ * size_t max_len, Bytes &chunk)` returning the total blob size.
+ */
+template <typename HandlerT>
+void registerStreamServiceHandler(const std::string &service_name, HandlerT handler)
+{
+  ZeroLanComNode::instance().registerStreamServiceHandler(service_name, handler);
 }
 
 template <typename HandlerT>
 void registerSubscriberHandler(const std::string &name, HandlerT callback)
 {
-  auto &subscriberManager = SubscriberManager::instance();
-  subscriberManager.registerTopicSubscriber(name, callback);
+  ZeroLanComNode::instance().registerSubscriberHandler(name, callback);
 }
 
 template <typename HandlerT, typename ClassT>
 void registerSubscriberHandler(const std::string &name, HandlerT callback,
                                ClassT *instance)
 {
-  auto &subscriberManager = SubscriberManager::instance();
-  subscriberManager.registerTopicSubscriber(name, callback, instance);
+  ZeroLanComNode::instance().registerSubscriberHandler(name, callback, instance);
 }
 
 template <typename RequestType, typename ResponseType>
-void request(const std::string &service_name, const RequestType &req, ResponseType &res)
+ResponseStatus request(const std::string &service_name, const RequestType &req,
+                       ResponseType &res)
+{
+  return ZeroLanComNode::instance().request<RequestType, ResponseType>(service_name,
+                                                                       req, res);
+}
+
+template <typename RequestType>
+ResponseStatus requestStream(const std::string &service_name, const RequestType &req,
+                             const StreamCallback &callback,
+                             uint32_t chunk_size = DEFAULT_STREAM_CHUNK_SIZE,
+                             int chunk_timeout_ms = DEFAULT_STREAM_CHUNK_TIMEOUT_MS)
 {
-  waitForService(service_name);
-  Client::zlcRequest<RequestType, ResponseType>(service_name, req, res);
+  return ZeroLanComNode::instance().requestStream<RequestType>(
+      service_name, req, callback, chunk_size, chunk_timeout_ms);
 }
 
 template <typename RequestType>
-void request(const std::string &service_name, const RequestType &req, Empty &)
+ResponseStatus request(const std::string &service_name, const RequestType &req, Empty &)
 {
   Empty zlc_empty;
-  request<RequestType, Empty>(service_name, req, zlc_empty);
+  return request<RequestType, Empty>(service_name, req, zlc_empty);
 }
 
 } // namespace zlc
@@ -0,0 +1,461 @@
+#include "zerolancom/bag/bag_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+// Update [start, end] and the count of a topic or chunk with one timestamp
+template <typename T> void addMessage(T &stats, uint64_t timestamp_ns)
+{
+  if (stats.message_count == 0 || timestamp_ns < stats.start_ns)
+  {
+    stats.start_ns = timestamp_ns;
+  }
+  stats.end_ns = std::max(stats.end_ns, timestamp_ns);
+  ++stats.message_count;
+}
+} // namespace
+
+std::unique_ptr<BagReader> BagReader::open(const std::string &path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    zlc::warn("[BagReader] Cannot open {}: {}", path, std::strerror(errno));
+    return nullptr;
+  }
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < BAG_FILE_HEADER_SIZE)
+  {
+    zlc::warn("[BagReader] {} is not a recording", path);
+    ::close(fd);
+    return nullptr;
+  }
+
+  const auto size = static_cast<size_t>(st.st_size);
+  void *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // the mapping keeps the file open
+  if (map == MAP_FAILED)
+  {
+    zlc::warn("[BagReader] Cannot map {}: {}", path, std::strerror(errno));
+    return nullptr;
+  }
+
+  std::unique_ptr<BagReader> reader(
+      new BagReader(static_cast<const uint8_t *>(map), size));
+
+  BagFileHeader header;
+  std::memcpy(&header, reader->map_, sizeof(header));
+  if (std::memcmp(header.magic, BAG_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version == 0 || header.version > BAG_VERSION)
+  {
+    zlc::warn("[BagReader] {} is not a recording", path);
+    return nullptr;
+  }
+
+  reader->indexed_ = header.version >= 2 && reader->readSummary();
+  if (!reader->indexed_)
+  {
+    zlc::info("[BagReader] {} has no summary, scanning it", path);
+    reader->chunks_.clear();
+    reader->topics_.clear();
+    reader->scan();
+  }
+  return reader;
+}
+
+BagReader::BagReader(const uint8_t *map, size_t size) : map_(map), size_(size)
+{
+}
+
+BagReader::~BagReader()
+{
+  ::munmap(const_cast<uint8_t *>(map_), size_);
+}
+
+bool BagReader::readSummary()
+{
+  if (size_ < BAG_FILE_HEADER_SIZE + sizeof(BagFooter))
+  {
+    return false;
+  }
+  BagFooter footer;
+  std::memcpy(&footer, map_ + size_ - sizeof(footer), sizeof(footer));
+  const uint64_t summary_end = size_ - sizeof(footer);
+  if (footer.magic != BAG_FOOTER_MAGIC ||
+      footer.summary_offset < BAG_FILE_HEADER_SIZE ||
+      footer.summary_offset + sizeof(BagSummaryHeader) > summary_end)
+  {
+    return false;
+  }
+
+  const uint8_t *pos = map_ + footer.summary_offset;
+  const uint8_t *end = map_ + summary_end;
+  BagSummaryHeader header;
+  std::memcpy(&header, pos, sizeof(header));
+  pos += sizeof(header);
+
+  // Counts come from the file; bound them before multiplying
+  const auto remaining = [&pos, end]() { return static_cast<uint64_t>(end - pos); };
+  if (header.chunk_count > remaining() / sizeof(BagSummaryChunk))
+  {
+    return false;
+  }
+
+  // Chunks live between the file header and the summary
+  for (uint64_t i = 0; i < header.chunk_count; ++i)
+  {
+    BagSummaryChunk info;
+    std::memcpy(&info, pos, sizeof(info));
+    pos += sizeof(info);
+
+    if (info.offset < BAG_FILE_HEADER_SIZE ||
+        info.offset + sizeof(BagChunkHeader) > footer.summary_offset)
+    {
+      return false;
+    }
+    const auto *chunk_header =
+        reinterpret_cast<const BagChunkHeader *>(map_ + info.offset);
+    const uint64_t data_offset = info.offset + sizeof(BagChunkHeader);
+    if (chunk_header->magic != BAG_CHUNK_MAGIC ||
+        chunk_header->data_size > footer.summary_offset - data_offset ||
+        info.index_offset % alignof(BagIndexEntry) != 0 ||
+        info.index_offset < data_offset || info.index_offset > footer.summary_offset ||
+        info.index_count > (footer.summary_offset - info.index_offset) /
+                               sizeof(BagIndexEntry))
+    {
+      return false;
+    }
+
+    Chunk chunk;
+    chunk.data = map_ + data_offset;
+    chunk.data_size = chunk_header->data_size;
+    chunk.start_ns = info.start_ns;
+    chunk.end_ns = info.end_ns;
+    chunk.message_count = info.message_count;
+    chunk.index = reinterpret_cast<const BagIndexEntry *>(map_ + info.index_offset);
+    chunk.index_count = info.index_count;
+    chunks_.push_back(std::move(chunk));
+  }
+
+  if (header.chunk_topic_count > remaining() / sizeof(BagSummaryChunkTopic))
+  {
+    return false;
+  }
+  for (uint64_t i = 0; i < header.chunk_topic_count; ++i)
+  {
+    BagSummaryChunkTopic info;
+    std::memcpy(&info, pos, sizeof(info));
+    pos += sizeof(info);
+    if (info.chunk >= chunks_.size())
+    {
+      return false;
+    }
+    chunks_[info.chunk].topics.push_back(info.topic_id);
+  }
+
+  for (uint32_t i = 0; i < header.topic_count; ++i)
+  {
+    BagSummaryTopic info;
+    if (remaining() < sizeof(info))
+    {
+      return false;
+    }
+    std::memcpy(&info, pos, sizeof(info));
+    pos += sizeof(info);
+    if (remaining() < bagPadded(info.name_size))
+    {
+      return false;
+    }
+
+    if (topics_.size() <= info.topic_id)
+    {
+      topics_.resize(info.topic_id + 1);
+    }
+    BagTopicInfo &topic = topics_[info.topic_id];
+    topic.name.assign(reinterpret_cast<const char *>(pos), info.name_size);
+    topic.message_count = info.message_count;
+    topic.start_ns = info.start_ns;
+    topic.end_ns = info.end_ns;
+    pos += bagPadded(info.name_size);
+  }
+
+  message_count_ = header.message_count;
+  start_ns_ = header.start_ns;
+  end_ns_ = header.end_ns;
+  return true;
+}
+
+void BagReader::scan()
+{
+  uint64_t offset = BAG_FILE_HEADER_SIZE;
+  while (offset + sizeof(BagChunkHeader) <= size_)
+  {
+    const auto *header = reinterpret_cast<const BagChunkHeader *>(map_ + offset);
+    if (header->magic != BAG_CHUNK_MAGIC || header->chunk_size < sizeof(BagChunkHeader))
+    {
+      break; // pre-allocated space of a crashed recording, or the summary
+    }
+
+    // Only trust records that made it into the file
+    const uint64_t available = size_ - offset - sizeof(BagChunkHeader);
+    Chunk chunk;
+    chunk.data = map_ + offset + sizeof(BagChunkHeader);
+    chunk.data_size = std::min(header->data_size, available);
+
+    uint64_t pos = 0;
+    while (pos + sizeof(BagRecordHeader) <= chunk.data_size)
+    {
+      const auto *record = reinterpret_cast<const BagRecordHeader *>(chunk.data + pos);
+      if (pos + sizeof(BagRecordHeader) + record->size > chunk.data_size)
+      {
+        break;
+      }
+
+      const uint8_t *payload = chunk.data + pos + sizeof(BagRecordHeader);
+      if (record->op == static_cast<uint8_t>(BagOp::TOPIC))
+      {
+        if (topics_.size() <= record->topic_id)
+        {
+          topics_.resize(record->topic_id + 1);
+        }
+        topics_[record->topic_id].name.assign(reinterpret_cast<const char *>(payload),
+                                              record->size);
+      }
+      else if (record->op == static_cast<uint8_t>(BagOp::MESSAGE))
+      {
+        if (topics_.size() <= record->topic_id)
+        {
+          topics_.resize(record->topic_id + 1);
+        }
+        addMessage(topics_[record->topic_id], record->timestamp_ns);
+        addMessage(chunk, record->timestamp_ns);
+        if (std::find(chunk.topics.begin(), chunk.topics.end(), record->topic_id) ==
+            chunk.topics.end())
+        {
+          chunk.topics.push_back(record->topic_id);
+        }
+      }
+      else if (record->op == static_cast<uint8_t>(BagOp::INDEX))
+      {
+        chunk.index = reinterpret_cast<const BagIndexEntry *>(payload);
+        chunk.index_count = record->size / sizeof(BagIndexEntry);
+      }
+      pos += bagRecordSize(record->size);
+    }
+    chunk.data_size = std::min(pos, chunk.data_size);
+
+    message_count_ += chunk.message_count;
+    chunks_.push_back(std::move(chunk));
+    offset += header->chunk_size;
+  }
+
+  bool first = true;
+  for (const BagTopicInfo &topic : topics_)
+  {
+    if (topic.message_count == 0)
+    {
+      continue;
+    }
+    start_ns_ = first ? topic.start_ns : std::min(start_ns_, topic.start_ns);
+    end_ns_ = std::max(end_ns_, topic.end_ns);
+    first = false;
+  }
+}
+
+bool BagReader::Filter::matches(uint16_t topic_id, uint64_t timestamp_ns) const
+{
+  return timestamp_ns >= start_ns && timestamp_ns <= end_ns &&
+         (all_topics || (topic_id < topics.size() && topics[topic_id]));
+}
+
+bool BagReader::Filter::matches(const Chunk &chunk) const
+{
+  if (chunk.message_count == 0 || chunk.end_ns < start_ns || chunk.start_ns > end_ns)
+  {
+    return false;
+  }
+  return all_topics ||
+         std::any_of(chunk.topics.begin(), chunk.topics.end(), [this](uint16_t id)
+                     { return id < topics.size() && topics[id]; });
+}
+
+BagReader::Filter BagReader::makeFilter(const BagQuery &query) const
+{
+  Filter filter;
+  filter.start_ns = query.start_ns;
+  filter.end_ns = query.end_ns;
+  if (!query.topics.empty())
+  {
+    filter.all_topics = false;
+    filter.topics.assign(topics_.size(), false);
+    for (size_t id = 0; id < topics_.size(); ++id)
+    {
+      filter.topics[id] = std::find(query.topics.begin(), query.topics.end(),
+                                    topics_[id].name) != query.topics.end();
+    }
+  }
+  return filter;
+}
+
+BagMessage BagReader::message(const Chunk &chunk, uint64_t offset) const
+{
+  const auto *record = reinterpret_cast<const BagRecordHeader *>(chunk.data + offset);
+  BagMessage message;
+  message.topic_id = record->topic_id;
+  message.topic =
+      record->topic_id < topics_.size() ? &topics_[record->topic_id].name : nullptr;
+  message.timestamp_ns = record->timestamp_ns;
+  message.data.data = chunk.data + offset + sizeof(BagRecordHeader);
+  message.data.size = record->size;
+  return message;
+}
+
+bool BagReader::visit(const Chunk &chunk, const Filter &filter,
+                      const Callback &callback, const std::atomic<bool> *stop) const
+{
+  // Indexed chunks: only the index and the selected records are touched
+  if (chunk.index)
+  {
+    for (uint64_t i = 0; i < chunk.index_count; ++i)
+    {
+      const BagIndexEntry &entry = chunk.index[i];
+      if (!filter.matches(entry.topic_id, entry.timestamp_ns) ||
+          entry.offset + sizeof(BagRecordHeader) + entry.size > chunk.data_size)
+      {
+        continue;
+      }
+      if ((stop && stop->load(std::memory_order_relaxed)) ||
+          !callback(message(chunk, entry.offset)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint64_t pos = 0;
+  while (pos < chunk.data_size)
+  {
+    const auto *record = reinterpret_cast<const BagRecordHeader *>(chunk.data + pos);
+    if (record->op == static_cast<uint8_t>(BagOp::MESSAGE) &&
+        filter.matches(record->topic_id, record->timestamp_ns))
+    {
+      if ((stop && stop->load(std::memory_order_relaxed)) ||
+          !callback(message(chunk, pos)))
+      {
+        return false;
+      }
+    }
+    pos += bagRecordSize(record->size);
+  }
+  return true;
+}
+
+void BagReader::forEach(const Callback &callback) const
+{
+  forEach(BagQuery{}, callback);
+}
+
+void BagReader::forEach(const BagQuery &query, const Callback &callback) const
+{
+  const Filter filter = makeFilter(query);
+  for (const Chunk &chunk : chunks_)
+  {
+    if (filter.matches(chunk) && !visit(chunk, filter, callback, nullptr))
+    {
+      return;
+    }
+  }
+}
+
+void BagReader::forEachParallel(const BagQuery &query, const Callback &callback,
+                                unsigned threads) const
+{
+  const Filter filter = makeFilter(query);
+  std::vector<const Chunk *> selected;
+  for (const Chunk &chunk : chunks_)
+  {
+    if (filter.matches(chunk))
+    {
+      selected.push_back(&chunk);
+    }
+  }
+  if (selected.empty())
+  {
+    return;
+  }
+
+  if (threads == 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = static_cast<unsigned>(std::min<size_t>(threads, selected.size()));
+
+  std::atomic<size_t> next{0};
+  std::atomic<bool> stop{false};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  // Threads take the next unclaimed chunk until none are left
+  const auto worker = [&]()
+  {
+    try
+    {
+      for (;;)
+      {
+        const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= selected.size() || stop.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+        if (!visit(*selected[i], filter, callback, &stop))
+        {
+          stop = true;
+          return;
+        }
+      }
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+      stop = true;
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < threads; ++i)
+  {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (std::thread &thread : pool)
+  {
+    thread.join();
+  }
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace zlc
@@ -0,0 +1,511 @@
+#include "zerolancom/bag/bag_writer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+uint64_t pageSize()
+{
+  static const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  return page;
+}
+
+uint64_t roundUpToPage(uint64_t size)
+{
+  return (size + pageSize() - 1) / pageSize() * pageSize();
+}
+
+uint64_t wallClockNs()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count());
+}
+} // namespace
+
+std::unique_ptr<BagWriter> BagWriter::create(const std::string &path,
+                                             const BagWriterOptions &options)
+{
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    zlc::error("[BagWriter] Cannot create {}: {}", path, std::strerror(errno));
+    return nullptr;
+  }
+
+  std::vector<uint8_t> page(BAG_FILE_HEADER_SIZE, 0);
+  BagFileHeader header{};
+  std::memcpy(header.magic, BAG_MAGIC, sizeof(header.magic));
+  header.version = BAG_VERSION;
+  header.created_ns = wallClockNs();
+  std::memcpy(page.data(), &header, sizeof(header));
+  if (::pwrite(fd, page.data(), page.size(), 0) != static_cast<ssize_t>(page.size()))
+  {
+    zlc::error("[BagWriter] Cannot write header of {}: {}", path, std::strerror(errno));
+    ::close(fd);
+    return nullptr;
+  }
+
+  return std::unique_ptr<BagWriter>(new BagWriter(fd, path, options));
+}
+
+BagWriter::BagWriter(int fd, const std::string &path, const BagWriterOptions &options)
+    : options_(options), path_(path), fd_(fd), queue_(options.queue_messages)
+{
+  thread_ = std::thread(
+      [this]()
+      {
+        configureCurrentThread("zlc-bag-write", options_.thread);
+        run();
+      });
+}
+
+BagWriter::~BagWriter()
+{
+  close();
+}
+
+uint16_t BagWriter::addTopic(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(topics_mutex_);
+  auto it = topic_ids_.find(name);
+  if (it != topic_ids_.end())
+  {
+    return it->second;
+  }
+  if (topic_names_.size() > std::numeric_limits<uint16_t>::max())
+  {
+    throw std::length_error("Too many topics in one recording");
+  }
+  const auto id = static_cast<uint16_t>(topic_names_.size());
+  topic_names_.push_back(name);
+  topic_ids_.emplace(name, id);
+  return id;
+}
+
+bool BagWriter::write(uint16_t topic_id, uint64_t timestamp_ns, const ByteView &payload)
+{
+  return write(topic_id, timestamp_ns, zmq::message_t(payload.data, payload.size));
+}
+
+bool BagWriter::write(uint16_t topic_id, uint64_t timestamp_ns,
+                      zmq::message_t &&payload)
+{
+  // Counted before running_ is checked, so close() can wait for this call
+  writers_.fetch_add(1);
+  struct Leave
+  {
+    std::atomic<int> &writers;
+    ~Leave()
+    {
+      writers.fetch_sub(1);
+    }
+  } leave{writers_};
+
+  const size_t size = payload.size();
+  if (!running_ || size > std::numeric_limits<uint32_t>::max())
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (queued_bytes_.fetch_add(size, std::memory_order_relaxed) + size >
+      options_.queue_bytes)
+  {
+    queued_bytes_.fetch_sub(size, std::memory_order_relaxed);
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  Entry entry;
+  entry.topic_id = topic_id;
+  entry.timestamp_ns = timestamp_ns;
+  entry.payload = std::move(payload);
+  if (!queue_.tryPush(std::move(entry)))
+  {
+    queued_bytes_.fetch_sub(size, std::memory_order_relaxed);
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  wake();
+  return true;
+}
+
+void BagWriter::wake()
+{
+  // Pairs with the fence in run(): either the writer thread sees the pushed
+  // entry, or this sees idle_ set
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (idle_.load(std::memory_order_relaxed))
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+  }
+}
+
+void BagWriter::close()
+{
+  if (fd_ < 0)
+  {
+    return;
+  }
+
+  running_ = false;
+  // A write() that saw running_ set may still be pushing its entry
+  while (writers_.load() != 0)
+  {
+    std::this_thread::yield();
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+  }
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+
+  // Nothing can be queued any more; record what the writer thread left behind
+  Entry entry;
+  while (queue_.tryPop(entry))
+  {
+    appendQueued(entry);
+  }
+
+  if (chunk_)
+  {
+    endChunk(true);
+  }
+  else if (::ftruncate(fd_, static_cast<off_t>(file_end_)) != 0)
+  {
+    zlc::warn("[BagWriter] Cannot trim {}: {}", path_, std::strerror(errno));
+  }
+  writeSummary();
+  ::fdatasync(fd_);
+  ::close(fd_);
+  fd_ = -1;
+
+  zlc::info("[BagWriter] Closed {}: {} messages, {} bytes, {} dropped", path_,
+            messages_.load(), bytes_.load(), dropped_.load());
+}
+
+BagWriterStats BagWriter::stats() const
+{
+  BagWriterStats stats;
+  stats.messages = messages_.load(std::memory_order_relaxed);
+  stats.bytes = bytes_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.chunks = chunks_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void BagWriter::run()
+{
+  Entry entry;
+  for (;;)
+  {
+    if (queue_.tryPop(entry))
+    {
+      appendQueued(entry);
+      continue;
+    }
+    // close() drains whatever is queued after this returns
+    if (!running_)
+    {
+      break;
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    idle_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const bool popped = queue_.tryPop(entry);
+    if (!popped && running_)
+    {
+      wake_cv_.wait(lock);
+    }
+    idle_.store(false, std::memory_order_relaxed);
+    lock.unlock();
+    if (popped)
+    {
+      appendQueued(entry);
+    }
+  }
+}
+
+void BagWriter::appendQueued(Entry &entry)
+{
+  queued_bytes_.fetch_sub(entry.payload.size(), std::memory_order_relaxed);
+  append(entry);
+  entry.payload.rebuild(); // release the frame now, not on the next pop
+}
+
+void BagWriter::append(const Entry &entry)
+{
+  if (disk_full_)
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  std::string name;
+  {
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    name = topic_names_.at(entry.topic_id);
+  }
+  if (chunk_topics_.size() <= entry.topic_id)
+  {
+    chunk_topics_.resize(entry.topic_id + 1, 0);
+  }
+
+  // Room for the message, its topic binding and one more index entry
+  const uint64_t message_size = bagRecordSize(entry.payload.size());
+  const uint64_t topic_size = bagRecordSize(name.size());
+  const bool bound = chunk_ && chunk_topics_[entry.topic_id] > 0;
+  const uint64_t needed = message_size + (bound ? 0 : topic_size);
+  const uint64_t index_size =
+      bagRecordSize((chunk_index_.size() + 1) * sizeof(BagIndexEntry));
+
+  auto *header = reinterpret_cast<BagChunkHeader *>(chunk_);
+  if (!chunk_ || sizeof(BagChunkHeader) + header->data_size + needed + index_size >
+                     chunk_capacity_)
+  {
+    if (chunk_)
+    {
+      endChunk(false);
+    }
+    if (!beginChunk(message_size + topic_size + bagRecordSize(sizeof(BagIndexEntry))))
+    {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    header = reinterpret_cast<BagChunkHeader *>(chunk_);
+  }
+
+  if (chunk_topics_[entry.topic_id] == 0)
+  {
+    appendRecord(BagOp::TOPIC, entry.topic_id, 0,
+                 reinterpret_cast<const uint8_t *>(name.data()), name.size());
+  }
+  ++chunk_topics_[entry.topic_id];
+
+  BagIndexEntry index{};
+  index.timestamp_ns = entry.timestamp_ns;
+  index.offset = header->data_size;
+  index.topic_id = entry.topic_id;
+  index.size = static_cast<uint32_t>(entry.payload.size());
+  chunk_index_.push_back(index);
+
+  appendRecord(BagOp::MESSAGE, entry.topic_id, entry.timestamp_ns,
+               static_cast<const uint8_t *>(entry.payload.data()),
+               entry.payload.size());
+
+  if (header->message_count == 0)
+  {
+    header->start_ns = entry.timestamp_ns;
+  }
+  header->start_ns = std::min(header->start_ns, entry.timestamp_ns);
+  header->end_ns = std::max(header->end_ns, entry.timestamp_ns);
+  ++header->message_count;
+
+  if (summary_topics_.size() <= entry.topic_id)
+  {
+    summary_topics_.resize(entry.topic_id + 1, BagSummaryTopic{});
+  }
+  BagSummaryTopic &topic = summary_topics_[entry.topic_id];
+  if (topic.message_count == 0)
+  {
+    topic.start_ns = entry.timestamp_ns;
+  }
+  topic.start_ns = std::min(topic.start_ns, entry.timestamp_ns);
+  topic.end_ns = std::max(topic.end_ns, entry.timestamp_ns);
+  ++topic.message_count;
+
+  messages_.fetch_add(1, std::memory_order_relaxed);
+  bytes_.fetch_add(entry.payload.size(), std::memory_order_relaxed);
+}
+
+void BagWriter::appendRecord(BagOp op, uint16_t topic_id, uint64_t timestamp_ns,
+                             const uint8_t *data, size_t size)
+{
+  auto *header = reinterpret_cast<BagChunkHeader *>(chunk_);
+  uint8_t *dst = chunk_ + sizeof(BagChunkHeader) + header->data_size;
+
+  BagRecordHeader record{};
+  record.op = static_cast<uint8_t>(op);
+  record.topic_id = topic_id;
+  record.size = static_cast<uint32_t>(size);
+  record.timestamp_ns = timestamp_ns;
+  std::memcpy(dst, &record, sizeof(record));
+  if (size > 0)
+  {
+    std::memcpy(dst + sizeof(record), data, size);
+  }
+  // Padding is already zero: the chunk is freshly allocated
+
+  header->data_size += bagRecordSize(size);
+}
+
+bool BagWriter::beginChunk(uint64_t min_data)
+{
+  const uint64_t size =
+      roundUpToPage(std::max(options_.chunk_size, sizeof(BagChunkHeader) + min_data));
+
+  const int rc = ::posix_fallocate(fd_, static_cast<off_t>(file_end_),
+                                   static_cast<off_t>(size));
+  if (rc != 0)
+  {
+    zlc::error("[BagWriter] Cannot allocate {} bytes in {}, recording stopped: {}",
+               size, path_, std::strerror(rc));
+    disk_full_ = true;
+    return false;
+  }
+
+  void *map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                     static_cast<off_t>(file_end_));
+  if (map == MAP_FAILED)
+  {
+    zlc::error("[BagWriter] Cannot map {} bytes of {}, recording stopped: {}", size,
+               path_, std::strerror(errno));
+    disk_full_ = true;
+    return false;
+  }
+
+  chunk_ = static_cast<uint8_t *>(map);
+  chunk_offset_ = file_end_;
+  chunk_capacity_ = size;
+  std::fill(chunk_topics_.begin(), chunk_topics_.end(), 0);
+  chunk_index_.clear();
+
+  auto *header = reinterpret_cast<BagChunkHeader *>(chunk_);
+  *header = BagChunkHeader{};
+  header->magic = BAG_CHUNK_MAGIC;
+  header->chunk_size = size;
+  chunks_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void BagWriter::endChunk(bool last)
+{
+  auto *header = reinterpret_cast<BagChunkHeader *>(chunk_);
+
+  // Close the chunk with its index; append() always leaves room for it
+  BagSummaryChunk summary{};
+  summary.offset = chunk_offset_;
+  summary.index_offset = chunk_offset_ + sizeof(BagChunkHeader) + header->data_size +
+                         sizeof(BagRecordHeader);
+  summary.index_count = chunk_index_.size();
+  summary.start_ns = header->start_ns;
+  summary.end_ns = header->end_ns;
+  summary.message_count = header->message_count;
+  appendRecord(BagOp::INDEX, 0, 0,
+               reinterpret_cast<const uint8_t *>(chunk_index_.data()),
+               chunk_index_.size() * sizeof(BagIndexEntry));
+
+  for (size_t id = 0; id < chunk_topics_.size(); ++id)
+  {
+    if (chunk_topics_[id] > 0)
+    {
+      BagSummaryChunkTopic topic{};
+      topic.chunk = summary_chunks_.size();
+      topic.topic_id = static_cast<uint16_t>(id);
+      topic.message_count = chunk_topics_[id];
+      summary_chunk_topics_.push_back(topic);
+    }
+  }
+  summary_chunks_.push_back(summary);
+
+  const uint64_t used = sizeof(BagChunkHeader) + header->data_size;
+
+  // The next chunk starts on the page after the last record, reusing the rest
+  // of this chunk's allocation
+  header->chunk_size = last ? used : roundUpToPage(used);
+  file_end_ = chunk_offset_ + header->chunk_size;
+
+  ::munmap(chunk_, chunk_capacity_);
+  chunk_ = nullptr;
+
+  if (last)
+  {
+    if (::ftruncate(fd_, static_cast<off_t>(file_end_)) != 0)
+    {
+      zlc::warn("[BagWriter] Cannot trim {}: {}", path_, std::strerror(errno));
+    }
+    return;
+  }
+
+  // Start writeback now instead of letting dirty pages pile up
+  ::sync_file_range(fd_, static_cast<off_t>(chunk_offset_),
+                    static_cast<off_t>(used), SYNC_FILE_RANGE_WRITE);
+}
+
+void BagWriter::writeSummary()
+{
+  BagSummaryHeader header{};
+  header.chunk_count = summary_chunks_.size();
+  header.chunk_topic_count = summary_chunk_topics_.size();
+  header.message_count = messages_.load();
+
+  std::vector<uint8_t> topics;
+  {
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    for (size_t id = 0; id < summary_topics_.size(); ++id)
+    {
+      BagSummaryTopic topic = summary_topics_[id];
+      if (topic.message_count == 0)
+      {
+        continue;
+      }
+      const std::string &name = topic_names_[id];
+      topic.topic_id = static_cast<uint16_t>(id);
+      topic.name_size = static_cast<uint32_t>(name.size());
+
+      const size_t pos = topics.size();
+      topics.resize(pos + sizeof(topic) + bagPadded(name.size()), 0);
+      std::memcpy(topics.data() + pos, &topic, sizeof(topic));
+      std::memcpy(topics.data() + pos + sizeof(topic), name.data(), name.size());
+
+      if (header.topic_count == 0 || topic.start_ns < header.start_ns)
+      {
+        header.start_ns = topic.start_ns;
+      }
+      header.end_ns = std::max(header.end_ns, topic.end_ns);
+      ++header.topic_count;
+    }
+  }
+
+  std::vector<uint8_t> summary(sizeof(header));
+  std::memcpy(summary.data(), &header, sizeof(header));
+  const auto appendTable = [&summary](const void *data, size_t size)
+  {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    summary.insert(summary.end(), bytes, bytes + size);
+  };
+  appendTable(summary_chunks_.data(), summary_chunks_.size() * sizeof(BagSummaryChunk));
+  appendTable(summary_chunk_topics_.data(),
+              summary_chunk_topics_.size() * sizeof(BagSummaryChunkTopic));
+  appendTable(topics.data(), topics.size());
+
+  BagFooter footer{};
+  footer.summary_offset = file_end_;
+  footer.magic = BAG_FOOTER_MAGIC;
+  appendTable(&footer, sizeof(footer));
+
+  if (::pwrite(fd_, summary.data(), summary.size(), static_cast<off_t>(file_end_)) !=
+      static_cast<ssize_t>(summary.size()))
+  {
+    zlc::warn("[BagWriter] Cannot write the summary of {}, readers will scan it: {}",
+              path_, std::strerror(errno));
+  }
+}
+
+} // namespace zlc
@@ -0,0 +1,163 @@
+#include "zerolancom/nodes/bridge.hpp"
+
+#include <algorithm>
+
+#include "zerolancom/sockets/client.hpp"
+#include "zerolancom/utils/exception.hpp"
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+const char *directionName(BridgeDirection direction)
+{
+  return direction == BridgeDirection::A_TO_B ? "A->B" : "B->A";
+}
+} // namespace
+
+Bridge::Bridge(const BridgeOptions &options) : options_(options)
+{
+  const NodeOptions &a = options.a.node;
+  const NodeOptions &b = options.b.node;
+  if (a.group == b.group && a.group_port == b.group_port &&
+      a.group_name == b.group_name)
+  {
+    // Both nodes would discover each other's relayed topics and services
+    zlc::warn("[Bridge] Both sides use group {}:{} '{}'; relayed traffic can "
+              "loop back",
+              a.group, a.group_port, a.group_name);
+  }
+
+  a_ = std::make_unique<ZeroLanComNode>(options.name + "_a", options.a.ip, a);
+  b_ = std::make_unique<ZeroLanComNode>(options.name + "_b", options.b.ip, b);
+  zlc::info("[Bridge] Bridging {} ({}) and {} ({})", options.a.ip, a.group_name,
+            options.b.ip, b.group_name);
+}
+
+Bridge::~Bridge()
+{
+  // Stop the receiving threads before the publishers they call go away
+  a_->stop();
+  b_->stop();
+  publishers_.clear();
+  b_.reset();
+  a_.reset();
+}
+
+ZeroLanComNode &Bridge::from(BridgeDirection direction)
+{
+  return direction == BridgeDirection::A_TO_B ? *a_ : *b_;
+}
+
+ZeroLanComNode &Bridge::to(BridgeDirection direction)
+{
+  return direction == BridgeDirection::A_TO_B ? *b_ : *a_;
+}
+
+bool Bridge::claim(std::unordered_map<std::string, BridgeDirection> &relayed,
+                   const std::string &name, BridgeDirection direction, bool &added)
+{
+  auto [it, inserted] = relayed.emplace(name, direction);
+  added = inserted;
+  return inserted || it->second == direction;
+}
+
+bool Bridge::relayTopic(const std::string &topic, BridgeDirection direction)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool added = false;
+  if (!claim(topics_, topic, direction, added))
+  {
+    zlc::error("[Bridge] Topic '{}' is already relayed {}", topic,
+               directionName(topics_[topic]));
+    return false;
+  }
+  if (!added)
+  {
+    return true;
+  }
+
+  publishers_.push_back(std::make_unique<Publisher<Bytes>>(
+      to(direction), topic, false, options_.publisher));
+  Publisher<Bytes> *publisher = publishers_.back().get();
+
+  ZeroLanComNode &source = from(direction);
+  source.setSubscriberSocketOptions(topic, options_.subscriber);
+  source.registerRawSubscriber(topic, [publisher](const ByteView &payload)
+                               { publisher->publishRaw(payload); });
+
+  zlc::info("[Bridge] Relaying topic '{}' {}", topic, directionName(direction));
+  return true;
+}
+
+bool Bridge::relayService(const std::string &service, BridgeDirection direction)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool added = false;
+  if (!claim(services_, service, direction, added))
+  {
+    zlc::error("[Bridge] Service '{}' is already relayed {}", service,
+               directionName(services_[service]));
+    return false;
+  }
+  if (!added)
+  {
+    return true;
+  }
+
+  ZeroLanComNode *source = &from(direction);
+  const int timeout_ms = options_.service_timeout_ms;
+  ZeroLanComNode &target = to(direction);
+
+  // Relayed calls wait on the link, so they run on worker threads and never
+  // hold up the far node's polling thread (and its get_node_info). Set up
+  // before the handler, so no request is served without them
+  if (!target.setServiceLimits(service, options_.service_limits))
+  {
+    zlc::error("[Bridge] Cannot relay service '{}': service limits rejected", service);
+    services_.erase(service);
+    return false;
+  }
+  target.setServiceCompression(service, options_.service_compression);
+
+  target.registerRawServiceHandler(
+      service,
+      [source, service, timeout_ms](const ByteView &request, ByteBuffer &out)
+      {
+        // Providers are looked up on every call, so a restarted or added
+        // provider is picked up; an overloaded one is retried on the others
+        const std::vector<SocketInfo> providers =
+            source->nodeInfoManager().getServiceProviders(service);
+        zmq::message_t response;
+        ResponseStatus status = ResponseStatus::NOSERVICE;
+        for (size_t attempt = 0; attempt < std::max<size_t>(providers.size(), 1);
+             ++attempt)
+        {
+          LoadBalancer::Call call(source->loadBalancer(), service, providers);
+          if (call.url().empty())
+          {
+            throw ServiceStatusException(ResponseStatus::NOSERVICE,
+                                         "no provider on the other side");
+          }
+          status = call.finish(Client::zlcRequestRaw(source->context(), service,
+                                                     call.url(), request, response,
+                                                     timeout_ms));
+          if (status != ResponseStatus::OVERLOADED)
+          {
+            break;
+          }
+        }
+        if (is_error(status))
+        {
+          throw ServiceStatusException(status, Response::description(status));
+        }
+        out.write(static_cast<const char *>(response.data()), response.size());
+      });
+
+  zlc::info("[Bridge] Relaying service '{}' {}", service, directionName(direction));
+  return true;
+}
+
+} // namespace zlc
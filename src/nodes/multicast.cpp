@@ -2,36 +2,49 @@
 
 #include <arpa/inet.h>
 #include <chrono>
+#include <sys/time.h>
 #include <thread>
 #include <unistd.h>
 
 #include "zerolancom/utils/exception.hpp"
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
 #include "zerolancom/utils/zmq_utils.hpp"
 
 namespace zlc
 {
 
+namespace
+{
+// recvfrom wakes up at least this often to expire silent nodes and notice stop()
+constexpr int RECEIVE_TIMEOUT_MS = 100;
+
+// Room for a burst of heartbeats from a few thousand nodes
+constexpr int RECEIVE_BUFFER_BYTES = 1024 * 1024;
+} // namespace
+
 /* ================= MulticastSender ================= */
 
-MulticastSender::MulticastSender(const std::string &group, int port,
-                                 const std::string &localIP,
-                                 const std::string &groupName)
-    : groupName_(groupName)
+MulticastSender::MulticastSender(NodeInfoManager &nodeInfoManager,
+                                 const std::string &group, int port,
+                                 const std::vector<NetworkInterface> &interfaces,
+                                 const std::string &groupName, int ttl)
+    : nodeInfoManager_(&nodeInfoManager), groupName_(groupName)
 {
   sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 
-  int ttl = 1;
   setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
 
-  in_addr local{};
-  local.s_addr = inet_addr(localIP.c_str());
-  setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_IF, &local, sizeof(local));
+  for (const NetworkInterface &interface : interfaces)
+  {
+    in_addr local{};
+    local.s_addr = inet_addr(interface.ip.c_str());
+    interfaces_.push_back(local);
+  }
 
   addr_.sin_family = AF_INET;
   addr_.sin_port = htons(port);
   addr_.sin_addr.s_addr = inet_addr(group.c_str());
-  nodeInfoManager_ = NodeInfoManager::instancePtr();
   nodeInfoManager_->setGroupName(groupName);
 }
 
@@ -44,10 +57,15 @@ MulticastSender::~MulticastSender()
   }
 }
 
-void MulticastSender::start()
+void MulticastSender::start(const ThreadOptions &thread)
 {
   running_ = true;
-  thread_ = std::thread([this]() { this->run(); });
+  thread_ = std::thread(
+      [this, thread]()
+      {
+        configureCurrentThread("zlc-mc-send", thread);
+        this->run();
+      });
 }
 
 void MulticastSender::stop()
@@ -75,16 +93,37 @@ void MulticastSender::run()
 
 void MulticastSender::sendHeartbeat(const Bytes &msg)
 {
-  sendto(sock_, msg.data(), msg.size(), 0, reinterpret_cast<sockaddr *>(&addr_),
-         sizeof(addr_));
+  // One socket for all interfaces: switch the outgoing interface per send
+  for (const in_addr &local : interfaces_)
+  {
+    setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_IF, &local, sizeof(local));
+    if (sendto(sock_, msg.data(), msg.size(), 0, reinterpret_cast<sockaddr *>(&addr_),
+               sizeof(addr_)) >= 0)
+    {
+      MetricsRegistry::global().discovery().heartbeats_sent.add();
+    }
+  }
 }
 
 /* ================= MulticastReceiver ================= */
 
-MulticastReceiver::MulticastReceiver(const std::string &group, int port,
-                                     const std::string &localIP,
+bool MulticastReceiver::fromOwnSubnet(const std::string &nodeIP) const
+{
+  for (const NetworkInterface &interface : interfaces_)
+  {
+    if (interface.contains(nodeIP))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+MulticastReceiver::MulticastReceiver(NodeInfoManager &nodeInfoManager,
+                                     const std::string &group, int port,
+                                     const std::vector<NetworkInterface> &interfaces,
                                      const std::string &groupName)
-    : localIP_(localIP), groupName_(groupName)
+    : interfaces_(interfaces), groupName_(groupName), nodeInfoManager_(&nodeInfoManager)
 {
   sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 
@@ -92,6 +131,13 @@ MulticastReceiver::MulticastReceiver(const std::string &group, int port,
   setsockopt(sock_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
   setsockopt(sock_, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
 
+  timeval timeout{};
+  timeout.tv_usec = RECEIVE_TIMEOUT_MS * 1000;
+  setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  int rcvbuf = RECEIVE_BUFFER_BYTES;
+  setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
   sockaddr_in addr{};
   addr.sin_family = AF_INET;
   addr.sin_port = htons(port);
@@ -99,12 +145,16 @@ MulticastReceiver::MulticastReceiver(const std::string &group, int port,
 
   bind(sock_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
 
-  ip_mreq mreq{};
-  mreq.imr_multiaddr.s_addr = inet_addr(group.c_str());
-  mreq.imr_interface.s_addr = inet_addr(localIP.c_str());
-  setsockopt(sock_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
-
-  nodeInfoManager_ = NodeInfoManager::instancePtr();
+  for (const NetworkInterface &interface : interfaces_)
+  {
+    ip_mreq mreq{};
+    mreq.imr_multiaddr.s_addr = inet_addr(group.c_str());
+    mreq.imr_interface.s_addr = inet_addr(interface.ip.c_str());
+    if (setsockopt(sock_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)
+    {
+      zlc::warn("[MulticastReceiver] Cannot join {} on {}", group, interface.ip);
+    }
+  }
 }
 
 MulticastReceiver::~MulticastReceiver()
@@ -116,10 +166,15 @@ MulticastReceiver::~MulticastReceiver()
   }
 }
 
-void MulticastReceiver::start()
+void MulticastReceiver::start(const ThreadOptions &thread)
 {
   running_ = true;
-  thread_ = std::thread([this]() { this->run(); });
+  thread_ = std::thread(
+      [this, thread]()
+      {
+        configureCurrentThread("zlc-mc-recv", thread);
+        this->run();
+      });
 }
 
 void MulticastReceiver::stop()
@@ -136,9 +191,21 @@ void MulticastReceiver::stop()
 
 void MulticastReceiver::run()
 {
+  Bytes buf(1024);
+  auto lastCheck = std::chrono::steady_clock::now();
+
   while (running_)
   {
-    Bytes buf(1024);
+    // Expire silent nodes on a timer rather than per datagram, so a quiet
+    // network still notices departures and a busy one does not rescan the
+    // node table for every heartbeat
+    const auto now = std::chrono::steady_clock::now();
+    if (now - lastCheck >= std::chrono::milliseconds(RECEIVE_TIMEOUT_MS))
+    {
+      nodeInfoManager_->checkHeartbeats();
+      lastCheck = now;
+    }
+
     sockaddr_in src{};
     socklen_t slen = sizeof(src);
 
@@ -147,14 +214,13 @@ void MulticastReceiver::run()
 
     if (n <= 0)
     {
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
       continue;
     }
 
     std::string nodeIP = inet_ntoa(src.sin_addr);
 
-    // Check if in same subnet
-    if (!isInSameSubnet(localIP_, nodeIP))
+    // Only accept peers on the subnet of one of our interfaces
+    if (!fromOwnSubnet(nodeIP))
       continue;
 
     try
@@ -170,16 +236,18 @@ void MulticastReceiver::run()
       if (heartbeat.node_id == nodeInfoManager_->nodeID())
         continue;
 
+      MetricsRegistry::global().discovery().heartbeats_received.add();
+
       nodeInfoManager_->processHeartbeat(heartbeat, nodeIP);
-      nodeInfoManager_->checkHeartbeats();
     }
     catch (const std::exception &e)
     {
-      warn("[MulticastReceiver] Failed to decode heartbeat from {}: {}", nodeIP,
-           e.what());
+      static LogRateLimit limit;
+      MetricsRegistry::global().discovery().heartbeat_errors.add();
+      warnRateLimited(limit,
+                      "[MulticastReceiver] Failed to decode heartbeat from {}: {}",
+                      nodeIP, e.what());
     }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
 }
 
@@ -1,10 +1,32 @@
 #include "zerolancom/nodes/node_info.hpp"
 
+#include <algorithm>
+#include <fstream>
+#include <unistd.h>
+
 #include "zerolancom/utils/logger.hpp"
 
 namespace zlc
 {
 
+/* ================= SocketInfo ================= */
+
+std::string SocketInfo::tcpURL() const
+{
+  return "tcp://" + ip + ":" + std::to_string(port);
+}
+
+std::string SocketInfo::url() const
+{
+  // A stale entry or a peer in another container leaves no socket file here
+  constexpr size_t IPC_PREFIX_LEN = 6; // "ipc://"
+  if (ipc.size() > IPC_PREFIX_LEN && ::access(ipc.c_str() + IPC_PREFIX_LEN, F_OK) == 0)
+  {
+    return ipc;
+  }
+  return tcpURL();
+}
+
 /* ================= NodeInfo ================= */
 
 void NodeInfo::printNodeInfo() const
@@ -14,10 +36,18 @@ void NodeInfo::printNodeInfo() const
   zlc::info("InfoID: {}", infoID);
   zlc::info("Name: {}", name);
   zlc::info("IP: {}", ip);
+  for (const auto &address : interfaces)
+  {
+    zlc::info("Also on: {}", address);
+  }
+  zlc::info("HostID: {}", hostID);
   zlc::info("Topics:");
   for (const auto &t : topics)
   {
-    zlc::info("  - {}:{}", t.name, t.port);
+    if (t.shm.empty())
+      zlc::info("  - {}:{}", t.name, t.port);
+    else
+      zlc::info("  - {}:{} (shm {})", t.name, t.port, t.shm);
   }
   zlc::info("Services:");
   for (const auto &s : services)
@@ -26,4 +56,51 @@ void NodeInfo::printNodeInfo() const
   }
 }
 
+void NodeInfo::dropHostLocalEndpoints()
+{
+  for (auto &t : topics)
+  {
+    t.shm.clear();
+    t.ipc.clear();
+  }
+  for (auto &s : services)
+  {
+    s.ipc.clear();
+  }
+}
+
+void NodeInfo::useInterface(const std::string &address)
+{
+  if (address == ip ||
+      std::find(interfaces.begin(), interfaces.end(), address) == interfaces.end())
+  {
+    return;
+  }
+  // Topics stay on the interface their publisher bound to
+  for (auto &s : services)
+  {
+    if (s.ip == ip)
+    {
+      s.ip = address;
+    }
+  }
+}
+
+/* ================= Host identity ================= */
+
+std::string localHostID()
+{
+  std::string bootID;
+  std::ifstream("/proc/sys/kernel/random/boot_id") >> bootID;
+
+  char mountNS[64] = {};
+  ssize_t n = ::readlink("/proc/self/ns/mnt", mountNS, sizeof(mountNS) - 1);
+
+  if (bootID.empty() || n <= 0)
+  {
+    return {};
+  }
+  return bootID + "/" + std::string(mountNS, static_cast<size_t>(n));
+}
+
 } // namespace zlc
@@ -1,23 +1,54 @@
 #include "zerolancom/nodes/node_info_manager.hpp"
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
 #include <msgpack.hpp>
 #include <zmq.hpp>
 
+#include "zerolancom/serialization/serializer.hpp"
 #include "zerolancom/sockets/client.hpp"
 #include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
 #include "zerolancom/utils/zmq_utils.hpp"
 
 namespace zlc
 {
 
+namespace
+{
+// Contents of a discovery cache file
+struct DiscoveryCache
+{
+  uint32_t version{1};
+  std::string group_name;
+  std::vector<NodeInfo> nodes;
+
+  MSGPACK_DEFINE_MAP(version, group_name, nodes)
+};
+} // namespace
+
 /* ================= Constructor ================= */
 
-NodeInfoManager::NodeInfoManager(const std::string &name, const std::string &ip)
+NodeInfoManager::NodeInfoManager(const std::string &name, const std::string &ip,
+                                 ZMQContext &context)
+    : context_(context)
 {
   localNodeInfo_.nodeID = generateUUID();
   localNodeInfo_.infoID = 0;
   localNodeInfo_.name = name;
   localNodeInfo_.ip = ip;
+  localNodeInfo_.hostID = localHostID();
+}
+
+NodeInfoManager::~NodeInfoManager()
+{
+  MetricsRegistry::global().discovery().nodes.add(-counted_nodes_);
 }
 
 /* ================= private helpers ================= */
@@ -28,6 +59,26 @@ void NodeInfoManager::updateNodeUnlocked(const std::string &nodeID,
   nodes_info_[nodeID] = info;
   nodes_info_id_[nodeID] = info.infoID;
   nodes_heartbeat_[nodeID] = std::chrono::steady_clock::now();
+  tentative_.erase(nodeID);
+  countNodesUnlocked();
+}
+
+void NodeInfoManager::countNodesUnlocked()
+{
+  // Several nodes in one process each add their own count, so the gauge is
+  // their sum rather than whichever node wrote last
+  const int64_t known = static_cast<int64_t>(nodes_info_.size());
+  MetricsRegistry::global().discovery().nodes.add(known - counted_nodes_);
+  counted_nodes_ = known;
+}
+
+void NodeInfoManager::notifyDiscovery()
+{
+  {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    ++discovery_generation_;
+  }
+  discovery_cv_.notify_all();
 }
 
 bool NodeInfoManager::checkNodeIDUnlocked(const std::string &nodeID) const
@@ -44,22 +95,70 @@ bool NodeInfoManager::checkNodeInfoIDUnlocked(const std::string &nodeID,
   return it->second == infoID;
 }
 
-std::optional<NodeInfo> NodeInfoManager::fetchNodeInfo(const std::string &ip,
-                                                       int32_t servicePort)
+const SocketInfo *NodeInfoManager::findServiceUnlocked(const std::string &serviceName,
+                                                       std::string &nodeID) const
+{
+  const SocketInfo *fallback = nullptr;
+  for (const auto &[id, node] : nodes_info_)
+  {
+    for (const auto &t : node.services)
+    {
+      if (t.name != serviceName)
+      {
+        continue;
+      }
+      if (tentative_.count(id) == 0)
+      {
+        nodeID = id;
+        return &t;
+      }
+      if (fallback == nullptr)
+      {
+        fallback = &t;
+        nodeID = id;
+      }
+    }
+  }
+  if (fallback != nullptr)
+  {
+    return fallback;
+  }
+  nodeID.clear();
+  for (const auto &t : localNodeInfo_.services)
+  {
+    if (t.name == serviceName)
+    {
+      return &t;
+    }
+  }
+  return nullptr;
+}
+
+std::optional<NodeInfo> NodeInfoManager::fetchNodeInfo(const std::string &url,
+                                                       int timeout_ms)
 {
+  DiscoveryMetrics &metrics = MetricsRegistry::global().discovery();
+  metrics.node_fetches.add();
   try
   {
-    zlc::info("[NodeInfoManager] Fetching node info from {}:{}", ip, servicePort);
-    const std::string service_url = "tcp://" + ip + ":" + std::to_string(servicePort);
+    zlc::trace("[NodeInfoManager] Fetching node info from {}", url);
     // Create a temporary REQ socket
     NodeInfo info;
-    Client::zlcRequest<Empty, NodeInfo>("get_node_info", service_url, Empty{}, info);
+    if (is_error(Client::zlcRequest<Empty, NodeInfo>(context_, "get_node_info", url,
+                                                     Empty{}, info, timeout_ms)))
+    {
+      metrics.node_fetch_failures.add();
+      return std::nullopt;
+    }
     return info;
   }
   catch (const std::exception &e)
   {
-    zlc::warn("[NodeInfoManager] Failed to fetch node info from {}:{}: {}", ip,
-              servicePort, e.what());
+    static LogRateLimit limit;
+    zlc::warnRateLimited(limit,
+                         "[NodeInfoManager] Failed to fetch node info from {}: {}", url,
+                         e.what());
+    metrics.node_fetch_failures.add();
     return std::nullopt;
   }
 }
@@ -80,10 +179,24 @@ bool NodeInfoManager::checkNodeInfoID(const std::string &nodeID, uint32_t infoID
 
 void NodeInfoManager::removeNode(const std::string &nodeID)
 {
-  std::unique_lock lock(data_mutex_);
-  nodes_info_.erase(nodeID);
-  nodes_info_id_.erase(nodeID);
-  nodes_heartbeat_.erase(nodeID);
+  {
+    std::unique_lock lock(data_mutex_);
+    if (nodes_info_.erase(nodeID) != 0)
+    {
+      MetricsRegistry::global().discovery().nodes_removed.add();
+    }
+    nodes_info_id_.erase(nodeID);
+    nodes_heartbeat_.erase(nodeID);
+    tentative_.erase(nodeID);
+    countNodesUnlocked();
+  }
+  saveCache();
+}
+
+size_t NodeInfoManager::knownNodeCount() const
+{
+  std::shared_lock lock(data_mutex_);
+  return nodes_info_.size();
 }
 
 std::vector<SocketInfo>
@@ -102,6 +215,7 @@ NodeInfoManager::getPublisherInfo(const std::string &topicName) const
       }
     }
   }
+  std::lock_guard<std::mutex> local(local_mutex_);
   for (const auto &t : localNodeInfo_.topics)
   {
     if (t.name == topicName)
@@ -112,55 +226,142 @@ NodeInfoManager::getPublisherInfo(const std::string &topicName) const
   return result;
 }
 
+bool NodeInfoManager::isLocalTopic(const SocketInfo &info) const
+{
+  std::lock_guard<std::mutex> lock(local_mutex_);
+  for (const auto &t : localNodeInfo_.topics)
+  {
+    if (t.name == info.name && t.port == info.port && t.ip == info.ip)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 const SocketInfo *NodeInfoManager::getServiceInfo(const std::string &serviceName) const
 {
   std::shared_lock lock(data_mutex_);
+  std::lock_guard<std::mutex> local(local_mutex_);
+  std::string nodeID;
+  return findServiceUnlocked(serviceName, nodeID);
+}
+
+std::string NodeInfoManager::getServiceURL(const std::string &serviceName) const
+{
+  std::shared_lock lock(data_mutex_);
+  std::lock_guard<std::mutex> local(local_mutex_);
+  std::string nodeID;
+  const SocketInfo *info = findServiceUnlocked(serviceName, nodeID);
+  return info == nullptr ? std::string() : info->url();
+}
 
+std::vector<SocketInfo>
+NodeInfoManager::getServiceProviders(const std::string &serviceName) const
+{
+  std::shared_lock lock(data_mutex_);
+
+  std::vector<SocketInfo> confirmed;
+  std::vector<SocketInfo> tentative;
   for (const auto &[id, node] : nodes_info_)
   {
     for (const auto &t : node.services)
     {
       if (t.name == serviceName)
       {
-        return &t;
+        (tentative_.count(id) == 0 ? confirmed : tentative).push_back(t);
       }
     }
   }
+  std::lock_guard<std::mutex> local(local_mutex_);
   for (const auto &t : localNodeInfo_.services)
   {
     if (t.name == serviceName)
     {
-      return &t;
+      confirmed.push_back(t);
+    }
+  }
+  return confirmed.empty() ? tentative : confirmed;
+}
+
+bool NodeInfoManager::waitUntil(const std::function<bool()> &ready,
+                                std::chrono::steady_clock::time_point deadline) const
+{
+  std::unique_lock lock(wait_mutex_);
+  while (true)
+  {
+    // Read the generation first: a change made while ready() runs bumps it,
+    // so it is never missed
+    const uint64_t seen = discovery_generation_;
+    lock.unlock();
+    const bool done = ready();
+    lock.lock();
+    if (done)
+    {
+      return true;
+    }
+    if (!discovery_cv_.wait_until(lock, deadline,
+                                  [&] { return discovery_generation_ != seen; }))
+    {
+      return ready();
     }
   }
-  return nullptr;
 }
 
 void NodeInfoManager::checkHeartbeats()
 {
   std::unique_lock lock(data_mutex_);
 
-  auto now = std::chrono::steady_clock::now();
+  const auto deadline = std::chrono::steady_clock::now() -
+                        std::chrono::milliseconds(HEARTBEAT_TIMEOUT_MS);
   std::vector<std::string> to_remove;
 
   for (const auto &[nodeID, last] : nodes_heartbeat_)
   {
-    auto duration =
-        std::chrono::duration_cast<std::chrono::seconds>(now - last).count();
-    if (duration > 2)
+    if (last < deadline)
     {
       to_remove.push_back(nodeID);
     }
   }
 
+  std::vector<NodeInfo> removed;
   for (const auto &nodeID : to_remove)
   {
-    node_remove_event.trigger(nodes_info_[nodeID]);
-    nodes_info_.erase(nodeID);
+    // Nodes whose info was never fetched were never announced either
+    auto it = nodes_info_.find(nodeID);
+    if (it != nodes_info_.end())
+    {
+      if (tentative_.erase(nodeID) != 0)
+      {
+        zlc::info("Cached node {} evicted: no heartbeat", it->second.name);
+      }
+      else
+      {
+        zlc::info("Node {} removed due to heartbeat timeout", nodeID);
+      }
+      removed.push_back(std::move(it->second));
+      nodes_info_.erase(it);
+    }
     nodes_info_id_.erase(nodeID);
     nodes_heartbeat_.erase(nodeID);
-    zlc::info("Node {} removed due to heartbeat timeout", nodeID);
   }
+
+  if (removed.empty())
+  {
+    return;
+  }
+  DiscoveryMetrics &metrics = MetricsRegistry::global().discovery();
+  metrics.nodes_removed.add(removed.size());
+  countNodesUnlocked();
+  lock.unlock();
+
+  // Outside the lock, like processHeartbeat(): handlers join shm reader
+  // threads, whose callbacks may query discovery (request(), waitForTopic())
+  for (const NodeInfo &info : removed)
+  {
+    node_remove_event.trigger(info);
+  }
+  saveCache();
 }
 
 void NodeInfoManager::processHeartbeat(const HeartbeatMessage &heartbeat,
@@ -177,6 +378,12 @@ void NodeInfoManager::processHeartbeat(const HeartbeatMessage &heartbeat,
       // Update heartbeat timestamp
       nodes_heartbeat_[heartbeat.node_id] = std::chrono::steady_clock::now();
 
+      // A cached node that is still there, with the same info, is confirmed
+      if (tentative_.erase(heartbeat.node_id) != 0)
+      {
+        zlc::trace("Cached node {} confirmed by heartbeat", heartbeat.node_id);
+      }
+
       if (!checkNodeIDUnlocked(heartbeat.node_id))
       {
         // New node - need to fetch full info
@@ -193,18 +400,29 @@ void NodeInfoManager::processHeartbeat(const HeartbeatMessage &heartbeat,
 
     if (needsFetch)
     {
-      auto nodeInfoOpt = fetchNodeInfo(nodeIP, heartbeat.service_port);
+      auto nodeInfoOpt = fetchNodeInfo("tcp://" + nodeIP + ":" +
+                                       std::to_string(heartbeat.service_port));
       if (nodeInfoOpt.has_value())
       {
         NodeInfo &nodeInfo = nodeInfoOpt.value();
 
+        // ipc:// endpoints and shm segments only resolve on the node's own host
+        if (nodeInfo.hostID.empty() || nodeInfo.hostID != localNodeInfo_.hostID)
+        {
+          nodeInfo.dropHostLocalEndpoints();
+        }
+        nodeInfo.useInterface(nodeIP);
+
         {
           std::unique_lock lock(data_mutex_);
           updateNodeUnlocked(heartbeat.node_id, nodeInfo);
         }
+        saveCache();
+        notifyDiscovery();
 
         if (isNew)
         {
+          MetricsRegistry::global().discovery().nodes_added.add();
           zlc::info("Node {} added via heartbeat", nodeInfo.name);
           nodeInfo.printNodeInfo();
         }
@@ -215,8 +433,211 @@ void NodeInfoManager::processHeartbeat(const HeartbeatMessage &heartbeat,
   }
   catch (const std::exception &e)
   {
-    zlc::error("Error processing heartbeat: {}", e.what());
+    static LogRateLimit limit;
+    zlc::errorRateLimited(limit, "Error processing heartbeat: {}", e.what());
+  }
+}
+
+/* ================= Discovery Cache ================= */
+
+bool NodeInfoManager::loadCache(const std::string &path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  const Bytes bytes((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+
+  DiscoveryCache cache;
+  try
+  {
+    decode(ByteView{bytes.data(), bytes.size()}, cache);
+  }
+  catch (const std::exception &e)
+  {
+    zlc::warn("[NodeInfoManager] Ignoring unreadable discovery cache {}: {}", path,
+              e.what());
+    return false;
+  }
+
+  std::string groupName;
+  {
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    groupName = groupName_;
+  }
+  if (cache.version != 1 || cache.group_name != groupName)
+  {
+    return false;
+  }
+
+  size_t loaded = 0;
+  {
+    std::unique_lock lock(data_mutex_);
+    for (const NodeInfo &info : cache.nodes)
+    {
+      if (info.nodeID == localNodeInfo_.nodeID || checkNodeIDUnlocked(info.nodeID))
+      {
+        continue;
+      }
+      // Counts as a heartbeat now, so it is evicted unless a real one follows
+      updateNodeUnlocked(info.nodeID, info);
+      tentative_.insert(info.nodeID);
+      ++loaded;
+    }
+  }
+  zlc::info("[NodeInfoManager] Loaded {} cached node(s) from {}", loaded, path);
+  if (loaded > 0)
+  {
+    notifyDiscovery();
+  }
+  return loaded > 0;
+}
+
+void NodeInfoManager::setCachePath(const std::string &path)
+{
+  std::lock_guard<std::mutex> lock(local_mutex_);
+  cachePath_ = path;
+}
+
+bool NodeInfoManager::saveCache() const
+{
+  DiscoveryCache cache;
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    if (cachePath_.empty())
+    {
+      return false;
+    }
+    path = cachePath_;
+    cache.group_name = groupName_;
+  }
+  {
+    std::shared_lock lock(data_mutex_);
+    for (const auto &[id, node] : nodes_info_)
+    {
+      cache.nodes.push_back(node);
+    }
+  }
+
+  ByteBuffer out;
+  encode(cache, out);
+
+  // Write a private temporary file and rename it over the cache, so readers
+  // never see a partial file and nodes sharing the path do not collide
+  const std::string tmp = path + "." + localNodeInfo_.nodeID + ".tmp";
+  const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    static LogRateLimit limit;
+    zlc::warnRateLimited(limit, "[NodeInfoManager] Cannot write discovery cache {}: {}",
+                         tmp, std::strerror(errno));
+    return false;
+  }
+  const ssize_t size = static_cast<ssize_t>(out.size);
+  const bool written = ::write(fd, out.data, out.size) == size;
+  const bool synced = written && ::fsync(fd) == 0;
+  ::close(fd);
+  if (!synced || std::rename(tmp.c_str(), path.c_str()) != 0)
+  {
+    ::unlink(tmp.c_str());
+    return false;
   }
+  return true;
+}
+
+bool NodeInfoManager::isTentative(const std::string &nodeID) const
+{
+  std::shared_lock lock(data_mutex_);
+  return tentative_.count(nodeID) != 0;
+}
+
+bool NodeInfoManager::isTentativeService(const std::string &serviceName) const
+{
+  std::shared_lock lock(data_mutex_);
+  std::lock_guard<std::mutex> local(local_mutex_);
+  std::string nodeID;
+  return findServiceUnlocked(serviceName, nodeID) != nullptr &&
+         tentative_.count(nodeID) != 0;
+}
+
+void NodeInfoManager::evictTentativeService(const std::string &serviceName)
+{
+  std::string nodeID;
+  NodeInfo info;
+  {
+    std::shared_lock lock(data_mutex_);
+    std::lock_guard<std::mutex> local(local_mutex_);
+    if (findServiceUnlocked(serviceName, nodeID) == nullptr ||
+        tentative_.count(nodeID) == 0)
+    {
+      return;
+    }
+    info = nodes_info_.at(nodeID);
+  }
+  zlc::info("[NodeInfoManager] Evicting cached node {}: '{}' did not answer",
+            info.name, serviceName);
+  removeNode(nodeID);
+  node_remove_event.trigger(info);
+}
+
+bool NodeInfoManager::confirmTentativeService(const std::string &serviceName)
+{
+  std::string nodeID;
+  std::string url;
+  {
+    std::shared_lock lock(data_mutex_);
+    std::lock_guard<std::mutex> local(local_mutex_);
+    const SocketInfo *info = findServiceUnlocked(serviceName, nodeID);
+    if (info == nullptr)
+    {
+      return false;
+    }
+    if (tentative_.count(nodeID) == 0)
+    {
+      return true;
+    }
+    url = info->url();
+  }
+
+  // The port may belong to another process since the cache was written, so a
+  // reply alone does not confirm the node
+  const std::optional<NodeInfo> reply =
+      fetchNodeInfo(url, TENTATIVE_REQUEST_TIMEOUT_MS);
+  NodeInfo info;
+  {
+    std::unique_lock lock(data_mutex_);
+    auto it = nodes_info_.find(nodeID);
+    if (it == nodes_info_.end())
+    {
+      return false; // evicted meanwhile
+    }
+    if (reply && reply->nodeID == nodeID)
+    {
+      if (tentative_.erase(nodeID) != 0)
+      {
+        nodes_heartbeat_[nodeID] = std::chrono::steady_clock::now();
+        zlc::trace("Cached node {} confirmed by get_node_info", it->second.name);
+      }
+      return true;
+    }
+    info = it->second;
+  }
+  if (reply)
+  {
+    zlc::info("[NodeInfoManager] Evicting cached node {}: {} now belongs to {}",
+              info.name, url, reply->name);
+  }
+  else
+  {
+    zlc::info("[NodeInfoManager] Evicting cached node {}: no answer from {}",
+              info.name, url);
+  }
+  removeNode(nodeID);
+  node_remove_event.trigger(info);
+  return false;
 }
 
 /* ================= Local Node Management ================= */
@@ -238,6 +659,13 @@ void NodeInfoManager::setServicePort(int32_t port)
   servicePort_ = port;
 }
 
+void NodeInfoManager::setInterfaces(const std::vector<std::string> &ips)
+{
+  std::lock_guard<std::mutex> lock(local_mutex_);
+  localNodeInfo_.interfaces = ips;
+  ++localNodeInfo_.infoID;
+}
+
 HeartbeatMessage NodeInfoManager::createHeartbeat() const
 {
   std::lock_guard<std::mutex> lock(local_mutex_);
@@ -256,18 +684,35 @@ NodeInfo NodeInfoManager::getLocalNodeInfo() const
   return localNodeInfo_;
 }
 
-void NodeInfoManager::registerLocalTopic(const std::string &name, uint16_t port)
+void NodeInfoManager::registerLocalTopic(const std::string &name, uint16_t port,
+                                         const std::string &shm,
+                                         const std::string &ipc, const std::string &ip)
 {
-  std::lock_guard<std::mutex> lock(local_mutex_);
-  localNodeInfo_.topics.push_back(SocketInfo{name, localNodeInfo_.ip, port});
-  ++localNodeInfo_.infoID;
+  NodeInfo local;
+  {
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    localNodeInfo_.topics.push_back(
+        SocketInfo{name, ip.empty() ? localNodeInfo_.ip : ip, port, shm, ipc});
+    ++localNodeInfo_.infoID;
+    local = localNodeInfo_;
+  }
+  notifyDiscovery();
+
+  // Our own heartbeats are ignored, so subscribers on this node that were
+  // registered first (stream subscribers) learn of the topic here
+  node_update_event.trigger(local);
 }
 
-void NodeInfoManager::registerLocalService(const std::string &name, uint16_t port)
+void NodeInfoManager::registerLocalService(const std::string &name, uint16_t port,
+                                           const std::string &ipc)
 {
-  std::lock_guard<std::mutex> lock(local_mutex_);
-  localNodeInfo_.services.push_back(SocketInfo{name, localNodeInfo_.ip, port});
-  ++localNodeInfo_.infoID;
+  {
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    localNodeInfo_.services.push_back(
+        SocketInfo{name, localNodeInfo_.ip, port, {}, ipc});
+    ++localNodeInfo_.infoID;
+  }
+  notifyDiscovery();
 }
 
 } // namespace zlc
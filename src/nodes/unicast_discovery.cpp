@@ -0,0 +1,345 @@
+#include "zerolancom/nodes/unicast_discovery.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/metrics.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+// Same cadence as MulticastSender
+constexpr int HEARTBEAT_INTERVAL_MS = 1000;
+
+// recvfrom wakes up at least this often to send, expire and notice stop()
+constexpr int RECEIVE_TIMEOUT_MS = 100;
+
+constexpr size_t RELAY_HEADER_SIZE = 8; // magic + IPv4 address
+
+// Shortest gap between two relayed heartbeats of one peer: half an interval,
+// so a heartbeat that arrives early after a late one is still relayed
+constexpr int RELAY_INTERVAL_MS = HEARTBEAT_INTERVAL_MS / 2;
+
+// Resolve "host:port"; false (logged) if it is malformed or unknown
+bool resolvePeer(const std::string &spec, sockaddr_in &addr)
+{
+  const size_t colon = spec.rfind(':');
+  if (colon == std::string::npos || colon == 0 || colon + 1 == spec.size())
+  {
+    zlc::warn("[UnicastDiscovery] Peer '{}' is not host:port", spec);
+    return false;
+  }
+  const std::string host = spec.substr(0, colon);
+  const std::string port = spec.substr(colon + 1);
+
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo *result = nullptr;
+  const int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+  if (rc != 0 || result == nullptr)
+  {
+    zlc::warn("[UnicastDiscovery] Cannot resolve peer '{}': {}", spec,
+              gai_strerror(rc));
+    return false;
+  }
+  std::memcpy(&addr, result->ai_addr, sizeof(addr));
+  freeaddrinfo(result);
+  return true;
+}
+
+bool sameAddress(const sockaddr_in &a, const sockaddr_in &b)
+{
+  return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+} // namespace
+
+UnicastDiscovery::UnicastDiscovery(NodeInfoManager &nodeInfoManager,
+                                   const std::string &groupName,
+                                   const UnicastDiscoveryOptions &options)
+    : groupName_(groupName), rendezvous_(options.rendezvous),
+      maxPeers_(options.max_peers), nodeInfoManager_(&nodeInfoManager)
+{
+  sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock_ < 0)
+  {
+    zlc::error("[UnicastDiscovery] Cannot create UDP socket: {}", std::strerror(errno));
+    return;
+  }
+
+  timeval timeout{};
+  timeout.tv_usec = RECEIVE_TIMEOUT_MS * 1000;
+  setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // No SO_REUSEPORT: unicast datagrams must reach this node, not a neighbour
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(std::max(options.port, 0)));
+  addr.sin_addr.s_addr = INADDR_ANY;
+  socklen_t len = sizeof(addr);
+  if (bind(sock_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      getsockname(sock_, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+  {
+    zlc::error("[UnicastDiscovery] Cannot bind UDP port {}: {}", options.port,
+               std::strerror(errno));
+  }
+  else
+  {
+    port_ = ntohs(addr.sin_port);
+  }
+
+  for (const std::string &spec : options.peers)
+  {
+    Peer peer;
+    peer.configured = true;
+    if (resolvePeer(spec, peer.addr))
+    {
+      peers_.push_back(peer);
+    }
+  }
+
+  zlc::info("[UnicastDiscovery] UDP port {}, {} peer(s){}", port_, peers_.size(),
+            rendezvous_ ? ", relaying as rendezvous" : "");
+}
+
+UnicastDiscovery::~UnicastDiscovery()
+{
+  stop();
+  if (sock_ >= 0)
+  {
+    close(sock_);
+  }
+}
+
+bool UnicastDiscovery::start(const ThreadOptions &thread)
+{
+  if (sock_ < 0)
+  {
+    zlc::error("[UnicastDiscovery] Not started: no UDP socket");
+    return false;
+  }
+  running_ = true;
+  thread_ = std::thread(
+      [this, thread]()
+      {
+        configureCurrentThread("zlc-uc-disc", thread);
+        this->run();
+      });
+  return true;
+}
+
+void UnicastDiscovery::stop()
+{
+  if (running_)
+  {
+    running_ = false;
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+}
+
+void UnicastDiscovery::run()
+{
+  Bytes buf(1024);
+  auto lastSend = std::chrono::steady_clock::time_point{};
+  auto lastCheck = std::chrono::steady_clock::now();
+
+  while (running_)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - lastSend >= std::chrono::milliseconds(HEARTBEAT_INTERVAL_MS))
+    {
+      sendHeartbeats();
+      lastSend = now;
+    }
+    // Multicast may be off, so expire silent nodes here as well
+    if (now - lastCheck >= std::chrono::milliseconds(RECEIVE_TIMEOUT_MS))
+    {
+      nodeInfoManager_->checkHeartbeats();
+      lastCheck = now;
+    }
+
+    sockaddr_in src{};
+    socklen_t slen = sizeof(src);
+    const ssize_t n = recvfrom(sock_, buf.data(), buf.size(), 0,
+                               reinterpret_cast<sockaddr *>(&src), &slen);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+      static LogRateLimit limit;
+      errorRateLimited(limit, "[UnicastDiscovery] recvfrom failed: {}",
+                       std::strerror(errno));
+      std::this_thread::sleep_for(std::chrono::milliseconds(RECEIVE_TIMEOUT_MS));
+      continue;
+    }
+    if (n <= 0)
+    {
+      continue;
+    }
+
+    try
+    {
+      receive(buf.data(), static_cast<size_t>(n), src);
+    }
+    catch (const std::exception &e)
+    {
+      static LogRateLimit limit;
+      MetricsRegistry::global().discovery().heartbeat_errors.add();
+      warnRateLimited(limit,
+                      "[UnicastDiscovery] Failed to decode heartbeat from {}: {}",
+                      inet_ntoa(src.sin_addr), e.what());
+    }
+  }
+}
+
+void UnicastDiscovery::sendHeartbeats()
+{
+  expirePeers();
+  const Bytes msg = nodeInfoManager_->createHeartbeat().encode();
+  for (const Peer &peer : peers_)
+  {
+    if (sendto(sock_, msg.data(), msg.size(), 0,
+               reinterpret_cast<const sockaddr *>(&peer.addr), sizeof(peer.addr)) >= 0)
+    {
+      MetricsRegistry::global().discovery().heartbeats_sent.add();
+    }
+  }
+}
+
+void UnicastDiscovery::receive(const uint8_t *data, size_t size, const sockaddr_in &src)
+{
+  uint32_t magic = 0;
+  if (size >= RELAY_HEADER_SIZE)
+  {
+    std::memcpy(&magic, data, sizeof(magic));
+  }
+
+  if (ntohl(magic) == RELAY_MAGIC)
+  {
+    // Only a rendezvous we were configured with may send us elsewhere
+    if (!isConfiguredPeer(src))
+    {
+      static LogRateLimit limit;
+      warnRateLimited(limit, "[UnicastDiscovery] Ignoring relay from unknown {}",
+                      inet_ntoa(src.sin_addr));
+      return;
+    }
+
+    // Relayed by a rendezvous: the node itself is at the embedded address
+    in_addr origin{};
+    std::memcpy(&origin.s_addr, data + 4, sizeof(origin.s_addr));
+    HeartbeatMessage heartbeat = HeartbeatMessage::decode(
+        data + RELAY_HEADER_SIZE, size - RELAY_HEADER_SIZE);
+    if (heartbeat.group_name != groupName_ ||
+        heartbeat.node_id == nodeInfoManager_->nodeID())
+    {
+      return;
+    }
+    MetricsRegistry::global().discovery().heartbeats_received.add();
+    nodeInfoManager_->processHeartbeat(heartbeat, inet_ntoa(origin));
+    return;
+  }
+
+  HeartbeatMessage heartbeat = HeartbeatMessage::decode(data, size);
+  if (heartbeat.node_id == nodeInfoManager_->nodeID())
+  {
+    return;
+  }
+  const bool sameGroup = heartbeat.group_name == groupName_;
+  if (!sameGroup && !rendezvous_)
+  {
+    return;
+  }
+
+  // Answer the sender from now on
+  const auto now = std::chrono::steady_clock::now();
+  Peer *sender = peer(src);
+  if (sender != nullptr)
+  {
+    sender->group_name = heartbeat.group_name;
+    sender->last_seen = now;
+  }
+
+  // Relay a peer's heartbeats at most twice per heartbeat interval
+  if (rendezvous_ && sender != nullptr &&
+      now - sender->last_relayed >= std::chrono::milliseconds(RELAY_INTERVAL_MS))
+  {
+    sender->last_relayed = now;
+    relay(data, size, src, heartbeat.group_name);
+  }
+  if (sameGroup)
+  {
+    MetricsRegistry::global().discovery().heartbeats_received.add();
+    nodeInfoManager_->processHeartbeat(heartbeat, inet_ntoa(src.sin_addr));
+  }
+}
+
+void UnicastDiscovery::relay(const uint8_t *data, size_t size, const sockaddr_in &src,
+                             const std::string &groupName)
+{
+  Bytes envelope(RELAY_HEADER_SIZE + size);
+  const uint32_t magic = htonl(RELAY_MAGIC);
+  std::memcpy(envelope.data(), &magic, sizeof(magic));
+  std::memcpy(envelope.data() + 4, &src.sin_addr.s_addr, sizeof(src.sin_addr.s_addr));
+  std::memcpy(envelope.data() + RELAY_HEADER_SIZE, data, size);
+
+  for (const Peer &peer : peers_)
+  {
+    if (peer.group_name == groupName && !sameAddress(peer.addr, src))
+    {
+      sendto(sock_, envelope.data(), envelope.size(), 0,
+             reinterpret_cast<const sockaddr *>(&peer.addr), sizeof(peer.addr));
+    }
+  }
+}
+
+void UnicastDiscovery::expirePeers()
+{
+  const auto timeout = std::chrono::milliseconds(NodeInfoManager::HEARTBEAT_TIMEOUT_MS);
+  const auto deadline = std::chrono::steady_clock::now() - timeout;
+  auto expired = [&](const Peer &peer)
+  { return !peer.configured && peer.last_seen < deadline; };
+  peers_.erase(std::remove_if(peers_.begin(), peers_.end(), expired), peers_.end());
+}
+
+UnicastDiscovery::Peer *UnicastDiscovery::peer(const sockaddr_in &addr)
+{
+  size_t learned = 0;
+  for (Peer &peer : peers_)
+  {
+    if (sameAddress(peer.addr, addr))
+    {
+      return &peer;
+    }
+    learned += peer.configured ? 0 : 1;
+  }
+  if (learned >= maxPeers_)
+  {
+    static LogRateLimit limit;
+    warnRateLimited(limit, "[UnicastDiscovery] Peer table full ({}), ignoring {}",
+                    maxPeers_, inet_ntoa(addr.sin_addr));
+    return nullptr;
+  }
+  Peer peer;
+  peer.addr = addr;
+  peers_.push_back(peer);
+  return &peers_.back();
+}
+
+bool UnicastDiscovery::isConfiguredPeer(const sockaddr_in &addr) const
+{
+  return std::any_of(peers_.begin(), peers_.end(), [&](const Peer &peer)
+                     { return peer.configured && sameAddress(peer.addr, addr); });
+}
+
+} // namespace zlc
@@ -1,41 +1,136 @@
 #include "zerolancom/nodes/zerolancom_node.hpp"
 
-#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 namespace zlc
 {
 
-ZeroLanComNode::ZeroLanComNode(const std::string &name, const std::string &ip,
-                               const std::string &group, int groupPort)
-    : ZeroLanComNode(name, ip, group, groupPort, "zlc_default_group_name")
+namespace
+{
+NodeOptions multicastOptions(const std::string &group, int groupPort,
+                             const std::string &groupName)
+{
+  NodeOptions options;
+  options.group = group;
+  options.group_port = groupPort;
+  options.group_name = groupName;
+  return options;
+}
+
+// The node's own IP first, then options.interfaces; unresolvable specs and
+// duplicates are skipped
+std::vector<NetworkInterface> discoveryInterfaces(const std::string &ip,
+                                                  const NodeOptions &options)
 {
+  std::string spec = ip;
+  if (options.subnet_prefix >= 0)
+  {
+    spec += "/" + std::to_string(options.subnet_prefix);
+  }
+  const NetworkInterface fallback{"", ip, DEFAULT_SUBNET_MASK};
+  std::vector<NetworkInterface> interfaces{
+      resolveNetworkInterface(spec).value_or(fallback)};
+
+  for (const std::string &extra : options.interfaces)
+  {
+    auto interface = resolveNetworkInterface(extra);
+    if (!interface)
+    {
+      continue;
+    }
+    auto same = [&](const NetworkInterface &other)
+    { return other.ip == interface->ip; };
+    if (std::none_of(interfaces.begin(), interfaces.end(), same))
+    {
+      interfaces.push_back(*interface);
+    }
+  }
+  return interfaces;
 }
+} // namespace
 
 ZeroLanComNode::ZeroLanComNode(const std::string &name, const std::string &ip,
                                const std::string &group, int groupPort,
                                const std::string &groupName)
+    : ZeroLanComNode(name, ip, multicastOptions(group, groupPort, groupName))
+{
+}
+
+ZeroLanComNode::ZeroLanComNode(const std::string &name, const std::string &ip,
+                               const NodeOptions &options)
+    : name_(name)
 {
   zlc::info("[ZeroLanComNode] Initializing ZeroLanComNode '{}' at {}", name, ip);
-  zlc::info("[ZeroLanComNode] Using multicast group {}:{} with group name '{}'", group,
-            groupPort, groupName);
-  ZMQContext::initExternal();
-  NodeInfoManager::initExternal(name, ip);
-  ServiceManager::initExternal(ip);
+  if (options.unicast.multicast || !options.unicast.enabled())
+  {
+    zlc::info("[ZeroLanComNode] Using multicast group {}:{} with group name '{}'",
+              options.group, options.group_port, options.group_name);
+  }
+  context_ = std::make_unique<ZMQContext>(options.zmq);
+  nodeInfoManager_ = std::make_unique<NodeInfoManager>(name, ip, *context_);
+  loadBalancer_ = std::make_unique<LoadBalancer>();
+  serviceManager_ = std::make_unique<ServiceManager>(*context_, ip);
 
   // Set service port in NodeInfoManager before starting multicast
-  NodeInfoManager::instance().setServicePort(ServiceManager::instance().service_port);
+  nodeInfoManager_->setServicePort(serviceManager_->service_port);
 
-  MulticastReceiver::initExternal(group, groupPort, ip, groupName);
-  MulticastSender::initExternal(group, groupPort, ip, groupName);
-  SubscriberManager::initExternal();
+  // Discovery runs on every interface; get_node_info and the services answer
+  // on all of them, so peers fetch and call through the one they heard us on
+  const std::vector<NetworkInterface> interfaces = discoveryInterfaces(ip, options);
+  std::vector<std::string> extra_ips;
+  for (const NetworkInterface &interface : interfaces)
+  {
+    zlc::info("[ZeroLanComNode] Discovering on {} ({}/{})",
+              interface.name.empty() ? "-" : interface.name, interface.ip,
+              interface.prefixLength());
+    if (interface.ip != ip && serviceManager_->bindInterface(interface.ip))
+    {
+      extra_ips.push_back(interface.ip);
+    }
+  }
+  nodeInfoManager_->setInterfaces(extra_ips);
 
-  // Register internal get_node_info service
+  nodeInfoManager_->setGroupName(options.group_name);
+  if (!options.discovery_cache.empty())
+  {
+    // Before anything subscribes, so cached publishers are connected at once
+    nodeInfoManager_->loadCache(options.discovery_cache);
+    nodeInfoManager_->setCachePath(options.discovery_cache);
+  }
+  if (options.unicast.multicast || !options.unicast.enabled())
+  {
+    multicastReceiver_ = std::make_unique<MulticastReceiver>(
+        *nodeInfoManager_, options.group, options.group_port, interfaces,
+        options.group_name);
+    multicastSender_ = std::make_unique<MulticastSender>(
+        *nodeInfoManager_, options.group, options.group_port, interfaces,
+        options.group_name, options.multicast_ttl);
+  }
+  if (options.unicast.enabled())
+  {
+    unicastDiscovery_ = std::make_unique<UnicastDiscovery>(
+        *nodeInfoManager_, options.group_name, options.unicast);
+  }
+  subscriberManager_ =
+      std::make_unique<SubscriberManager>(*context_, *nodeInfoManager_);
+
+  // Register internal get_node_info and get_metrics services
   registerGetNodeInfoService();
+  registerGetMetricsService();
 
-  MulticastSender::instance().start();
-  MulticastReceiver::instance().start();
-  ServiceManager::instance().start();
-  SubscriberManager::instance().start();
+  if (multicastSender_)
+  {
+    multicastSender_->start(options.threads.multicast_sender);
+    multicastReceiver_->start(options.threads.multicast_receiver);
+  }
+  if (unicastDiscovery_ && !unicastDiscovery_->start(options.threads.unicast_discovery))
+  {
+    unicastDiscovery_.reset();
+  }
+  serviceManager_->start(options.threads.service);
+  subscriberManager_->start(options.threads.subscriber);
   running = true;
 }
 
@@ -46,32 +141,56 @@ ZeroLanComNode::~ZeroLanComNode()
 
 void ZeroLanComNode::registerGetNodeInfoService()
 {
-  auto &serviceManager = ServiceManager::instance();
-  serviceManager.registerHandler<Empty, NodeInfo>(
-      "get_node_info",
-      [](const Empty &) -> NodeInfo
-      { return NodeInfoManager::instance().getLocalNodeInfo(); });
+  NodeInfoManager *nodes = nodeInfoManager_.get();
+  serviceManager_->registerHandler<Empty, NodeInfo>(
+      "get_node_info", [nodes](const Empty &) -> NodeInfo
+      { return nodes->getLocalNodeInfo(); });
+}
+
+void ZeroLanComNode::registerGetMetricsService()
+{
+  auto handler = [this](const Empty &) -> MetricsSnapshot { return getMetrics(); };
+
+  // "get_metrics" answers on any node's service port, like get_node_info;
+  // "<node>/get_metrics" is advertised so other nodes can find it by name
+  const std::string advertised = name_ + "/get_metrics";
+  serviceManager_->registerHandler<Empty, MetricsSnapshot>("get_metrics", handler);
+  serviceManager_->registerHandler<Empty, MetricsSnapshot>(advertised, handler);
+  nodeInfoManager_->registerLocalService(advertised, serviceManager_->service_port,
+                                         serviceManager_->service_ipc);
 }
 
 void ZeroLanComNode::stop()
 {
   running = false;
-  MulticastSender::instance().stop();
-  MulticastReceiver::instance().stop();
-  ServiceManager::instance().stop();
-  SubscriberManager::instance().stop();
+  if (!context_)
+  {
+    return; // already stopped
+  }
+
+  if (multicastSender_)
+  {
+    multicastSender_->stop();
+    multicastReceiver_->stop();
+  }
+  if (unicastDiscovery_)
+  {
+    unicastDiscovery_->stop();
+  }
+  serviceManager_->stop();
+  subscriberManager_->stop();
 
   // Destroy in reverse order of initialization, respecting dependencies
   // SubscriberManager subscribes to NodeInfoManager events, so destroy first
-  SubscriberManager::destroy();
-  ServiceManager::destroy();
-  MulticastReceiver::destroy();
-  MulticastSender::destroy();
-  NodeInfoManager::destroy();
-  ZMQContext::destroy();
-  // Shutdown logger before destroying singletons to avoid segfault during global dtors
-  zlc::info("[ZeroLanComNode] Shutdown complete.");
-  Logger::shutdown();
+  subscriberManager_.reset();
+  serviceManager_.reset();
+  unicastDiscovery_.reset();
+  multicastReceiver_.reset();
+  multicastSender_.reset();
+  loadBalancer_.reset();
+  nodeInfoManager_.reset();
+  context_.reset();
+  zlc::info("[ZeroLanComNode] Node '{}' stopped.", name_);
 }
 
 bool ZeroLanComNode::isRunning() const
@@ -79,4 +198,143 @@ bool ZeroLanComNode::isRunning() const
   return running;
 }
 
+uint16_t ZeroLanComNode::unicastDiscoveryPort() const
+{
+  return unicastDiscovery_ ? unicastDiscovery_->port() : 0;
+}
+
+void ZeroLanComNode::setServiceCompression(const std::string &service_name,
+                                           const CompressionConfig &config)
+{
+  serviceManager().setCompression(service_name, config);
+}
+
+bool ZeroLanComNode::setServiceLimits(const std::string &service_name,
+                                      const ServiceLimits &limits)
+{
+  return serviceManager().setLimits(service_name, limits);
+}
+
+void ZeroLanComNode::setLoadBalancing(const std::string &service_name,
+                                      const LoadBalancerOptions &options)
+{
+  loadBalancer().setOptions(service_name, options);
+}
+
+bool ZeroLanComNode::waitForService(const std::string &service_name,
+                                    int max_wait_ms) const
+{
+  const NodeInfoManager &nodes = nodeInfoManager();
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(max_wait_ms);
+  if (!nodes.waitUntil([&] { return nodes.getServiceInfo(service_name) != nullptr; },
+                       deadline))
+  {
+    zlc::warn("[Client] Timeout waiting for service '{}'", service_name);
+    return false;
+  }
+  zlc::trace("[Client] Service '{}' is now available.", service_name);
+  return true;
+}
+
+bool ZeroLanComNode::waitForService(const std::string &service_name, int max_wait_ms,
+                                    int /*check_interval_ms*/) const
+{
+  return waitForService(service_name, max_wait_ms);
+}
+
+bool ZeroLanComNode::waitForTopic(const std::string &topic_name, int max_wait_ms) const
+{
+  const NodeInfoManager &nodes = nodeInfoManager();
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(max_wait_ms);
+  if (!nodes.waitUntil([&] { return !nodes.getPublisherInfo(topic_name).empty(); },
+                       deadline))
+  {
+    zlc::warn("[Subscriber] Timeout waiting for topic '{}'", topic_name);
+    return false;
+  }
+  return true;
+}
+
+bool ZeroLanComNode::waitForAll(const std::vector<std::string> &service_names,
+                                std::chrono::steady_clock::time_point deadline) const
+{
+  const NodeInfoManager &nodes = nodeInfoManager();
+  std::vector<std::string> missing;
+  auto ready = [&]()
+  {
+    missing.clear();
+    for (const std::string &name : service_names)
+    {
+      if (nodes.getServiceInfo(name) == nullptr)
+      {
+        missing.push_back(name);
+      }
+    }
+    return missing.empty();
+  };
+  if (!nodes.waitUntil(ready, deadline))
+  {
+    std::string names;
+    for (const std::string &name : missing)
+    {
+      names += (names.empty() ? "'" : ", '") + name + "'";
+    }
+    zlc::warn("[Client] Timeout waiting for service(s) {}", names);
+    return false;
+  }
+  return true;
+}
+
+void ZeroLanComNode::registerRawServiceHandler(const std::string &service_name,
+                                               const ServiceCallback &handler)
+{
+  ServiceManager &services = serviceManager();
+  services.registerRawHandler(service_name, handler);
+  nodeInfoManager().registerLocalService(service_name, services.service_port,
+                                         services.service_ipc);
+}
+
+void ZeroLanComNode::registerRawSubscriber(const std::string &name,
+                                           const RawCallback &callback)
+{
+  subscriberManager().registerRawSubscriber(name, callback);
+}
+
+void ZeroLanComNode::registerRawSubscriber(const std::string &name,
+                                           const RawMessageCallback &callback)
+{
+  subscriberManager().registerRawSubscriber(name, callback);
+}
+
+void ZeroLanComNode::setSubscriberSocketOptions(const std::string &name,
+                                                const SocketOptions &options)
+{
+  subscriberManager().setSocketOptions(name, options);
+}
+
+void ZeroLanComNode::registerStreamSubscriber(const std::string &name,
+                                              const StreamCallback &callback,
+                                              int window)
+{
+  subscriberManager().registerStreamSubscriber(name, callback, window);
+}
+
+MetricsSnapshot ZeroLanComNode::getMetrics() const
+{
+  MetricsSnapshot snap = MetricsRegistry::global().snapshot();
+  snap.node = name_;
+  // The registry's gauge sums every node in the process; report this one's
+  snap.discovery.nodes =
+      nodeInfoManager_ ? static_cast<int64_t>(nodeInfoManager_->knownNodeCount()) : 0;
+  return snap;
+}
+
+ResponseStatus ZeroLanComNode::requestMetrics(const std::string &node_name,
+                                              MetricsSnapshot &metrics)
+{
+  return request(node_name + "/get_metrics", empty, metrics);
+}
+
 } // namespace zlc
@@ -26,6 +26,29 @@ ByteBuffer::~ByteBuffer()
   std::free(data);
 }
 
+ByteBuffer::ByteBuffer(ByteBuffer &&other) noexcept
+    : data(other.data), size(other.size), capacity(other.capacity)
+{
+  other.data = nullptr;
+  other.size = 0;
+  other.capacity = 0;
+}
+
+ByteBuffer &ByteBuffer::operator=(ByteBuffer &&other) noexcept
+{
+  if (this != &other)
+  {
+    std::free(data);
+    data = other.data;
+    size = other.size;
+    capacity = other.capacity;
+    other.data = nullptr;
+    other.size = 0;
+    other.capacity = 0;
+  }
+  return *this;
+}
+
 void ByteBuffer::write(const char *buf, size_t len)
 {
   if (size + len > capacity)
@@ -41,6 +64,15 @@ void ByteBuffer::write(const char *buf, size_t len)
   size += len;
 }
 
+uint8_t *ByteBuffer::release()
+{
+  uint8_t *block = data;
+  data = nullptr;
+  size = 0;
+  capacity = 0;
+  return block;
+}
+
 /* ================= Utilities ================= */
 
 std::string decodeServiceHeader(ByteView payload)
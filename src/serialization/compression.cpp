@@ -0,0 +1,434 @@
+#include "zerolancom/serialization/compression.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef ZLC_WITH_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#ifdef ZLC_WITH_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+#include "zerolancom/utils/exception.hpp"
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+
+std::atomic<uint64_t> maxDecompressed{DEFAULT_MAX_DECOMPRESSED_SIZE};
+
+// Longest output of one lz4 input byte (a match length byte adds up to 255)
+constexpr uint64_t LZ4_MAX_RATIO = 255;
+
+uint64_t elapsedNs(std::chrono::steady_clock::time_point start)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count());
+}
+
+#ifdef ZLC_WITH_ZSTD
+
+struct DDictDeleter
+{
+  void operator()(ZSTD_DDict *dict) const
+  {
+    ZSTD_freeDDict(dict);
+  }
+};
+
+// Process-wide zstd dictionaries keyed by dictionary ID
+std::shared_mutex &dictionaryMutex()
+{
+  static std::shared_mutex mutex;
+  return mutex;
+}
+
+std::unordered_map<uint32_t, std::unique_ptr<ZSTD_DDict, DDictDeleter>> &
+dictionaryRegistry()
+{
+  static std::unordered_map<uint32_t, std::unique_ptr<ZSTD_DDict, DDictDeleter>>
+      registry;
+  return registry;
+}
+
+ZSTD_DCtx *threadDCtx()
+{
+  struct DCtxHolder
+  {
+    ZSTD_DCtx *ctx{ZSTD_createDCtx()};
+    ~DCtxHolder()
+    {
+      ZSTD_freeDCtx(ctx);
+    }
+  };
+  static thread_local DCtxHolder holder;
+  return holder.ctx;
+}
+
+#endif
+
+} // namespace
+
+/* ================= CompressionStats ================= */
+
+void CompressionStats::record(uint64_t raw, uint64_t compressed, uint64_t ns)
+{
+  messages.fetch_add(1, std::memory_order_relaxed);
+  raw_bytes.fetch_add(raw, std::memory_order_relaxed);
+  compressed_bytes.fetch_add(compressed, std::memory_order_relaxed);
+  cpu_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+CompressionStatsSnapshot CompressionStats::snapshot() const
+{
+  CompressionStatsSnapshot snap;
+  snap.messages = messages.load(std::memory_order_relaxed);
+  snap.skipped = skipped.load(std::memory_order_relaxed);
+  snap.raw_bytes = raw_bytes.load(std::memory_order_relaxed);
+  snap.compressed_bytes = compressed_bytes.load(std::memory_order_relaxed);
+  snap.cpu_ns = cpu_ns.load(std::memory_order_relaxed);
+  return snap;
+}
+
+/* ================= Codec queries ================= */
+
+bool isCodecAvailable(CompressionCodec codec)
+{
+  switch (codec)
+  {
+  case CompressionCodec::NONE:
+    return true;
+  case CompressionCodec::LZ4:
+#ifdef ZLC_WITH_LZ4
+    return true;
+#else
+    return false;
+#endif
+  case CompressionCodec::ZSTD:
+#ifdef ZLC_WITH_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+const char *codecName(CompressionCodec codec)
+{
+  switch (codec)
+  {
+  case CompressionCodec::NONE:
+    return "none";
+  case CompressionCodec::LZ4:
+    return "lz4";
+  case CompressionCodec::ZSTD:
+    return "zstd";
+  }
+  return "unknown";
+}
+
+/* ================= Compressor ================= */
+
+struct Compressor::Impl
+{
+#ifdef ZLC_WITH_ZSTD
+  ZSTD_CCtx *cctx{nullptr};
+  ZSTD_CDict *cdict{nullptr};
+
+  ~Impl()
+  {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeCCtx(cctx);
+  }
+#endif
+};
+
+Compressor::Compressor() : impl_(std::make_unique<Impl>())
+{
+}
+
+Compressor::Compressor(const CompressionConfig &config)
+    : config_(config), impl_(std::make_unique<Impl>())
+{
+  if (!isCodecAvailable(config_.codec))
+  {
+    zlc::warn("[Compressor] Codec '{}' not available in this build, sending raw",
+              codecName(config_.codec));
+    config_.codec = CompressionCodec::NONE;
+    return;
+  }
+
+#ifdef ZLC_WITH_ZSTD
+  if (config_.codec == CompressionCodec::ZSTD)
+  {
+    impl_->cctx = ZSTD_createCCtx();
+    if (!config_.dictionary.empty())
+    {
+      int level = config_.level == 0 ? ZSTD_CLEVEL_DEFAULT : config_.level;
+      impl_->cdict = ZSTD_createCDict(config_.dictionary.data(),
+                                      config_.dictionary.size(), level);
+      // Local subscribers need the dictionary as well
+      registerCompressionDictionary(config_.dictionary);
+    }
+  }
+#endif
+}
+
+Compressor::~Compressor() = default;
+
+bool Compressor::enabled() const
+{
+  return config_.codec != CompressionCodec::NONE;
+}
+
+bool Compressor::compress(const ByteView &in, Bytes &out, MessageHeader &header)
+{
+  if (!enabled() || in.size < config_.threshold)
+  {
+    stats_.skipped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  size_t written = 0;
+
+  switch (config_.codec)
+  {
+#ifdef ZLC_WITH_LZ4
+  case CompressionCodec::LZ4:
+  {
+    const int srcSize = static_cast<int>(in.size);
+    out.resize(static_cast<size_t>(LZ4_compressBound(srcSize)));
+    const char *src = reinterpret_cast<const char *>(in.data);
+    char *dst = reinterpret_cast<char *>(out.data());
+    const int dstCapacity = static_cast<int>(out.size());
+    int rc = config_.level > 0
+                 ? LZ4_compress_HC(src, dst, srcSize, dstCapacity, config_.level)
+                 : LZ4_compress_default(src, dst, srcSize, dstCapacity);
+    written = rc > 0 ? static_cast<size_t>(rc) : 0;
+    break;
+  }
+#endif
+#ifdef ZLC_WITH_ZSTD
+  case CompressionCodec::ZSTD:
+  {
+    out.resize(ZSTD_compressBound(in.size));
+    size_t rc =
+        impl_->cdict
+            ? ZSTD_compress_usingCDict(impl_->cctx, out.data(), out.size(), in.data,
+                                       in.size, impl_->cdict)
+            : ZSTD_compressCCtx(impl_->cctx, out.data(), out.size(), in.data, in.size,
+                                config_.level == 0 ? ZSTD_CLEVEL_DEFAULT
+                                                   : config_.level);
+    written = ZSTD_isError(rc) ? 0 : rc;
+    break;
+  }
+#endif
+  default:
+    break;
+  }
+
+  uint64_t ns = elapsedNs(start);
+
+  if (written == 0 || written >= in.size)
+  {
+    // Codec failed or payload is incompressible; send it raw
+    stats_.skipped.fetch_add(1, std::memory_order_relaxed);
+    stats_.cpu_ns.fetch_add(ns, std::memory_order_relaxed);
+    return false;
+  }
+
+  out.resize(written);
+  stats_.record(in.size, written, ns);
+
+  header.flags |= MessageHeader::FLAG_COMPRESSED;
+  header.codec = config_.codec;
+  header.raw_size = in.size;
+  return true;
+}
+
+CompressionStatsSnapshot Compressor::stats() const
+{
+  return stats_.snapshot();
+}
+
+/* ================= Decompression ================= */
+
+void checkDecompressedSize(const MessageHeader &header, const ByteView &in)
+{
+  const uint64_t limit = maxDecompressed.load(std::memory_order_relaxed);
+  if (header.raw_size > limit)
+  {
+    throw DecodeException("decompressed size " + std::to_string(header.raw_size) +
+                          " exceeds limit " + std::to_string(limit));
+  }
+
+  switch (header.codec)
+  {
+  case CompressionCodec::LZ4:
+    // The lz4 API takes int sizes
+    if (in.size > static_cast<size_t>(INT_MAX) ||
+        header.raw_size > static_cast<uint64_t>(INT_MAX) ||
+        header.raw_size > in.size * LZ4_MAX_RATIO)
+    {
+      throw DecodeException("impossible lz4 raw size " +
+                            std::to_string(header.raw_size));
+    }
+    break;
+  case CompressionCodec::ZSTD:
+#ifdef ZLC_WITH_ZSTD
+  {
+    const unsigned long long content = ZSTD_getFrameContentSize(in.data, in.size);
+    if (content == ZSTD_CONTENTSIZE_ERROR ||
+        (content != ZSTD_CONTENTSIZE_UNKNOWN && content != header.raw_size))
+    {
+      throw DecodeException("zstd frame does not match raw size " +
+                            std::to_string(header.raw_size));
+    }
+  }
+#endif
+    break;
+  case CompressionCodec::NONE:
+    break;
+  }
+}
+
+void setMaxDecompressedSize(uint64_t bytes)
+{
+  maxDecompressed.store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t maxDecompressedSize()
+{
+  return maxDecompressed.load(std::memory_order_relaxed);
+}
+
+void decompress(const MessageHeader &header, const ByteView &in,
+                [[maybe_unused]] uint8_t *out, CompressionStats *stats)
+{
+  checkDecompressedSize(header, in);
+  auto start = std::chrono::steady_clock::now();
+
+  switch (header.codec)
+  {
+#ifdef ZLC_WITH_LZ4
+  case CompressionCodec::LZ4:
+  {
+    int rc = LZ4_decompress_safe(reinterpret_cast<const char *>(in.data),
+                                 reinterpret_cast<char *>(out),
+                                 static_cast<int>(in.size),
+                                 static_cast<int>(header.raw_size));
+    if (rc < 0 || static_cast<uint64_t>(rc) != header.raw_size)
+    {
+      throw DecodeException("corrupt lz4 payload");
+    }
+    break;
+  }
+#endif
+#ifdef ZLC_WITH_ZSTD
+  case CompressionCodec::ZSTD:
+  {
+    size_t rc = 0;
+    unsigned dictID = ZSTD_getDictID_fromFrame(in.data, in.size);
+    if (dictID != 0)
+    {
+      std::shared_lock lock(dictionaryMutex());
+      auto it = dictionaryRegistry().find(dictID);
+      if (it == dictionaryRegistry().end())
+      {
+        throw DecodeException("unknown zstd dictionary " + std::to_string(dictID));
+      }
+      rc = ZSTD_decompress_usingDDict(threadDCtx(), out, header.raw_size, in.data,
+                                      in.size, it->second.get());
+    }
+    else
+    {
+      rc = ZSTD_decompressDCtx(threadDCtx(), out, header.raw_size, in.data, in.size);
+    }
+    if (ZSTD_isError(rc) || rc != header.raw_size)
+    {
+      throw DecodeException("corrupt zstd payload");
+    }
+    break;
+  }
+#endif
+  default:
+    throw DecodeException(std::string("unsupported compression codec ") +
+                          codecName(header.codec));
+  }
+
+  if (stats)
+  {
+    stats->record(header.raw_size, in.size, elapsedNs(start));
+  }
+}
+
+void registerCompressionDictionary(const Bytes &dictionary)
+{
+#ifdef ZLC_WITH_ZSTD
+  unsigned dictID = ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+  if (dictID == 0)
+  {
+    zlc::warn("[Compressor] Ignoring raw-content dictionary without an ID");
+    return;
+  }
+
+  std::unique_lock lock(dictionaryMutex());
+  auto &registry = dictionaryRegistry();
+  if (registry.find(dictID) == registry.end())
+  {
+    ZSTD_DDict *ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    registry.emplace(dictID, std::unique_ptr<ZSTD_DDict, DDictDeleter>(ddict));
+  }
+#else
+  (void)dictionary;
+  zlc::warn("[Compressor] zstd not available, dictionary ignored");
+#endif
+}
+
+Bytes trainCompressionDictionary(const std::vector<Bytes> &samples,
+                                 size_t dictionary_size)
+{
+#ifdef ZLC_WITH_ZSTD
+  Bytes concatenated;
+  std::vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (const auto &sample : samples)
+  {
+    concatenated.insert(concatenated.end(), sample.begin(), sample.end());
+    sizes.push_back(sample.size());
+  }
+
+  Bytes dictionary(dictionary_size);
+  size_t rc = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(),
+                                    concatenated.data(), sizes.data(),
+                                    static_cast<unsigned>(sizes.size()));
+  if (ZDICT_isError(rc))
+  {
+    throw std::runtime_error(std::string("zstd dictionary training failed: ") +
+                             ZDICT_getErrorName(rc));
+  }
+  dictionary.resize(rc);
+  return dictionary;
+#else
+  (void)samples;
+  (void)dictionary_size;
+  throw std::runtime_error("zstd dictionary training requires ZLC_WITH_ZSTD");
+#endif
+}
+
+} // namespace zlc
@@ -0,0 +1,153 @@
+#include "zerolancom/serialization/message_header.hpp"
+
+#include <time.h>
+
+#include "zerolancom/utils/exception.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+
+void writeU64(Bytes &buf, uint64_t val)
+{
+  for (int shift = 56; shift >= 0; shift -= 8)
+  {
+    buf.push_back(static_cast<uint8_t>((val >> shift) & 0xFF));
+  }
+}
+
+void writeU32(Bytes &buf, uint32_t val)
+{
+  for (int shift = 24; shift >= 0; shift -= 8)
+  {
+    buf.push_back(static_cast<uint8_t>((val >> shift) & 0xFF));
+  }
+}
+
+uint32_t readU32(const uint8_t *data)
+{
+  uint32_t val = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    val = (val << 8) | data[i];
+  }
+  return val;
+}
+
+uint64_t readU64(const uint8_t *data)
+{
+  uint64_t val = 0;
+  for (int i = 0; i < 8; ++i)
+  {
+    val = (val << 8) | data[i];
+  }
+  return val;
+}
+
+void requireBytes(size_t offset, size_t needed, size_t size)
+{
+  if (offset + needed > size)
+  {
+    throw DecodeException("MessageHeader: truncated header frame");
+  }
+}
+
+} // namespace
+
+uint64_t traceClockNow(TraceClock clock)
+{
+  timespec ts{};
+  clock_gettime(clock == TraceClock::REALTIME ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+Bytes MessageHeader::encode() const
+{
+  Bytes buf;
+  if (empty())
+    return buf;
+
+  buf.reserve(48);
+  buf.push_back(flags);
+
+  if (compressed())
+  {
+    buf.push_back(static_cast<uint8_t>(codec));
+    writeU64(buf, raw_size);
+  }
+
+  if (chunked())
+  {
+    writeU64(buf, stream_id);
+    writeU64(buf, offset);
+    writeU64(buf, total_size);
+    writeU32(buf, chunk_size);
+  }
+
+  if (sequenced())
+  {
+    writeU32(buf, publisher_id);
+    writeU64(buf, seq);
+  }
+
+  if (timestamped())
+  {
+    buf.push_back(static_cast<uint8_t>(clock));
+    writeU64(buf, publish_ns);
+    writeU64(buf, send_ns);
+  }
+
+  return buf;
+}
+
+MessageHeader MessageHeader::decode(const uint8_t *data, size_t size)
+{
+  MessageHeader header;
+  if (size == 0)
+    return header;
+
+  size_t offset = 0;
+  header.flags = data[offset++];
+
+  if (header.compressed())
+  {
+    requireBytes(offset, 9, size);
+    header.codec = static_cast<CompressionCodec>(data[offset]);
+    header.raw_size = readU64(data + offset + 1);
+    offset += 9;
+  }
+
+  if (header.chunked())
+  {
+    requireBytes(offset, 28, size);
+    header.stream_id = readU64(data + offset);
+    header.offset = readU64(data + offset + 8);
+    header.total_size = readU64(data + offset + 16);
+    header.chunk_size = readU32(data + offset + 24);
+    offset += 28;
+  }
+
+  if (header.sequenced())
+  {
+    requireBytes(offset, 12, size);
+    header.publisher_id = readU32(data + offset);
+    header.seq = readU64(data + offset + 4);
+    offset += 12;
+  }
+
+  if (header.timestamped())
+  {
+    requireBytes(offset, 17, size);
+    header.clock = static_cast<TraceClock>(data[offset]);
+    header.publish_ns = readU64(data + offset + 1);
+    header.send_ns = readU64(data + offset + 9);
+    offset += 17;
+  }
+
+  return header;
+}
+
+} // namespace zlc
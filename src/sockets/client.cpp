@@ -1,48 +1,219 @@
 #include "zerolancom/sockets/client.hpp"
+
+#include <unordered_map>
+
 #include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/nodes/zerolancom_node.hpp"
+#include "zerolancom/utils/exception.hpp"
 
 namespace zlc
 {
 
+namespace
+{
+CompressionStats &responseDecompressionStats()
+{
+  static CompressionStats stats;
+  return stats;
+}
+
+// Registry entries live as long as the process, so each calling thread
+// resolves a service once and then skips the registry lock
+ServiceMetrics &callMetrics(const std::string &service_name)
+{
+  thread_local std::unordered_map<std::string, ServiceMetrics *> cache;
+  thread_local const std::string *last_name = nullptr;
+  thread_local ServiceMetrics *last = nullptr;
+  if (last_name != nullptr && *last_name == service_name)
+  {
+    return *last;
+  }
+
+  auto it = cache.find(service_name);
+  if (it == cache.end())
+  {
+    it = cache.emplace(service_name, &MetricsRegistry::global().service(service_name))
+             .first;
+  }
+  last_name = &it->first;
+  last = it->second;
+  return *last;
+}
+} // namespace
+
 void Client::sendRequest(const std::string &service_name, const ByteView &payload,
-                         ZMQSocket &socket)
+                         ZMQSocket &socket, const MessageHeader &header)
 {
   // Send service name frame
   socket.send(zmq::buffer(service_name), zmq::send_flags::sndmore);
 
+  // Optional header frame (chunk requests)
+  if (!header.empty())
+  {
+    Bytes header_bytes = header.encode();
+    socket.send(zmq::buffer(header_bytes), zmq::send_flags::sndmore);
+  }
+
   // Send payload frame
   socket.send(zmq::buffer(payload.data, payload.size), zmq::send_flags::none);
 
-  zlc::info("[Client] Sent request to service '{}'", service_name);
+  zlc::trace("[Client] Sent request to service '{}'", service_name);
 }
 
-void Client::receiveResponse(ZMQSocket &socket, zmq::message_t &payloadMsg,
-                             const std::string &service_name)
+ResponseStatus Client::receiveResponse(ZMQSocket &socket, zmq::message_t &payloadMsg,
+                                      const std::string &service_name,
+                                      MessageHeader *header)
 {
   zmq::message_t statusMsg;
 
   if (!socket.recv(statusMsg, zmq::recv_flags::none))
   {
     zlc::error("Timeout waiting for response from service {}", service_name);
-    return;
+    return ResponseStatus::SERVICE_TIMEOUT;
+  }
+
+  zmq::message_t headerMsg;
+  if (statusMsg.size() != 1 || !statusMsg.more() ||
+      !socket.recv(headerMsg, zmq::recv_flags::none) || !headerMsg.more())
+  {
+    zlc::error("Malformed response received from service {}", service_name);
+    return ResponseStatus::INVALID_RESPONSE;
   }
 
-  if (!statusMsg.more())
+  ResponseStatus status =
+      static_cast<ResponseStatus>(*static_cast<const uint8_t *>(statusMsg.data()));
+
+  MessageHeader responseHeader;
+  try
+  {
+    responseHeader = MessageHeader::decode(
+        static_cast<const uint8_t *>(headerMsg.data()), headerMsg.size());
+  }
+  catch (const DecodeException &e)
   {
-    zlc::error("No payload frame received for service response from {}", service_name);
-    return;
+    zlc::error("Invalid response header from service {}: {}", service_name, e.what());
+    return ResponseStatus::INVALID_RESPONSE;
+  }
+
+  std::string detail;
+  if (responseHeader.flags & Response::FLAG_HAS_DETAIL)
+  {
+    zmq::message_t detailMsg;
+    if (!socket.recv(detailMsg, zmq::recv_flags::none) || !detailMsg.more())
+    {
+      zlc::error("No payload frame received for service response from {}",
+                 service_name);
+      return ResponseStatus::INVALID_RESPONSE;
+    }
+    detail = detailMsg.to_string();
   }
 
   if (!socket.recv(payloadMsg, zmq::recv_flags::none))
   {
     zlc::error("Timeout waiting for payload from service {}", service_name);
-    return;
+    return ResponseStatus::SERVICE_TIMEOUT;
   }
 
   if (payloadMsg.more())
   {
     zlc::error("More frames received than expected from service {}", service_name);
   }
+
+  if (is_error(status))
+  {
+    zlc::error("Service {} failed with {}{}{}", service_name,
+               Response::description(status), detail.empty() ? "" : ": ", detail);
+    return status;
+  }
+
+  if (responseHeader.compressed())
+  {
+    // Decompress straight into a message the caller decodes from
+    const ByteView compressed{static_cast<const uint8_t *>(payloadMsg.data()),
+                              payloadMsg.size()};
+    try
+    {
+      checkDecompressedSize(responseHeader, compressed);
+      zmq::message_t raw(responseHeader.raw_size);
+      decompress(responseHeader, compressed, static_cast<uint8_t *>(raw.data()),
+                 &responseDecompressionStats());
+      payloadMsg = std::move(raw);
+    }
+    catch (const DecodeException &e)
+    {
+      zlc::error("Invalid compressed response from service {}: {}", service_name,
+                 e.what());
+      return ResponseStatus::INVALID_RESPONSE;
+    }
+  }
+
+  if (header)
+  {
+    *header = responseHeader;
+  }
+  return status;
+}
+
+ResponseStatus Client::zlcRequestRaw(ZMQContext &context,
+                                     const std::string &service_name,
+                                     const std::string &service_url,
+                                     const ByteView &request, zmq::message_t &response,
+                                     int timeout_ms)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  ZMQSocket req_socket = context.createTempSocket(zmq::socket_type::req);
+  if (timeout_ms >= 0)
+  {
+    req_socket.set(zmq::sockopt::rcvtimeo, timeout_ms);
+    req_socket.set(zmq::sockopt::linger, 0);
+  }
+  req_socket.connect(service_url);
+
+  sendRequest(service_name, request, req_socket);
+  ResponseStatus status = receiveResponse(req_socket, response, service_name);
+
+  req_socket.close();
+  recordCall(service_name, status, start);
+  return status;
+}
+
+void Client::recordCall(const std::string &service_name, ResponseStatus status,
+                        std::chrono::steady_clock::time_point start)
+{
+  ServiceMetrics &metrics = callMetrics(service_name);
+  metrics.call_latency.record(std::chrono::steady_clock::now() - start);
+  metrics.calls.add();
+  if (is_error(status))
+  {
+    metrics.call_failures.add();
+  }
+}
+
+std::string Client::serviceURL(const NodeInfoManager &nodes,
+                               const std::string &service_name)
+{
+  std::string url = nodes.getServiceURL(service_name);
+  if (url.empty())
+  {
+    zlc::error("Service {} is not available", service_name);
+  }
+  return url;
+}
+
+ZMQContext &Client::defaultContext()
+{
+  return ZeroLanComNode::instance().context();
+}
+
+const NodeInfoManager &Client::defaultNodeInfoManager()
+{
+  return ZeroLanComNode::instance().nodeInfoManager();
+}
+
+CompressionStatsSnapshot Client::decompressionStats()
+{
+  return responseDecompressionStats().snapshot();
 }
 
 } // namespace zlc
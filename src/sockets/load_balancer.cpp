@@ -0,0 +1,151 @@
+#include "zerolancom/sockets/load_balancer.hpp"
+
+#include <algorithm>
+
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+void LoadBalancer::setOptions(const std::string &service_name,
+                              const LoadBalancerOptions &options)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  services_[service_name].options = options;
+}
+
+LoadBalancerOptions LoadBalancer::options(const std::string &service_name) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = services_.find(service_name);
+  return it == services_.end() ? LoadBalancerOptions{} : it->second.options;
+}
+
+std::string LoadBalancer::acquire(const std::string &service_name,
+                                  const std::vector<SocketInfo> &providers)
+{
+  if (providers.empty())
+  {
+    return {};
+  }
+
+  // Sorted, so round-robin does not depend on discovery order
+  std::vector<std::string> urls;
+  urls.reserve(providers.size());
+  for (const SocketInfo &provider : providers)
+  {
+    urls.push_back(provider.url());
+  }
+  std::sort(urls.begin(), urls.end());
+  urls.erase(std::unique(urls.begin(), urls.end()), urls.end());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ServiceState &state = services_[service_name];
+
+  for (auto it = state.endpoints.begin(); it != state.endpoints.end();)
+  {
+    const bool gone = !std::binary_search(urls.begin(), urls.end(), it->first);
+    it = gone && it->second.outstanding == 0 ? state.endpoints.erase(it) : ++it;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<std::string> candidates;
+  for (const std::string &url : urls)
+  {
+    if (state.endpoints[url].ejected_until <= now)
+    {
+      candidates.push_back(url);
+    }
+  }
+  if (candidates.empty())
+  {
+    candidates = urls;
+  }
+
+  // Ties go to the next provider in round-robin order
+  const size_t start = state.next++ % candidates.size();
+  size_t best = start;
+  auto cost = [&](size_t i)
+  {
+    const Endpoint &endpoint = state.endpoints[candidates[i]];
+    switch (state.options.policy)
+    {
+    case LoadBalancePolicy::LEAST_OUTSTANDING:
+      return static_cast<double>(endpoint.outstanding);
+    case LoadBalancePolicy::EWMA:
+      // Unmeasured providers are almost free, so each gets tried
+      return (endpoint.ewma_ns + 1.0) * (endpoint.outstanding + 1);
+    case LoadBalancePolicy::ROUND_ROBIN:
+      break;
+    }
+    return 0.0;
+  };
+  for (size_t n = 1; n < candidates.size(); ++n)
+  {
+    const size_t i = (start + n) % candidates.size();
+    if (cost(i) < cost(best))
+    {
+      best = i;
+    }
+  }
+
+  ++state.endpoints[candidates[best]].outstanding;
+  return candidates[best];
+}
+
+void LoadBalancer::release(const std::string &service_name, const std::string &url,
+                           ResponseStatus status, std::chrono::nanoseconds latency)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto service = services_.find(service_name);
+  if (service == services_.end())
+  {
+    return;
+  }
+  auto it = service->second.endpoints.find(url);
+  if (it == service->second.endpoints.end())
+  {
+    return;
+  }
+
+  Endpoint &endpoint = it->second;
+  const LoadBalancerOptions &options = service->second.options;
+  endpoint.outstanding = std::max(endpoint.outstanding - 1, 0);
+
+  if (status == ResponseStatus::SERVICE_TIMEOUT || status == ResponseStatus::NOSERVICE)
+  {
+    endpoint.ejected_until =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(options.eject_ms);
+    zlc::warn("[LoadBalancer] Ejecting {} from '{}' for {} ms", url, service_name,
+              options.eject_ms);
+  }
+  else if (status == ResponseStatus::OVERLOADED)
+  {
+    endpoint.ejected_until = std::chrono::steady_clock::now() +
+                             std::chrono::milliseconds(options.overload_backoff_ms);
+  }
+  else if (status == ResponseStatus::SUCCESS)
+  {
+    const double sample = static_cast<double>(latency.count());
+    endpoint.ewma_ns = endpoint.ewma_ns == 0.0
+                           ? sample
+                           : options.ewma_alpha * sample +
+                                 (1.0 - options.ewma_alpha) * endpoint.ewma_ns;
+  }
+}
+
+bool LoadBalancer::isEjected(const std::string &service_name,
+                             const std::string &url) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto service = services_.find(service_name);
+  if (service == services_.end())
+  {
+    return false;
+  }
+  auto it = service->second.endpoints.find(url);
+  return it != service->second.endpoints.end() &&
+         it->second.ejected_until > std::chrono::steady_clock::now();
+}
+
+} // namespace zlc
@@ -1,31 +1,97 @@
 #include "zerolancom/sockets/service_manager.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iterator>
+#include <unistd.h>
 
 #include "zerolancom/utils/exception.hpp"
 
 namespace zlc
 {
 
-ServiceManager::ServiceManager(const std::string &ip)
+namespace
 {
-  res_socket_ = ZMQContext::createSocket(zmq::socket_type::rep);
+// Payloads this small fit in a ZMQ very-small-message and are cheaper to copy
+// than to hand over (which allocates a refcounted content block)
+constexpr size_t ZERO_COPY_MIN_SIZE = 32;
+
+// Adaptive limits: multiplicative decrease, and how fast the latency baseline
+// creeps up so a lasting change in handler cost becomes the new normal
+constexpr double AIMD_BACKOFF = 0.9;
+constexpr double BASELINE_DRIFT = 1.01;
+
+void freeByteBuffer(void *data, void *)
+{
+  std::free(data);
+}
+} // namespace
+
+ServiceManager::ServiceManager(ZMQContext &context, const std::string &ip)
+{
+  res_socket_ = context.createSocket(zmq::socket_type::router);
   res_socket_->set(zmq::sockopt::rcvtimeo, SOCKET_TIMEOUT_MS);
   res_socket_->bind("tcp://" + ip + ":0");
   service_port = getBoundPort(*res_socket_);
+  service_ipc = bindIpcEndpoint(*res_socket_);
+
+  if (::pipe(wake_fds_) != 0)
+  {
+    zlc::error("[ServiceManager] Cannot create wake-up pipe; limited services "
+               "will answer on the next poll only");
+    wake_fds_[0] = wake_fds_[1] = -1;
+  }
+  for (int fd : wake_fds_)
+  {
+    if (fd >= 0)
+    {
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+      ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+  }
 
   zlc::info("[ServiceManager] ServiceManager bound to port {}", service_port);
 }
 
+bool ServiceManager::bindInterface(const std::string &ip)
+{
+  try
+  {
+    res_socket_->bind("tcp://" + ip + ":" + std::to_string(service_port));
+    return true;
+  }
+  catch (const zmq::error_t &e)
+  {
+    zlc::warn("[ServiceManager] Cannot also bind {}:{}: {}", ip, service_port,
+              e.what());
+    return false;
+  }
+}
+
 ServiceManager::~ServiceManager()
 {
   stop();
+  for (int fd : wake_fds_)
+  {
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+  }
 }
 
-void ServiceManager::start()
+void ServiceManager::start(const ThreadOptions &thread)
 {
+  thread_options_ = thread;
   running_ = true;
-  thread_ = std::thread([this]() { this->run(); });
+  thread_ = std::thread(
+      [this, thread]()
+      {
+        configureCurrentThread("zlc-service", thread);
+        this->run();
+      });
 }
 
 void ServiceManager::stop()
@@ -38,107 +104,385 @@ void ServiceManager::stop()
       thread_.join();
     }
   }
+
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(admission_mutex_);
+    stopping_ = true;
+    for (auto &[name, admission] : admissions_)
+    {
+      admission->ready.notify_all();
+      std::move(admission->workers.begin(), admission->workers.end(),
+                std::back_inserter(workers));
+      admission->workers.clear();
+    }
+  }
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
 }
 
 void ServiceManager::run()
 {
+  // pollOnce() waits in zmq::poll, so there is no sleep between requests
   while (running_)
   {
     pollOnce();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
 }
 
+void ServiceManager::addHandler(const std::string &name, ServiceCallback handler)
+{
+  auto shared = std::make_shared<const ServiceCallback>(std::move(handler));
+  ServiceMetrics *metrics = &MetricsRegistry::global().service(name);
+  std::unique_lock lock(handlers_mutex_);
+  handlers_[name] = std::move(shared);
+  metrics_[name] = metrics;
+}
+
+void ServiceManager::addStreamHandler(const std::string &name,
+                                      StreamServiceCallback handler)
+{
+  auto shared = std::make_shared<const StreamServiceCallback>(std::move(handler));
+  ServiceMetrics *metrics = &MetricsRegistry::global().service(name);
+  std::unique_lock lock(handlers_mutex_);
+  stream_handlers_[name] = std::move(shared);
+  metrics_[name] = metrics;
+}
+
+ServiceMetrics *ServiceManager::findMetrics(const std::string &service_name) const
+{
+  std::shared_lock lock(handlers_mutex_);
+  auto it = metrics_.find(service_name);
+  return it == metrics_.end() ? nullptr : it->second;
+}
+
 void ServiceManager::handleRequest(const std::string &service_name,
                                    const ByteView &payload, Response &response)
 {
-  auto it = handlers_.find(service_name);
+  std::shared_ptr<const ServiceCallback> handler;
+  {
+    std::shared_lock lock(handlers_mutex_);
+    auto it = handlers_.find(service_name);
+    if (it != handlers_.end())
+    {
+      handler = it->second;
+    }
+  }
 
-  zlc::info("[ServiceManager] Handling request for service '{}'", service_name);
+  zlc::trace("[ServiceManager] Handling request for service '{}'", service_name);
 
-  if (it == handlers_.end())
+  if (!handler)
   {
     response.code = ResponseStatus::NOSERVICE;
     return;
   }
 
   response.code = ResponseStatus::SUCCESS;
+  auto start = std::chrono::steady_clock::now();
 
   try
   {
-    response.payload = it->second(payload);
+    (*handler)(payload, response.payload);
   }
   catch (const DecodeException &e)
   {
-    zlc::error("[ServiceManager] ZMQ error while handling service '{}': {}",
+    zlc::error("[ServiceManager] Cannot decode request for service '{}': {}",
                service_name, e.what());
-    response.code = ResponseStatus::INVALID_RESPONSE;
+    response.code = ResponseStatus::INVALID_REQUEST;
+    response.detail = e.what();
   }
   catch (const EncodeException &e)
   {
-    zlc::error("[ServiceManager] ZMQ error while handling service '{}': {}",
+    zlc::error("[ServiceManager] Cannot encode response of service '{}': {}",
                service_name, e.what());
-    response.code = ResponseStatus::INVALID_REQUEST;
+    response.code = ResponseStatus::INVALID_RESPONSE;
+    response.detail = e.what();
+  }
+  catch (const ServiceStatusException &e)
+  {
+    response.code = e.status();
+    response.detail = e.what();
   }
   catch (const std::exception &e)
   {
     zlc::error("[ServiceManager] Exception while handling service '{}': {}",
                service_name, e.what());
     response.code = ResponseStatus::SERVICE_FAIL;
+    response.detail = e.what();
+  }
+
+  recordRequest(service_name, response, start);
+}
+
+void ServiceManager::handleStreamRequest(const std::string &service_name,
+                                         const MessageHeader &request_header,
+                                         const ByteView &payload, Response &response,
+                                         MessageHeader &response_header)
+{
+  std::shared_ptr<const StreamServiceCallback> handler;
+  {
+    std::shared_lock lock(handlers_mutex_);
+    auto it = stream_handlers_.find(service_name);
+    if (it != stream_handlers_.end())
+    {
+      handler = it->second;
+    }
+  }
+
+  if (!handler)
+  {
+    response.code = ResponseStatus::NOSERVICE;
+    return;
+  }
+
+  response.code = ResponseStatus::SUCCESS;
+
+  size_t max_len = std::min(request_header.chunk_size == 0 ? DEFAULT_STREAM_CHUNK_SIZE
+                                                           : request_header.chunk_size,
+                            MAX_STREAM_CHUNK_SIZE);
+  auto start = std::chrono::steady_clock::now();
+  try
+  {
+    Bytes chunk;
+    uint64_t total_size = (*handler)(payload, request_header.offset, max_len, chunk);
+    response.payload.write(reinterpret_cast<const char *>(chunk.data()),
+                           std::min(chunk.size(), max_len));
+
+    response_header.flags |= MessageHeader::FLAG_CHUNKED;
+    response_header.stream_id = request_header.stream_id;
+    response_header.offset = request_header.offset;
+    response_header.total_size = total_size;
+    response_header.chunk_size = static_cast<uint32_t>(max_len);
+  }
+  catch (const DecodeException &e)
+  {
+    zlc::error("[ServiceManager] Invalid stream request for '{}': {}", service_name,
+               e.what());
+    response.code = ResponseStatus::INVALID_REQUEST;
+    response.detail = e.what();
+  }
+  catch (const std::exception &e)
+  {
+    zlc::error("[ServiceManager] Exception while streaming service '{}': {}",
+               service_name, e.what());
+    response.code = ResponseStatus::SERVICE_FAIL;
+    response.detail = e.what();
+  }
+
+  recordRequest(service_name, response, start);
+}
+
+void ServiceManager::recordRequest(const std::string &service_name,
+                                   const Response &response,
+                                   std::chrono::steady_clock::time_point start)
+{
+  ServiceMetrics *found = findMetrics(service_name);
+  if (found == nullptr)
+  {
+    return;
+  }
+
+  ServiceMetrics &metrics = *found;
+  metrics.handler_latency.record(std::chrono::steady_clock::now() - start);
+  metrics.requests.add();
+  if (is_error(response.code))
+  {
+    metrics.failures.add();
   }
 }
 
 void ServiceManager::clearHandlers()
 {
+  std::unique_lock lock(handlers_mutex_);
   handlers_.clear();
+  stream_handlers_.clear();
+  metrics_.clear();
 }
 
 void ServiceManager::removeHandler(const std::string &name)
 {
+  std::unique_lock lock(handlers_mutex_);
   handlers_.erase(name);
+  stream_handlers_.erase(name);
+  metrics_.erase(name);
 }
 
-void ServiceManager::pollOnce()
+/* ================= Admission Control ================= */
+
+bool ServiceManager::setLimits(const std::string &name, const ServiceLimits &limits)
 {
-  try
+  if (limits.max_concurrency < 1 || limits.max_queue < 0 ||
+      limits.latency_tolerance <= 1.0)
+  {
+    zlc::warn("[ServiceManager] Invalid limits for service '{}'", name);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(admission_mutex_);
+  if (stopping_)
+  {
+    return false;
+  }
+  if (admissions_.count(name) != 0)
   {
-    zmq::message_t service_name_msg;
+    zlc::warn("[ServiceManager] Limits of service '{}' are already set", name);
+    return false;
+  }
+
+  auto admission = std::make_unique<Admission>();
+  admission->limits = limits;
+  admission->limit = limits.max_concurrency;
+  for (int i = 0; i < limits.max_concurrency; ++i)
+  {
+    admission->workers.emplace_back(
+        [this, state = admission.get()]()
+        {
+          configureCurrentThread("zlc-svc-worker", thread_options_);
+          this->runWorker(*state);
+        });
+  }
+  admissions_[name] = std::move(admission);
+  zlc::info("[ServiceManager] Service '{}': {} concurrent, {} queued{}", name,
+            limits.max_concurrency, limits.max_queue,
+            limits.adaptive ? ", adaptive" : "");
+  return true;
+}
+
+int ServiceManager::concurrencyLimit(const std::string &name) const
+{
+  std::lock_guard<std::mutex> lock(admission_mutex_);
+  auto it = admissions_.find(name);
+  return it == admissions_.end() ? 0 : static_cast<int>(it->second->limit);
+}
 
-    if (!res_socket_->recv(service_name_msg, zmq::recv_flags::none))
+void ServiceManager::runWorker(Admission &admission)
+{
+  std::unique_lock<std::mutex> lock(admission_mutex_);
+  while (true)
+  {
+    auto runnable = [&]()
+    {
+      return !admission.queue.empty() &&
+             admission.inflight < static_cast<int>(admission.limit);
+    };
+    admission.ready.wait(lock, [&] { return stopping_ || runnable(); });
+    if (stopping_)
     {
       return;
     }
+    PendingRequest request = std::move(admission.queue.front());
+    admission.queue.pop_front();
+    ++admission.inflight;
+    lock.unlock();
 
-    std::string service_name = decodeServiceHeader(
-        ByteView{static_cast<const uint8_t *>(service_name_msg.data()),
-                 service_name_msg.size()});
+    CompletedResponse done;
+    done.identity = std::move(request.identity);
+    done.service_name = request.service_name;
+    const auto start = std::chrono::steady_clock::now();
+    process(request, done.response, done.header);
+    const auto latency = std::chrono::steady_clock::now() - start;
 
-    if (!service_name_msg.more())
+    lock.lock();
+    --admission.inflight;
+    if (admission.limits.adaptive)
     {
-      zlc::warn("[ServiceManager] Missing payload frame");
-      return;
+      adapt(admission, latency);
     }
+    completed_.push_back(std::move(done));
+    admission.ready.notify_one();
+    wake();
+  }
+}
 
-    zmq::message_t payload_msg;
-    if (!res_socket_->recv(payload_msg, zmq::recv_flags::none))
+void ServiceManager::adapt(Admission &admission, std::chrono::nanoseconds latency)
+{
+  const double sample = static_cast<double>(latency.count());
+  const double drifted = admission.baseline_ns * BASELINE_DRIFT;
+  admission.baseline_ns =
+      admission.baseline_ns == 0.0 ? sample : std::min(sample, drifted);
+
+  const double max = admission.limits.max_concurrency;
+  if (sample > admission.limits.latency_tolerance * admission.baseline_ns)
+  {
+    admission.limit = std::max(1.0, admission.limit * AIMD_BACKOFF);
+  }
+  else
+  {
+    admission.limit = std::min(max, admission.limit + 1.0 / admission.limit);
+  }
+}
+
+void ServiceManager::wake()
+{
+  const char byte = 1;
+  if (wake_fds_[1] >= 0 && ::write(wake_fds_[1], &byte, 1) < 0)
+  {
+    // Pipe full: the polling thread has a wake-up pending anyway
+  }
+}
+
+void ServiceManager::sendCompleted()
+{
+  std::vector<CompletedResponse> completed;
+  {
+    std::lock_guard<std::mutex> lock(admission_mutex_);
+    completed.swap(completed_);
+  }
+  for (CompletedResponse &done : completed)
+  {
+    sendResponse(done.identity, done.response, done.header, done.service_name);
+  }
+}
+
+void ServiceManager::setCompression(const std::string &name,
+                                    const CompressionConfig &config)
+{
+  std::lock_guard<std::mutex> lock(compression_mutex_);
+  compressors_[name] = std::make_unique<Compressor>(config);
+}
+
+CompressionStatsSnapshot ServiceManager::compressionStats(const std::string &name) const
+{
+  std::lock_guard<std::mutex> lock(compression_mutex_);
+  auto it = compressors_.find(name);
+  return it == compressors_.end() ? CompressionStatsSnapshot{} : it->second->stats();
+}
+
+void ServiceManager::pollOnce()
+{
+  try
+  {
+    zmq::pollitem_t items[] = {{res_socket_->handle(), 0, ZMQ_POLLIN, 0},
+                               {nullptr, wake_fds_[0], ZMQ_POLLIN, 0}};
+    const size_t count = wake_fds_[0] >= 0 ? 2 : 1;
+    if (zmq::poll(items, count, std::chrono::milliseconds(SOCKET_TIMEOUT_MS)) <= 0)
     {
+      sendCompleted();
       return;
     }
 
-    ByteView payload{static_cast<const uint8_t *>(payload_msg.data()),
-                     payload_msg.size()};
-
-    if (payload_msg.more())
+    if (count == 2 && (items[1].revents & ZMQ_POLLIN) != 0)
     {
-      zlc::warn("[ServiceManager] Extra frames received");
+      char buf[64];
+      while (::read(wake_fds_[0], buf, sizeof(buf)) > 0)
+      {
+      }
     }
+    sendCompleted();
 
-    Response response;
-    handleRequest(service_name, payload, response);
-
-    // Send response frames
-    res_socket_->send(zmq::buffer(response.code), zmq::send_flags::sndmore);
-    res_socket_->send(zmq::buffer(response.payload), zmq::send_flags::none);
+    // Take every waiting request, so overload is answered at once
+    while (true)
+    {
+      PendingRequest request;
+      if (!receiveRequest(request))
+      {
+        break;
+      }
+      dispatch(std::move(request));
+      sendCompleted();
+    }
   }
   catch (const zmq::error_t &e)
   {
@@ -151,4 +495,205 @@ void ServiceManager::pollOnce()
   }
 }
 
+bool ServiceManager::receiveRequest(PendingRequest &request)
+{
+  // [identity][][service]([header])[payload] from a REQ client
+  if (!res_socket_->recv(request.identity, zmq::recv_flags::dontwait))
+  {
+    return false;
+  }
+
+  zmq::message_t frame;
+  while (request.identity.more())
+  {
+    res_socket_->recv(frame, zmq::recv_flags::none);
+    if (frame.size() == 0)
+    {
+      break; // REQ envelope delimiter
+    }
+  }
+  if (!frame.more())
+  {
+    static LogRateLimit limit;
+    zlc::warnRateLimited(limit, "[ServiceManager] Missing service frame");
+    request.error = "missing service frame";
+    return true;
+  }
+
+  zmq::message_t service_name_msg;
+  res_socket_->recv(service_name_msg, zmq::recv_flags::none);
+  request.service_name = decodeServiceHeader(
+      ByteView{static_cast<const uint8_t *>(service_name_msg.data()),
+               service_name_msg.size()});
+
+  if (!service_name_msg.more())
+  {
+    static LogRateLimit limit;
+    zlc::warnRateLimited(limit, "[ServiceManager] Missing payload frame");
+    request.error = "missing payload frame";
+    return true;
+  }
+  if (request.service_name.empty())
+  {
+    request.error = "empty service name";
+  }
+
+  res_socket_->recv(request.payload, zmq::recv_flags::none);
+
+  // [service][header][payload] carries a chunk request
+  if (request.payload.more())
+  {
+    try
+    {
+      request.header = MessageHeader::decode(
+          static_cast<const uint8_t *>(request.payload.data()), request.payload.size());
+    }
+    catch (const DecodeException &e)
+    {
+      static LogRateLimit limit;
+      zlc::warnRateLimited(limit, "[ServiceManager] Invalid request header: {}",
+                           e.what());
+      request.valid_header = false;
+    }
+    res_socket_->recv(request.payload, zmq::recv_flags::none);
+  }
+
+  while (request.payload.more())
+  {
+    static LogRateLimit limit;
+    zlc::warnRateLimited(limit, "[ServiceManager] Extra frames received");
+    res_socket_->recv(frame, zmq::recv_flags::none);
+  }
+  return true;
+}
+
+void ServiceManager::dispatch(PendingRequest &&request)
+{
+  if (!request.error.empty())
+  {
+    // Answered at once: a ROUTER never replies on its own, so the caller
+    // would wait forever
+    Response response(ResponseStatus::INVALID_REQUEST);
+    response.detail = request.error;
+    MessageHeader header;
+    sendResponse(request.identity, response, header, request.service_name);
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(admission_mutex_);
+    auto it = admissions_.find(request.service_name);
+    if (it != admissions_.end())
+    {
+      Admission &admission = *it->second;
+      const int limit = static_cast<int>(admission.limit);
+      const int idle = std::max(limit - admission.inflight, 0);
+      if (static_cast<int>(admission.queue.size()) < idle + admission.limits.max_queue)
+      {
+        admission.queue.push_back(std::move(request));
+        admission.ready.notify_one();
+        return;
+      }
+      lock.unlock();
+
+      zlc::trace("[ServiceManager] Rejecting request for '{}': overloaded",
+                 request.service_name);
+      if (ServiceMetrics *metrics = findMetrics(request.service_name))
+      {
+        metrics->rejected.add();
+      }
+      Response response(ResponseStatus::OVERLOADED);
+      response.detail = "service overloaded";
+      MessageHeader header;
+      sendResponse(request.identity, response, header, request.service_name);
+      return;
+    }
+  }
+
+  Response response;
+  MessageHeader header;
+  process(request, response, header);
+  sendResponse(request.identity, response, header, request.service_name);
+}
+
+void ServiceManager::process(const PendingRequest &request, Response &response,
+                             MessageHeader &header)
+{
+  ByteView payload{static_cast<const uint8_t *>(request.payload.data()),
+                   request.payload.size()};
+  if (!request.valid_header)
+  {
+    response.code = ResponseStatus::INVALID_REQUEST;
+    response.detail = "invalid request header";
+  }
+  else if (request.header.chunked())
+  {
+    handleStreamRequest(request.service_name, request.header, payload, response,
+                        header);
+  }
+  else
+  {
+    handleRequest(request.service_name, payload, response);
+  }
+}
+
+void ServiceManager::sendResponse(zmq::message_t &identity, Response &response,
+                                  MessageHeader &header,
+                                  const std::string &service_name)
+{
+  // Compress the response payload if configured for this service
+  bool compressed = false;
+  {
+    std::lock_guard<std::mutex> lock(compression_mutex_);
+    auto it = compressors_.find(service_name);
+    compressed = it != compressors_.end() &&
+                 it->second->compress(ByteView{response.payload.data,
+                                               response.payload.size},
+                                      compressed_, header);
+  }
+
+  if (!response.detail.empty())
+  {
+    header.flags |= Response::FLAG_HAS_DETAIL;
+  }
+
+  res_socket_->send(identity, zmq::send_flags::sndmore);
+  res_socket_->send(zmq::message_t(), zmq::send_flags::sndmore);
+
+  uint8_t code = static_cast<uint8_t>(response.code);
+  res_socket_->send(zmq::buffer(&code, 1), zmq::send_flags::sndmore);
+
+  if (header.empty())
+  {
+    res_socket_->send(zmq::message_t(), zmq::send_flags::sndmore);
+  }
+  else
+  {
+    Bytes header_bytes = header.encode();
+    res_socket_->send(zmq::buffer(header_bytes), zmq::send_flags::sndmore);
+  }
+
+  if (!response.detail.empty())
+  {
+    res_socket_->send(zmq::buffer(response.detail), zmq::send_flags::sndmore);
+  }
+
+  if (compressed)
+  {
+    res_socket_->send(zmq::buffer(compressed_), zmq::send_flags::none);
+  }
+  else if (response.payload.size <= ZERO_COPY_MIN_SIZE)
+  {
+    res_socket_->send(zmq::buffer(response.payload.data, response.payload.size),
+                      zmq::send_flags::none);
+  }
+  else
+  {
+    // Hand the encode buffer to ZMQ; it frees the block once sent
+    size_t size = response.payload.size;
+    zmq::message_t payload_msg(response.payload.release(), size, freeByteBuffer);
+    res_socket_->send(payload_msg, zmq::send_flags::none);
+  }
+}
+
 } // namespace zlc
@@ -0,0 +1,671 @@
+#include "zerolancom/sockets/shm_transport.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+/* ================= Segment layout ================= */
+
+constexpr uint32_t SHM_MAX_READERS = 64;
+
+// One open reader; lets the writer undo what a reader that died left behind
+struct ShmReaderEntry
+{
+  std::atomic<uint32_t> pid;        // 0 = free
+  std::atomic<uint32_t> slot;       // slot index + 1 while read in place, else 0
+  std::atomic<uint32_t> generation; // generation `slot` belongs to
+  uint32_t reserved;
+};
+
+// [ShmRingHeader][slot 0][slot 1]...; each slot is a ShmSlot followed by data
+struct ShmRingHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t generation;
+  uint64_t slot_size;
+  uint64_t slot_stride;
+  std::atomic<uint64_t> latest;          // (seq << 16) | slot, seq 0 = empty
+  std::atomic<uint32_t> notify;          // futex word, bumped on every write
+  std::atomic<uint32_t> waiters;         // readers sleeping on `notify`
+  std::atomic<uint32_t> next_generation; // set once replaced by a bigger ring
+  std::atomic<uint32_t> closed;
+  std::atomic<uint32_t> attached; // open readers (generation 0 only)
+  ShmReaderEntry reader_table[SHM_MAX_READERS]; // generation 0 only
+};
+
+struct ShmSlot
+{
+  std::atomic<uint64_t> seq; // 0 while being written
+  std::atomic<uint32_t> readers;
+  uint32_t header_size;
+  uint64_t payload_size;
+};
+
+namespace
+{
+
+constexpr uint32_t SHM_MAGIC = 0x5A4C4352; // "ZLCR"
+constexpr uint32_t SHM_VERSION = 2;
+constexpr size_t SHM_ALIGN = 64;
+constexpr size_t SHM_HEADER_SIZE = 1152;
+constexpr size_t SHM_SLOT_HEADER_SIZE = SHM_ALIGN;
+constexpr uint32_t SHM_MAX_SLOTS = 0xFFFF;
+
+static_assert(sizeof(ShmRingHeader) <= SHM_HEADER_SIZE);
+static_assert(SHM_HEADER_SIZE % SHM_ALIGN == 0);
+static_assert(sizeof(ShmSlot) <= SHM_SLOT_HEADER_SIZE);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+size_t alignUp(size_t value)
+{
+  return (value + SHM_ALIGN - 1) / SHM_ALIGN * SHM_ALIGN;
+}
+
+std::string segmentName(const std::string &name, uint32_t generation)
+{
+  return generation == 0 ? name : name + "." + std::to_string(generation);
+}
+
+void futexWait(std::atomic<uint32_t> *word, uint32_t expected, int timeout_ms)
+{
+#ifdef __linux__
+  timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+  // Not FUTEX_PRIVATE: the word is shared between processes
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, &ts,
+          nullptr, 0);
+#else
+  (void)word;
+  (void)expected;
+  std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout_ms, 1)));
+#endif
+}
+
+void futexWakeAll(std::atomic<uint32_t> *word)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr,
+          nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+// A process we may not signal (EPERM) still exists
+bool processAlive(uint32_t pid)
+{
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+}
+
+void notifyReaders(ShmRingHeader *header)
+{
+  header->notify.fetch_add(1);
+  if (header->waiters.load() != 0)
+  {
+    futexWakeAll(&header->notify);
+  }
+}
+
+bool mapSegment(int fd, size_t size, ShmMapping &out)
+{
+  void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    return false;
+  }
+  out.base = base;
+  out.size = size;
+  return true;
+}
+
+bool createSegment(const std::string &name, uint32_t slots, size_t slot_size,
+                   uint32_t generation, ShmMapping &out)
+{
+  slot_size = alignUp(slot_size);
+  const size_t stride = SHM_SLOT_HEADER_SIZE + slot_size;
+  const size_t size = SHM_HEADER_SIZE + stride * slots;
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    zlc::warn("[ShmTransport] Cannot create segment '{}': {}", name,
+              std::strerror(errno));
+    return false;
+  }
+
+  // Reserve the pages now so a full /dev/shm fails here instead of SIGBUS later
+  int rc = ftruncate(fd, static_cast<off_t>(size));
+#ifdef __linux__
+  if (rc == 0)
+  {
+    rc = posix_fallocate(fd, 0, static_cast<off_t>(size));
+    errno = rc != 0 ? rc : errno;
+  }
+#endif
+  if (rc != 0 || !mapSegment(fd, size, out))
+  {
+    zlc::warn("[ShmTransport] Cannot allocate {} bytes for segment '{}': {}", size,
+              name, std::strerror(errno));
+    if (rc != 0)
+    {
+      close(fd);
+    }
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  auto *header = new (out.base) ShmRingHeader();
+  header->slot_count = slots;
+  header->generation = generation;
+  header->slot_size = slot_size;
+  header->slot_stride = stride;
+  header->version = SHM_VERSION;
+  header->magic = SHM_MAGIC;
+  return true;
+}
+
+bool openSegment(const std::string &name, ShmMapping &out)
+{
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < SHM_HEADER_SIZE)
+  {
+    close(fd);
+    return false;
+  }
+
+  ShmMapping mapping;
+  if (!mapSegment(fd, static_cast<size_t>(st.st_size), mapping))
+  {
+    return false;
+  }
+
+  const ShmRingHeader *header = mapping.header();
+  if (header->magic != SHM_MAGIC || header->version != SHM_VERSION ||
+      header->slot_count == 0 ||
+      SHM_HEADER_SIZE + header->slot_stride * header->slot_count > mapping.size)
+  {
+    zlc::warn("[ShmTransport] Segment '{}' has an unexpected layout", name);
+    return false;
+  }
+
+  out = std::move(mapping);
+  return true;
+}
+
+} // namespace
+
+/* ================= ShmMapping ================= */
+
+ShmMapping::~ShmMapping()
+{
+  if (base)
+  {
+    munmap(base, size);
+  }
+}
+
+ShmMapping::ShmMapping(ShmMapping &&other) noexcept : base(other.base), size(other.size)
+{
+  other.base = nullptr;
+  other.size = 0;
+}
+
+ShmMapping &ShmMapping::operator=(ShmMapping &&other) noexcept
+{
+  if (this != &other)
+  {
+    if (base)
+    {
+      munmap(base, size);
+    }
+    base = other.base;
+    size = other.size;
+    other.base = nullptr;
+    other.size = 0;
+  }
+  return *this;
+}
+
+ShmRingHeader *ShmMapping::header() const
+{
+  return static_cast<ShmRingHeader *>(base);
+}
+
+ShmSlot *ShmMapping::slot(uint32_t index) const
+{
+  return reinterpret_cast<ShmSlot *>(static_cast<uint8_t *>(base) + SHM_HEADER_SIZE +
+                                     header()->slot_stride * index);
+}
+
+uint8_t *ShmMapping::slotData(uint32_t index) const
+{
+  return reinterpret_cast<uint8_t *>(slot(index)) + SHM_SLOT_HEADER_SIZE;
+}
+
+/* ================= ShmRingWriter ================= */
+
+std::unique_ptr<ShmRingWriter> ShmRingWriter::create(const std::string &name,
+                                                     const SharedMemoryOptions &options)
+{
+  std::unique_ptr<ShmRingWriter> writer(new ShmRingWriter());
+  writer->name_ = name;
+  // The latest slot is never overwritten, so at least two are needed
+  writer->slots_ = std::clamp<uint32_t>(options.slots, 2, SHM_MAX_SLOTS);
+
+  if (!createSegment(name, writer->slots_, std::max<size_t>(options.slot_size, 1), 0,
+                     writer->first_))
+  {
+    return nullptr;
+  }
+  return writer;
+}
+
+ShmRingWriter::~ShmRingWriter()
+{
+  if (current_.base)
+  {
+    current_.header()->closed.store(1);
+    notifyReaders(current_.header());
+    shm_unlink(segmentName(name_, generation_).c_str());
+  }
+  if (first_.base)
+  {
+    first_.header()->closed.store(1);
+    notifyReaders(first_.header());
+    shm_unlink(name_.c_str());
+  }
+}
+
+bool ShmRingWriter::hasReaders()
+{
+  checkReaders();
+  return first_.header()->attached.load(std::memory_order_relaxed) != 0;
+}
+
+void ShmRingWriter::checkReaders()
+{
+  const auto now = std::chrono::steady_clock::now();
+  if (now < next_reader_check_)
+  {
+    return;
+  }
+  next_reader_check_ = now + std::chrono::milliseconds(READER_CHECK_INTERVAL_MS);
+
+  ShmRingHeader *root = first_.header();
+  if (root->attached.load(std::memory_order_relaxed) == 0)
+  {
+    return;
+  }
+
+  const ShmMapping &ring = current_.base ? current_ : first_;
+  for (ShmReaderEntry &entry : root->reader_table)
+  {
+    uint32_t pid = entry.pid.load();
+    if (pid == 0 || processAlive(pid))
+    {
+      continue;
+    }
+
+    // Release the slot it died reading, so the writer can use it again
+    const uint32_t slot = entry.slot.load();
+    if (slot != 0 && slot <= slots_ && entry.generation.load() == generation_)
+    {
+      std::atomic<uint32_t> &readers = ring.slot(slot - 1)->readers;
+      uint32_t count = readers.load();
+      while (count != 0 && !readers.compare_exchange_weak(count, count - 1))
+      {
+      }
+    }
+    entry.slot.store(0);
+
+    if (entry.pid.compare_exchange_strong(pid, 0))
+    {
+      root->attached.fetch_sub(1);
+      zlc::warn("[ShmTransport] Reader {} of '{}' exited without detaching", pid,
+                name_);
+    }
+  }
+}
+
+bool ShmRingWriter::grow(size_t needed)
+{
+  const ShmMapping &old = current_.base ? current_ : first_;
+  const size_t slot_size = std::max(needed, 2 * old.header()->slot_size);
+  const uint32_t generation = generation_ + 1;
+
+  ShmMapping next;
+  if (!createSegment(segmentName(name_, generation), slots_, slot_size, generation,
+                     next))
+  {
+    return false;
+  }
+
+  // Readers of older generations re-resolve through generation 0
+  first_.header()->next_generation.store(generation);
+  notifyReaders(first_.header());
+  if (current_.base)
+  {
+    current_.header()->next_generation.store(generation);
+    notifyReaders(current_.header());
+    shm_unlink(segmentName(name_, generation_).c_str());
+  }
+
+  current_ = std::move(next);
+  generation_ = generation;
+  next_slot_ = 0;
+
+  zlc::info("[ShmTransport] Segment '{}' grown to {} byte slots", name_,
+            current_.header()->slot_size);
+  return true;
+}
+
+bool ShmRingWriter::write(const ByteView &header, const ByteView &payload)
+{
+  const size_t needed = header.size + payload.size;
+  if (needed > (current_.base ? current_ : first_).header()->slot_size && !grow(needed))
+  {
+    ++dropped_;
+    return false;
+  }
+
+  const ShmMapping &ring = current_.base ? current_ : first_;
+  ShmRingHeader *ring_header = ring.header();
+
+  const uint64_t latest = ring_header->latest.load(std::memory_order_acquire);
+  const uint32_t latest_slot =
+      (latest >> 16) == 0 ? slots_ : static_cast<uint32_t>(latest & 0xFFFF);
+
+  for (uint32_t n = 0; n < slots_; ++n)
+  {
+    const uint32_t index = (next_slot_ + n) % slots_;
+    if (index == latest_slot)
+    {
+      continue;
+    }
+
+    // Claim the slot, then check that no reader got in first. Readers
+    // increment `readers` before re-checking `seq`, so one side always backs off.
+    ShmSlot *slot = ring.slot(index);
+    slot->seq.store(0);
+    if (slot->readers.load() != 0)
+    {
+      continue;
+    }
+
+    uint8_t *data = ring.slotData(index);
+    if (header.size != 0)
+    {
+      std::memcpy(data, header.data, header.size);
+    }
+    if (payload.size != 0)
+    {
+      std::memcpy(data + header.size, payload.data, payload.size);
+    }
+    slot->header_size = static_cast<uint32_t>(header.size);
+    slot->payload_size = payload.size;
+
+    ++seq_;
+    slot->seq.store(seq_, std::memory_order_release);
+    ring_header->latest.store((seq_ << 16) | index);
+    notifyReaders(ring_header);
+
+    next_slot_ = (index + 1) % slots_;
+    return true;
+  }
+
+  // Every other slot is still being read in place, or held by a dead reader
+  checkReaders();
+  ++dropped_;
+  return false;
+}
+
+/* ================= ShmRingReader ================= */
+
+std::unique_ptr<ShmRingReader> ShmRingReader::open(const std::string &name)
+{
+  std::unique_ptr<ShmRingReader> reader(new ShmRingReader());
+  reader->name_ = name;
+  if (!openSegment(name, reader->root_) || !openSegment(name, reader->mapping_))
+  {
+    return nullptr;
+  }
+
+  // Register in the reader table, so the writer notices if this process dies
+  ShmRingHeader *root = reader->root_.header();
+  const uint32_t pid = static_cast<uint32_t>(getpid());
+  for (ShmReaderEntry &entry : root->reader_table)
+  {
+    uint32_t free = 0;
+    if (entry.pid.compare_exchange_strong(free, pid))
+    {
+      entry.slot.store(0);
+      reader->entry_ = &entry;
+      break;
+    }
+  }
+  if (reader->entry_ == nullptr)
+  {
+    zlc::warn("[ShmTransport] Segment '{}' has {} readers already", name,
+              SHM_MAX_READERS);
+    return nullptr;
+  }
+  root->attached.fetch_add(1);
+
+  if (reader->mapping_.header()->next_generation.load() != 0)
+  {
+    reader->followGeneration();
+  }
+  return reader;
+}
+
+ShmRingReader::~ShmRingReader()
+{
+  if (entry_ != nullptr)
+  {
+    // Unless the writer already took this reader for dead
+    uint32_t pid = static_cast<uint32_t>(getpid());
+    if (entry_->pid.compare_exchange_strong(pid, 0))
+    {
+      root_.header()->attached.fetch_sub(1);
+    }
+  }
+}
+
+bool ShmRingReader::closed() const
+{
+  return detached_ || mapping_.header()->closed.load() != 0;
+}
+
+bool ShmRingReader::followGeneration()
+{
+  const uint32_t generation =
+      root_.header()->next_generation.load(std::memory_order_acquire);
+
+  ShmMapping next;
+  if (generation == 0 || !openSegment(segmentName(name_, generation), next))
+  {
+    detached_ = true;
+    return false;
+  }
+
+  mapping_ = std::move(next);
+  generation_ = generation;
+  return true;
+}
+
+bool ShmRingReader::readNext(const Handler &handler, int timeout_ms)
+{
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  while (!detached_)
+  {
+    ShmRingHeader *header = mapping_.header();
+
+    if (header->next_generation.load(std::memory_order_acquire) != 0)
+    {
+      followGeneration();
+      continue;
+    }
+
+    const uint64_t latest = header->latest.load(std::memory_order_acquire);
+    const uint64_t seq = latest >> 16;
+
+    if (seq != 0 && seq != last_seq_)
+    {
+      const uint32_t index = static_cast<uint32_t>(latest & 0xFFFF);
+      if (index >= header->slot_count)
+      {
+        detached_ = true;
+        return false;
+      }
+
+      ShmSlot *slot = mapping_.slot(index);
+      slot->readers.fetch_add(1);
+      if (slot->seq.load() != seq)
+      {
+        // Overwritten since `latest` was read; a newer message is available
+        slot->readers.fetch_sub(1);
+        continue;
+      }
+
+      // Recorded after the increment: if this process dies in between, the
+      // slot stays held rather than being released under a live reader
+      entry_->generation.store(generation_);
+      entry_->slot.store(index + 1);
+      struct ReadGuard
+      {
+        ShmSlot *slot;
+        ShmReaderEntry *entry;
+        ~ReadGuard()
+        {
+          entry->slot.store(0);
+          slot->readers.fetch_sub(1, std::memory_order_release);
+        }
+      } guard{slot, entry_};
+
+      const uint32_t header_size = slot->header_size;
+      const uint64_t payload_size = slot->payload_size;
+      if (header_size + payload_size > header->slot_size)
+      {
+        detached_ = true;
+        return false;
+      }
+
+      if (last_seq_ != 0 && seq > last_seq_ + 1)
+      {
+        skipped_ += seq - last_seq_ - 1;
+      }
+      last_seq_ = seq;
+      const uint8_t *data = mapping_.slotData(index);
+      handler(ByteView{data, header_size}, ByteView{data + header_size, payload_size});
+      return true;
+    }
+
+    if (header->closed.load() != 0)
+    {
+      return false;
+    }
+
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0)
+    {
+      return false;
+    }
+
+    // Re-check after sampling the futex word so a write in between is not missed
+    const uint32_t observed = header->notify.load();
+    if ((header->latest.load() >> 16) != seq || header->next_generation.load() != 0 ||
+        header->closed.load() != 0)
+    {
+      continue;
+    }
+
+    header->waiters.fetch_add(1);
+    futexWait(&header->notify, observed, static_cast<int>(remaining.count()));
+    header->waiters.fetch_sub(1);
+  }
+  return false;
+}
+
+/* ================= ShmSubscription ================= */
+
+ShmSubscription::ShmSubscription(std::unique_ptr<ShmRingReader> reader,
+                                 ShmRingReader::Handler handler, Counter *dropped,
+                                 const ThreadOptions &thread)
+    : reader_(std::move(reader)), handler_(std::move(handler)), dropped_(dropped),
+      thread_(
+          [this, thread]()
+          {
+            configureCurrentThread("zlc-shm-read", thread);
+            uint64_t reported = 0;
+            while (running_ && !reader_->closed())
+            {
+              try
+              {
+                reader_->readNext(handler_, 100);
+              }
+              catch (const std::exception &e)
+              {
+                static LogRateLimit limit;
+                zlc::errorRateLimited(
+                    limit, "[ShmTransport] Exception in subscriber callback: {}",
+                    e.what());
+              }
+              if (dropped_ && reader_->skipped() != reported)
+              {
+                dropped_->add(reader_->skipped() - reported);
+                reported = reader_->skipped();
+              }
+            }
+          })
+{
+}
+
+ShmSubscription::~ShmSubscription()
+{
+  running_ = false;
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+/* ================= Naming ================= */
+
+std::string makeShmSegmentName()
+{
+  static std::atomic<uint32_t> counter{0};
+  return "/zlc." + std::to_string(getpid()) + "." + std::to_string(counter++);
+}
+
+} // namespace zlc
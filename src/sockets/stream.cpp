@@ -0,0 +1,59 @@
+#include "zerolancom/sockets/stream.hpp"
+
+#include <cstring>
+
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+/* ================= StreamAssembler ================= */
+
+StreamAssembler::StreamAssembler(CompleteCallback on_complete, uint64_t max_blob_size)
+    : on_complete_(std::move(on_complete)), max_blob_size_(max_blob_size)
+{
+}
+
+void StreamAssembler::operator()(const StreamChunk &chunk)
+{
+  if (chunk.total_size > max_blob_size_)
+  {
+    zlc::warn("[StreamAssembler] Stream {} of {} bytes exceeds limit, dropped",
+              chunk.stream_id, chunk.total_size);
+    pending_.erase(chunk.stream_id);
+    return;
+  }
+
+  if (chunk.first())
+  {
+    Bytes &blob = pending_[chunk.stream_id];
+    blob.clear();
+    blob.reserve(chunk.total_size);
+  }
+
+  auto it = pending_.find(chunk.stream_id);
+  if (it == pending_.end())
+  {
+    return; // joined mid-stream
+  }
+
+  Bytes &blob = it->second;
+  if (blob.size() != chunk.offset)
+  {
+    zlc::warn("[StreamAssembler] Stream {} lost data at offset {}, dropped",
+              chunk.stream_id, blob.size());
+    pending_.erase(it);
+    return;
+  }
+
+  blob.insert(blob.end(), chunk.data.begin(), chunk.data.end());
+
+  if (chunk.last())
+  {
+    Bytes complete = std::move(blob);
+    pending_.erase(it);
+    on_complete_(chunk.stream_id, std::move(complete));
+  }
+}
+
+} // namespace zlc
@@ -0,0 +1,150 @@
+#include "zerolancom/sockets/stream_publisher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/nodes/zerolancom_node.hpp"
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+StreamPublisher::StreamPublisher(const std::string &topic_name,
+                                 const StreamOptions &options)
+    : StreamPublisher(ZeroLanComNode::instance(), topic_name, options)
+{
+}
+
+StreamPublisher::StreamPublisher(ZeroLanComNode &node, const std::string &topic_name,
+                                 const StreamOptions &options)
+    : topic_name_(topic_name), options_(options),
+      next_stream_id_(std::random_device{}()),
+      metrics_(&MetricsRegistry::global().topic(topic_name)),
+      compressor_(options.compression)
+{
+  if (options_.chunk_size == 0)
+  {
+    options_.chunk_size = DEFAULT_STREAM_CHUNK_SIZE;
+  }
+
+  // The window is the flow-control contract, so it wins over the node's HWM
+  SocketOptions socket_options;
+  socket_options.sndhwm = std::max(options_.window, 1);
+  socket_ = node.context().createSocket(zmq::socket_type::pub, socket_options);
+  socket_->set(zmq::sockopt::xpub_nodrop, 1);
+
+  NodeInfoManager &nodeInfoManager = node.nodeInfoManager();
+  const std::string address = nodeInfoManager.getLocalNodeInfo().ip;
+  socket_->bind("tcp://" + address + ":0");
+  port_ = getBoundPort(*socket_);
+
+  zlc::info("[StreamPublisher] Stream topic '{}' bound to port {}", topic_name_, port_);
+
+  nodeInfoManager.registerLocalTopic(topic_name_, static_cast<uint16_t>(port_), {},
+                                     bindIpcEndpoint(*socket_));
+}
+
+bool StreamPublisher::publish(const ByteView &blob)
+{
+  return publishChunks(blob.size, [&blob](uint64_t offset, size_t len)
+                       { return ByteView{blob.data + offset, len}; });
+}
+
+bool StreamPublisher::publish(std::istream &in, uint64_t total_size)
+{
+  return publish(total_size,
+                 [&in](uint64_t, uint8_t *dst, size_t len)
+                 {
+                   in.read(reinterpret_cast<char *>(dst),
+                           static_cast<std::streamsize>(len));
+                   if (static_cast<size_t>(in.gcount()) != len)
+                   {
+                     throw std::runtime_error("input ended early");
+                   }
+                 });
+}
+
+bool StreamPublisher::publish(uint64_t total_size, const ChunkSource &source)
+{
+  chunk_buffer_.resize(std::min<uint64_t>(options_.chunk_size, total_size));
+  return publishChunks(total_size,
+                       [this, &source](uint64_t offset, size_t len)
+                       {
+                         source(offset, chunk_buffer_.data(), len);
+                         return ByteView{chunk_buffer_.data(), len};
+                       });
+}
+
+bool StreamPublisher::publishChunks(
+    uint64_t total_size, const std::function<ByteView(uint64_t, size_t)> &next)
+{
+  MessageHeader header;
+  header.flags = MessageHeader::FLAG_CHUNKED;
+  header.stream_id = next_stream_id_++;
+  header.total_size = total_size;
+  header.chunk_size = options_.chunk_size;
+  metrics_->published.add();
+
+  uint64_t offset = 0;
+  do
+  {
+    size_t len = static_cast<size_t>(
+        std::min<uint64_t>(options_.chunk_size, total_size - offset));
+
+    ByteView chunk;
+    try
+    {
+      chunk = next(offset, len);
+    }
+    catch (const std::exception &e)
+    {
+      zlc::error("[StreamPublisher] Source for '{}' failed at offset {}: {}",
+                 topic_name_, offset, e.what());
+      return false;
+    }
+
+    header.offset = offset;
+    if (!sendChunk(header, chunk))
+    {
+      zlc::error("[StreamPublisher] Stream {} on '{}' stalled at offset {}",
+                 header.stream_id, topic_name_, offset);
+      return false;
+    }
+    offset += len;
+  } while (offset < total_size);
+
+  return true;
+}
+
+bool StreamPublisher::sendChunk(MessageHeader header, const ByteView &chunk)
+{
+  ByteView payload = chunk;
+  if (compressor_.enabled() && compressor_.compress(chunk, compressed_, header))
+  {
+    payload = ByteView{compressed_.data(), compressed_.size()};
+  }
+  Bytes header_bytes = header.encode();
+
+  // With XPUB_NODROP a full window makes the first frame fail with EAGAIN;
+  // the rest of a multipart message is always accepted once it has started.
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(options_.send_timeout_ms);
+  while (!socket_->send(zmq::buffer(header_bytes),
+                        zmq::send_flags::sndmore | zmq::send_flags::dontwait))
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  socket_->send(zmq::buffer(payload.data, payload.size), zmq::send_flags::none);
+  metrics_->published_bytes.add(header_bytes.size() + payload.size);
+  return true;
+}
+
+} // namespace zlc
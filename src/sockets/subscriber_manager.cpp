@@ -3,17 +3,51 @@
 #include <algorithm>
 #include <chrono>
 
+#include "zerolancom/utils/exception.hpp"
+
 namespace zlc
 {
 
-SubscriberManager::SubscriberManager()
+namespace
+{
+using SteadyTime = std::chrono::steady_clock::time_point;
+
+ByteView toByteView(const zmq::message_t &msg)
+{
+  return ByteView{static_cast<const uint8_t *>(msg.data()), msg.size()};
+}
+
+// Split a traced message's latency into its stages. Steady-clock instants
+// taken on this side are moved onto the publisher's trace clock first.
+void recordTrace(TopicMetrics &metrics, const MessageHeader &hdr, SteadyTime received,
+                 SteadyTime dispatched)
+{
+  using std::chrono::nanoseconds;
+
+  const SteadyTime done = std::chrono::steady_clock::now();
+  const int64_t now = static_cast<int64_t>(traceClockNow(hdr.clock));
+  const int64_t publish = static_cast<int64_t>(hdr.publish_ns);
+  const int64_t send = static_cast<int64_t>(hdr.send_ns);
+  const int64_t read = now - nanoseconds(done - received).count();
+
+  metrics.latency.record(nanoseconds(now - publish));
+  metrics.encode_latency.record(nanoseconds(send - publish));
+  metrics.transit_latency.record(nanoseconds(read - send));
+  metrics.drain_latency.record(dispatched - received);
+  metrics.dispatch_latency.record(done - dispatched);
+}
+} // namespace
+
+SubscriberManager::SubscriberManager(ZMQContext &context,
+                                     NodeInfoManager &nodeInfoManager)
+    : context_(context), nodeInfoManager_(nodeInfoManager)
 {
   // Subscribe to node/topic updates
-  NodeInfoManager::instance().node_update_event.subscribe(std::bind(
+  nodeInfoManager_.node_update_event.subscribe(std::bind(
       &SubscriberManager::updateTopicSubscriber, this, std::placeholders::_1));
 
   // Subscribe to node removal events
-  NodeInfoManager::instance().node_remove_event.subscribe(std::bind(
+  nodeInfoManager_.node_remove_event.subscribe(std::bind(
       &SubscriberManager::removeTopicSubscriber, this, std::placeholders::_1));
 }
 
@@ -22,10 +56,19 @@ SubscriberManager::~SubscriberManager()
   stop();
 }
 
-void SubscriberManager::start()
+void SubscriberManager::start(const ThreadOptions &thread)
 {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threadOptions_ = thread;
+  }
   running_ = true;
-  thread_ = std::thread([this]() { this->run(); });
+  thread_ = std::thread(
+      [this, thread]()
+      {
+        configureCurrentThread("zlc-sub", thread);
+        this->run();
+      });
 }
 
 void SubscriberManager::stop()
@@ -38,6 +81,20 @@ void SubscriberManager::stop()
       thread_.join();
     }
   }
+
+  // Join shm reader threads outside the lock; their callbacks may need it
+  std::vector<std::unique_ptr<ShmSubscription>> readers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &sub : subscribers_)
+    {
+      for (auto &[url, reader] : sub->shmReaders)
+      {
+        readers.push_back(std::move(reader));
+      }
+      sub->shmReaders.clear();
+    }
+  }
 }
 
 void SubscriberManager::run()
@@ -49,38 +106,163 @@ void SubscriberManager::run()
 }
 
 void SubscriberManager::_registerTopicSubscriber(
-    const std::string &topicName, const std::function<void(const ByteView &)> &callback)
+    const std::string &topicName, const std::function<void(const ByteView &)> &callback,
+    std::type_index localType,
+    const std::function<void(const std::shared_ptr<const void> &)> &localCallback)
+{
+  auto sub = std::make_unique<Subscriber>();
+  sub->callback = callback;
+  sub->localType = localType;
+  sub->localCallback = localCallback;
+  addSubscriber(topicName, std::move(sub), 0);
+}
+
+void SubscriberManager::registerStreamSubscriber(const std::string &topicName,
+                                                 const StreamCallback &callback,
+                                                 int window)
+{
+  auto sub = std::make_unique<Subscriber>();
+  sub->streamCallback = callback;
+  sub->everyMessage = true;
+  addSubscriber(topicName, std::move(sub), std::max(window, 1));
+}
+
+void SubscriberManager::registerRawSubscriber(const std::string &topicName,
+                                              const RawCallback &callback)
+{
+  auto sub = std::make_unique<Subscriber>();
+  sub->callback = callback;
+  sub->everyMessage = true;
+  addSubscriber(topicName, std::move(sub), 0);
+}
+
+void SubscriberManager::registerRawSubscriber(const std::string &topicName,
+                                              const RawMessageCallback &callback)
+{
+  auto sub = std::make_unique<Subscriber>();
+  sub->messageCallback = callback;
+  sub->everyMessage = true;
+  addSubscriber(topicName, std::move(sub), 0);
+}
+
+void SubscriberManager::setSocketOptions(const std::string &topicName,
+                                         const SocketOptions &options)
 {
   std::lock_guard<std::mutex> lock(mutex_);
+  socketOptions_[topicName] = options;
+}
 
-  Subscriber sub;
-  sub.topicName = topicName;
-  sub.callback = callback;
+void SubscriberManager::addSubscriber(const std::string &topicName,
+                                      std::unique_ptr<Subscriber> sub, int rcvhwm)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  sub->topicName = topicName;
+  sub->decompressStats = std::make_shared<CompressionStats>();
+  sub->metrics = &MetricsRegistry::global().topic(topicName);
 
-  sub.socket = ZMQContext::createSocket(zmq::socket_type::sub);
-  sub.socket->set(zmq::sockopt::subscribe, "");
-  auto urls = findTopicURLs(topicName);
-  for (const auto &url : urls)
+  SocketOptions options;
+  auto it = socketOptions_.find(topicName);
+  if (it != socketOptions_.end())
+  {
+    options = it->second;
+  }
+  // A stream window bounds the queue unless the topic sets its own HWM
+  if (rcvhwm > 0 && !options.rcvhwm)
   {
-    sub.socket->connect(url);
-    zlc::info("[SubscriberManager] '{}' connected to {}", topicName, url);
-    sub.publisherURLs.push_back(url);
+    options.rcvhwm = rcvhwm;
+  }
+  sub->socket = context_.createSocket(zmq::socket_type::sub, options);
+  sub->socket->set(zmq::sockopt::subscribe, "");
+  for (const auto &info : nodeInfoManager_.getPublisherInfo(topicName))
+  {
+    connectPublisher(*sub, info);
   }
   subscribers_.push_back(std::move(sub));
 }
 
-std::vector<std::string> SubscriberManager::findTopicURLs(const std::string &topicName)
+void SubscriberManager::connectPublisher(Subscriber &sub, const SocketInfo &info)
 {
-  std::vector<std::string> urls;
+  // Publishers on this node deliver through publishLocal(); StreamPublisher
+  // has no local path, so stream subscribers still connect to it
+  if (!sub.streamCallback && nodeInfoManager_.isLocalTopic(info))
+  {
+    return;
+  }
+
+  // NodeInfoManager clears shm and ipc for publishers on other hosts. Stream
+  // and raw subscribers need every message, which the latest-only ring cannot
+  // give.
+  const bool useShm = !info.shm.empty() && !sub.everyMessage;
+  const std::string url = useShm ? "shm://" + info.shm : info.url();
 
-  auto infos = NodeInfoManager::instance().getPublisherInfo(topicName);
+  if (std::find(sub.publisherURLs.begin(), sub.publisherURLs.end(), url) !=
+      sub.publisherURLs.end())
+  {
+    return; // already connected
+  }
 
-  for (const auto &t : infos)
+  if (useShm)
   {
-    urls.push_back(fmt::format("tcp://{}:{}", t.ip, t.port));
+    auto reader = ShmRingReader::open(info.shm);
+    if (reader)
+    {
+      Subscriber *target = &sub;
+      sub.shmReaders[url] = std::make_unique<ShmSubscription>(
+          std::move(reader),
+          [this, target](const ByteView &header, const ByteView &payload)
+          {
+            // Slots overwritten before the reader got to them count as gaps
+            trackSequence(*target, header);
+            dispatch(*target, header, payload, std::chrono::steady_clock::now());
+          },
+          &sub.metrics->dropped, threadOptions_);
+      sub.publisherURLs.push_back(url);
+      zlc::info("[SubscriberManager] '{}' reading {} from shared memory", info.name,
+                info.shm);
+      return;
+    }
+    zlc::warn("[SubscriberManager] Cannot open shared memory {} for '{}', using ZMQ",
+              info.shm, info.name);
+    SocketInfo fallback = info;
+    fallback.shm.clear();
+    connectPublisher(sub, fallback);
+    return;
   }
 
-  return urls;
+  sub.socket->connect(url);
+  sub.publisherURLs.push_back(url);
+  zlc::info("[SubscriberManager] '{}' connected to {}", info.name, url);
+}
+
+std::unique_ptr<ShmSubscription>
+SubscriberManager::disconnectPublisher(Subscriber &sub, const SocketInfo &info)
+{
+  std::unique_ptr<ShmSubscription> reader;
+
+  for (const std::string &url : {"shm://" + info.shm, info.ipc, info.tcpURL()})
+  {
+    auto it = std::find(sub.publisherURLs.begin(), sub.publisherURLs.end(), url);
+    if (it == sub.publisherURLs.end())
+    {
+      continue; // not connected to this publisher
+    }
+
+    auto shm = sub.shmReaders.find(url);
+    if (shm != sub.shmReaders.end())
+    {
+      reader = std::move(shm->second);
+      sub.shmReaders.erase(shm);
+    }
+    else
+    {
+      sub.socket->disconnect(url);
+    }
+    sub.publisherURLs.erase(it);
+
+    zlc::info("[SubscriberManager] '{}' disconnected from {}", info.name, url);
+  }
+  return reader;
 }
 
 void SubscriberManager::updateTopicSubscriber(const NodeInfo &nodeInfo)
@@ -91,52 +273,207 @@ void SubscriberManager::updateTopicSubscriber(const NodeInfo &nodeInfo)
   {
     for (auto &sub : subscribers_)
     {
-      if (sub.topicName != topic.name)
-        continue;
-
-      std::string url = fmt::format("tcp://{}:{}", topic.ip, topic.port);
-
-      if (std::find(sub.publisherURLs.begin(), sub.publisherURLs.end(), url) !=
-          sub.publisherURLs.end())
+      if (sub->topicName == topic.name)
       {
-        continue; // already connected
+        connectPublisher(*sub, topic);
       }
-
-      sub.socket->connect(url);
-      sub.publisherURLs.push_back(url);
-
-      zlc::info("[SubscriberManager] '{}' connected to {}", topic.name, url);
     }
   }
 }
 
 void SubscriberManager::removeTopicSubscriber(const NodeInfo &nodeInfo)
 {
+  // Shm reader threads are joined after the lock is released
+  std::vector<std::unique_ptr<ShmSubscription>> readers;
+
   std::lock_guard<std::mutex> lock(mutex_);
 
   for (const auto &topic : nodeInfo.topics)
   {
     for (auto &sub : subscribers_)
     {
-      if (sub.topicName != topic.name)
+      if (sub->topicName != topic.name)
         continue;
 
-      std::string url = fmt::format("tcp://{}:{}", topic.ip, topic.port);
+      if (auto reader = disconnectPublisher(*sub, topic))
+      {
+        readers.push_back(std::move(reader));
+      }
+    }
+  }
+}
+
+CompressionStatsSnapshot
+SubscriberManager::decompressionStats(const std::string &topicName)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  CompressionStatsSnapshot total;
+  for (const auto &sub : subscribers_)
+  {
+    if (sub->topicName != topicName)
+      continue;
+    auto snap = sub->decompressStats->snapshot();
+    total.messages += snap.messages;
+    total.skipped += snap.skipped;
+    total.raw_bytes += snap.raw_bytes;
+    total.compressed_bytes += snap.compressed_bytes;
+    total.cpu_ns += snap.cpu_ns;
+  }
+  return total;
+}
 
-      auto it = std::find(sub.publisherURLs.begin(), sub.publisherURLs.end(), url);
-      if (it == sub.publisherURLs.end())
+bool SubscriberManager::hasLocalSubscribers(const std::string &topicName)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::any_of(subscribers_.begin(), subscribers_.end(),
+                     [&](const std::unique_ptr<Subscriber> &sub)
+                     { return sub->topicName == topicName && !sub->streamCallback; });
+}
+
+void SubscriberManager::publishLocal(const std::string &topicName, std::type_index type,
+                                     const std::shared_ptr<const void> &msg,
+                                     const std::function<ByteView()> &encoded)
+{
+  // Subscribers are never removed and their callbacks are set before they are
+  // added, so the pointers and callbacks can be used without any lock
+  std::vector<Subscriber *> targets;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &sub : subscribers_)
+    {
+      if (sub->topicName == topicName && !sub->streamCallback)
       {
-        continue; // not connected to this publisher
+        targets.push_back(sub.get());
       }
+    }
+  }
 
-      sub.socket->disconnect(url);
-      sub.publisherURLs.erase(it);
+  for (Subscriber *sub : targets)
+  {
+    // Not under dispatchMutex: a callback that publishes on the same topic
+    // (relay, echo) would deadlock on it
+    try
+    {
+      sub->metrics->delivered_local.add();
+      if (sub->localCallback && sub->localType == type)
+      {
+        sub->localCallback(msg);
+      }
+      else if (sub->callback)
+      {
+        // Different message type on the same topic: go through the codec
+        sub->callback(encoded());
+      }
+      else if (sub->messageCallback)
+      {
+        const ByteView bytes = encoded();
+        zmq::message_t frame(bytes.data, bytes.size);
+        sub->messageCallback(frame);
+      }
+    }
+    catch (const std::exception &e)
+    {
+      static LogRateLimit limit;
+      zlc::errorRateLimited(
+          limit, "[SubscriberManager] Exception in local subscriber of '{}': {}",
+          topicName, e.what());
+    }
+  }
+}
+
+void SubscriberManager::dispatch(Subscriber &sub, const ByteView &header,
+                                 const ByteView &payload, SteadyTime received,
+                                 zmq::message_t *frame)
+{
+  std::lock_guard<std::mutex> lock(sub.dispatchMutex);
+  const SteadyTime dispatched = std::chrono::steady_clock::now();
+
+  sub.metrics->received.add();
+  sub.metrics->received_bytes.add(header.size + payload.size);
 
-      zlc::info("[SubscriberManager] '{}' disconnected from {}", topic.name, url);
+  MessageHeader hdr = MessageHeader::decode(header.data, header.size);
+  deliver(sub, hdr, payload, frame);
+
+  if (hdr.timestamped())
+  {
+    recordTrace(*sub.metrics, hdr, received, dispatched);
+  }
+}
+
+void SubscriberManager::deliver(Subscriber &sub, const MessageHeader &hdr,
+                                const ByteView &payload, zmq::message_t *frame)
+{
+  ByteView view = payload;
+  if (hdr.compressed())
+  {
+    checkDecompressedSize(hdr, view); // before allocating what the peer claims
+    sub.scratch.resize(hdr.raw_size);
+    decompress(hdr, view, sub.scratch.data(), sub.decompressStats.get());
+    view = ByteView{sub.scratch.data(), sub.scratch.size()};
+  }
+
+  if (sub.streamCallback)
+  {
+    if (!hdr.chunked())
+    {
+      static LogRateLimit limit;
+      zlc::warnRateLimited(
+          limit, "[SubscriberManager] Non-chunked message on stream topic '{}'",
+          sub.topicName);
+      return;
     }
+    sub.streamCallback(StreamChunk{hdr.stream_id, hdr.offset, hdr.total_size, view});
+    return;
+  }
+
+  if (hdr.chunked())
+  {
+    static LogRateLimit limit;
+    zlc::warnRateLimited(
+        limit, "[SubscriberManager] Chunked message on '{}' needs a stream subscriber",
+        sub.topicName);
+    return;
+  }
+
+  if (sub.callback)
+  {
+    sub.callback(view);
+  }
+  else if (sub.messageCallback)
+  {
+    if (frame && !hdr.compressed())
+    {
+      sub.messageCallback(*frame);
+      return;
+    }
+    zmq::message_t copy(view.data, view.size);
+    sub.messageCallback(copy);
   }
 }
 
+void SubscriberManager::trackSequence(Subscriber &sub, const ByteView &header)
+{
+  if (header.size == 0)
+    return;
+
+  MessageHeader hdr;
+  try
+  {
+    hdr = MessageHeader::decode(header.data, header.size);
+  }
+  catch (const DecodeException &)
+  {
+    return; // reported when the message is dispatched
+  }
+  if (!hdr.sequenced())
+    return;
+
+  std::lock_guard<std::mutex> lock(sub.dispatchMutex);
+  const SequenceTracker::Event event = sub.sequences.observe(hdr.publisher_id, hdr.seq);
+  sub.metrics->recordSequence(hdr.publisher_id, event.gap, event.late, event.duplicate);
+}
+
 void SubscriberManager::pollOnce()
 {
   try
@@ -153,8 +490,8 @@ void SubscriberManager::pollOnce()
 
       for (auto &sub : subscribers_)
       {
-        poll_items.push_back({sub.socket->handle(), 0, ZMQ_POLLIN, 0});
-        subs.push_back(&sub);
+        poll_items.push_back({sub->socket->handle(), 0, ZMQ_POLLIN, 0});
+        subs.push_back(sub.get());
       }
     }
 
@@ -163,37 +500,75 @@ void SubscriberManager::pollOnce()
 
     for (size_t i = 0; i < poll_items.size(); ++i)
     {
-      if (poll_items[i].revents & ZMQ_POLLIN)
+      if (!(poll_items[i].revents & ZMQ_POLLIN))
+        continue;
+
+      // A malformed message only costs its own subscriber this cycle
+      try
       {
+        zmq::message_t last_header;
         zmq::message_t last_msg;
         zmq::message_t tmp_msg;
         bool has_data = false;
+        uint64_t drained = 0;
+        SteadyTime received{};
 
         while (subs[i]->socket->recv(tmp_msg, zmq::recv_flags::dontwait))
         {
-          last_msg = std::move(tmp_msg);
+          if (tmp_msg.more())
+          {
+            // [header][payload]: multipart messages arrive atomically
+            last_header = std::move(tmp_msg);
+            subs[i]->socket->recv(last_msg, zmq::recv_flags::none);
+          }
+          else
+          {
+            last_header = zmq::message_t();
+            last_msg = std::move(tmp_msg);
+          }
+          received = std::chrono::steady_clock::now();
           has_data = true;
+          ++drained;
+          trackSequence(*subs[i], toByteView(last_header));
+
+          // Streams and raw subscribers need every message, not just the latest
+          if (subs[i]->everyMessage)
+          {
+            dispatch(*subs[i], toByteView(last_header), toByteView(last_msg),
+                     received, &last_msg);
+            has_data = false;
+          }
         }
 
         if (has_data)
         {
-          ByteView view{static_cast<const uint8_t*>(last_msg.data()), last_msg.size()};
-          
-          if (subs[i]->callback) {
-            subs[i]->callback(view);
-          }
+          // Latest-only: everything drained before the last message is dropped
+          subs[i]->metrics->dropped.add(drained - 1);
+          dispatch(*subs[i], toByteView(last_header), toByteView(last_msg), received);
         }
       }
+      catch (const zmq::error_t &)
+      {
+        throw;
+      }
+      catch (const std::exception &e)
+      {
+        static LogRateLimit limit;
+        zlc::errorRateLimited(limit, "[SubscriberManager] Dropped message on '{}': {}",
+                              subs[i]->topicName, e.what());
+      }
     }
   }
   catch (const zmq::error_t &e)
   {
     if (e.num() == ETERM) return;
-    zlc::error("[SubscriberManager] ZMQ error: {}", e.what());
+    static LogRateLimit limit;
+    zlc::errorRateLimited(limit, "[SubscriberManager] ZMQ error: {}", e.what());
   }
   catch (const std::exception &e)
   {
-    zlc::error("[SubscriberManager] Exception: {}", e.what());
+    static LogRateLimit limit;
+    zlc::errorRateLimited(limit, "[SubscriberManager] Exception: {}", e.what());
   }
 }
 } // namespace zlc
@@ -1,5 +1,6 @@
 #include "zerolancom/utils/logger.hpp"
 
+#include <algorithm>
 #include <ctime>
 #include <filesystem>
 #include <vector>
@@ -9,33 +10,41 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include "zerolancom/utils/thread_utils.hpp"
+
 namespace zlc
 {
 
 /* ================= Logger ================= */
 
 void Logger::init(bool enable_file_logging, const std::string &log_dir)
+{
+  LoggerOptions options;
+  options.file_logging = enable_file_logging;
+  options.log_dir = log_dir;
+  init(options);
+}
+
+void Logger::init(const LoggerOptions &options)
 {
   // Ensure initialization happens only once
   if (initialized_)
     return;
 
-  spdlog::init_thread_pool(8192, 1);
-
   std::vector<spdlog::sink_ptr> sinks;
 
   auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
   sinks.push_back(console_sink);
 
-  if (enable_file_logging)
+  if (options.file_logging)
   {
-    std::filesystem::create_directories(log_dir);
+    std::filesystem::create_directories(options.log_dir);
 
     std::time_t t = std::time(nullptr);
     char ts[32];
     std::strftime(ts, sizeof(ts), "%Y%m%d_%H%M%S", std::localtime(&t));
 
-    std::string file_path = log_dir + "/output_" + ts + ".txt";
+    std::string file_path = options.log_dir + "/output_" + ts + ".txt";
 
     auto file_sink =
         std::make_shared<spdlog::sinks::basic_file_sink_mt>(file_path, true);
@@ -43,12 +52,25 @@ void Logger::init(bool enable_file_logging, const std::string &log_dir)
     sinks.push_back(file_sink);
   }
 
-  auto async_logger = std::make_shared<spdlog::async_logger>(
-      "zlc_async", sinks.begin(), sinks.end(), spdlog::thread_pool(),
-      spdlog::async_overflow_policy::block);
+  std::shared_ptr<spdlog::logger> logger;
+  if (options.async)
+  {
+    spdlog::init_thread_pool(std::max<size_t>(options.queue_size, 1), 1,
+                             []() { configureCurrentThread("zlc-log"); });
+    const auto overflow = options.overflow == LogOverflowPolicy::DROP_OLDEST
+                              ? spdlog::async_overflow_policy::overrun_oldest
+                              : spdlog::async_overflow_policy::block;
+    logger = std::make_shared<spdlog::async_logger>(
+        "zlc_async", sinks.begin(), sinks.end(), spdlog::thread_pool(), overflow);
+  }
+  else
+  {
+    logger = std::make_shared<spdlog::logger>("zlc", sinks.begin(), sinks.end());
+  }
 
-  spdlog::set_default_logger(async_logger);
+  spdlog::set_default_logger(logger);
   spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] %v");
+  spdlog::set_level(toSpdLevel(options.level));
 
   initialized_ = true;
 }
@@ -90,29 +112,54 @@ spdlog::level::level_enum Logger::toSpdLevel(LogLevel lvl)
   return spdlog::level::info;
 }
 
+/* ================= LogRateLimit ================= */
+
+LogRateLimit::LogRateLimit(std::chrono::milliseconds interval)
+    : interval_ns_(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count())
+{
+}
+
+bool LogRateLimit::allow(uint64_t &suppressed)
+{
+  const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  int64_t next = next_ns_.load(std::memory_order_relaxed);
+  // Only the thread that moves the deadline logs; concurrent callers count
+  if (now < next || !next_ns_.compare_exchange_strong(next, now + interval_ns_,
+                                                      std::memory_order_relaxed))
+  {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+  return true;
+}
+
 /* ================= free functions ================= */
 
 void trace(const std::string &msg)
 {
-  if (Logger::isInitialized())
+  if (logLevelActive(LogLevel::TRACE) && Logger::isInitialized())
     spdlog::trace(msg);
 }
 
 void info(const std::string &msg)
 {
-  if (Logger::isInitialized())
+  if (logLevelActive(LogLevel::INFO) && Logger::isInitialized())
     spdlog::info(msg);
 }
 
 void warn(const std::string &msg)
 {
-  if (Logger::isInitialized())
+  if (logLevelActive(LogLevel::WARN) && Logger::isInitialized())
     spdlog::warn(msg);
 }
 
 void error(const std::string &msg)
 {
-  if (Logger::isInitialized())
+  if (logLevelActive(LogLevel::ERROR) && Logger::isInitialized())
     spdlog::error(msg);
 }
 
@@ -0,0 +1,282 @@
+#include "zerolancom/utils/metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace zlc
+{
+
+/* ================= LatencyHistogram ================= */
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+  if (value < SUB_BUCKETS)
+  {
+    return static_cast<size_t>(value);
+  }
+
+  // Position of the highest set bit; the next SUB_BUCKET_BITS bits pick the
+  // linear sub-bucket within that power of two
+  unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(value));
+  unsigned shift = msb - SUB_BUCKET_BITS;
+  return static_cast<size_t>(shift) * SUB_BUCKETS + static_cast<size_t>(value >> shift);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+  if (index < 2 * SUB_BUCKETS)
+  {
+    return index;
+  }
+
+  size_t shift = index / SUB_BUCKETS - 1;
+  uint64_t mantissa = SUB_BUCKETS + index % SUB_BUCKETS;
+  uint64_t lower = mantissa << shift;
+  return lower + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value_ns)
+{
+  buckets_[bucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value_ns, std::memory_order_relaxed);
+
+  uint64_t current = max_.load(std::memory_order_relaxed);
+  while (value_ns > current &&
+         !max_.compare_exchange_weak(current, value_ns, std::memory_order_relaxed))
+  {
+  }
+}
+
+uint64_t LatencyHistogram::quantile(double q) const
+{
+  // Count from the buckets themselves so concurrent records cannot push the
+  // rank past the last bucket
+  std::array<uint64_t, BUCKET_COUNT> counts;
+  uint64_t total = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; ++i)
+  {
+    counts[i] = bucketCount(i);
+    total += counts[i];
+  }
+  if (total == 0)
+  {
+    return 0;
+  }
+
+  q = std::clamp(q, 0.0, 1.0);
+  uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; ++i)
+  {
+    seen += counts[i];
+    if (seen >= rank)
+    {
+      return std::min(bucketUpperBound(i), max());
+    }
+  }
+  return max();
+}
+
+LatencySummary LatencyHistogram::summary() const
+{
+  LatencySummary s;
+  s.count = count();
+  s.sum_ns = sum();
+  s.max_ns = max();
+  s.p50_ns = quantile(0.5);
+  s.p90_ns = quantile(0.9);
+  s.p99_ns = quantile(0.99);
+  s.p999_ns = quantile(0.999);
+  return s;
+}
+
+/* ================= TopicMetrics ================= */
+
+namespace
+{
+void countSequence(PublisherSequenceMetrics &metrics, uint64_t gap, bool late,
+                   bool duplicate)
+{
+  metrics.received.add();
+  if (gap > 0)
+    metrics.gaps.add(gap);
+  if (late)
+    metrics.reordered.add();
+  if (duplicate)
+    metrics.duplicated.add();
+}
+
+void foldInto(PublisherSequenceMetrics &total, const PublisherSequenceMetrics &metrics)
+{
+  total.received.add(metrics.received.value());
+  total.gaps.add(metrics.gaps.value());
+  total.reordered.add(metrics.reordered.value());
+  total.duplicated.add(metrics.duplicated.value());
+}
+
+PublisherSequenceSnapshot sequenceSnapshot(uint32_t id,
+                                           const PublisherSequenceMetrics &p)
+{
+  const uint64_t gaps = p.gaps.value();
+  const uint64_t reordered = p.reordered.value();
+  return PublisherSequenceSnapshot{id, p.received.value(),
+                                   gaps > reordered ? gaps - reordered : 0, reordered,
+                                   p.duplicated.value()};
+}
+} // namespace
+
+void TopicMetrics::recordSequence(uint32_t publisher_id, uint64_t gap, bool late,
+                                  bool duplicate,
+                                  std::chrono::steady_clock::time_point now)
+{
+  const int64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch())
+          .count();
+
+  // Entries are only removed under the exclusive lock, so the counters can
+  // be bumped under the shared one
+  {
+    std::shared_lock lock(publishers_mutex_);
+    auto it = publishers_.find(publisher_id);
+    if (it != publishers_.end())
+    {
+      it->second->last_seen.set(now_ns);
+      countSequence(*it->second, gap, late, duplicate);
+      return;
+    }
+  }
+
+  std::unique_lock lock(publishers_mutex_);
+  auto it = publishers_.find(publisher_id);
+  if (it == publishers_.end())
+  {
+    // A new publisher: retire the ones that went quiet first
+    const int64_t expiry_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(PUBLISHER_IDLE_EXPIRY)
+            .count();
+    for (auto idle = publishers_.begin(); idle != publishers_.end();)
+    {
+      if (now_ns - idle->second->last_seen.value() > expiry_ns)
+      {
+        foldInto(other_publishers_, *idle->second);
+        idle = publishers_.erase(idle);
+      }
+      else
+      {
+        ++idle;
+      }
+    }
+    if (publishers_.size() >= MAX_PUBLISHERS)
+    {
+      countSequence(other_publishers_, gap, late, duplicate);
+      return;
+    }
+    it = publishers_.emplace(publisher_id, std::make_unique<PublisherSequenceMetrics>())
+             .first;
+  }
+  it->second->last_seen.set(now_ns);
+  countSequence(*it->second, gap, late, duplicate);
+}
+
+/* ================= MetricsRegistry ================= */
+
+MetricsRegistry &MetricsRegistry::global()
+{
+  static MetricsRegistry registry;
+  return registry;
+}
+
+TopicMetrics &MetricsRegistry::topic(const std::string &name)
+{
+  {
+    std::shared_lock lock(mutex_);
+    auto it = topics_.find(name);
+    if (it != topics_.end())
+    {
+      return *it->second;
+    }
+  }
+
+  std::unique_lock lock(mutex_);
+  auto &entry = topics_[name];
+  if (!entry)
+  {
+    entry = std::make_unique<TopicMetrics>();
+  }
+  return *entry;
+}
+
+ServiceMetrics &MetricsRegistry::service(const std::string &name)
+{
+  {
+    std::shared_lock lock(mutex_);
+    auto it = services_.find(name);
+    if (it != services_.end())
+    {
+      return *it->second;
+    }
+  }
+
+  std::unique_lock lock(mutex_);
+  auto &entry = services_[name];
+  if (!entry)
+  {
+    entry = std::make_unique<ServiceMetrics>();
+  }
+  return *entry;
+}
+
+MetricsSnapshot MetricsRegistry::snapshot() const
+{
+  MetricsSnapshot snap;
+
+  {
+    std::shared_lock lock(mutex_);
+
+    snap.topics.reserve(topics_.size());
+    for (const auto &[name, t] : topics_)
+    {
+      TopicMetricsSnapshot topic{
+          name, t->published.value(), t->published_bytes.value(), t->received.value(),
+          t->received_bytes.value(), t->delivered_local.value(), t->dropped.value(),
+          t->latency.summary(), t->encode_latency.summary(),
+          t->transit_latency.summary(), t->drain_latency.summary(),
+          t->dispatch_latency.summary(), {}, sequenceSnapshot(0, t->otherPublishers())};
+
+      t->forEachPublisher([&topic](uint32_t id, const PublisherSequenceMetrics &p)
+                          { topic.publishers.push_back(sequenceSnapshot(id, p)); });
+      std::sort(topic.publishers.begin(), topic.publishers.end(),
+                [](const auto &a, const auto &b)
+                { return a.publisher_id < b.publisher_id; });
+      snap.topics.push_back(std::move(topic));
+    }
+
+    snap.services.reserve(services_.size());
+    for (const auto &[name, s] : services_)
+    {
+      snap.services.push_back(ServiceMetricsSnapshot{
+          name, s->requests.value(), s->failures.value(), s->handler_latency.summary(),
+          s->calls.value(), s->call_failures.value(), s->call_latency.summary(),
+          s->rejected.value()});
+    }
+  }
+
+  std::sort(snap.topics.begin(), snap.topics.end(),
+            [](const auto &a, const auto &b) { return a.name < b.name; });
+  std::sort(snap.services.begin(), snap.services.end(),
+            [](const auto &a, const auto &b) { return a.name < b.name; });
+
+  const DiscoveryMetrics &d = discovery_;
+  snap.discovery = DiscoveryMetricsSnapshot{
+      d.heartbeats_sent.value(),     d.heartbeats_received.value(),
+      d.heartbeat_errors.value(),    d.node_fetches.value(),
+      d.node_fetch_failures.value(), d.nodes_added.value(),
+      d.nodes_removed.value(),       d.nodes.value()};
+  return snap;
+}
+
+} // namespace zlc
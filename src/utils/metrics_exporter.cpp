@@ -0,0 +1,470 @@
+#include "zerolancom/utils/metrics_exporter.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <tuple>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/thread_utils.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+
+constexpr int POLL_INTERVAL_MS = 100;
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+std::string escapeLabel(const std::string &value)
+{
+  std::string out;
+  out.reserve(value.size());
+  for (char c : value)
+  {
+    switch (c)
+    {
+    case '\\':
+      out += "\\\\";
+      break;
+    case '"':
+      out += "\\\"";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    default:
+      out += c;
+    }
+  }
+  return out;
+}
+
+double toSeconds(uint64_t ns)
+{
+  return static_cast<double>(ns) / 1e9;
+}
+
+class TextWriter
+{
+public:
+  TextWriter(MetricsFormat format, const std::string &node)
+      : format_(format), node_label_("node=\"" + escapeLabel(node) + "\"")
+  {
+  }
+
+  void header(const std::string &name, const char *type, const char *help)
+  {
+    // OpenMetrics names a counter family without its _total suffix
+    std::string family = name;
+    if (format_ == MetricsFormat::OPENMETRICS && std::strcmp(type, "counter") == 0)
+    {
+      family = name.substr(0, name.size() - std::strlen("_total"));
+    }
+    fmt::format_to(std::back_inserter(out_), "# TYPE {} {}\n# HELP {} {}\n", family,
+                   type, family, help);
+  }
+
+  // Integer and floating-point samples; integers keep full 64-bit precision
+  template <typename V>
+  void sample(const std::string &name, const std::string &labels, V value)
+  {
+    fmt::format_to(std::back_inserter(out_), "{}{{{}{}}} {}\n", name, node_label_,
+                   labels, value);
+  }
+
+  void summary(const std::string &name, const std::string &labels,
+               const LatencySummary &s)
+  {
+    const std::pair<const char *, uint64_t> quantiles[] = {
+        {"0.5", s.p50_ns}, {"0.9", s.p90_ns}, {"0.99", s.p99_ns}, {"0.999", s.p999_ns}};
+    for (const auto &[q, ns] : quantiles)
+    {
+      sample(name, labels + fmt::format(",quantile=\"{}\"", q), toSeconds(ns));
+    }
+    sample(name + "_sum", labels, toSeconds(s.sum_ns));
+    sample(name + "_count", labels, s.count);
+  }
+
+  std::string finish()
+  {
+    if (format_ == MetricsFormat::OPENMETRICS)
+    {
+      out_ += "# EOF\n";
+    }
+    return std::move(out_);
+  }
+
+private:
+  MetricsFormat format_;
+  std::string node_label_;
+  std::string out_;
+};
+
+template <typename Entry, typename Getter>
+void writeFamily(TextWriter &w, const std::vector<Entry> &entries, const char *label,
+                 const std::string &name, const char *type, const char *help,
+                 Getter get)
+{
+  if (entries.empty())
+    return;
+
+  w.header(name, type, help);
+  for (const auto &e : entries)
+  {
+    std::string labels = fmt::format(",{}=\"{}\"", label, escapeLabel(e.name));
+    get(w, name, labels, e);
+  }
+}
+
+template <typename Entry, typename Field>
+void writeCounters(TextWriter &w, const std::vector<Entry> &entries, const char *label,
+                   const std::string &name, const char *help, Field field)
+{
+  writeFamily(w, entries, label, name, "counter", help,
+              [field](TextWriter &w, const std::string &name, const std::string &labels,
+                      const Entry &e)
+              { w.sample(name, labels, e.*field); });
+}
+
+template <typename Entry>
+void writeSummaries(TextWriter &w, const std::vector<Entry> &entries, const char *label,
+                    const std::string &name, const char *help,
+                    LatencySummary Entry::*field)
+{
+  writeFamily(w, entries, label, name, "summary", help,
+              [field](TextWriter &w, const std::string &name, const std::string &labels,
+                      const Entry &e) { w.summary(name, labels, e.*field); });
+}
+
+// Per-publisher sequence counters, labelled with topic and publisher ID;
+// expired publishers and those over the cap share publisher="other"
+void writePublisherCounters(TextWriter &w,
+                            const std::vector<TopicMetricsSnapshot> &topics,
+                            const std::string &name, const char *help,
+                            uint64_t PublisherSequenceSnapshot::*field)
+{
+  bool any = false;
+  auto sample = [&](const std::string &labels, uint64_t value)
+  {
+    if (!any)
+    {
+      w.header(name, "counter", help);
+      any = true;
+    }
+    w.sample(name, labels, value);
+  };
+  for (const auto &t : topics)
+  {
+    for (const auto &p : t.publishers)
+    {
+      sample(fmt::format(",topic=\"{}\",publisher=\"{:08x}\"", escapeLabel(t.name),
+                         p.publisher_id),
+             p.*field);
+    }
+    if (t.other_publishers.received != 0)
+    {
+      sample(fmt::format(",topic=\"{}\",publisher=\"other\"", escapeLabel(t.name)),
+             t.other_publishers.*field);
+    }
+  }
+}
+
+bool sendAll(int fd, const std::string &data)
+{
+  size_t sent = 0;
+  while (sent < data.size())
+  {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0)
+    {
+      if (n < 0 && errno == EINTR)
+        continue;
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+} // namespace
+
+/* ================= Text format ================= */
+
+std::string formatMetrics(const MetricsSnapshot &snap, MetricsFormat format)
+{
+  TextWriter w(format, snap.node);
+  using T = TopicMetricsSnapshot;
+  using S = ServiceMetricsSnapshot;
+
+  const auto &topics = snap.topics;
+  writeCounters(w, topics, "topic", "zlc_topic_published_messages_total",
+                "Messages published", &T::published);
+  writeCounters(w, topics, "topic", "zlc_topic_published_bytes_total",
+                "Bytes sent to the network", &T::published_bytes);
+  writeCounters(w, topics, "topic", "zlc_topic_received_messages_total",
+                "Messages received from the network or shared memory", &T::received);
+  writeCounters(w, topics, "topic", "zlc_topic_received_bytes_total", "Bytes received",
+                &T::received_bytes);
+  writeCounters(w, topics, "topic", "zlc_topic_local_deliveries_total",
+                "Messages handed to subscribers in the same process",
+                &T::delivered_local);
+  writeCounters(w, topics, "topic", "zlc_topic_dropped_messages_total",
+                "Messages superseded before delivery", &T::dropped);
+  writePublisherCounters(w, topics, "zlc_topic_sequenced_messages_total",
+                         "Sequenced messages read off a ZMQ socket",
+                         &PublisherSequenceSnapshot::received);
+  writePublisherCounters(w, topics, "zlc_topic_lost_messages_total",
+                         "Sequence numbers that never arrived",
+                         &PublisherSequenceSnapshot::lost);
+  writePublisherCounters(w, topics, "zlc_topic_reordered_messages_total",
+                         "Messages that arrived after a later one",
+                         &PublisherSequenceSnapshot::reordered);
+  writePublisherCounters(w, topics, "zlc_topic_duplicated_messages_total",
+                         "Sequence numbers seen more than once",
+                         &PublisherSequenceSnapshot::duplicated);
+  writeSummaries(w, topics, "topic", "zlc_topic_latency_seconds",
+                 "Traced messages: publish() until the callback returns",
+                 &T::latency);
+  writeSummaries(w, topics, "topic", "zlc_topic_encode_latency_seconds",
+                 "Traced messages: publish() until handed to ZMQ", &T::encode_latency);
+  writeSummaries(w, topics, "topic", "zlc_topic_transit_latency_seconds",
+                 "Traced messages: handed to ZMQ until read by the subscriber",
+                 &T::transit_latency);
+  writeSummaries(w, topics, "topic", "zlc_topic_drain_latency_seconds",
+                 "Traced messages: read by the subscriber until dispatched",
+                 &T::drain_latency);
+  writeSummaries(w, topics, "topic", "zlc_topic_dispatch_latency_seconds",
+                 "Traced messages: decompression, decode and callback",
+                 &T::dispatch_latency);
+
+  const auto &services = snap.services;
+  writeCounters(w, services, "service", "zlc_service_requests_total",
+                "Requests handled", &S::requests);
+  writeCounters(w, services, "service", "zlc_service_failures_total",
+                "Requests handled with an error status", &S::failures);
+  writeCounters(w, services, "service", "zlc_service_rejected_total",
+                "Requests rejected as OVERLOADED", &S::rejected);
+  writeSummaries(w, services, "service", "zlc_service_handler_latency_seconds",
+                 "Handler run time", &S::handler_latency);
+  writeCounters(w, services, "service", "zlc_service_calls_total", "Requests sent",
+                &S::calls);
+  writeCounters(w, services, "service", "zlc_service_call_failures_total",
+                "Requests that returned an error status", &S::call_failures);
+  writeSummaries(w, services, "service", "zlc_service_call_latency_seconds",
+                 "Round-trip time seen by the client", &S::call_latency);
+
+  const DiscoveryMetricsSnapshot &d = snap.discovery;
+  const std::tuple<const char *, const char *, uint64_t> discovery[] = {
+      {"zlc_discovery_heartbeats_sent_total", "Heartbeats sent", d.heartbeats_sent},
+      {"zlc_discovery_heartbeats_received_total", "Heartbeats from other nodes",
+       d.heartbeats_received},
+      {"zlc_discovery_heartbeat_errors_total", "Undecodable heartbeats",
+       d.heartbeat_errors},
+      {"zlc_discovery_node_fetches_total", "Node info requests", d.node_fetches},
+      {"zlc_discovery_node_fetch_failures_total", "Failed node info requests",
+       d.node_fetch_failures},
+      {"zlc_discovery_nodes_added_total", "Nodes discovered", d.nodes_added},
+      {"zlc_discovery_nodes_removed_total", "Nodes timed out or removed",
+       d.nodes_removed}};
+  for (const auto &[name, help, value] : discovery)
+  {
+    w.header(name, "counter", help);
+    w.sample(name, "", value);
+  }
+  w.header("zlc_discovery_nodes", "gauge", "Remote nodes currently known");
+  w.sample("zlc_discovery_nodes", "", d.nodes);
+
+  return w.finish();
+}
+
+/* ================= MetricsExporter ================= */
+
+MetricsExporter::MetricsExporter(const std::string &node_name,
+                                 const MetricsExporterOptions &options)
+    : node_name_(node_name), options_(options)
+{
+  if (!options_.serve_http)
+    return;
+
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  int reuse = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(options_.http_port);
+  addr.sin_addr.s_addr = inet_addr(options_.http_address.c_str());
+
+  socklen_t len = sizeof(addr);
+  if (listen_fd_ < 0 ||
+      ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      ::listen(listen_fd_, 8) != 0 ||
+      getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+  {
+    zlc::error("[MetricsExporter] Cannot serve HTTP on {}:{}: {}",
+               options_.http_address, options_.http_port, std::strerror(errno));
+    if (listen_fd_ >= 0)
+    {
+      ::close(listen_fd_);
+      listen_fd_ = -1;
+    }
+    return;
+  }
+
+  http_port_ = ntohs(addr.sin_port);
+  zlc::info("[MetricsExporter] Serving metrics on http://{}:{}/metrics",
+            options_.http_address, http_port_);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+  stop();
+  if (listen_fd_ >= 0)
+  {
+    ::close(listen_fd_);
+  }
+}
+
+void MetricsExporter::start()
+{
+  running_ = true;
+  thread_ = std::thread(
+      [this]()
+      {
+        configureCurrentThread("zlc-metrics");
+        this->run();
+      });
+}
+
+void MetricsExporter::stop()
+{
+  if (running_)
+  {
+    running_ = false;
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+}
+
+MetricsSnapshot MetricsExporter::snapshot() const
+{
+  MetricsSnapshot snap = MetricsRegistry::global().snapshot();
+  snap.node = node_name_;
+  return snap;
+}
+
+bool MetricsExporter::writeFile() const
+{
+  if (options_.file_path.empty())
+    return false;
+
+  const std::string tmp = options_.file_path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    out << formatMetrics(snapshot(), MetricsFormat::PROMETHEUS_TEXT);
+    if (!out)
+    {
+      zlc::warn("[MetricsExporter] Cannot write {}", tmp);
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), options_.file_path.c_str()) != 0)
+  {
+    zlc::warn("[MetricsExporter] Cannot replace {}: {}", options_.file_path,
+              std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void MetricsExporter::run()
+{
+  auto next_write = std::chrono::steady_clock::now();
+
+  while (running_)
+  {
+    if (!options_.file_path.empty() && std::chrono::steady_clock::now() >= next_write)
+    {
+      writeFile();
+      next_write += std::chrono::milliseconds(options_.file_interval_ms);
+    }
+
+    if (listen_fd_ < 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+      continue;
+    }
+
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, POLL_INTERVAL_MS) <= 0)
+      continue;
+
+    int fd = ::accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0)
+      continue;
+
+    serveClient(fd);
+    ::close(fd);
+  }
+}
+
+void MetricsExporter::serveClient(int fd) const
+{
+  // A slow or idle client must not stall the file writer
+  timeval timeout{1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  char buf[1024];
+  while (request.find("\r\n\r\n") == std::string::npos &&
+         request.size() < MAX_REQUEST_SIZE)
+  {
+    ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0)
+      return;
+    request.append(buf, static_cast<size_t>(n));
+  }
+
+  const bool is_get = request.rfind("GET ", 0) == 0;
+  const size_t path_end = request.find(' ', 4);
+  const std::string path =
+      is_get && path_end != std::string::npos ? request.substr(4, path_end - 4) : "";
+
+  if (path != "/metrics" && path != "/")
+  {
+    sendAll(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n"
+                "Connection: close\r\n\r\n");
+    return;
+  }
+
+  const bool openmetrics =
+      request.find("application/openmetrics-text") != std::string::npos;
+  const std::string body =
+      formatMetrics(snapshot(), openmetrics ? MetricsFormat::OPENMETRICS
+                                            : MetricsFormat::PROMETHEUS_TEXT);
+  const char *content_type =
+      openmetrics ? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+                  : "text/plain; version=0.0.4; charset=utf-8";
+
+  sendAll(fd, fmt::format("HTTP/1.1 200 OK\r\nContent-Type: {}\r\n"
+                          "Content-Length: {}\r\nConnection: close\r\n\r\n",
+                          content_type, body.size()) +
+                  body);
+}
+
+} // namespace zlc
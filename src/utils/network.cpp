@@ -0,0 +1,90 @@
+#include "zerolancom/utils/network.hpp"
+
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+
+namespace zlc
+{
+
+int NetworkInterface::prefixLength() const
+{
+  return __builtin_popcount(netmask);
+}
+
+std::vector<NetworkInterface> listNetworkInterfaces()
+{
+  std::vector<NetworkInterface> interfaces;
+  ifaddrs *list = nullptr;
+  if (getifaddrs(&list) != 0)
+  {
+    zlc::warn("[Network] getifaddrs failed; subnet masks default to /24");
+    return interfaces;
+  }
+
+  for (const ifaddrs *it = list; it != nullptr; it = it->ifa_next)
+  {
+    if (it->ifa_addr == nullptr || it->ifa_addr->sa_family != AF_INET ||
+        (it->ifa_flags & IFF_UP) == 0)
+    {
+      continue;
+    }
+    NetworkInterface interface;
+    interface.name = it->ifa_name;
+    interface.ip = inet_ntoa(reinterpret_cast<sockaddr_in *>(it->ifa_addr)->sin_addr);
+    if (it->ifa_netmask != nullptr)
+    {
+      interface.netmask =
+          ntohl(reinterpret_cast<sockaddr_in *>(it->ifa_netmask)->sin_addr.s_addr);
+    }
+    interfaces.push_back(interface);
+  }
+
+  freeifaddrs(list);
+  return interfaces;
+}
+
+std::optional<NetworkInterface> resolveNetworkInterface(const std::string &spec)
+{
+  const size_t slash = spec.find('/');
+  const std::string address = spec.substr(0, slash);
+
+  std::optional<NetworkInterface> result;
+  for (const NetworkInterface &interface : listNetworkInterfaces())
+  {
+    if (interface.ip == address || interface.name == address)
+    {
+      result = interface;
+      break;
+    }
+  }
+
+  if (!result)
+  {
+    in_addr parsed{};
+    if (inet_aton(address.c_str(), &parsed) == 0)
+    {
+      zlc::warn("[Network] No interface or IP address '{}'", address);
+      return std::nullopt;
+    }
+    // Not a local address (yet); keep the historical /24
+    result = NetworkInterface{"", address, DEFAULT_SUBNET_MASK};
+  }
+
+  if (slash != std::string::npos)
+  {
+    char *end = nullptr;
+    const long prefix = std::strtol(spec.c_str() + slash + 1, &end, 10);
+    if (end == spec.c_str() + slash + 1 || *end != '\0' || prefix < 0 || prefix > 32)
+    {
+      zlc::warn("[Network] Invalid subnet prefix in '{}'", spec);
+      return std::nullopt;
+    }
+    result->netmask = prefix == 0 ? 0 : ~uint32_t{0} << (32 - prefix);
+  }
+  return result;
+}
+
+} // namespace zlc
@@ -0,0 +1,30 @@
+#include "zerolancom/utils/request_result.hpp"
+
+namespace zlc
+{
+
+const char *Response::description(ResponseStatus code)
+{
+  switch (code)
+  {
+  case ResponseStatus::SUCCESS:
+    return "SUCCESS";
+  case ResponseStatus::NOSERVICE:
+    return "NOSERVICE";
+  case ResponseStatus::INVALID_RESPONSE:
+    return "INVALID_RESPONSE";
+  case ResponseStatus::SERVICE_FAIL:
+    return "SERVICE_FAIL";
+  case ResponseStatus::SERVICE_TIMEOUT:
+    return "SERVICE_TIMEOUT";
+  case ResponseStatus::INVALID_REQUEST:
+    return "INVALID_REQUEST";
+  case ResponseStatus::UNKNOWN_ERROR:
+    return "UNKNOWN_ERROR";
+  case ResponseStatus::OVERLOADED:
+    return "OVERLOADED";
+  }
+  return "UNKNOWN_ERROR";
+}
+
+} // namespace zlc
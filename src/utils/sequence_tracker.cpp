@@ -0,0 +1,60 @@
+#include "zerolancom/utils/sequence_tracker.hpp"
+
+#include <algorithm>
+
+namespace zlc
+{
+
+SequenceTracker::Event SequenceTracker::observe(uint32_t publisher_id, uint64_t seq)
+{
+  Event event;
+
+  if (publishers_.size() >= MAX_PUBLISHERS && publishers_.count(publisher_id) == 0)
+  {
+    auto oldest = std::min_element(publishers_.begin(), publishers_.end(),
+                                   [](const auto &a, const auto &b)
+                                   { return a.second.seen < b.second.seen; });
+    publishers_.erase(oldest);
+  }
+
+  auto [it, inserted] = publishers_.try_emplace(publisher_id);
+  State &state = it->second;
+  state.seen = ++observed_;
+  if (inserted)
+  {
+    state.last = seq;
+    state.window = 1;
+    return event;
+  }
+
+  if (seq > state.last)
+  {
+    const uint64_t advance = seq - state.last;
+    event.gap = advance - 1;
+    state.window = advance >= WINDOW ? 0 : state.window << advance;
+    state.window |= 1;
+    state.last = seq;
+    return event;
+  }
+
+  const uint64_t behind = state.last - seq;
+  if (behind >= WINDOW)
+  {
+    event.late = true; // too old to tell apart from a duplicate
+    return event;
+  }
+
+  const uint64_t bit = uint64_t{1} << behind;
+  if (state.window & bit)
+  {
+    event.duplicate = true;
+  }
+  else
+  {
+    state.window |= bit;
+    event.late = true;
+  }
+  return event;
+}
+
+} // namespace zlc
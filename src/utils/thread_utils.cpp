@@ -0,0 +1,63 @@
+#include "zerolancom/utils/thread_utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+#include "zerolancom/utils/logger.hpp"
+
+namespace zlc
+{
+
+namespace
+{
+// Linux thread names hold 15 characters plus the terminator
+constexpr size_t MAX_THREAD_NAME = 15;
+} // namespace
+
+void configureCurrentThread(const std::string &name, const ThreadOptions &options)
+{
+  const pthread_t self = pthread_self();
+  pthread_setname_np(self, name.substr(0, MAX_THREAD_NAME).c_str());
+
+  if (!options.cpus.empty())
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : options.cpus)
+    {
+      if (cpu < 0 || cpu >= CPU_SETSIZE)
+      {
+        zlc::warn("[Thread] Ignoring invalid CPU {} for thread '{}'", cpu, name);
+        continue;
+      }
+      CPU_SET(cpu, &set);
+    }
+
+    const int rc = pthread_setaffinity_np(self, sizeof(set), &set);
+    if (rc != 0)
+    {
+      zlc::warn("[Thread] Cannot set CPU affinity of thread '{}': {}", name,
+                std::strerror(rc));
+    }
+  }
+
+  if (options.fifo_priority > 0)
+  {
+    sched_param param{};
+    param.sched_priority =
+        std::clamp(options.fifo_priority, sched_get_priority_min(SCHED_FIFO),
+                   sched_get_priority_max(SCHED_FIFO));
+
+    const int rc = pthread_setschedparam(self, SCHED_FIFO, &param);
+    if (rc != 0)
+    {
+      zlc::warn("[Thread] Cannot set SCHED_FIFO priority {} for thread '{}': {} "
+                "(needs CAP_SYS_NICE or an rtprio limit)",
+                param.sched_priority, name, std::strerror(rc));
+    }
+  }
+}
+
+} // namespace zlc
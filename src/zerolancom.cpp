@@ -1,5 +1,4 @@
 #include "zerolancom/zerolancom.hpp"
-#include "zerolancom/nodes/zerolancom_node.hpp"
 
 #include <chrono>
 #include <thread>
@@ -10,14 +9,24 @@ namespace zlc
 void init(const std::string &node_name, const std::string &ip_address,
           const std::string &group, int groupPort, const std::string &groupName)
 {
-  Logger::init(false);
-  Logger::setLevel(LogLevel::INFO);
+  Logger::init(); // keeps an application's own Logger::init() settings
   ZeroLanComNode::initManaged(node_name, ip_address, group, groupPort, groupName);
 }
 
+void init(const std::string &node_name, const std::string &ip_address,
+          const NodeOptions &options)
+{
+  Logger::init(); // keeps an application's own Logger::init() settings
+  ZeroLanComNode::initManaged(node_name, ip_address, options);
+}
+
 void shutdown()
 {
+  MetricsExporter::destroy();
   ZeroLanComNode::destroy();
+  // Shutdown logger before destroying singletons to avoid segfault during global dtors
+  zlc::info("[ZeroLanComNode] Shutdown complete.");
+  Logger::shutdown();
 }
 
 void sleep(int ms)
@@ -44,22 +53,91 @@ void spin()
   node.stop();
 }
 
-void waitForService(const std::string &service_name, int max_wait_ms,
-                    int check_interval_ms)
+bool waitForService(const std::string &service_name, int max_wait_ms)
+{
+  return ZeroLanComNode::instance().waitForService(service_name, max_wait_ms);
+}
+
+bool waitForService(const std::string &service_name, int max_wait_ms,
+                    int /*check_interval_ms*/)
+{
+  return waitForService(service_name, max_wait_ms);
+}
+
+bool waitForTopic(const std::string &topic_name, int max_wait_ms)
+{
+  return ZeroLanComNode::instance().waitForTopic(topic_name, max_wait_ms);
+}
+
+bool waitForAll(const std::vector<std::string> &service_names,
+                std::chrono::steady_clock::time_point deadline)
+{
+  return ZeroLanComNode::instance().waitForAll(service_names, deadline);
+}
+
+void setServiceCompression(const std::string &service_name,
+                           const CompressionConfig &config)
+{
+  ZeroLanComNode::instance().setServiceCompression(service_name, config);
+}
+
+bool setServiceLimits(const std::string &service_name, const ServiceLimits &limits)
+{
+  return ZeroLanComNode::instance().setServiceLimits(service_name, limits);
+}
+
+void setLoadBalancing(const std::string &service_name,
+                      const LoadBalancerOptions &options)
 {
-  int waited_ms = 0;
+  ZeroLanComNode::instance().setLoadBalancing(service_name, options);
+}
 
-  while (waited_ms < max_wait_ms)
+void registerRawSubscriber(const std::string &topic_name, const RawCallback &callback)
+{
+  ZeroLanComNode::instance().registerRawSubscriber(topic_name, callback);
+}
+
+void registerRawSubscriber(const std::string &topic_name,
+                           const RawMessageCallback &callback)
+{
+  ZeroLanComNode::instance().registerRawSubscriber(topic_name, callback);
+}
+
+void setSubscriberSocketOptions(const std::string &topic_name,
+                                const SocketOptions &options)
+{
+  ZeroLanComNode::instance().setSubscriberSocketOptions(topic_name, options);
+}
+
+MetricsSnapshot getMetrics()
+{
+  if (ZeroLanComNode::isInitialized())
   {
-    auto serviceInfoPtr = NodeInfoManager::instance().getServiceInfo(service_name);
-    if (serviceInfoPtr != nullptr)
-    {
-      zlc::info("[Client] Service '{}' is now available.", service_name);
-      return;
-    }
-    std::this_thread::sleep_for(std::chrono::milliseconds(check_interval_ms));
-    waited_ms += check_interval_ms;
+    return ZeroLanComNode::instance().getMetrics();
   }
-  zlc::warn("[Client] Timeout waiting for service '{}'", service_name);
+  return MetricsRegistry::global().snapshot();
+}
+
+ResponseStatus requestMetrics(const std::string &node_name, MetricsSnapshot &metrics)
+{
+  return ZeroLanComNode::instance().requestMetrics(node_name, metrics);
+}
+
+void startMetricsExporter(const MetricsExporterOptions &options)
+{
+  stopMetricsExporter();
+  MetricsExporter::initManaged(ZeroLanComNode::instance().name(), options);
+  MetricsExporter::instance().start();
+}
+
+void stopMetricsExporter()
+{
+  MetricsExporter::destroy();
+}
+
+void registerStreamSubscriber(const std::string &name, const StreamCallback &callback,
+                              int window)
+{
+  ZeroLanComNode::instance().registerStreamSubscriber(name, callback, window);
 }
 } // namespace zlc
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "zerolancom/nodes/heartbeat_message.hpp"
+#include "zerolancom/nodes/node_info.hpp"
+#include "zerolancom/nodes/node_info_manager.hpp"
+#include "zerolancom/serialization/serializer.hpp"
+#include "zerolancom/utils/request_result.hpp"
+
+namespace zlc_test
+{
+
+struct DiscoverySimulatorOptions
+{
+  std::string group{"224.0.0.1"};
+  int port{7720};
+  std::string group_name{"zlc_default_group_name"};
+  std::string ip{"127.0.0.1"};
+  int heartbeat_interval_ms{1000};
+};
+
+/**
+ * @brief Simulates many discovery peers from inside one process.
+ *
+ * Every simulated peer owns a REP socket that answers `get_node_info` with a
+ * synthetic NodeInfo (one topic, one service) and sends HeartbeatMessage
+ * datagrams to the multicast group, spread evenly over the heartbeat interval.
+ * To a NodeInfoManager on the same group they look like real nodes, which
+ * lets tests and benchmarks load discovery with hundreds of peers and churn
+ * them without starting hundreds of processes.
+ *
+ * Peers get an empty hostID, so the manager treats them as remote nodes.
+ */
+class DiscoverySimulator
+{
+public:
+  explicit DiscoverySimulator(const DiscoverySimulatorOptions &options)
+      : options_(options), context_(1)
+  {
+    sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    int ttl = 1;
+    setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+    in_addr local{};
+    local.s_addr = inet_addr(options_.ip.c_str());
+    setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_IF, &local, sizeof(local));
+
+    addr_.sin_family = AF_INET;
+    addr_.sin_port = htons(static_cast<uint16_t>(options_.port));
+    addr_.sin_addr.s_addr = inet_addr(options_.group.c_str());
+
+    running_ = true;
+    server_thread_ = std::thread([this]() { serve(); });
+    heartbeat_thread_ = std::thread([this]() { sendHeartbeats(); });
+  }
+
+  ~DiscoverySimulator()
+  {
+    running_ = false;
+    server_thread_.join();
+    heartbeat_thread_.join();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      peers_.clear();
+    }
+    if (sock_ >= 0)
+    {
+      close(sock_);
+    }
+  }
+
+  DiscoverySimulator(const DiscoverySimulator &) = delete;
+  DiscoverySimulator &operator=(const DiscoverySimulator &) = delete;
+
+  /**
+   * @brief Start `count` new peers.
+   * @return node IDs of the new peers
+   */
+  std::vector<zlc::UUID> addPeers(size_t count)
+  {
+    std::vector<zlc::UUID> ids;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto peer = std::make_unique<Peer>(context_);
+      peer->socket.set(zmq::sockopt::linger, 0);
+      peer->socket.bind("tcp://" + options_.ip + ":0");
+      const std::string endpoint = peer->socket.get(zmq::sockopt::last_endpoint);
+      const auto port =
+          static_cast<uint16_t>(std::stoi(endpoint.substr(endpoint.rfind(':') + 1)));
+
+      const std::string name = "sim_peer_" + std::to_string(peers_.size());
+      peer->info.nodeID = zlc::generateUUID();
+      peer->info.infoID = 0;
+      peer->info.name = name;
+      peer->info.ip = options_.ip;
+      peer->info.topics.push_back(
+          zlc::SocketInfo{name + "/topic", options_.ip, port, {}, {}});
+      peer->info.services.push_back(
+          zlc::SocketInfo{name + "/service", options_.ip, port, {}, {}});
+      peer->port = port;
+
+      ids.push_back(peer->info.nodeID);
+      peers_.push_back(std::move(peer));
+    }
+    return ids;
+  }
+
+  /**
+   * @brief Stop a peer's heartbeats and replies, as if its process died.
+   *
+   * The socket stays bound until the simulator is destroyed, so pending
+   * fetches time out instead of being refused.
+   */
+  void removePeer(const zlc::UUID &id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Peer *peer = findUnlocked(id))
+    {
+      peer->alive = false;
+    }
+  }
+
+  // Bump a peer's info_id, as if it registered a new topic
+  void touchPeer(const zlc::UUID &id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Peer *peer = findUnlocked(id))
+    {
+      ++peer->info.infoID;
+    }
+  }
+
+  std::vector<zlc::UUID> alivePeers() const
+  {
+    std::vector<zlc::UUID> ids;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &peer : peers_)
+    {
+      if (peer->alive)
+      {
+        ids.push_back(peer->info.nodeID);
+      }
+    }
+    return ids;
+  }
+
+  bool isAlive(const zlc::UUID &id) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &peer : peers_)
+    {
+      if (peer->info.nodeID == id)
+      {
+        return peer->alive;
+      }
+    }
+    return false;
+  }
+
+  // get_node_info requests answered so far
+  uint64_t fetchesServed() const
+  {
+    return fetches_served_.load();
+  }
+
+  // CPU time used by the simulator's own threads, to subtract from the process
+  double cpuSeconds() const
+  {
+    return static_cast<double>(server_cpu_ns_.load() + heartbeat_cpu_ns_.load()) /
+           1e9;
+  }
+
+private:
+  struct Peer
+  {
+    explicit Peer(zmq::context_t &context) : socket(context, zmq::socket_type::rep)
+    {
+    }
+
+    zmq::socket_t socket;
+    zlc::NodeInfo info;
+    uint16_t port{0};
+    bool alive{true};
+  };
+
+  static uint64_t threadCpuNs()
+  {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+           static_cast<uint64_t>(ts.tv_nsec);
+  }
+
+  Peer *findUnlocked(const zlc::UUID &id)
+  {
+    for (auto &peer : peers_)
+    {
+      if (peer->info.nodeID == id)
+      {
+        return peer.get();
+      }
+    }
+    return nullptr;
+  }
+
+  // Answer get_node_info for every live peer. Only this thread touches the
+  // sockets once they are bound; peers are never freed before it exits.
+  void serve()
+  {
+    std::vector<zmq::pollitem_t> items;
+    std::vector<Peer *> polled;
+
+    while (running_)
+    {
+      items.clear();
+      polled.clear();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &peer : peers_)
+        {
+          if (peer->alive)
+          {
+            items.push_back({peer->socket.handle(), 0, ZMQ_POLLIN, 0});
+            polled.push_back(peer.get());
+          }
+        }
+      }
+
+      if (items.empty())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      else if (zmq::poll(items, std::chrono::milliseconds(10)) > 0)
+      {
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+          if (items[i].revents & ZMQ_POLLIN)
+          {
+            reply(*polled[i]);
+          }
+        }
+      }
+      server_cpu_ns_ = threadCpuNs();
+    }
+  }
+
+  void reply(Peer &peer)
+  {
+    // Drain [service][payload]; every request is answered with the NodeInfo
+    zmq::message_t frame;
+    do
+    {
+      if (!peer.socket.recv(frame, zmq::recv_flags::dontwait))
+      {
+        return;
+      }
+    } while (frame.more());
+
+    zlc::ByteBuffer out;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!peer.alive)
+      {
+        return; // removed while the request was queued
+      }
+      zlc::encode(peer.info, out);
+    }
+
+    const uint8_t code = static_cast<uint8_t>(zlc::ResponseStatus::SUCCESS);
+    peer.socket.send(zmq::buffer(&code, 1), zmq::send_flags::sndmore);
+    peer.socket.send(zmq::message_t(), zmq::send_flags::sndmore);
+    peer.socket.send(zmq::buffer(out.data, out.size), zmq::send_flags::none);
+    fetches_served_.fetch_add(1);
+  }
+
+  // Send each live peer's heartbeat once per interval, in 10 ms slots so the
+  // receiver sees a steady stream rather than one burst
+  void sendHeartbeats()
+  {
+    constexpr int SLOT_MS = 10;
+    const uint64_t slots =
+        static_cast<uint64_t>(std::max(1, options_.heartbeat_interval_ms / SLOT_MS));
+    auto next = std::chrono::steady_clock::now();
+
+    for (uint64_t tick = 0; running_; ++tick)
+    {
+      std::vector<zlc::Bytes> datagrams;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = tick % slots; i < peers_.size(); i += slots)
+        {
+          const Peer &peer = *peers_[i];
+          if (!peer.alive)
+          {
+            continue;
+          }
+          zlc::HeartbeatMessage msg;
+          msg.zlc_version = {zlc::ZLC_VERSION_MAJOR, zlc::ZLC_VERSION_MINOR,
+                             zlc::ZLC_VERSION_PATCH};
+          msg.node_id = peer.info.nodeID;
+          msg.info_id = static_cast<int32_t>(peer.info.infoID);
+          msg.service_port = peer.port;
+          msg.group_name = options_.group_name;
+          datagrams.push_back(msg.encode());
+        }
+      }
+
+      for (const auto &bytes : datagrams)
+      {
+        sendto(sock_, bytes.data(), bytes.size(), 0,
+               reinterpret_cast<const sockaddr *>(&addr_), sizeof(addr_));
+      }
+      heartbeat_cpu_ns_ = threadCpuNs();
+
+      next += std::chrono::milliseconds(SLOT_MS);
+      std::this_thread::sleep_until(next);
+    }
+  }
+
+  DiscoverySimulatorOptions options_;
+  zmq::context_t context_;
+  int sock_{-1};
+  sockaddr_in addr_{};
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Peer>> peers_;
+
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> fetches_served_{0};
+  std::atomic<uint64_t> server_cpu_ns_{0};
+  std::atomic<uint64_t> heartbeat_cpu_ns_{0};
+  std::thread server_thread_;
+  std::thread heartbeat_thread_;
+};
+
+/**
+ * @brief Tracks which simulated peers a NodeInfoManager currently knows.
+ *
+ * Subscribes to the manager's update and remove events; a removal of a peer
+ * the simulator still runs counts as a false eviction. Events cannot be
+ * unsubscribed, so shut the node down before the observer goes away.
+ */
+class DiscoveryObserver
+{
+public:
+  DiscoveryObserver(zlc::NodeInfoManager &manager, const DiscoverySimulator &simulator)
+  {
+    manager.node_update_event.subscribe(
+        [this](const zlc::NodeInfo &info)
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          known_.insert(info.nodeID);
+          ++updates_;
+        });
+    manager.node_remove_event.subscribe(
+        [this, &simulator](const zlc::NodeInfo &info)
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          known_.erase(info.nodeID);
+          ++removals_;
+          if (simulator.isAlive(info.nodeID))
+          {
+            ++false_evictions_;
+          }
+        });
+  }
+
+  DiscoveryObserver(const DiscoveryObserver &) = delete;
+  DiscoveryObserver &operator=(const DiscoveryObserver &) = delete;
+
+  // How many of `ids` the manager currently knows
+  size_t knownCount(const std::vector<zlc::UUID> &ids) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto &id : ids)
+    {
+      count += known_.count(id);
+    }
+    return count;
+  }
+
+  // node_update_event count: first fetches plus re-fetches
+  uint64_t updates() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return updates_;
+  }
+
+  uint64_t removals() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return removals_;
+  }
+
+  uint64_t falseEvictions() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return false_evictions_;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::unordered_set<zlc::UUID> known_;
+  uint64_t updates_{0};
+  uint64_t removals_{0};
+  uint64_t false_evictions_{0};
+};
+
+} // namespace zlc_test
@@ -0,0 +1,351 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "zerolancom/bag/bag_reader.hpp"
+#include "zerolancom/bag/bag_writer.hpp"
+#include "zerolancom/utils/logger.hpp"
+
+using namespace zlc;
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class BagTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!Logger::isInitialized())
+    {
+      Logger::init();
+    }
+    path_ = (std::filesystem::temp_directory_path() /
+             ("zlc_test_" + std::to_string(getpid()) + ".bag"))
+                .string();
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove(path_);
+  }
+
+  static Bytes payload(size_t size, uint8_t seed)
+  {
+    Bytes bytes(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      bytes[i] = static_cast<uint8_t>(seed + i);
+    }
+    return bytes;
+  }
+
+  static ByteView view(const Bytes &bytes)
+  {
+    return ByteView{bytes.data(), bytes.size()};
+  }
+
+  struct Read
+  {
+    std::string topic;
+    uint64_t timestamp_ns;
+    Bytes data;
+  };
+
+  std::vector<Read> readAll(const BagReader &reader)
+  {
+    std::vector<Read> messages;
+    reader.forEach(
+        [&](const BagMessage &message)
+        {
+          messages.push_back({message.topic ? *message.topic : "", message.timestamp_ns,
+                              Bytes(message.data.begin(), message.data.end())});
+          return true;
+        });
+    return messages;
+  }
+
+  std::string path_;
+};
+
+// =============================================
+// Bag Tests
+// =============================================
+
+TEST_F(BagTest, RoundTrip)
+{
+  auto writer = BagWriter::create(path_);
+  ASSERT_NE(writer, nullptr);
+  const uint16_t camera = writer->addTopic("camera");
+  const uint16_t imu = writer->addTopic("imu");
+  EXPECT_EQ(writer->addTopic("camera"), camera);
+
+  const Bytes frame = payload(1000, 1);
+  const Bytes sample = payload(13, 2);
+  EXPECT_TRUE(writer->write(camera, 100, view(frame)));
+  EXPECT_TRUE(writer->write(imu, 150, view(sample)));
+  EXPECT_TRUE(writer->write(camera, 200, view(frame)));
+  writer->close();
+
+  const BagWriterStats stats = writer->stats();
+  EXPECT_EQ(stats.messages, 3u);
+  EXPECT_EQ(stats.bytes, 2013u);
+  EXPECT_EQ(stats.dropped, 0u);
+
+  auto reader = BagReader::open(path_);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(reader->messageCount(), 3u);
+  EXPECT_EQ(reader->startNs(), 100u);
+  EXPECT_EQ(reader->endNs(), 200u);
+
+  const auto messages = readAll(*reader);
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_EQ(messages[0].topic, "camera");
+  EXPECT_EQ(messages[0].data, frame);
+  EXPECT_EQ(messages[1].topic, "imu");
+  EXPECT_EQ(messages[1].timestamp_ns, 150u);
+  EXPECT_EQ(messages[1].data, sample);
+  EXPECT_EQ(messages[2].timestamp_ns, 200u);
+}
+
+TEST_F(BagTest, SpansChunksAndOversizedMessages)
+{
+  BagWriterOptions options;
+  options.chunk_size = 4096;
+  auto writer = BagWriter::create(path_, options);
+  ASSERT_NE(writer, nullptr);
+  const uint16_t topic = writer->addTopic("frames");
+
+  // Several messages per chunk, then one larger than a chunk
+  for (uint64_t i = 0; i < 20; ++i)
+  {
+    const Bytes data = payload(1500, static_cast<uint8_t>(i));
+    ASSERT_TRUE(writer->write(topic, i, view(data)));
+  }
+  const Bytes big = payload(3 * 4096, 7);
+  ASSERT_TRUE(writer->write(topic, 20, view(big)));
+  writer->close();
+  EXPECT_GT(writer->stats().chunks, 5u);
+
+  auto reader = BagReader::open(path_);
+  ASSERT_NE(reader, nullptr);
+  const auto messages = readAll(*reader);
+  ASSERT_EQ(messages.size(), 21u);
+  for (uint64_t i = 0; i < 20; ++i)
+  {
+    EXPECT_EQ(messages[i].topic, "frames");
+    EXPECT_EQ(messages[i].data, payload(1500, static_cast<uint8_t>(i)));
+  }
+  EXPECT_EQ(messages[20].data, big);
+}
+
+TEST_F(BagTest, DropsWhenQueueIsFull)
+{
+  BagWriterOptions options;
+  options.queue_bytes = 100;
+  auto writer = BagWriter::create(path_, options);
+  ASSERT_NE(writer, nullptr);
+  const uint16_t topic = writer->addTopic("big");
+
+  EXPECT_FALSE(writer->write(topic, 1, view(payload(200, 0))));
+  writer->close();
+  EXPECT_EQ(writer->stats().dropped, 1u);
+  EXPECT_EQ(writer->stats().messages, 0u);
+  EXPECT_FALSE(writer->write(topic, 2, view(payload(10, 0)))); // closed
+
+  auto reader = BagReader::open(path_);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(reader->messageCount(), 0u);
+}
+
+TEST_F(BagTest, CloseKeepsEveryAcceptedMessage)
+{
+  auto writer = BagWriter::create(path_);
+  ASSERT_NE(writer, nullptr);
+  const uint16_t topic = writer->addTopic("race");
+
+  // Writers keep going while close() runs; whatever write() accepted must be
+  // in the file
+  std::atomic<uint64_t> accepted{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back(
+        [&, t]()
+        {
+          const Bytes data = payload(64, static_cast<uint8_t>(t));
+          for (uint64_t i = 0; i < 20000; ++i)
+          {
+            if (writer->write(topic, i, zmq::message_t(data.data(), data.size())))
+            {
+              accepted.fetch_add(1);
+            }
+          }
+        });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  writer->close();
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  const BagWriterStats stats = writer->stats();
+  EXPECT_EQ(stats.messages, accepted.load());
+  EXPECT_EQ(stats.messages + stats.dropped, 80000u);
+
+  auto reader = BagReader::open(path_);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(reader->messageCount(), accepted.load());
+}
+
+TEST_F(BagTest, RejectsOtherFiles)
+{
+  EXPECT_EQ(BagReader::open(path_ + ".missing"), nullptr);
+
+  auto writer = BagWriter::create(path_);
+  ASSERT_NE(writer, nullptr);
+  writer->close();
+  ::truncate(path_.c_str(), 100);
+  EXPECT_EQ(BagReader::open(path_), nullptr);
+}
+
+// =============================================
+// Indexed Reads
+// =============================================
+
+namespace
+{
+// 300 messages on three topics, 10 ns apart, over many small chunks
+void writeThreeTopics(const std::string &path)
+{
+  BagWriterOptions options;
+  options.chunk_size = 4096;
+  auto writer = BagWriter::create(path, options);
+  ASSERT_NE(writer, nullptr);
+  const uint16_t ids[] = {writer->addTopic("a"), writer->addTopic("b"),
+                          writer->addTopic("c")};
+  const Bytes data(500, 0x5a);
+  for (uint64_t i = 0; i < 300; ++i)
+  {
+    ASSERT_TRUE(writer->write(ids[i % 3], i * 10, ByteView{data.data(), data.size()}));
+  }
+  writer->close();
+}
+} // namespace
+
+TEST_F(BagTest, QueriesByTopicAndTime)
+{
+  writeThreeTopics(path_);
+  auto reader = BagReader::open(path_);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_TRUE(reader->indexed());
+  EXPECT_GT(reader->chunkCount(), 10u);
+  EXPECT_EQ(reader->messageCount(), 300u);
+  EXPECT_EQ(reader->endNs(), 2990u);
+  ASSERT_EQ(reader->topics().size(), 3u);
+  EXPECT_EQ(reader->topics()[1].name, "b");
+  EXPECT_EQ(reader->topics()[1].message_count, 100u);
+  EXPECT_EQ(reader->topics()[1].start_ns, 10u);
+
+  BagQuery query;
+  query.topics = {"b", "missing"};
+  query.start_ns = 1000;
+  query.end_ns = 1990;
+  std::vector<uint64_t> timestamps;
+  reader->forEach(query,
+                  [&](const BagMessage &message)
+                  {
+                    EXPECT_EQ(*message.topic, "b");
+                    EXPECT_EQ(message.data.size, 500u);
+                    timestamps.push_back(message.timestamp_ns);
+                    return true;
+                  });
+
+  // b is every third message starting at 10 ns: 1000, 1030, ..., 1990
+  ASSERT_EQ(timestamps.size(), 34u);
+  EXPECT_EQ(timestamps.front(), 1000u);
+  EXPECT_EQ(timestamps.back(), 1990u);
+
+  query.topics = {"missing"};
+  size_t count = 0;
+  reader->forEach(query,
+                  [&](const BagMessage &)
+                  {
+                    ++count;
+                    return true;
+                  });
+  EXPECT_EQ(count, 0u);
+}
+
+TEST_F(BagTest, ParallelVisitsEveryMatch)
+{
+  writeThreeTopics(path_);
+  auto reader = BagReader::open(path_);
+  ASSERT_NE(reader, nullptr);
+
+  BagQuery query;
+  query.topics = {"a", "c"};
+  std::atomic<size_t> count{0};
+  std::atomic<uint64_t> sum{0};
+  reader->forEachParallel(
+      query,
+      [&](const BagMessage &message)
+      {
+        count.fetch_add(1);
+        sum.fetch_add(message.timestamp_ns);
+        return true;
+      },
+      4);
+
+  uint64_t expected = 0;
+  for (uint64_t i = 0; i < 300; ++i)
+  {
+    expected += (i % 3 != 1) ? i * 10 : 0;
+  }
+  EXPECT_EQ(count.load(), 200u);
+  EXPECT_EQ(sum.load(), expected);
+
+  EXPECT_THROW(reader->forEachParallel(
+                   query, [](const BagMessage &) -> bool
+                   { throw std::runtime_error("decode failed"); }),
+               std::runtime_error);
+}
+
+TEST_F(BagTest, ScansFilesWithoutSummary)
+{
+  writeThreeTopics(path_);
+
+  // A recorder that died before close() leaves no footer
+  const auto size = std::filesystem::file_size(path_);
+  ::truncate(path_.c_str(), static_cast<off_t>(size - sizeof(BagFooter)));
+
+  auto reader = BagReader::open(path_);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_FALSE(reader->indexed());
+  EXPECT_EQ(reader->messageCount(), 300u);
+  EXPECT_EQ(reader->startNs(), 0u);
+  EXPECT_EQ(reader->endNs(), 2990u);
+
+  BagQuery query;
+  query.topics = {"c"};
+  query.end_ns = 100;
+  size_t count = 0;
+  reader->forEach(query,
+                  [&](const BagMessage &message)
+                  {
+                    EXPECT_EQ(*message.topic, "c");
+                    ++count;
+                    return true;
+                  });
+  EXPECT_EQ(count, 3u); // 20, 50 and 80 ns
+}
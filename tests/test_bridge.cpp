@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "zerolancom/nodes/bridge.hpp"
+#include "zerolancom/zerolancom.hpp"
+
+#include "test_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_test;
+
+// =============================================
+// Global State for Async Callbacks
+// =============================================
+
+namespace
+{
+AsyncResult<std::string> g_topic_result;
+
+void topicCallback(const std::string &msg)
+{
+  g_topic_result.set(msg);
+}
+} // namespace
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class BridgeTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!Logger::isInitialized())
+    {
+      Logger::init();
+    }
+    // Two groups of our own that only the bridge is part of both of
+    const std::string prefix = "bridge_" + std::to_string(getpid());
+    BridgeOptions options;
+    options.a.node.group_name = unique_name(prefix + "_a");
+    options.b.node.group_name = unique_name(prefix + "_b");
+    options.service_timeout_ms = 2000;
+
+    node_a_ = std::make_unique<Node>(unique_name("NodeA"), "127.0.0.1", options.a.node);
+    node_b_ = std::make_unique<Node>(unique_name("NodeB"), "127.0.0.1", options.b.node);
+    bridge_ = std::make_unique<Bridge>(options);
+    g_topic_result.reset();
+  }
+
+  void TearDown() override
+  {
+    bridge_.reset();
+    node_b_.reset();
+    node_a_.reset();
+  }
+
+  std::unique_ptr<Node> node_a_;
+  std::unique_ptr<Node> node_b_;
+  std::unique_ptr<Bridge> bridge_;
+};
+
+// =============================================
+// Bridge Tests
+// =============================================
+
+TEST_F(BridgeTest, RelaysTopic)
+{
+  const std::string topic = unique_name("BridgedTopic");
+  ASSERT_TRUE(bridge_->relayTopic(topic, BridgeDirection::A_TO_B));
+  node_b_->registerSubscriberHandler(topic, topicCallback);
+
+  Publisher<std::string> pub(*node_a_, topic);
+
+  // Publish until both hops have discovered the topic and connected
+  for (int i = 0; i < 100 && !g_topic_result.received(); ++i)
+  {
+    pub.publish("from A");
+    g_topic_result.wait_for(std::chrono::milliseconds(100));
+  }
+
+  ASSERT_TRUE(g_topic_result.received());
+  EXPECT_EQ(g_topic_result.get(), "from A");
+}
+
+TEST_F(BridgeTest, RelaysService)
+{
+  const std::string service = unique_name("BridgedEcho");
+  node_a_->registerServiceHandler(service, echoServiceHandler);
+  ASSERT_TRUE(bridge_->relayService(service, BridgeDirection::A_TO_B));
+  bridge_->nodeA().waitForService(service, 3000);
+
+  node_b_->waitForService(service, 3000);
+  std::string response;
+  ResponseStatus status = node_b_->request(service, std::string("hello"), response);
+
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "hello");
+}
+
+TEST_F(BridgeTest, SlowRelayDoesNotStallOtherServices)
+{
+  const std::string slow = unique_name("BridgedSlow");
+  const std::string fast = unique_name("BridgedFast");
+  node_a_->registerServiceHandler(
+      slow, +[](const std::string &msg)
+            {
+              std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+              return msg;
+            });
+  node_a_->setServiceLimits(slow, ServiceLimits{2, 0}); // not the provider's bottleneck
+  node_a_->registerServiceHandler(fast, echoServiceHandler);
+  ASSERT_TRUE(bridge_->relayService(slow, BridgeDirection::A_TO_B));
+  ASSERT_TRUE(bridge_->relayService(fast, BridgeDirection::A_TO_B));
+  ASSERT_TRUE(bridge_->nodeA().waitForAll(
+      {slow, fast}, std::chrono::steady_clock::now() + std::chrono::seconds(3)));
+  ASSERT_TRUE(node_b_->waitForAll(
+      {slow, fast}, std::chrono::steady_clock::now() + std::chrono::seconds(3)));
+
+  ResponseStatus slow_status = ResponseStatus::UNKNOWN_ERROR;
+  std::thread caller(
+      [&]()
+      {
+        std::string response;
+        slow_status = node_b_->request(slow, std::string("slow"), response);
+      });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // The far node's polling thread is free while the slow call is relayed
+  const auto start = std::chrono::steady_clock::now();
+  std::string response;
+  EXPECT_EQ(node_b_->request(fast, std::string("fast"), response),
+            ResponseStatus::SUCCESS);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+
+  caller.join();
+  EXPECT_EQ(slow_status, ResponseStatus::SUCCESS);
+}
+
+TEST_F(BridgeTest, RefusesBothDirections)
+{
+  const std::string topic = unique_name("LoopTopic");
+  EXPECT_TRUE(bridge_->relayTopic(topic, BridgeDirection::A_TO_B));
+  EXPECT_TRUE(bridge_->relayTopic(topic, BridgeDirection::A_TO_B));
+  EXPECT_FALSE(bridge_->relayTopic(topic, BridgeDirection::B_TO_A));
+
+  const std::string service = unique_name("LoopService");
+  EXPECT_TRUE(bridge_->relayService(service, BridgeDirection::B_TO_A));
+  EXPECT_FALSE(bridge_->relayService(service, BridgeDirection::A_TO_B));
+}
+
+TEST_F(BridgeTest, RejectedLimitsReleaseTheService)
+{
+  const std::string service = unique_name("LimitedService");
+  // The far side already has limits for it, so the bridge cannot set its own
+  ASSERT_TRUE(bridge_->nodeB().setServiceLimits(service, ServiceLimits{1, 0}));
+
+  EXPECT_FALSE(bridge_->relayService(service, BridgeDirection::A_TO_B));
+  EXPECT_FALSE(node_b_->waitForService(service, 500));
+
+  // Not claimed, so the other direction is still free
+  EXPECT_TRUE(bridge_->relayService(service, BridgeDirection::B_TO_A));
+}
+
+TEST_F(BridgeTest, MissingProviderReportsNoService)
+{
+  const std::string service = unique_name("NobodyHome");
+  ASSERT_TRUE(bridge_->relayService(service, BridgeDirection::A_TO_B));
+
+  node_b_->waitForService(service, 3000);
+  std::string response;
+  ResponseStatus status = node_b_->request(service, std::string("hi"), response);
+  EXPECT_EQ(status, ResponseStatus::NOSERVICE);
+}
@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zerolancom/serialization/compression.hpp"
+#include "zerolancom/serialization/message_header.hpp"
+#include "zerolancom/utils/exception.hpp"
+
+using namespace zlc;
+
+namespace
+{
+// Highly compressible payload, e.g. an occupancy grid
+Bytes makeGrid(size_t size)
+{
+  Bytes data(size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    data[i] = static_cast<uint8_t>((i / 64) % 3 == 0 ? 0xFF : 0x00);
+  }
+  return data;
+}
+
+void roundTrip(CompressionCodec codec)
+{
+  CompressionConfig config;
+  config.codec = codec;
+  config.threshold = 128;
+  Compressor compressor(config);
+
+  Bytes raw = makeGrid(64 * 1024);
+  Bytes compressed;
+  MessageHeader header;
+  ASSERT_TRUE(compressor.compress(ByteView{raw.data(), raw.size()}, compressed, header));
+  EXPECT_TRUE(header.compressed());
+  EXPECT_EQ(header.codec, codec);
+  EXPECT_EQ(header.raw_size, raw.size());
+  EXPECT_LT(compressed.size(), raw.size());
+
+  Bytes wire = header.encode();
+  MessageHeader received = MessageHeader::decode(wire.data(), wire.size());
+
+  Bytes restored(received.raw_size);
+  CompressionStats stats;
+  decompress(received, ByteView{compressed.data(), compressed.size()}, restored.data(),
+             &stats);
+  EXPECT_EQ(restored, raw);
+
+  auto snap = stats.snapshot();
+  EXPECT_EQ(snap.messages, 1u);
+  EXPECT_LT(snap.ratio(), 1.0);
+  EXPECT_EQ(compressor.stats().messages, 1u);
+}
+} // namespace
+
+// =============================================
+// MessageHeader Tests
+// =============================================
+
+TEST(CompressionTest, EmptyHeaderEncodesToNothing)
+{
+  MessageHeader header;
+  EXPECT_TRUE(header.encode().empty());
+
+  MessageHeader decoded = MessageHeader::decode(nullptr, 0);
+  EXPECT_TRUE(decoded.empty());
+}
+
+TEST(CompressionTest, HeaderRoundTrip)
+{
+  MessageHeader header;
+  header.flags = MessageHeader::FLAG_COMPRESSED;
+  header.codec = CompressionCodec::ZSTD;
+  header.raw_size = 0x0102030405ULL;
+
+  Bytes wire = header.encode();
+  MessageHeader decoded = MessageHeader::decode(wire.data(), wire.size());
+
+  EXPECT_EQ(decoded.flags, header.flags);
+  EXPECT_EQ(decoded.codec, header.codec);
+  EXPECT_EQ(decoded.raw_size, header.raw_size);
+}
+
+TEST(CompressionTest, TracedHeaderRoundTrip)
+{
+  MessageHeader header;
+  header.flags = MessageHeader::FLAG_COMPRESSED | MessageHeader::FLAG_SEQUENCED |
+                 MessageHeader::FLAG_TIMESTAMPED;
+  header.codec = CompressionCodec::LZ4;
+  header.raw_size = 4096;
+  header.publisher_id = 0xCAFEF00D;
+  header.seq = 42;
+  header.clock = TraceClock::REALTIME;
+  header.publish_ns = traceClockNow(TraceClock::REALTIME);
+  header.send_ns = header.publish_ns + 1500;
+
+  Bytes wire = header.encode();
+  EXPECT_EQ(wire.size(), 1u + 9u + 12u + 17u);
+  MessageHeader decoded = MessageHeader::decode(wire.data(), wire.size());
+
+  EXPECT_TRUE(decoded.sequenced());
+  EXPECT_TRUE(decoded.timestamped());
+  EXPECT_EQ(decoded.raw_size, header.raw_size);
+  EXPECT_EQ(decoded.publisher_id, header.publisher_id);
+  EXPECT_EQ(decoded.seq, header.seq);
+  EXPECT_EQ(decoded.clock, TraceClock::REALTIME);
+  EXPECT_EQ(decoded.publish_ns, header.publish_ns);
+  EXPECT_EQ(decoded.send_ns, header.send_ns);
+
+  // Cutting the timestamp short is an error, like any other truncation
+  EXPECT_THROW(MessageHeader::decode(wire.data(), wire.size() - 1), DecodeException);
+}
+
+TEST(CompressionTest, TruncatedHeaderThrows)
+{
+  uint8_t truncated[] = {MessageHeader::FLAG_COMPRESSED, 0x01};
+  EXPECT_THROW(MessageHeader::decode(truncated, sizeof(truncated)), DecodeException);
+}
+
+// =============================================
+// Compressor Tests
+// =============================================
+
+TEST(CompressionTest, DisabledCompressorSendsRaw)
+{
+  Compressor compressor;
+  Bytes raw = makeGrid(8192);
+  Bytes out;
+  MessageHeader header;
+
+  EXPECT_FALSE(compressor.enabled());
+  EXPECT_FALSE(compressor.compress(ByteView{raw.data(), raw.size()}, out, header));
+  EXPECT_TRUE(header.empty());
+}
+
+TEST(CompressionTest, BelowThresholdIsSkipped)
+{
+  CompressionConfig config;
+  config.codec = CompressionCodec::LZ4;
+  config.threshold = 1024;
+  Compressor compressor(config);
+
+  Bytes raw = makeGrid(512);
+  Bytes out;
+  MessageHeader header;
+
+  EXPECT_FALSE(compressor.compress(ByteView{raw.data(), raw.size()}, out, header));
+  EXPECT_TRUE(header.empty());
+}
+
+TEST(CompressionTest, Lz4RoundTrip)
+{
+  if (!isCodecAvailable(CompressionCodec::LZ4))
+    GTEST_SKIP() << "Built without LZ4";
+  roundTrip(CompressionCodec::LZ4);
+}
+
+TEST(CompressionTest, ZstdRoundTrip)
+{
+  if (!isCodecAvailable(CompressionCodec::ZSTD))
+    GTEST_SKIP() << "Built without zstd";
+  roundTrip(CompressionCodec::ZSTD);
+}
+
+TEST(CompressionTest, CorruptPayloadThrows)
+{
+  if (!isCodecAvailable(CompressionCodec::LZ4))
+    GTEST_SKIP() << "Built without LZ4";
+
+  MessageHeader header;
+  header.flags = MessageHeader::FLAG_COMPRESSED;
+  header.codec = CompressionCodec::LZ4;
+  header.raw_size = 1024;
+
+  Bytes garbage(32, 0xAB);
+  Bytes out(header.raw_size);
+  EXPECT_THROW(decompress(header, ByteView{garbage.data(), garbage.size()}, out.data()),
+               DecodeException);
+}
+
+TEST(CompressionTest, OversizedRawSizeIsRejected)
+{
+  MessageHeader header;
+  header.flags = MessageHeader::FLAG_COMPRESSED;
+  header.codec = CompressionCodec::ZSTD;
+  header.raw_size = DEFAULT_MAX_DECOMPRESSED_SIZE + 1;
+
+  Bytes payload(32, 0xAB);
+  EXPECT_THROW(checkDecompressedSize(header, ByteView{payload.data(), payload.size()}),
+               DecodeException);
+
+  setMaxDecompressedSize(16);
+  header.raw_size = 17;
+  EXPECT_THROW(checkDecompressedSize(header, ByteView{payload.data(), payload.size()}),
+               DecodeException);
+  setMaxDecompressedSize(DEFAULT_MAX_DECOMPRESSED_SIZE);
+}
+
+TEST(CompressionTest, ImpossibleLz4SizeIsRejected)
+{
+  MessageHeader header;
+  header.flags = MessageHeader::FLAG_COMPRESSED;
+  header.codec = CompressionCodec::LZ4;
+
+  // 32 bytes of lz4 cannot expand to 1 MiB
+  Bytes payload(32, 0xAB);
+  header.raw_size = 1024 * 1024;
+  EXPECT_THROW(checkDecompressedSize(header, ByteView{payload.data(), payload.size()}),
+               DecodeException);
+
+  header.raw_size = 1024;
+  EXPECT_NO_THROW(
+      checkDecompressedSize(header, ByteView{payload.data(), payload.size()}));
+}
+
+TEST(CompressionTest, ZstdSizeMismatchIsRejected)
+{
+  if (!isCodecAvailable(CompressionCodec::ZSTD))
+    GTEST_SKIP() << "Built without zstd";
+
+  CompressionConfig config;
+  config.codec = CompressionCodec::ZSTD;
+  config.threshold = 128;
+  Compressor compressor(config);
+
+  Bytes raw = makeGrid(64 * 1024);
+  Bytes compressed;
+  MessageHeader header;
+  ASSERT_TRUE(compressor.compress(ByteView{raw.data(), raw.size()}, compressed, header));
+  const ByteView view{compressed.data(), compressed.size()};
+  EXPECT_NO_THROW(checkDecompressedSize(header, view));
+
+  // A peer lying about the raw size is caught before anything is allocated
+  header.raw_size = 64 * 1024 * 1024;
+  EXPECT_THROW(checkDecompressedSize(header, view), DecodeException);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "discovery_simulator.hpp"
+#include "test_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_test;
+
+namespace
+{
+bool waitUntil(const std::function<bool()> &ready, std::chrono::milliseconds timeout)
+{
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!ready())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+
+// Long enough for a node that stopped sending heartbeats to be evicted
+const std::chrono::milliseconds EVICTION_TIMEOUT{NodeInfoManager::HEARTBEAT_TIMEOUT_MS +
+                                                 2000};
+} // namespace
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class DiscoveryLoadTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // A group of our own, so concurrent test binaries do not see these peers
+    options_.group_name = unique_name("discovery_load_" + std::to_string(getpid()));
+    simulator_ = std::make_unique<DiscoverySimulator>(options_);
+
+    zlc::init(unique_name("DiscoveryLoadNode"), options_.ip, options_.group,
+              options_.port, options_.group_name);
+    observer_ = std::make_unique<DiscoveryObserver>(
+        ZeroLanComNode::instance().nodeInfoManager(), *simulator_);
+  }
+
+  void TearDown() override
+  {
+    zlc::shutdown();
+    observer_.reset();
+    simulator_.reset();
+  }
+
+  bool converged(const std::vector<UUID> &ids, std::chrono::milliseconds timeout)
+  {
+    return waitUntil([&]() { return observer_->knownCount(ids) == ids.size(); },
+                     timeout);
+  }
+
+  DiscoverySimulatorOptions options_;
+  std::unique_ptr<DiscoverySimulator> simulator_;
+  std::unique_ptr<DiscoveryObserver> observer_;
+};
+
+// =============================================
+// Load Tests
+// =============================================
+
+TEST_F(DiscoveryLoadTest, HundredPeersConverge)
+{
+  const auto peers = simulator_->addPeers(100);
+
+  ASSERT_TRUE(converged(peers, std::chrono::seconds(15)));
+  EXPECT_EQ(MetricsRegistry::global().discovery().nodes.value(), 100);
+
+  // Peers that keep sending heartbeats must never be evicted
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+      NodeInfoManager::HEARTBEAT_TIMEOUT_MS + 1000));
+  EXPECT_EQ(observer_->knownCount(peers), peers.size());
+  EXPECT_EQ(observer_->falseEvictions(), 0u);
+}
+
+TEST_F(DiscoveryLoadTest, SilentPeersAreEvicted)
+{
+  const auto peers = simulator_->addPeers(40);
+  ASSERT_TRUE(converged(peers, std::chrono::seconds(10)));
+
+  const std::vector<UUID> removed(peers.begin(), peers.begin() + 10);
+  const std::vector<UUID> kept(peers.begin() + 10, peers.end());
+  for (const auto &id : removed)
+  {
+    simulator_->removePeer(id);
+  }
+
+  EXPECT_TRUE(waitUntil([&]() { return observer_->knownCount(removed) == 0; },
+                        EVICTION_TIMEOUT));
+  EXPECT_EQ(observer_->knownCount(kept), kept.size());
+  EXPECT_EQ(observer_->removals(), removed.size());
+  EXPECT_EQ(observer_->falseEvictions(), 0u);
+}
+
+TEST_F(DiscoveryLoadTest, ChurnedPeersJoin)
+{
+  const auto first = simulator_->addPeers(30);
+  ASSERT_TRUE(converged(first, std::chrono::seconds(10)));
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    simulator_->removePeer(first[i]);
+  }
+  const auto second = simulator_->addPeers(10);
+
+  EXPECT_TRUE(converged(second, std::chrono::seconds(10)));
+  EXPECT_TRUE(waitUntil(
+      [&]()
+      {
+        return observer_->knownCount(std::vector<UUID>(first.begin(),
+                                                       first.begin() + 10)) == 0;
+      },
+      EVICTION_TIMEOUT));
+  EXPECT_EQ(observer_->falseEvictions(), 0u);
+}
+
+TEST_F(DiscoveryLoadTest, InfoChangeIsRefetched)
+{
+  const auto peers = simulator_->addPeers(10);
+  ASSERT_TRUE(converged(peers, std::chrono::seconds(10)));
+
+  // Unchanged peers are not fetched again
+  const uint64_t updates = observer_->updates();
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(2 * options_.heartbeat_interval_ms));
+  EXPECT_EQ(observer_->updates(), updates);
+
+  simulator_->touchPeer(peers[0]);
+  EXPECT_TRUE(waitUntil([&]() { return observer_->updates() == updates + 1; },
+                        std::chrono::seconds(5)));
+}
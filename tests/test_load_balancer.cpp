@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "zerolancom/sockets/load_balancer.hpp"
+#include "zerolancom/utils/logger.hpp"
+
+using namespace zlc;
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class LoadBalancerTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!Logger::isInitialized())
+    {
+      Logger::init();
+    }
+    for (uint16_t port : {5001, 5002, 5003})
+    {
+      providers_.push_back(SocketInfo{"plan_path", "10.0.0.1", port, {}, {}});
+    }
+  }
+
+  std::string url(uint16_t port) const
+  {
+    return "tcp://10.0.0.1:" + std::to_string(port);
+  }
+
+  LoadBalancer balancer_;
+  std::vector<SocketInfo> providers_;
+};
+
+// =============================================
+// Policy Tests
+// =============================================
+
+TEST_F(LoadBalancerTest, RoundRobinVisitsEveryProvider)
+{
+  std::map<std::string, int> calls;
+  for (int i = 0; i < 30; ++i)
+  {
+    const std::string picked = balancer_.acquire("plan_path", providers_);
+    balancer_.release("plan_path", picked, ResponseStatus::SUCCESS, {});
+    ++calls[picked];
+  }
+  ASSERT_EQ(calls.size(), 3u);
+  for (const auto &[picked, count] : calls)
+  {
+    EXPECT_EQ(count, 10) << picked;
+  }
+  EXPECT_TRUE(balancer_.acquire("plan_path", {}).empty());
+}
+
+TEST_F(LoadBalancerTest, LeastOutstandingAvoidsBusyProvider)
+{
+  LoadBalancerOptions options;
+  options.policy = LoadBalancePolicy::LEAST_OUTSTANDING;
+  balancer_.setOptions("plan_path", options);
+
+  // Three calls in flight, one per provider; the first one then finishes
+  const std::string first = balancer_.acquire("plan_path", providers_);
+  balancer_.acquire("plan_path", providers_);
+  balancer_.acquire("plan_path", providers_);
+  balancer_.release("plan_path", first, ResponseStatus::SUCCESS, {});
+
+  EXPECT_EQ(balancer_.acquire("plan_path", providers_), first);
+}
+
+TEST_F(LoadBalancerTest, EwmaPrefersFastProvider)
+{
+  LoadBalancerOptions options;
+  options.policy = LoadBalancePolicy::EWMA;
+  balancer_.setOptions("plan_path", options);
+
+  // One call each to measure them; 5002 is the fastest
+  for (int i = 0; i < 3; ++i)
+  {
+    const std::string picked = balancer_.acquire("plan_path", providers_);
+    const auto latency = std::chrono::milliseconds(picked == url(5002) ? 1 : 20);
+    balancer_.release("plan_path", picked, ResponseStatus::SUCCESS, latency);
+  }
+
+  for (int i = 0; i < 5; ++i)
+  {
+    const std::string picked = balancer_.acquire("plan_path", providers_);
+    EXPECT_EQ(picked, url(5002));
+    balancer_.release("plan_path", picked, ResponseStatus::SUCCESS,
+                      std::chrono::milliseconds(1));
+  }
+}
+
+TEST_F(LoadBalancerTest, TimeoutEjectsProvider)
+{
+  LoadBalancerOptions options;
+  options.eject_ms = 200;
+  balancer_.setOptions("plan_path", options);
+
+  {
+    LoadBalancer::Call call(balancer_, "plan_path", providers_);
+    call.finish(ResponseStatus::SERVICE_TIMEOUT);
+    EXPECT_EQ(call.url(), url(5001));
+  }
+  EXPECT_TRUE(balancer_.isEjected("plan_path", url(5001)));
+
+  for (int i = 0; i < 10; ++i)
+  {
+    LoadBalancer::Call call(balancer_, "plan_path", providers_);
+    EXPECT_NE(call.url(), url(5001));
+    call.finish(ResponseStatus::SUCCESS);
+  }
+
+  // The only provider is used even while ejected
+  const std::vector<SocketInfo> only{providers_[0]};
+  EXPECT_EQ(balancer_.acquire("plan_path", only), url(5001));
+}
+
+TEST_F(LoadBalancerTest, DefaultOptionsTimeOut)
+{
+  // Without a finite timeout a hung provider would never be ejected
+  const LoadBalancerOptions options = balancer_.options("plan_path");
+  EXPECT_GT(options.request_timeout_ms, 0);
+  EXPECT_GT(options.eject_ms, 0);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "zerolancom/utils/logger.hpp"
+
+using namespace zlc;
+
+// =============================================
+// Rate Limiting Tests
+// =============================================
+
+TEST(LogRateLimitTest, FirstMessagePasses)
+{
+  LogRateLimit limit(std::chrono::seconds(60));
+  uint64_t suppressed = 42;
+
+  EXPECT_TRUE(limit.allow(suppressed));
+  EXPECT_EQ(suppressed, 0u);
+}
+
+TEST(LogRateLimitTest, RepeatsAreCountedUntilIntervalPasses)
+{
+  LogRateLimit limit(std::chrono::milliseconds(50));
+  uint64_t suppressed = 0;
+
+  ASSERT_TRUE(limit.allow(suppressed));
+  for (int i = 0; i < 10; ++i)
+  {
+    EXPECT_FALSE(limit.allow(suppressed));
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  EXPECT_TRUE(limit.allow(suppressed));
+  EXPECT_EQ(suppressed, 10u);
+}
+
+TEST(LogRateLimitTest, RateLimitedLoggingWithoutLogger)
+{
+  // Logging before Logger::init() is dropped, rate-limited or not
+  LogRateLimit limit;
+  zlc::warnRateLimited(limit, "dropped {}", 1);
+  zlc::errorRateLimited(limit, "dropped {}", 2);
+  SUCCEED();
+}
+
+// =============================================
+// Logger Tests
+// =============================================
+
+TEST(LoggerTest, SyncAndAsyncInit)
+{
+  LoggerOptions options;
+  options.async = false;
+  options.level = LogLevel::WARN;
+  Logger::init(options);
+  ASSERT_TRUE(Logger::isInitialized());
+  zlc::trace("trace is below the runtime level");
+  zlc::warn("sync warning {}", 1);
+  Logger::shutdown();
+  EXPECT_FALSE(Logger::isInitialized());
+
+  options.async = true;
+  options.queue_size = 16;
+  options.overflow = LogOverflowPolicy::DROP_OLDEST;
+  Logger::init(options);
+  for (int i = 0; i < 1000; ++i)
+  {
+    zlc::warn("async warning {}", i); // overruns the queue without blocking
+  }
+  Logger::shutdown();
+}
+
+TEST(LoggerTest, CompileTimeCutoff)
+{
+  EXPECT_EQ(logLevelActive(LogLevel::TRACE), ZLC_LOG_ACTIVE_LEVEL == 0);
+  EXPECT_TRUE(logLevelActive(LogLevel::FATAL));
+}
@@ -0,0 +1,438 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "zerolancom/utils/metrics.hpp"
+#include "zerolancom/utils/metrics_exporter.hpp"
+#include "zerolancom/utils/sequence_tracker.hpp"
+#include "zerolancom/zerolancom.hpp"
+
+#include "test_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_test;
+
+namespace
+{
+const TopicMetricsSnapshot *findTopic(const MetricsSnapshot &snap,
+                                      const std::string &name)
+{
+  for (const auto &t : snap.topics)
+  {
+    if (t.name == name)
+      return &t;
+  }
+  return nullptr;
+}
+
+const ServiceMetricsSnapshot *findService(const MetricsSnapshot &snap,
+                                          const std::string &name)
+{
+  for (const auto &s : snap.services)
+  {
+    if (s.name == name)
+      return &s;
+  }
+  return nullptr;
+}
+
+MetricsSnapshot sampleSnapshot()
+{
+  MetricsSnapshot snap;
+  snap.node = "cam\"1";
+  TopicMetricsSnapshot topic;
+  topic.name = "image";
+  topic.published = 10;
+  topic.published_bytes = 4096;
+  topic.dropped = 2;
+  topic.publishers.push_back(PublisherSequenceSnapshot{0xab, 9, 1, 0, 0});
+  topic.transit_latency.count = 10;
+  topic.transit_latency.p50_ns = 250000;
+  snap.topics.push_back(topic);
+  ServiceMetricsSnapshot service;
+  service.name = "detect";
+  service.requests = 5;
+  service.handler_latency.count = 5;
+  service.handler_latency.sum_ns = 5000000;
+  service.handler_latency.p99_ns = 2000000;
+  snap.services.push_back(service);
+  snap.discovery.nodes = 3;
+  return snap;
+}
+
+// Minimal HTTP GET against 127.0.0.1:port; returns the raw response
+std::string httpGet(uint16_t port, const std::string &path, const std::string &accept)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+  {
+    close(fd);
+    return {};
+  }
+
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n";
+  if (!accept.empty())
+    request += "Accept: " + accept + "\r\n";
+  request += "\r\n";
+  send(fd, request.data(), request.size(), 0);
+
+  std::string response;
+  char buf[4096];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+  {
+    response.append(buf, static_cast<size_t>(n));
+  }
+  close(fd);
+  return response;
+}
+} // namespace
+
+// =============================================
+// LatencyHistogram Tests
+// =============================================
+
+TEST(LatencyHistogramTest, BucketsCoverValuesContiguously)
+{
+  for (uint64_t value : {0ull, 1ull, 7ull, 8ull, 15ull, 16ull, 17ull, 1000ull,
+                         123456789ull, ~0ull})
+  {
+    size_t index = LatencyHistogram::bucketIndex(value);
+    ASSERT_LT(index, LatencyHistogram::BUCKET_COUNT);
+    EXPECT_LE(value, LatencyHistogram::bucketUpperBound(index)) << value;
+    if (index > 0)
+    {
+      EXPECT_GT(value, LatencyHistogram::bucketUpperBound(index - 1)) << value;
+    }
+  }
+}
+
+TEST(LatencyHistogramTest, QuantilesWithinBucketPrecision)
+{
+  LatencyHistogram hist;
+  for (uint64_t us = 1; us <= 1000; ++us)
+  {
+    hist.record(us * 1000);
+  }
+
+  EXPECT_EQ(hist.count(), 1000u);
+  EXPECT_EQ(hist.max(), 1000000u);
+
+  // 8 sub-buckets per power of two: at most 12.5% above the exact value
+  EXPECT_GE(hist.quantile(0.5), 500000u);
+  EXPECT_LE(hist.quantile(0.5), 562500u);
+  EXPECT_GE(hist.quantile(0.99), 990000u);
+  EXPECT_LE(hist.quantile(0.99), 1000000u);
+  EXPECT_EQ(hist.quantile(1.0), 1000000u);
+}
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero)
+{
+  LatencyHistogram hist;
+  LatencySummary summary = hist.summary();
+  EXPECT_EQ(summary.count, 0u);
+  EXPECT_EQ(summary.p99_ns, 0u);
+}
+
+// =============================================
+// SequenceTracker Tests
+// =============================================
+
+TEST(SequenceTrackerTest, ClassifiesGapsLateAndDuplicates)
+{
+  SequenceTracker tracker;
+
+  // The first message starts the sequence, even if it is not 1
+  auto first = tracker.observe(7, 10);
+  EXPECT_EQ(first.gap, 0u);
+
+  EXPECT_EQ(tracker.observe(7, 11).gap, 0u);
+  EXPECT_EQ(tracker.observe(7, 14).gap, 2u); // 12 and 13 missing
+
+  auto late = tracker.observe(7, 12);
+  EXPECT_TRUE(late.late);
+  EXPECT_FALSE(late.duplicate);
+
+  EXPECT_TRUE(tracker.observe(7, 12).duplicate);
+  EXPECT_TRUE(tracker.observe(7, 14).duplicate);
+}
+
+TEST(SequenceTrackerTest, PublishersAreIndependent)
+{
+  SequenceTracker tracker;
+  tracker.observe(1, 1);
+  tracker.observe(2, 100);
+
+  EXPECT_EQ(tracker.observe(1, 2).gap, 0u);
+  EXPECT_EQ(tracker.observe(2, 101).gap, 0u);
+  EXPECT_EQ(tracker.publisherCount(), 2u);
+}
+
+TEST(SequenceTrackerTest, LargeJumpClearsWindow)
+{
+  SequenceTracker tracker;
+  tracker.observe(1, 1);
+  EXPECT_EQ(tracker.observe(1, 1000).gap, 998u);
+
+  // Within the window after the jump: late, not duplicate
+  EXPECT_TRUE(tracker.observe(1, 990).late);
+  // Older than the window
+  EXPECT_TRUE(tracker.observe(1, 2).late);
+}
+
+TEST(SequenceTrackerTest, SnapshotReportsLostPerPublisher)
+{
+  std::string topic = unique_name("SequencedTopic");
+  TopicMetrics &metrics = MetricsRegistry::global().topic(topic);
+  metrics.recordSequence(5, 0, false, false);
+  metrics.recordSequence(5, 3, false, false);
+  metrics.recordSequence(5, 0, true, false);
+
+  auto snap = MetricsRegistry::global().snapshot();
+  const TopicMetricsSnapshot *entry = findTopic(snap, topic);
+  ASSERT_NE(entry, nullptr);
+  ASSERT_EQ(entry->publishers.size(), 1u);
+  EXPECT_EQ(entry->publishers[0].publisher_id, 5u);
+  EXPECT_EQ(entry->publishers[0].received, 3u);
+  EXPECT_EQ(entry->publishers[0].lost, 2u);
+  EXPECT_EQ(entry->publishers[0].reordered, 1u);
+  EXPECT_EQ(entry->other_publishers.received, 0u);
+}
+
+TEST(SequenceTrackerTest, EvictsLeastRecentlySeenPublisher)
+{
+  SequenceTracker tracker;
+  for (uint32_t id = 0; id < SequenceTracker::MAX_PUBLISHERS; ++id)
+  {
+    tracker.observe(id, 1);
+  }
+  tracker.observe(0, 2); // publisher 1 is now the least recently seen
+
+  tracker.observe(1000, 1);
+  EXPECT_EQ(tracker.publisherCount(), SequenceTracker::MAX_PUBLISHERS);
+  EXPECT_EQ(tracker.observe(0, 3).gap, 0u);
+  // Publisher 1 was forgotten, so its next message starts a new sequence
+  EXPECT_EQ(tracker.observe(1, 50).gap, 0u);
+}
+
+TEST(SequenceTrackerTest, IdlePublishersAreFoldedIntoOther)
+{
+  std::string topic = unique_name("SequencedTopic");
+  TopicMetrics &metrics = MetricsRegistry::global().topic(topic);
+  const auto start = std::chrono::steady_clock::now();
+  metrics.recordSequence(1, 2, false, false, start);
+
+  // A new publisher after the old one went quiet retires the old entry
+  metrics.recordSequence(
+      2, 0, false, false,
+      start + TopicMetrics::PUBLISHER_IDLE_EXPIRY + std::chrono::seconds(1));
+
+  auto snap = MetricsRegistry::global().snapshot();
+  const TopicMetricsSnapshot *entry = findTopic(snap, topic);
+  ASSERT_NE(entry, nullptr);
+  ASSERT_EQ(entry->publishers.size(), 1u);
+  EXPECT_EQ(entry->publishers[0].publisher_id, 2u);
+  EXPECT_EQ(entry->other_publishers.received, 1u);
+  EXPECT_EQ(entry->other_publishers.lost, 2u);
+}
+
+TEST(SequenceTrackerTest, PublishersOverCapCountAsOther)
+{
+  std::string topic = unique_name("SequencedTopic");
+  TopicMetrics &metrics = MetricsRegistry::global().topic(topic);
+  for (uint32_t id = 0; id <= TopicMetrics::MAX_PUBLISHERS; ++id)
+  {
+    metrics.recordSequence(id, 0, false, false);
+  }
+
+  auto snap = MetricsRegistry::global().snapshot();
+  const TopicMetricsSnapshot *entry = findTopic(snap, topic);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->publishers.size(), TopicMetrics::MAX_PUBLISHERS);
+  EXPECT_EQ(entry->other_publishers.received, 1u);
+
+  std::string text = formatMetrics(snap, MetricsFormat::PROMETHEUS_TEXT);
+  EXPECT_NE(text.find("publisher=\"other\""), std::string::npos);
+}
+
+// =============================================
+// MetricsRegistry Tests
+// =============================================
+
+TEST(MetricsRegistryTest, EntriesAreStableAndShared)
+{
+  std::string topic = unique_name("MetricsTopic");
+  TopicMetrics &first = MetricsRegistry::global().topic(topic);
+  first.published.add(3);
+
+  EXPECT_EQ(&MetricsRegistry::global().topic(topic), &first);
+
+  auto snap = MetricsRegistry::global().snapshot();
+  const TopicMetricsSnapshot *entry = findTopic(snap, topic);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->published, 3u);
+}
+
+// =============================================
+// Exporter Tests
+// =============================================
+
+TEST(MetricsExporterTest, PrometheusTextFormat)
+{
+  std::string text = formatMetrics(sampleSnapshot(), MetricsFormat::PROMETHEUS_TEXT);
+
+  EXPECT_NE(text.find("# TYPE zlc_topic_published_messages_total counter"),
+            std::string::npos);
+  EXPECT_NE(text.find("zlc_topic_published_messages_total{node=\"cam\\\"1\","
+                      "topic=\"image\"} 10"),
+            std::string::npos);
+  EXPECT_NE(text.find("zlc_service_handler_latency_seconds{node=\"cam\\\"1\","
+                      "service=\"detect\",quantile=\"0.99\"} 0.002"),
+            std::string::npos);
+  EXPECT_NE(text.find("zlc_service_handler_latency_seconds_count{node=\"cam\\\"1\","
+                      "service=\"detect\"} 5"),
+            std::string::npos);
+  EXPECT_NE(text.find("zlc_topic_lost_messages_total{node=\"cam\\\"1\","
+                      "topic=\"image\",publisher=\"000000ab\"} 1"),
+            std::string::npos);
+  EXPECT_NE(text.find("zlc_topic_transit_latency_seconds{node=\"cam\\\"1\","
+                      "topic=\"image\",quantile=\"0.5\"} 0.00025"),
+            std::string::npos);
+  EXPECT_NE(text.find("zlc_discovery_nodes{node=\"cam\\\"1\"} 3"), std::string::npos);
+  EXPECT_EQ(text.find("# EOF"), std::string::npos);
+}
+
+TEST(MetricsExporterTest, OpenMetricsFormat)
+{
+  std::string text = formatMetrics(sampleSnapshot(), MetricsFormat::OPENMETRICS);
+
+  // Counter families drop the _total suffix; samples keep it
+  EXPECT_NE(text.find("# TYPE zlc_topic_published_messages counter"),
+            std::string::npos);
+  EXPECT_NE(text.find("zlc_topic_published_messages_total{"), std::string::npos);
+  EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+}
+
+TEST(MetricsExporterTest, WritesFileAtomically)
+{
+  MetricsExporterOptions options;
+  options.file_path = "/tmp/" + unique_name("zlc_metrics") + ".prom";
+  MetricsExporter exporter("file_node", options);
+
+  ASSERT_TRUE(exporter.writeFile());
+
+  std::ifstream in(options.file_path);
+  std::stringstream content;
+  content << in.rdbuf();
+  EXPECT_NE(content.str().find("zlc_discovery_nodes{node=\"file_node\"}"),
+            std::string::npos);
+  EXPECT_NE(access((options.file_path + ".tmp").c_str(), F_OK), 0);
+  std::remove(options.file_path.c_str());
+}
+
+TEST(MetricsExporterTest, ServesHttpScrape)
+{
+  MetricsExporterOptions options;
+  options.serve_http = true;
+  options.http_port = 0;
+  MetricsExporter exporter("http_node", options);
+  ASSERT_NE(exporter.httpPort(), 0);
+  exporter.start();
+
+  std::string text = httpGet(exporter.httpPort(), "/metrics", "");
+  EXPECT_EQ(text.rfind("HTTP/1.1 200 OK", 0), 0u);
+  EXPECT_NE(text.find("text/plain; version=0.0.4"), std::string::npos);
+  EXPECT_NE(text.find("zlc_discovery_nodes{node=\"http_node\"}"), std::string::npos);
+
+  std::string om =
+      httpGet(exporter.httpPort(), "/metrics", "application/openmetrics-text");
+  EXPECT_NE(om.find("# EOF"), std::string::npos);
+
+  std::string missing = httpGet(exporter.httpPort(), "/other", "");
+  EXPECT_EQ(missing.rfind("HTTP/1.1 404", 0), 0u);
+}
+
+// =============================================
+// Node Integration Tests
+// =============================================
+
+class MetricsTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    node_name_ = unique_name("MetricsTestNode");
+    zlc::init(node_name_, "127.0.0.1");
+  }
+
+  void TearDown() override
+  {
+    zlc::shutdown();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  std::string node_name_;
+};
+
+TEST_F(MetricsTest, ServiceCallsAreCounted)
+{
+  std::string service = unique_name("CountedService");
+  zlc::registerServiceHandler(
+      service, +[](const std::string &req) { return req; });
+
+  std::string response;
+  for (int i = 0; i < 3; ++i)
+  {
+    zlc::request(service, std::string("x"), response);
+  }
+
+  MetricsSnapshot snap = zlc::getMetrics();
+  EXPECT_EQ(snap.node, node_name_);
+
+  const ServiceMetricsSnapshot *entry = findService(snap, service);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->requests, 3u);
+  EXPECT_EQ(entry->calls, 3u);
+  EXPECT_EQ(entry->failures, 0u);
+  EXPECT_EQ(entry->handler_latency.count, 3u);
+  EXPECT_GE(entry->call_latency.p50_ns, entry->handler_latency.p50_ns / 2);
+}
+
+TEST_F(MetricsTest, LocalPublishIsCounted)
+{
+  std::string topic = unique_name("CountedTopic");
+  zlc::registerSubscriberHandler(topic, +[](const std::string &) {});
+
+  zlc::Publisher<std::string> pub(topic);
+  pub.publish("a");
+  pub.publish("b");
+
+  const TopicMetricsSnapshot *entry = nullptr;
+  MetricsSnapshot snap = zlc::getMetrics();
+  entry = findTopic(snap, topic);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->published, 2u);
+  EXPECT_EQ(entry->delivered_local, 2u);
+}
+
+TEST_F(MetricsTest, GetMetricsServiceAnswers)
+{
+  MetricsSnapshot remote;
+  ResponseStatus status = zlc::requestMetrics(node_name_, remote);
+
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(remote.node, node_name_);
+}
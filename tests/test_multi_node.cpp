@@ -0,0 +1,668 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "test_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_test;
+
+// =============================================
+// Global State for Async Callbacks
+// =============================================
+
+namespace
+{
+AsyncResult<std::string> g_topic_result;
+
+void topicCallback(const std::string &msg)
+{
+  g_topic_result.set(msg);
+}
+} // namespace
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class MultiNodeTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!Logger::isInitialized())
+    {
+      Logger::init();
+    }
+    // A group of our own, so concurrent test binaries do not see these nodes
+    group_ = unique_name("multi_node_" + std::to_string(getpid()));
+    node_a_ = std::make_unique<Node>(unique_name("NodeA"), "127.0.0.1", "224.0.0.1",
+                                     7720, group_);
+    node_b_ = std::make_unique<Node>(unique_name("NodeB"), "127.0.0.1", "224.0.0.1",
+                                     7720, group_);
+    g_topic_result.reset();
+  }
+
+  void TearDown() override
+  {
+    node_b_.reset();
+    node_a_.reset();
+  }
+
+  std::string group_;
+  std::unique_ptr<Node> node_a_;
+  std::unique_ptr<Node> node_b_;
+};
+
+// =============================================
+// Multi-Node Tests
+// =============================================
+
+TEST_F(MultiNodeTest, NodesAreIndependent)
+{
+  EXPECT_NE(node_a_->name(), node_b_->name());
+  EXPECT_NE(&node_a_->context(), &node_b_->context());
+  EXPECT_NE(node_a_->serviceManager().service_port,
+            node_b_->serviceManager().service_port);
+}
+
+TEST_F(MultiNodeTest, ServiceAcrossNodes)
+{
+  const std::string service = unique_name("EchoService");
+  node_a_->registerServiceHandler(service, echoServiceHandler);
+
+  node_b_->waitForService(service, 3000);
+  std::string response;
+  ResponseStatus status = node_b_->request(service, std::string("hello"), response);
+
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "hello");
+}
+
+TEST_F(MultiNodeTest, TopicAcrossNodes)
+{
+  const std::string topic = unique_name("StringTopic");
+  node_b_->registerSubscriberHandler(topic, topicCallback);
+
+  Publisher<std::string> pub(*node_a_, topic);
+
+  // Publish until node B has discovered the topic and connected
+  for (int i = 0; i < 50 && !g_topic_result.received(); ++i)
+  {
+    pub.publish("from A");
+    g_topic_result.wait_for(std::chrono::milliseconds(100));
+  }
+
+  ASSERT_TRUE(g_topic_result.received());
+  EXPECT_EQ(g_topic_result.get(), "from A");
+}
+
+TEST_F(MultiNodeTest, RawSubscriberTakesFrame)
+{
+  const std::string topic = unique_name("RawTopic");
+  AsyncResult<std::string> result;
+  node_b_->registerRawSubscriber(topic,
+                                 [&result](zmq::message_t &payload)
+                                 {
+                                   zmq::message_t kept = std::move(payload);
+                                   result.set(kept.to_string());
+                                 });
+
+  Publisher<std::string> pub(*node_a_, topic);
+  for (int i = 0; i < 50 && !result.received(); ++i)
+  {
+    pub.publish("from A");
+    result.wait_for(std::chrono::milliseconds(100));
+  }
+
+  ASSERT_TRUE(result.received());
+  // Encoded, not decoded: the string is in there with its length prefix
+  EXPECT_NE(result.get().find("from A"), std::string::npos);
+}
+
+TEST_F(MultiNodeTest, SharedMemoryTopicTracksSequence)
+{
+  const std::string topic = unique_name("ShmSequencedTopic");
+  node_b_->registerSubscriberHandler(topic, topicCallback);
+
+  // Same host, so node B reads the ring instead of the TCP socket
+  PublisherOptions options;
+  options.shm.enabled = true;
+  options.sequence = true;
+  Publisher<std::string> pub(*node_a_, topic, false, options);
+
+  for (int i = 0; i < 50 && !g_topic_result.received(); ++i)
+  {
+    pub.publish("sequenced");
+    g_topic_result.wait_for(std::chrono::milliseconds(100));
+  }
+
+  ASSERT_TRUE(g_topic_result.received());
+  const PublisherSequenceSnapshot *sequence = nullptr;
+  MetricsSnapshot snap = MetricsRegistry::global().snapshot();
+  for (const auto &t : snap.topics)
+  {
+    for (const auto &p : t.publishers)
+    {
+      if (t.name == topic && p.publisher_id == pub.publisherID())
+        sequence = &p;
+    }
+  }
+  ASSERT_NE(sequence, nullptr);
+  EXPECT_GT(sequence->received, 0u);
+  EXPECT_EQ(sequence->duplicated, 0u);
+}
+
+namespace
+{
+// State of slowShmCallback(); the callback can only be a plain function
+AsyncResult<bool> g_shm_first_message;
+std::atomic<bool> g_shm_publisher_gone{false};
+Node *g_shm_caller = nullptr;
+std::string g_shm_service;
+AsyncResult<ResponseStatus> g_shm_status;
+
+// Still running when the publisher's node times out, then queries discovery
+void slowShmCallback(const std::string &)
+{
+  if (g_shm_first_message.received())
+    return;
+  g_shm_first_message.set(true);
+  while (!g_shm_publisher_gone)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(NodeInfoManager::HEARTBEAT_TIMEOUT_MS + 1000));
+  std::string response;
+  g_shm_status.set(g_shm_caller->request(g_shm_service, std::string("x"), response));
+}
+} // namespace
+
+TEST_F(MultiNodeTest, ShmCallbackQueriesDiscoveryWhilePublisherTimesOut)
+{
+  const std::string topic = unique_name("ShmTimeoutTopic");
+  g_shm_service = unique_name("LocalEcho");
+  g_shm_caller = node_b_.get();
+  node_b_->registerServiceHandler(g_shm_service, echoServiceHandler);
+  node_b_->registerSubscriberHandler(topic, slowShmCallback);
+
+  {
+    PublisherOptions options;
+    options.shm.enabled = true;
+    Publisher<std::string> pub(*node_a_, topic, false, options);
+    for (int i = 0; i < 50 && !g_shm_first_message.received(); ++i)
+    {
+      pub.publish("last words");
+      g_shm_first_message.wait_for(std::chrono::milliseconds(100));
+    }
+    ASSERT_TRUE(g_shm_first_message.received());
+  }
+  node_a_.reset(); // stops heartbeating without a goodbye
+  g_shm_publisher_gone = true;
+
+  // Evicting node A joins the reader thread while the callback calls request()
+  ASSERT_TRUE(g_shm_status.wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(g_shm_status.get(), ResponseStatus::SUCCESS);
+}
+
+TEST_F(MultiNodeTest, CompressedTopicArrivesDecompressed)
+{
+  const CompressionCodec codec = isCodecAvailable(CompressionCodec::LZ4)
+                                     ? CompressionCodec::LZ4
+                                     : CompressionCodec::ZSTD;
+  if (!isCodecAvailable(codec))
+    GTEST_SKIP() << "Built without compression codecs";
+
+  const std::string topic = unique_name("CompressedTopic");
+  node_b_->registerSubscriberHandler(topic, topicCallback);
+
+  PublisherOptions options;
+  options.compression.codec = codec;
+  options.compression.threshold = 128;
+  Publisher<std::string> pub(*node_a_, topic, false, options);
+
+  const std::string message(64 * 1024, 'z');
+  for (int i = 0; i < 50 && !g_topic_result.received(); ++i)
+  {
+    pub.publish(message);
+    g_topic_result.wait_for(std::chrono::milliseconds(100));
+  }
+
+  ASSERT_TRUE(g_topic_result.received());
+  EXPECT_EQ(g_topic_result.get(), message);
+  EXPECT_GT(pub.compressionStats().messages, 0u);
+  EXPECT_GT(node_b_->subscriberManager().decompressionStats(topic).messages, 0u);
+}
+
+TEST_F(MultiNodeTest, CompressedResponseArrivesDecompressed)
+{
+  const CompressionCodec codec = isCodecAvailable(CompressionCodec::ZSTD)
+                                     ? CompressionCodec::ZSTD
+                                     : CompressionCodec::LZ4;
+  if (!isCodecAvailable(codec))
+    GTEST_SKIP() << "Built without compression codecs";
+
+  const std::string service = unique_name("CompressedEcho");
+  node_a_->registerServiceHandler(service, echoServiceHandler);
+  CompressionConfig config;
+  config.codec = codec;
+  config.threshold = 128;
+  node_a_->setServiceCompression(service, config);
+
+  const uint64_t before = Client::decompressionStats().messages;
+  ASSERT_TRUE(node_b_->waitForService(service, 3000));
+  const std::string message(64 * 1024, 'r');
+  std::string response;
+  ASSERT_EQ(node_b_->request(service, message, response), ResponseStatus::SUCCESS);
+
+  EXPECT_EQ(response, message);
+  EXPECT_GT(Client::decompressionStats().messages, before);
+}
+
+TEST_F(MultiNodeTest, StoppedNodeRejectsUse)
+{
+  node_a_->stop();
+
+  EXPECT_FALSE(node_a_->isRunning());
+  EXPECT_TRUE(node_b_->isRunning());
+  EXPECT_THROW(node_a_->nodeInfoManager(), std::logic_error);
+  node_a_->stop(); // idempotent
+}
+
+TEST_F(MultiNodeTest, MetricsCountEachNodesPeers)
+{
+  auto known = [](const Node &node) { return node.getMetrics().discovery.nodes; };
+  for (int i = 0; i < 50 && (known(*node_a_) < 1 || known(*node_b_) < 1); ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  EXPECT_EQ(known(*node_a_), 1);
+  EXPECT_EQ(known(*node_b_), 1);
+
+  // The process-wide gauge is the sum over nodes, not the last node's count
+  const int64_t total = MetricsRegistry::global().discovery().nodes.value();
+  EXPECT_GE(total, 2);
+  node_b_.reset();
+  EXPECT_LT(MetricsRegistry::global().discovery().nodes.value(), total);
+}
+
+// =============================================
+// Discovery Waits
+// =============================================
+
+TEST_F(MultiNodeTest, WaitsWakeOnDiscovery)
+{
+  const std::string service = unique_name("LateEcho");
+  const std::string topic = unique_name("LateTopic");
+  std::unique_ptr<Publisher<std::string>> pub;
+  std::thread late(
+      [&]()
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        node_a_->registerServiceHandler(service, echoServiceHandler);
+        pub = std::make_unique<Publisher<std::string>>(*node_a_, topic);
+      });
+
+  EXPECT_TRUE(node_b_->waitForService(service, 5000));
+  late.join();
+  EXPECT_TRUE(node_b_->waitForTopic(topic, 5000));
+  EXPECT_TRUE(node_b_->waitForAll({service}, std::chrono::steady_clock::now()));
+}
+
+TEST_F(MultiNodeTest, ResolvesWhileRegisteringLocalServices)
+{
+  // Local services are appended while requests scan them
+  const std::string prefix = unique_name("Grow");
+  std::atomic<bool> done{false};
+  std::thread registrar(
+      [&]()
+      {
+        for (int i = 0; i < 200; ++i)
+        {
+          node_a_->registerServiceHandler(prefix + std::to_string(i), echoServiceHandler);
+        }
+        done = true;
+      });
+
+  NodeInfoManager &nodes = node_a_->nodeInfoManager();
+  while (!done)
+  {
+    nodes.getServiceProviders(prefix + "0");
+    nodes.getServiceInfo(prefix + "199");
+    nodes.getPublisherInfo(prefix);
+  }
+  registrar.join();
+  EXPECT_EQ(nodes.getServiceProviders(prefix + "199").size(), 1u);
+}
+
+TEST_F(MultiNodeTest, WaitsTimeOut)
+{
+  const std::string service = unique_name("PresentEcho");
+  node_a_->registerServiceHandler(service, echoServiceHandler);
+  ASSERT_TRUE(node_b_->waitForService(service, 5000));
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(node_b_->waitForAll({service, unique_name("Missing")},
+                                   start + std::chrono::milliseconds(200)));
+  const auto waited = std::chrono::steady_clock::now() - start;
+  EXPECT_GE(waited, std::chrono::milliseconds(200));
+  EXPECT_LT(waited, std::chrono::milliseconds(1000));
+
+  EXPECT_FALSE(node_b_->waitForTopic(unique_name("MissingTopic"), 50));
+
+  // request() gives up when the service never shows up
+  std::string response;
+  EXPECT_EQ(node_b_->request(unique_name("Missing"), std::string("x"), response),
+            ResponseStatus::NOSERVICE);
+}
+
+// =============================================
+// Load Balancing
+// =============================================
+
+TEST_F(MultiNodeTest, RequestsSpreadOverProviders)
+{
+  Node node_c(unique_name("NodeC"), "127.0.0.1", "224.0.0.1", 7720, group_);
+  const std::string service = unique_name("WhoAmI");
+  node_a_->registerServiceHandler(service,
+                                  [](const std::string &) { return std::string("A"); });
+  node_c.registerServiceHandler(service,
+                                [](const std::string &) { return std::string("C"); });
+
+  const NodeInfoManager &nodes = node_b_->nodeInfoManager();
+  ASSERT_TRUE(nodes.waitUntil(
+      [&] { return nodes.getServiceProviders(service).size() == 2; },
+      std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+
+  std::map<std::string, int> calls;
+  for (int i = 0; i < 10; ++i)
+  {
+    std::string response;
+    ASSERT_EQ(node_b_->request(service, std::string("who"), response),
+              ResponseStatus::SUCCESS);
+    ++calls[response];
+  }
+  EXPECT_EQ(calls["A"], 5);
+  EXPECT_EQ(calls["C"], 5);
+}
+
+// =============================================
+// Node Options
+// =============================================
+
+TEST(SocketOptionsTest, OverridesWinOverDefaults)
+{
+  SocketOptions defaults;
+  defaults.sndhwm = 1000;
+  defaults.linger_ms = 0;
+
+  SocketOptions overrides;
+  overrides.sndhwm = 10;
+  overrides.tcp_keepalive = true;
+
+  const SocketOptions merged = defaults.merged(overrides);
+  EXPECT_EQ(merged.sndhwm, 10);
+  EXPECT_EQ(merged.linger_ms, 0);
+  EXPECT_EQ(merged.tcp_keepalive, true);
+  EXPECT_FALSE(merged.rcvhwm.has_value());
+}
+
+TEST_F(MultiNodeTest, TunedNodeServesRequests)
+{
+  NodeOptions options;
+  options.group_name = unique_name("multi_node_tuned_" + std::to_string(getpid()));
+  options.zmq.io_threads = 2;
+  options.zmq.socket.sndhwm = 100;
+  options.zmq.socket.rcvbuf = 1 << 20;
+  options.zmq.socket.tcp_keepalive = true;
+  options.zmq.socket.tcp_keepalive_idle_s = 30;
+  Node node(unique_name("TunedNode"), "127.0.0.1", options);
+
+  SocketOptions topic_options;
+  topic_options.rcvhwm = 5;
+  node.setSubscriberSocketOptions(unique_name("TunedTopic"), topic_options);
+
+  const std::string service = unique_name("TunedEcho");
+  node.registerServiceHandler(service, echoServiceHandler);
+  node.waitForService(service);
+
+  std::string response;
+  EXPECT_EQ(node.request(service, std::string("tuned"), response),
+            ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "tuned");
+}
+
+// =============================================
+// Thread Options
+// =============================================
+
+namespace
+{
+std::vector<std::string> threadNames()
+{
+  std::vector<std::string> names;
+  for (const auto &task : std::filesystem::directory_iterator("/proc/self/task"))
+  {
+    std::ifstream comm(task.path() / "comm");
+    std::string name;
+    std::getline(comm, name);
+    names.push_back(name);
+  }
+  return names;
+}
+} // namespace
+
+TEST(ThreadOptionsTest, ConfigureNamesAndPinsThread)
+{
+  ThreadOptions options;
+  options.cpus = {0};
+
+  std::string name;
+  bool pinned = false;
+  std::thread worker(
+      [&]()
+      {
+        configureCurrentThread("zlc-test-thread-long-name", options);
+
+        char buf[16] = {};
+        pthread_getname_np(pthread_self(), buf, sizeof(buf));
+        name = buf;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+        pinned = CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set);
+      });
+  worker.join();
+
+  EXPECT_EQ(name, "zlc-test-thread"); // truncated to 15 characters
+  EXPECT_TRUE(pinned);
+}
+
+TEST_F(MultiNodeTest, InternalThreadsAreNamed)
+{
+  const std::vector<std::string> expected_names = {"zlc-mc-send", "zlc-mc-recv",
+                                                    "zlc-service", "zlc-sub"};
+  auto allNamed = [&](const std::vector<std::string> &names)
+  {
+    for (const std::string &name : expected_names)
+    {
+      if (std::find(names.begin(), names.end(), name) == names.end())
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Each thread names itself once it runs, which may be after the node is built
+  auto names = threadNames();
+  for (int i = 0; i < 50 && !allNamed(names); ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    names = threadNames();
+  }
+  for (const std::string &expected : expected_names)
+  {
+    EXPECT_NE(std::find(names.begin(), names.end(), expected), names.end())
+        << expected;
+  }
+}
+
+// =============================================
+// Discovery Cache
+// =============================================
+
+namespace
+{
+// Layout of the discovery cache file (node_info_manager.cpp)
+struct CacheFile
+{
+  uint32_t version{1};
+  std::string group_name;
+  std::vector<NodeInfo> nodes;
+
+  MSGPACK_DEFINE_MAP(version, group_name, nodes)
+};
+} // namespace
+
+class DiscoveryCacheTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!Logger::isInitialized())
+    {
+      Logger::init();
+    }
+    options_.group_name = unique_name("cache_" + std::to_string(getpid()));
+    options_.discovery_cache =
+        (std::filesystem::temp_directory_path() / (options_.group_name + ".cache"))
+            .string();
+    service_ = unique_name("CachedEcho");
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove(options_.discovery_cache);
+  }
+
+  // Let a node with the cache discover `provider`, which writes the cache
+  void warmCache(Node &provider)
+  {
+    provider.registerServiceHandler(service_, echoServiceHandler);
+    Node first(unique_name("First"), "127.0.0.1", options_);
+    first.waitForService(service_, 3000);
+    ASSERT_TRUE(std::filesystem::exists(options_.discovery_cache));
+  }
+
+  NodeOptions options_;
+  std::string service_;
+};
+
+TEST_F(DiscoveryCacheTest, WarmStartResolvesAtOnce)
+{
+  NodeOptions plain = options_;
+  plain.discovery_cache.clear();
+  Node provider(unique_name("Provider"), "127.0.0.1", plain);
+  warmCache(provider);
+
+  Node second(unique_name("Second"), "127.0.0.1", options_);
+  EXPECT_TRUE(second.nodeInfoManager().isTentativeService(service_));
+
+  std::string response;
+  EXPECT_EQ(second.request(service_, std::string("warm"), response),
+            ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "warm");
+}
+
+TEST_F(DiscoveryCacheTest, StaleEntryIsEvicted)
+{
+  {
+    NodeOptions plain = options_;
+    plain.discovery_cache.clear();
+    Node provider(unique_name("Provider"), "127.0.0.1", plain);
+    warmCache(provider);
+  }
+
+  Node second(unique_name("Second"), "127.0.0.1", options_);
+  ASSERT_TRUE(second.nodeInfoManager().isTentativeService(service_));
+
+  std::string response;
+  EXPECT_EQ(second.request(service_, std::string("cold"), response),
+            ResponseStatus::NOSERVICE);
+  EXPECT_EQ(second.nodeInfoManager().getServiceInfo(service_), nullptr);
+}
+
+TEST_F(DiscoveryCacheTest, StaleEntryIsEvictedBeforeStreaming)
+{
+  {
+    NodeOptions plain = options_;
+    plain.discovery_cache.clear();
+    Node provider(unique_name("Provider"), "127.0.0.1", plain);
+    warmCache(provider);
+  }
+
+  Node second(unique_name("Second"), "127.0.0.1", options_);
+  ASSERT_TRUE(second.nodeInfoManager().isTentativeService(service_));
+
+  size_t chunk_count = 0;
+  EXPECT_EQ(second.requestStream(
+                service_, std::string("cold"), [&](const StreamChunk &)
+                { ++chunk_count; }, 64 * 1024, 300),
+            ResponseStatus::NOSERVICE);
+  EXPECT_EQ(chunk_count, 0u);
+  EXPECT_EQ(second.nodeInfoManager().getServiceInfo(service_), nullptr);
+}
+
+TEST_F(DiscoveryCacheTest, ReusedPortIsNotConfirmed)
+{
+  NodeOptions plain = options_;
+  plain.discovery_cache.clear();
+  Node provider(unique_name("Provider"), "127.0.0.1", plain);
+  warmCache(provider);
+
+  // Rewrite the cache as if an earlier node of another group had served on the
+  // provider's port; the provider's heartbeats do not reach that group
+  std::ifstream in(options_.discovery_cache, std::ios::binary);
+  const Bytes bytes((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  CacheFile cache;
+  decode(ByteView{bytes.data(), bytes.size()}, cache);
+  ASSERT_EQ(cache.nodes.size(), 1u);
+  const std::string stale = unique_name("StaleNode");
+  cache.nodes[0].nodeID = stale;
+  options_.group_name += "_restarted";
+  cache.group_name = options_.group_name;
+  ByteBuffer out;
+  encode(cache, out);
+  std::ofstream(options_.discovery_cache, std::ios::binary | std::ios::trunc)
+      .write(reinterpret_cast<const char *>(out.data),
+             static_cast<std::streamsize>(out.size));
+
+  Node second(unique_name("Second"), "127.0.0.1", options_);
+  ASSERT_TRUE(second.nodeInfoManager().isTentative(stale));
+
+  // The provider answers, but with its own node ID
+  std::string response;
+  EXPECT_EQ(second.request(service_, std::string("moved"), response),
+            ResponseStatus::NOSERVICE);
+  EXPECT_FALSE(second.nodeInfoManager().checkNodeID(stale));
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "zerolancom/nodes/node_info.hpp"
+#include "zerolancom/utils/logger.hpp"
+#include "zerolancom/utils/network.hpp"
+
+using namespace zlc;
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class NetworkTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!Logger::isInitialized())
+    {
+      Logger::init();
+    }
+  }
+};
+
+// =============================================
+// Interface Resolution Tests
+// =============================================
+
+TEST_F(NetworkTest, ListsLoopback)
+{
+  bool found = false;
+  for (const NetworkInterface &interface : listNetworkInterfaces())
+  {
+    found = found || interface.ip == "127.0.0.1";
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST_F(NetworkTest, ResolvesByAddressAndName)
+{
+  auto by_ip = resolveNetworkInterface("127.0.0.1");
+  ASSERT_TRUE(by_ip.has_value());
+  EXPECT_FALSE(by_ip->name.empty());
+  EXPECT_EQ(by_ip->prefixLength(), 8); // loopback is 127.0.0.0/8
+
+  auto by_name = resolveNetworkInterface(by_ip->name);
+  ASSERT_TRUE(by_name.has_value());
+  EXPECT_EQ(by_name->ip, "127.0.0.1");
+}
+
+TEST_F(NetworkTest, PrefixOverridesMask)
+{
+  auto interface = resolveNetworkInterface("127.0.0.1/16");
+  ASSERT_TRUE(interface.has_value());
+  EXPECT_EQ(interface->netmask, 0xFFFF0000u);
+  EXPECT_TRUE(interface->contains("127.0.200.1"));
+  EXPECT_FALSE(interface->contains("127.1.0.1"));
+
+  // Addresses that are on no interface keep the historical /24
+  auto remote = resolveNetworkInterface("192.0.2.10");
+  ASSERT_TRUE(remote.has_value());
+  EXPECT_TRUE(remote->name.empty());
+  EXPECT_EQ(remote->prefixLength(), 24);
+}
+
+TEST_F(NetworkTest, RejectsBadSpecs)
+{
+  EXPECT_FALSE(resolveNetworkInterface("no_such_if0").has_value());
+  EXPECT_FALSE(resolveNetworkInterface("127.0.0.1/40").has_value());
+  EXPECT_FALSE(resolveNetworkInterface("127.0.0.1/").has_value());
+}
+
+TEST_F(NetworkTest, ServicesFollowDiscoveryInterface)
+{
+  NodeInfo info;
+  info.ip = "10.0.0.5";
+  info.interfaces = {"192.168.1.5"};
+  info.topics.push_back(SocketInfo{"camera", "10.0.0.5", 5000, {}, {}});
+  info.services.push_back(SocketInfo{"get_map", "10.0.0.5", 6000, {}, {}});
+
+  info.useInterface("172.16.0.9"); // not one of the node's addresses
+  EXPECT_EQ(info.services[0].ip, "10.0.0.5");
+
+  info.useInterface("192.168.1.5");
+  EXPECT_EQ(info.services[0].ip, "192.168.1.5");
+  EXPECT_EQ(info.topics[0].ip, "10.0.0.5");
+}
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <memory>
 #include <string>
 #include <thread>
 
@@ -24,6 +25,28 @@ void stringCallback(const std::string &msg)
 {
   g_string_result.set(msg);
 }
+
+AsyncResult<std::shared_ptr<const std::string>> g_shared_result;
+
+Publisher<std::string> *g_echo_publisher = nullptr;
+
+// Answers "ping" on the same topic, from inside the delivery of "ping"
+void echoCallback(const std::string &msg)
+{
+  if (msg == "ping")
+  {
+    g_echo_publisher->publish("pong");
+  }
+  else
+  {
+    g_string_result.set(msg);
+  }
+}
+
+void sharedStringCallback(const std::shared_ptr<const std::string> &msg)
+{
+  g_shared_result.set(msg);
+}
 } // namespace
 
 // =============================================
@@ -38,6 +61,7 @@ protected:
     node_name_ = unique_name("PubSubTestNode");
     zlc::init(node_name_, "127.0.0.1");
     g_string_result.reset();
+    g_shared_result.reset();
   }
 
   void TearDown() override
@@ -125,3 +149,84 @@ TEST_F(PubSubTest, LocalNamespaceTopic)
     GTEST_SKIP() << "Local pub/sub timed out";
   }
 }
+
+// =============================================
+// Shared-Memory Topic Test
+//
+// A second node on the same host reads the publisher's shared-memory ring
+// instead of connecting over TCP. (Subscribers on the publishing node itself
+// take the intra-process path instead.)
+// =============================================
+
+TEST_F(PubSubTest, SharedMemoryTopic)
+{
+  std::string topic = unique_name("ShmTopic");
+
+  Node subscriber(unique_name("ShmSubscriberNode"), "127.0.0.1");
+  subscriber.registerSubscriberHandler(topic, stringCallback);
+
+  PublisherOptions options;
+  options.shm.enabled = true;
+  options.shm.slot_size = 64 * 1024;
+  Publisher<std::string> pub(topic, false, options);
+
+  // Publish until the subscriber has discovered the topic and opened the ring
+  const std::string message(100 * 1024, 's'); // larger than a slot: ring grows
+  for (int i = 0; i < 50 && !g_string_result.received(); ++i)
+  {
+    pub.publish(message);
+    g_string_result.wait_for(std::chrono::milliseconds(100));
+  }
+
+  ASSERT_TRUE(g_string_result.received());
+  EXPECT_EQ(g_string_result.get(), message);
+}
+
+// =============================================
+// Intra-Process Tests
+//
+// Subscribers in the publishing process are called directly from publish(),
+// so no discovery or network round trip is involved.
+// =============================================
+
+TEST_F(PubSubTest, IntraProcessDeliveryIsSynchronous)
+{
+  std::string topic = unique_name("IntraTopic");
+
+  zlc::registerSubscriberHandler(topic, stringCallback);
+  Publisher<std::string> pub(topic);
+
+  pub.publish("in-process");
+
+  ASSERT_TRUE(g_string_result.received());
+  EXPECT_EQ(g_string_result.get(), "in-process");
+}
+
+TEST_F(PubSubTest, IntraProcessSharesMessageWithoutCopy)
+{
+  std::string topic = unique_name("IntraSharedTopic");
+
+  zlc::registerSubscriberHandler(topic, sharedStringCallback);
+  Publisher<std::string> pub(topic);
+
+  auto msg = std::make_shared<const std::string>("shared");
+  pub.publish(msg);
+
+  ASSERT_TRUE(g_shared_result.received());
+  EXPECT_EQ(g_shared_result.get().get(), msg.get());
+}
+
+TEST_F(PubSubTest, IntraProcessCallbackCanRepublish)
+{
+  std::string topic = unique_name("IntraEchoTopic");
+
+  zlc::registerSubscriberHandler(topic, echoCallback);
+  Publisher<std::string> pub(topic);
+  g_echo_publisher = &pub;
+
+  pub.publish("ping");
+  g_echo_publisher = nullptr;
+
+  ASSERT_TRUE(g_string_result.received());
+  EXPECT_EQ(g_string_result.get(), "pong");
+}
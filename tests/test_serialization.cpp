@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <cstdint>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -301,6 +302,35 @@ TEST(SerializationTest, BufferReuseWorks)
   EXPECT_NE(buffer.size, first_size); // Size should be different
 }
 
+TEST(SerializationTest, BufferMoveTransfersOwnership)
+{
+  ByteBuffer buffer;
+  encode(std::string("payload"), buffer);
+  const uint8_t *block = buffer.data;
+
+  ByteBuffer moved(std::move(buffer));
+
+  EXPECT_EQ(moved.data, block);
+  EXPECT_EQ(buffer.data, nullptr);
+  EXPECT_EQ(buffer.size, 0u);
+}
+
+TEST(SerializationTest, BufferReleaseDetachesBlock)
+{
+  ByteBuffer buffer;
+  encode(42, buffer);
+  size_t size = buffer.size;
+
+  uint8_t *block = buffer.release();
+  ASSERT_NE(block, nullptr);
+  EXPECT_EQ(buffer.data, nullptr);
+
+  int decoded = 0;
+  decode(ByteView{block, size}, decoded);
+  EXPECT_EQ(decoded, 42);
+  std::free(block);
+}
+
 // =============================================
 // Large Data Tests
 // =============================================
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 
 #include <atomic>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "zerolancom/nodes/zerolancom_node.hpp"
 #include "zerolancom/serialization/msppack_codec.hpp"
@@ -60,6 +63,11 @@ Empty emptyBothHandler(const Empty &)
 {
   return empty;
 }
+
+std::string throwingHandler(const std::string &)
+{
+  throw std::runtime_error("backend offline");
+}
 } // namespace
 
 TEST_F(ServiceTest, FreeFunctionHandler_StringToString)
@@ -113,6 +121,136 @@ TEST_F(ServiceTest, FreeFunctionHandler_EmptyToEmpty)
   SUCCEED();
 }
 
+// =============================================
+// Status Code Tests
+// =============================================
+
+TEST_F(ServiceTest, SuccessStatusReturned)
+{
+  std::string service = unique_name("StatusService");
+
+  zlc::registerServiceHandler(service, echoHandler);
+  zlc::waitForService(service, 1000);
+
+  std::string response;
+  ResponseStatus status =
+      Client::zlcRequest<const std::string &, std::string>(service, "ok", response);
+
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "echo:ok");
+}
+
+TEST_F(ServiceTest, HandlerExceptionReturnsServiceFail)
+{
+  std::string service = unique_name("ThrowingService");
+
+  zlc::registerServiceHandler(service, throwingHandler);
+  zlc::waitForService(service, 1000);
+
+  std::string response = "untouched";
+  ResponseStatus status =
+      Client::zlcRequest<const std::string &, std::string>(service, "x", response);
+
+  EXPECT_EQ(status, ResponseStatus::SERVICE_FAIL);
+  EXPECT_EQ(response, "untouched");
+}
+
+TEST_F(ServiceTest, UndecodableRequestReturnsInvalidRequest)
+{
+  std::string service = unique_name("UndecodableService");
+
+  zlc::registerServiceHandler(service, echoHandler);
+  zlc::waitForService(service, 1000);
+
+  // An integer payload cannot be decoded as the handler's std::string
+  std::string response = "untouched";
+  ResponseStatus status = Client::zlcRequest<int, std::string>(service, 42, response);
+
+  EXPECT_EQ(status, ResponseStatus::INVALID_REQUEST);
+  EXPECT_EQ(response, "untouched");
+}
+
+TEST_F(ServiceTest, MalformedRequestIsAnswered)
+{
+  std::string service = unique_name("MalformedService");
+
+  zlc::registerServiceHandler(service, echoHandler);
+  zlc::waitForService(service, 1000);
+
+  ZMQSocket socket =
+      ZeroLanComNode::instance().context().createTempSocket(zmq::socket_type::req);
+  socket.set(zmq::sockopt::rcvtimeo, 2000);
+  socket.set(zmq::sockopt::linger, 0);
+  socket.connect(
+      Client::serviceURL(ZeroLanComNode::instance().nodeInfoManager(), service));
+
+  // Service frame without a payload frame
+  socket.send(zmq::buffer(service), zmq::send_flags::none);
+
+  zmq::message_t payload;
+  EXPECT_EQ(Client::receiveResponse(socket, payload, service),
+            ResponseStatus::INVALID_REQUEST);
+  socket.close();
+}
+
+TEST(ResponseTest, DescriptionCoversAllCodes)
+{
+  EXPECT_STREQ(Response::description(ResponseStatus::SUCCESS), "SUCCESS");
+  EXPECT_STREQ(Response::description(ResponseStatus::NOSERVICE), "NOSERVICE");
+  EXPECT_STREQ(Response::description(ResponseStatus::SERVICE_FAIL), "SERVICE_FAIL");
+}
+
+// =============================================
+// Same-Host Transport Tests
+// =============================================
+
+TEST_F(ServiceTest, SameHostServiceUsesIpc)
+{
+  std::string service = unique_name("IpcService");
+
+  zlc::registerServiceHandler(service, echoHandler);
+  zlc::waitForService(service, 1000);
+
+  const SocketInfo *info =
+      ZeroLanComNode::instance().nodeInfoManager().getServiceInfo(service);
+  ASSERT_NE(info, nullptr);
+  if (info->ipc.empty())
+  {
+    GTEST_SKIP() << "ipc:// transport not available on this platform";
+  }
+  EXPECT_EQ(info->url(), info->ipc);
+
+  std::string response;
+  ResponseStatus status =
+      Client::zlcRequest<const std::string &, std::string>(service, "ipc", response);
+
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "echo:ipc");
+}
+
+TEST(SocketInfoTest, FallsBackToTcpWithoutSocketFile)
+{
+  SocketInfo info{"svc", "10.0.0.7", 5555, {}, "ipc:///nonexistent/zlc/socket"};
+  EXPECT_EQ(info.url(), "tcp://10.0.0.7:5555");
+
+  info.ipc.clear();
+  EXPECT_EQ(info.url(), "tcp://10.0.0.7:5555");
+}
+
+TEST(SocketInfoTest, RemoteHostEndpointsDropped)
+{
+  NodeInfo node;
+  node.topics.push_back(SocketInfo{"t", "10.0.0.7", 1, "/zlc.1.0", "ipc:///tmp/a"});
+  node.services.push_back(SocketInfo{"s", "10.0.0.7", 2, {}, "ipc:///tmp/b"});
+
+  node.dropHostLocalEndpoints();
+
+  EXPECT_TRUE(node.topics[0].shm.empty());
+  EXPECT_TRUE(node.topics[0].ipc.empty());
+  EXPECT_TRUE(node.services[0].ipc.empty());
+  EXPECT_EQ(node.services[0].port, 2);
+}
+
 // =============================================
 // Lambda Handler Tests (convert to function pointer with +)
 // =============================================
@@ -301,3 +439,121 @@ TEST_F(ServiceTest, HighLevelRequest_StringToString)
 
   EXPECT_EQ(response, "high:level");
 }
+
+// =============================================
+// Admission Control Tests
+// =============================================
+
+TEST_F(ServiceTest, OverloadIsRejectedAtOnce)
+{
+  std::string service = unique_name("SlowService");
+  zlc::registerServiceHandler(
+      service, +[](const std::string &req)
+               {
+                 std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                 return req;
+               });
+
+  ServiceLimits limits;
+  limits.max_concurrency = 1;
+  limits.max_queue = 1;
+  ASSERT_TRUE(zlc::setServiceLimits(service, limits));
+  EXPECT_FALSE(zlc::setServiceLimits(service, limits)); // set once
+
+  // One runs, one waits, two are turned away
+  std::atomic<int> succeeded{0};
+  std::atomic<int> overloaded{0};
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i)
+  {
+    callers.emplace_back(
+        [&]()
+        {
+          std::string response;
+          ResponseStatus status = zlc::request(service, std::string("x"), response);
+          (status == ResponseStatus::SUCCESS ? succeeded : overloaded)++;
+          EXPECT_TRUE(status == ResponseStatus::SUCCESS ||
+                      status == ResponseStatus::OVERLOADED);
+        });
+  }
+  for (std::thread &caller : callers)
+  {
+    caller.join();
+  }
+
+  EXPECT_EQ(succeeded, 2);
+  EXPECT_EQ(overloaded, 2);
+  EXPECT_EQ(ZeroLanComNode::instance().serviceManager().concurrencyLimit(service), 1);
+}
+
+TEST_F(ServiceTest, AdaptiveLimitStaysInBounds)
+{
+  std::string service = unique_name("AdaptiveService");
+  zlc::registerServiceHandler(service, echoHandler);
+
+  ServiceLimits limits;
+  limits.max_concurrency = 4;
+  limits.max_queue = 16;
+  limits.adaptive = true;
+  ASSERT_TRUE(zlc::setServiceLimits(service, limits));
+
+  for (int i = 0; i < 20; ++i)
+  {
+    std::string response;
+    ASSERT_EQ(zlc::request(service, std::string("a"), response),
+              ResponseStatus::SUCCESS);
+    EXPECT_EQ(response, "echo:a");
+  }
+  ServiceManager &services = ZeroLanComNode::instance().serviceManager();
+  const int limit = services.concurrencyLimit(service);
+  EXPECT_GE(limit, 1);
+  EXPECT_LE(limit, 4);
+
+  limits.max_concurrency = 0;
+  EXPECT_FALSE(zlc::setServiceLimits(unique_name("Invalid"), limits));
+}
+
+TEST_F(ServiceTest, RegistersWhileWorkersRun)
+{
+  std::string service = unique_name("BusyService");
+  zlc::registerServiceHandler(service, echoHandler);
+
+  ServiceLimits limits;
+  limits.max_concurrency = 4;
+  limits.max_queue = 16;
+  ASSERT_TRUE(zlc::setServiceLimits(service, limits));
+  ASSERT_TRUE(zlc::waitForService(service));
+
+  // Workers look handlers up while this thread keeps adding services
+  std::atomic<int> failed{0};
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i)
+  {
+    callers.emplace_back(
+        [&]()
+        {
+          for (int n = 0; n < 25; ++n)
+          {
+            std::string response;
+            if (zlc::request(service, std::string("w"), response) !=
+                    ResponseStatus::SUCCESS ||
+                response != "echo:w")
+            {
+              ++failed;
+            }
+          }
+        });
+  }
+  ServiceManager &services = ZeroLanComNode::instance().serviceManager();
+  for (int i = 0; i < 200; ++i)
+  {
+    services.registerRawHandler(unique_name("Extra"),
+                                [](const ByteView &, ByteBuffer &) {});
+  }
+  for (std::thread &caller : callers)
+  {
+    caller.join();
+  }
+
+  EXPECT_EQ(failed, 0);
+}
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "zerolancom/sockets/shm_transport.hpp"
+
+#include "test_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_test;
+
+namespace
+{
+SharedMemoryOptions smallRing()
+{
+  SharedMemoryOptions options;
+  options.enabled = true;
+  options.slots = 3;
+  options.slot_size = 1024;
+  return options;
+}
+
+ByteView view(const std::string &s)
+{
+  return ByteView{reinterpret_cast<const uint8_t *>(s.data()), s.size()};
+}
+
+std::string str(const ByteView &v)
+{
+  return std::string(reinterpret_cast<const char *>(v.data), v.size);
+}
+} // namespace
+
+// =============================================
+// Ring Buffer Tests
+// =============================================
+
+TEST(ShmTransportTest, WriteThenReadInPlace)
+{
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), smallRing());
+  ASSERT_NE(writer, nullptr);
+  auto reader = ShmRingReader::open(writer->name());
+  ASSERT_NE(reader, nullptr);
+
+  ASSERT_TRUE(writer->write(view("hdr"), view("payload")));
+
+  std::string header, payload;
+  EXPECT_TRUE(reader->readNext(
+      [&](const ByteView &h, const ByteView &p)
+      {
+        header = str(h);
+        payload = str(p);
+      },
+      100));
+  EXPECT_EQ(header, "hdr");
+  EXPECT_EQ(payload, "payload");
+
+  // Nothing new: times out
+  EXPECT_FALSE(reader->readNext([](const ByteView &, const ByteView &) {}, 10));
+}
+
+TEST(ShmTransportTest, ReaderSeesLatestOnly)
+{
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), smallRing());
+  ASSERT_NE(writer, nullptr);
+  auto reader = ShmRingReader::open(writer->name());
+  ASSERT_NE(reader, nullptr);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    ASSERT_TRUE(writer->write(ByteView{}, view("msg" + std::to_string(i))));
+  }
+
+  std::string payload;
+  EXPECT_TRUE(reader->readNext([&](const ByteView &, const ByteView &p)
+                               { payload = str(p); },
+                               100));
+  EXPECT_EQ(payload, "msg9");
+}
+
+TEST(ShmTransportTest, SlotInUseIsNotOverwritten)
+{
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), smallRing());
+  ASSERT_NE(writer, nullptr);
+  auto reader = ShmRingReader::open(writer->name());
+  ASSERT_NE(reader, nullptr);
+
+  ASSERT_TRUE(writer->write(ByteView{}, view("first")));
+
+  // Keep publishing while the reader holds the first message in place
+  std::string seen;
+  reader->readNext(
+      [&](const ByteView &, const ByteView &p)
+      {
+        for (int i = 0; i < 5; ++i)
+        {
+          writer->write(ByteView{}, view("later" + std::to_string(i)));
+        }
+        seen = str(p);
+      },
+      100);
+
+  EXPECT_EQ(seen, "first");
+}
+
+TEST(ShmTransportTest, GrowsForLargeMessages)
+{
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), smallRing());
+  ASSERT_NE(writer, nullptr);
+  auto reader = ShmRingReader::open(writer->name());
+  ASSERT_NE(reader, nullptr);
+
+  std::string large(64 * 1024, 'x');
+  ASSERT_TRUE(writer->write(ByteView{}, view(large)));
+
+  size_t size = 0;
+  EXPECT_TRUE(reader->readNext([&](const ByteView &, const ByteView &p)
+                               { size = p.size; },
+                               100));
+  EXPECT_EQ(size, large.size());
+
+  // Readers opening after the growth land on the current generation too
+  auto late = ShmRingReader::open(writer->name());
+  ASSERT_NE(late, nullptr);
+  EXPECT_TRUE(late->readNext([&](const ByteView &, const ByteView &p)
+                             { size = p.size; },
+                             100));
+  EXPECT_EQ(size, large.size());
+}
+
+TEST(ShmTransportTest, ReaderWakesOnWrite)
+{
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), smallRing());
+  ASSERT_NE(writer, nullptr);
+  auto reader = ShmRingReader::open(writer->name());
+  ASSERT_NE(reader, nullptr);
+
+  AsyncResult<std::string> result;
+  ShmSubscription subscription(std::move(reader),
+                               [&](const ByteView &, const ByteView &p)
+                               { result.set(str(p)); });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(writer->write(ByteView{}, view("wake")));
+
+  ASSERT_TRUE(result.wait_for(std::chrono::milliseconds(500)));
+  EXPECT_EQ(result.get(), "wake");
+}
+
+TEST(ShmTransportTest, ClosedWhenWriterDestroyed)
+{
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), smallRing());
+  ASSERT_NE(writer, nullptr);
+  const std::string name = writer->name();
+  auto reader = ShmRingReader::open(name);
+  ASSERT_NE(reader, nullptr);
+
+  writer.reset();
+
+  EXPECT_TRUE(reader->closed());
+  EXPECT_EQ(ShmRingReader::open(name), nullptr);
+}
+
+TEST(ShmTransportTest, WriterTracksAttachedReaders)
+{
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), smallRing());
+  ASSERT_NE(writer, nullptr);
+  EXPECT_FALSE(writer->hasReaders());
+
+  {
+    auto reader = ShmRingReader::open(writer->name());
+    ASSERT_NE(reader, nullptr);
+    EXPECT_TRUE(writer->hasReaders());
+  }
+
+  EXPECT_FALSE(writer->hasReaders());
+}
+
+TEST(ShmTransportTest, DeadReaderIsDropped)
+{
+  SharedMemoryOptions options = smallRing();
+  options.slots = 2;
+  auto writer = ShmRingWriter::create(makeShmSegmentName(), options);
+  ASSERT_NE(writer, nullptr);
+  ASSERT_TRUE(writer->write(ByteView{}, view("first")));
+
+  // A subscriber process dies while it reads the message in place
+  const pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0)
+  {
+    auto reader = ShmRingReader::open(writer->name());
+    if (reader)
+    {
+      reader->readNext([](const ByteView &, const ByteView &) { _exit(0); }, 1000);
+    }
+    _exit(1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+
+  EXPECT_FALSE(writer->hasReaders());
+
+  // Its slot is free again: with two slots, every write needs it
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_TRUE(writer->write(ByteView{}, view("later" + std::to_string(i))));
+  }
+  EXPECT_EQ(writer->dropped(), 0u);
+}
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "test_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_test;
+
+namespace
+{
+Bytes makeBlob(size_t size)
+{
+  Bytes blob(size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    blob[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return blob;
+}
+
+std::vector<StreamChunk> splitBlob(const Bytes &blob, uint64_t stream_id, size_t chunk)
+{
+  std::vector<StreamChunk> chunks;
+  size_t offset = 0;
+  do
+  {
+    size_t len = std::min(chunk, blob.size() - offset);
+    chunks.push_back(StreamChunk{stream_id, offset, blob.size(),
+                                 ByteView{blob.data() + offset, len}});
+    offset += len;
+  } while (offset < blob.size());
+  return chunks;
+}
+} // namespace
+
+// =============================================
+// StreamAssembler Tests
+// =============================================
+
+TEST(StreamAssemblerTest, ReassemblesInOrderChunks)
+{
+  Bytes blob = makeBlob(10000);
+  Bytes result;
+  StreamAssembler assembler([&](uint64_t, Bytes &&data) { result = std::move(data); });
+
+  for (const auto &chunk : splitBlob(blob, 1, 4096))
+  {
+    assembler(chunk);
+  }
+
+  EXPECT_EQ(result, blob);
+  EXPECT_EQ(assembler.pendingStreams(), 0u);
+}
+
+TEST(StreamAssemblerTest, DropsStreamWithMissingChunk)
+{
+  Bytes blob = makeBlob(10000);
+  int completed = 0;
+  StreamAssembler assembler([&](uint64_t, Bytes &&) { ++completed; });
+
+  auto chunks = splitBlob(blob, 2, 4096);
+  assembler(chunks[0]);
+  assembler(chunks[2]); // chunk 1 lost
+
+  EXPECT_EQ(completed, 0);
+  EXPECT_EQ(assembler.pendingStreams(), 0u);
+}
+
+TEST(StreamAssemblerTest, EmptyBlobCompletesImmediately)
+{
+  int completed = 0;
+  StreamAssembler assembler([&](uint64_t, Bytes &&data)
+                            { completed += data.empty() ? 1 : 0; });
+
+  assembler(StreamChunk{3, 0, 0, ByteView{}});
+
+  EXPECT_EQ(completed, 1);
+}
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class StreamTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    node_name_ = unique_name("StreamTestNode");
+    zlc::init(node_name_, "127.0.0.1");
+  }
+
+  void TearDown() override
+  {
+    zlc::shutdown();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  std::string node_name_;
+};
+
+// =============================================
+// Chunked Service Tests
+// =============================================
+
+TEST_F(StreamTest, ServiceStreamDeliversAllChunks)
+{
+  std::string service = unique_name("BlobService");
+  static Bytes blob = makeBlob(300 * 1024);
+
+  zlc::registerStreamServiceHandler(
+      service, +[](const std::string &, uint64_t offset, size_t max_len, Bytes &chunk)
+               {
+                 size_t len = std::min<uint64_t>(max_len, blob.size() - offset);
+                 chunk.assign(blob.begin() + offset, blob.begin() + offset + len);
+                 return static_cast<uint64_t>(blob.size());
+               });
+
+  Bytes received;
+  size_t chunk_count = 0;
+  ResponseStatus status = zlc::requestStream(
+      service, std::string("map"),
+      [&](const StreamChunk &chunk)
+      {
+        EXPECT_EQ(chunk.offset, received.size());
+        EXPECT_LE(chunk.data.size, 64u * 1024u);
+        received.insert(received.end(), chunk.data.begin(), chunk.data.end());
+        ++chunk_count;
+      },
+      64 * 1024);
+
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(received, blob);
+  EXPECT_EQ(chunk_count, 5u);
+}
+
+TEST_F(StreamTest, ServiceStreamTimesOutWhenProviderGoesAway)
+{
+  std::string service = unique_name("VanishingBlob");
+  static Bytes blob = makeBlob(300 * 1024);
+
+  auto provider = std::make_unique<Node>(unique_name("StreamProvider"), "127.0.0.1",
+                                         "224.0.0.1", 7720, unique_name("stream_gone"));
+  provider->registerStreamServiceHandler(
+      service, +[](const std::string &, uint64_t offset, size_t max_len, Bytes &chunk)
+               {
+                 size_t len = std::min<uint64_t>(max_len, blob.size() - offset);
+                 chunk.assign(blob.begin() + offset, blob.begin() + offset + len);
+                 return static_cast<uint64_t>(blob.size());
+               });
+  const std::string url =
+      "tcp://127.0.0.1:" + std::to_string(provider->serviceManager().service_port);
+
+  // The provider stops after serving the first chunk
+  size_t chunk_count = 0;
+  auto start = std::chrono::steady_clock::now();
+  ResponseStatus status = Client::zlcRequestStream(
+      ZeroLanComNode::instance().context(), service, url, std::string("map"),
+      [&](const StreamChunk &)
+      {
+        if (++chunk_count == 1)
+        {
+          provider.reset();
+        }
+      },
+      64 * 1024, 300);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(status, ResponseStatus::SERVICE_TIMEOUT);
+  EXPECT_EQ(chunk_count, 1u);
+  EXPECT_LT(elapsed, std::chrono::seconds(3));
+}
+
+TEST_F(StreamTest, ServiceStreamWithoutProviderReturnsNoService)
+{
+  size_t chunk_count = 0;
+  ResponseStatus status = Client::zlcRequestStream(
+      unique_name("missing_stream"), std::string("map"),
+      [&](const StreamChunk &) { ++chunk_count; }, 64 * 1024, 300);
+
+  EXPECT_EQ(status, ResponseStatus::NOSERVICE);
+  EXPECT_EQ(chunk_count, 0u);
+}
+
+// =============================================
+// Chunked Topic Tests
+// =============================================
+
+TEST_F(StreamTest, TopicStreamReassembles)
+{
+  std::string topic = unique_name("BlobTopic");
+  Bytes blob = makeBlob(200 * 1024);
+
+  AsyncResult<Bytes> result;
+  zlc::registerStreamSubscriber(
+      topic, StreamAssembler([&](uint64_t, Bytes &&data) { result.set(data); }));
+
+  StreamOptions options;
+  options.chunk_size = 16 * 1024;
+  options.window = 4;
+  StreamPublisher pub(topic, options);
+
+  // Publish until the subscriber has discovered the topic and connected
+  for (int i = 0; i < 50 && !result.received(); ++i)
+  {
+    ASSERT_TRUE(pub.publish(ByteView{blob.data(), blob.size()}));
+    result.wait_for(std::chrono::milliseconds(100));
+  }
+
+  ASSERT_TRUE(result.received());
+  EXPECT_EQ(result.get(), blob);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "zerolancom/zerolancom.hpp"
+
+#include "test_utils.hpp"
+
+using namespace zlc;
+using namespace zlc_test;
+
+// =============================================
+// Test Fixture
+// =============================================
+
+class UnicastDiscoveryTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!Logger::isInitialized())
+    {
+      Logger::init();
+    }
+    // Multicast off, so these nodes can only find each other by unicast
+    options_.group_name = unique_name("unicast_" + std::to_string(getpid()));
+    options_.unicast.multicast = false;
+  }
+
+  std::string peerOf(const Node &node) const
+  {
+    return "127.0.0.1:" + std::to_string(node.unicastDiscoveryPort());
+  }
+
+  NodeOptions options_;
+};
+
+// =============================================
+// Unicast Discovery Tests
+// =============================================
+
+TEST_F(UnicastDiscoveryTest, StaticPeerAnswersBack)
+{
+  NodeOptions listener = options_;
+  listener.unicast.port = 0;
+  Node a(unique_name("NodeA"), "127.0.0.1", listener);
+  ASSERT_NE(a.unicastDiscoveryPort(), 0);
+
+  // Only B knows A; A learns B from its heartbeats
+  NodeOptions knows_a = options_;
+  knows_a.unicast.peers = {peerOf(a)};
+  Node b(unique_name("NodeB"), "127.0.0.1", knows_a);
+
+  const std::string service = unique_name("UnicastEcho");
+  b.registerServiceHandler(service, echoServiceHandler);
+
+  a.waitForService(service, 5000);
+  std::string response;
+  ResponseStatus status = a.request(service, std::string("hello"), response);
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "hello");
+}
+
+TEST_F(UnicastDiscoveryTest, RendezvousIntroducesNodes)
+{
+  NodeOptions server = options_;
+  server.unicast.rendezvous = true;
+  Node rendezvous(unique_name("Rendezvous"), "127.0.0.1", server);
+  ASSERT_NE(rendezvous.unicastDiscoveryPort(), 0);
+
+  // A and B only know the rendezvous
+  NodeOptions client = options_;
+  client.unicast.peers = {peerOf(rendezvous)};
+  Node a(unique_name("NodeA"), "127.0.0.1", client);
+  Node b(unique_name("NodeB"), "127.0.0.1", client);
+
+  const std::string service = unique_name("RelayedEcho");
+  a.registerServiceHandler(service, echoServiceHandler);
+
+  b.waitForService(service, 5000);
+  std::string response;
+  ResponseStatus status = b.request(service, std::string("hi"), response);
+  EXPECT_EQ(status, ResponseStatus::SUCCESS);
+  EXPECT_EQ(response, "hi");
+}
+
+TEST_F(UnicastDiscoveryTest, IgnoresOtherGroups)
+{
+  NodeOptions server = options_;
+  server.unicast.rendezvous = true;
+  Node rendezvous(unique_name("Rendezvous"), "127.0.0.1", server);
+
+  NodeOptions other = options_;
+  other.group_name += "_other";
+  other.unicast.peers = {peerOf(rendezvous)};
+  Node a(unique_name("NodeA"), "127.0.0.1", other);
+
+  NodeOptions client = options_;
+  client.unicast.peers = {peerOf(rendezvous)};
+  Node b(unique_name("NodeB"), "127.0.0.1", client);
+
+  const std::string service = unique_name("OtherGroupEcho");
+  a.registerServiceHandler(service, echoServiceHandler);
+
+  b.waitForService(service, 2500);
+  EXPECT_EQ(b.nodeInfoManager().getServiceInfo(service), nullptr);
+}
+
+TEST_F(UnicastDiscoveryTest, RelayFromUnknownSenderIsIgnored)
+{
+  NodeOptions listener = options_;
+  listener.unicast.port = 0;
+  Node target(unique_name("Target"), "127.0.0.1", listener);
+  ASSERT_NE(target.unicastDiscoveryPort(), 0);
+
+  // A node the target could reach, but has not been told about
+  NodeOptions hidden = options_;
+  hidden.unicast.port = 0;
+  Node provider(unique_name("Provider"), "127.0.0.1", hidden);
+  const std::string service = unique_name("SpoofedEcho");
+  provider.registerServiceHandler(service, echoServiceHandler);
+
+  // A relay envelope from an address that is not a configured rendezvous
+  const Bytes heartbeat = provider.nodeInfoManager().createHeartbeat().encode();
+  Bytes datagram(8 + heartbeat.size());
+  const uint32_t magic = htonl(UnicastDiscovery::RELAY_MAGIC);
+  const in_addr_t origin = inet_addr("127.0.0.1");
+  std::memcpy(datagram.data(), &magic, sizeof(magic));
+  std::memcpy(datagram.data() + 4, &origin, sizeof(origin));
+  std::memcpy(datagram.data() + 8, heartbeat.data(), heartbeat.size());
+
+  const int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  ASSERT_GE(sock, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(target.unicastDiscoveryPort());
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  for (int i = 0; i < 3; ++i)
+  {
+    sendto(sock, datagram.data(), datagram.size(), 0,
+           reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+  }
+  close(sock);
+
+  target.waitForService(service, 1500);
+  EXPECT_EQ(target.nodeInfoManager().getServiceInfo(service), nullptr);
+}
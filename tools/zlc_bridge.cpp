@@ -0,0 +1,137 @@
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zerolancom/nodes/bridge.hpp"
+#include "zerolancom/zerolancom.hpp"
+
+// Relay topics and services between two networks (subnets or multicast
+// groups) until Ctrl-C. Messages are forwarded as encoded bytes.
+
+namespace
+{
+std::atomic<bool> g_stop{false};
+
+void onSignal(int)
+{
+  g_stop = true;
+}
+
+void usage()
+{
+  std::cerr
+      << "Usage: zlc_bridge [options]\n"
+         "  --a-ip IP / --b-ip IP          local IP on each network (127.0.0.1)\n"
+         "  --a-group ADDR / --b-group ADDR    multicast group (224.0.0.1)\n"
+         "  --a-port N / --b-port N        multicast port (7720)\n"
+         "  --a-group-name NAME / --b-group-name NAME    discovery group\n"
+         "  --ttl N                        multicast TTL of both sides (1)\n"
+         "  --topic-a2b T / --topic-b2a T  relay topic T (repeatable)\n"
+         "  --service-a2b S / --service-b2a S    relay service S (repeatable)\n"
+         "  --compress lz4|zstd            compress relayed data on egress\n"
+         "  --rcvhwm N / --sndhwm N        ZMQ high-water marks per topic\n"
+         "  --timeout-ms N                 relayed request timeout (5000)\n"
+         "  --name NAME                    node name prefix (zlc_bridge)\n";
+}
+
+bool parseSide(const std::string &flag, const char *value, zlc::BridgeSide &side)
+{
+  if (flag == "ip")
+    side.ip = value;
+  else if (flag == "group")
+    side.node.group = value;
+  else if (flag == "port")
+    side.node.group_port = std::atoi(value);
+  else if (flag == "group-name")
+    side.node.group_name = value;
+  else
+    return false;
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+  zlc::BridgeOptions options;
+  std::vector<std::pair<std::string, zlc::BridgeDirection>> topics;
+  std::vector<std::pair<std::string, zlc::BridgeDirection>> services;
+  const auto a2b = zlc::BridgeDirection::A_TO_B;
+  const auto b2a = zlc::BridgeDirection::B_TO_A;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (!has_value)
+    {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg.rfind("--a-", 0) == 0 && parseSide(arg.substr(4), value, options.a))
+      continue;
+    if (arg.rfind("--b-", 0) == 0 && parseSide(arg.substr(4), value, options.b))
+      continue;
+    if (arg == "--ttl")
+      options.a.node.multicast_ttl = options.b.node.multicast_ttl = std::atoi(value);
+    else if (arg == "--topic-a2b")
+      topics.emplace_back(value, a2b);
+    else if (arg == "--topic-b2a")
+      topics.emplace_back(value, b2a);
+    else if (arg == "--service-a2b")
+      services.emplace_back(value, a2b);
+    else if (arg == "--service-b2a")
+      services.emplace_back(value, b2a);
+    else if (arg == "--compress" && std::string(value) == "lz4")
+      options.publisher.compression.codec = zlc::CompressionCodec::LZ4;
+    else if (arg == "--compress" && std::string(value) == "zstd")
+      options.publisher.compression.codec = zlc::CompressionCodec::ZSTD;
+    else if (arg == "--rcvhwm")
+      options.subscriber.rcvhwm = std::atoi(value);
+    else if (arg == "--sndhwm")
+      options.publisher.socket.sndhwm = std::atoi(value);
+    else if (arg == "--timeout-ms")
+      options.service_timeout_ms = std::atoi(value);
+    else if (arg == "--name")
+      options.name = value;
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+  if (topics.empty() && services.empty())
+  {
+    usage();
+    return 1;
+  }
+  options.service_compression = options.publisher.compression;
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  zlc::Logger::init();
+  int relayed = 0;
+  {
+    zlc::Bridge bridge(options);
+    for (const auto &[topic, direction] : topics)
+    {
+      relayed += bridge.relayTopic(topic, direction) ? 1 : 0;
+    }
+    for (const auto &[service, direction] : services)
+    {
+      relayed += bridge.relayService(service, direction) ? 1 : 0;
+    }
+
+    while (!g_stop)
+    {
+      zlc::sleep(100);
+    }
+  }
+  std::cout << "Bridge stopped (" << relayed << " relays)\n";
+  return 0;
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "zerolancom/bag/bag_reader.hpp"
+#include "zerolancom/zerolancom.hpp"
+
+// Republish a bag file written by zlc_record. Payloads go out exactly as they
+// were recorded, so subscribers of the original types receive them unchanged.
+
+namespace
+{
+std::atomic<bool> g_stop{false};
+
+void onSignal(int)
+{
+  g_stop = true;
+}
+
+void usage()
+{
+  std::cerr << "Usage: zlc_play [options] FILE\n"
+               "  --rate R             playback speed: 1 = as recorded, 2 = twice as\n"
+               "                       fast, 0 = as fast as possible (1)\n"
+               "  --topics A,B,...     only play these topics (all)\n"
+               "  --start SEC          skip the first SEC seconds of the recording\n"
+               "  --duration SEC       only play SEC seconds (0 = to the end)\n"
+               "  --loop               start over at the end\n"
+               "  --wait-ms N          wait for subscribers to connect first (1000)\n"
+               "  --ip IP              local IP of the playing node (127.0.0.1)\n"
+               "  --name NAME          node name (zlc_play)\n"
+               "  --group-name NAME    discovery group (zlc_default_group_name)\n";
+}
+
+std::vector<std::string> splitTopics(const std::string &list)
+{
+  std::vector<std::string> topics;
+  std::stringstream stream(list);
+  std::string topic;
+  while (std::getline(stream, topic, ','))
+  {
+    if (!topic.empty())
+    {
+      topics.push_back(topic);
+    }
+  }
+  return topics;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+  std::string input;
+  std::string ip = "127.0.0.1";
+  std::string name = "zlc_play";
+  zlc::NodeOptions node_options;
+  double rate = 1.0;
+  bool loop = false;
+  int wait_ms = 1000;
+  double start_s = 0;
+  double duration_s = 0;
+  zlc::BagQuery query;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--rate" && has_value)
+      rate = std::atof(argv[++i]);
+    else if (arg == "--topics" && has_value)
+      query.topics = splitTopics(argv[++i]);
+    else if (arg == "--start" && has_value)
+      start_s = std::atof(argv[++i]);
+    else if (arg == "--duration" && has_value)
+      duration_s = std::atof(argv[++i]);
+    else if (arg == "--loop")
+      loop = true;
+    else if (arg == "--wait-ms" && has_value)
+      wait_ms = std::atoi(argv[++i]);
+    else if (arg == "--ip" && has_value)
+      ip = argv[++i];
+    else if (arg == "--name" && has_value)
+      name = argv[++i];
+    else if (arg == "--group-name" && has_value)
+      node_options.group_name = argv[++i];
+    else if (!arg.empty() && arg[0] != '-' && input.empty())
+      input = arg;
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+  if (input.empty() || rate < 0 || start_s < 0 || duration_s < 0)
+  {
+    usage();
+    return 1;
+  }
+
+  auto reader = zlc::BagReader::open(input);
+  if (!reader)
+  {
+    return 1;
+  }
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  zlc::init(name, ip, node_options);
+
+  // The window is relative to the start of the recording
+  query.start_ns = reader->startNs() + static_cast<uint64_t>(start_s * 1e9);
+  if (duration_s > 0)
+  {
+    query.end_ns = query.start_ns + static_cast<uint64_t>(duration_s * 1e9);
+  }
+
+  // One publisher per played topic, by topic ID
+  std::unordered_map<uint16_t, std::unique_ptr<zlc::Publisher<zlc::Bytes>>> publishers;
+  const auto &topics = reader->topics();
+  for (size_t id = 0; id < topics.size(); ++id)
+  {
+    const std::string &topic = topics[id].name;
+    const auto &only = query.topics;
+    const bool selected =
+        only.empty() || std::find(only.begin(), only.end(), topic) != only.end();
+    if (topics[id].message_count == 0 || !selected)
+    {
+      continue;
+    }
+    publishers.emplace(static_cast<uint16_t>(id),
+                       std::make_unique<zlc::Publisher<zlc::Bytes>>(topic));
+  }
+  zlc::info("[zlc_play] Playing {} topic(s) from {} ({} messages recorded)",
+            publishers.size(), input, reader->messageCount());
+
+  // Give discovery time to connect subscribers, or the first messages are lost
+  zlc::sleep(wait_ms);
+
+  uint64_t played = 0;
+  do
+  {
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t first_ns = query.start_ns;
+    reader->forEach(
+        query,
+        [&](const zlc::BagMessage &message)
+        {
+          if (g_stop)
+          {
+            return false;
+          }
+          auto it = publishers.find(message.topic_id);
+          if (it == publishers.end())
+          {
+            return true;
+          }
+          if (rate > 0 && message.timestamp_ns > first_ns)
+          {
+            const auto offset = std::chrono::nanoseconds(static_cast<int64_t>(
+                static_cast<double>(message.timestamp_ns - first_ns) / rate));
+            std::this_thread::sleep_until(start + offset);
+          }
+          it->second->publishRaw(message.data);
+          ++played;
+          return true;
+        });
+  } while (loop && !g_stop);
+
+  publishers.clear();
+  zlc::shutdown();
+  std::cout << "Played " << played << " messages\n";
+  return 0;
+}
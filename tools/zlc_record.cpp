@@ -0,0 +1,142 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "zerolancom/bag/bag_writer.hpp"
+#include "zerolancom/zerolancom.hpp"
+
+// Record topics into a bag file (see bag_format.hpp) until Ctrl-C or
+// --duration. Payloads are stored as received, without decoding.
+
+namespace
+{
+std::atomic<bool> g_stop{false};
+
+void onSignal(int)
+{
+  g_stop = true;
+}
+
+void usage()
+{
+  std::cerr << "Usage: zlc_record -o FILE [options] TOPIC...\n"
+               "  -o, --output FILE    bag file to write\n"
+               "  --ip IP              local IP of the recording node (127.0.0.1)\n"
+               "  --name NAME          node name (zlc_record)\n"
+               "  --group-name NAME    discovery group (zlc_default_group_name)\n"
+               "  --duration SEC       stop after SEC seconds (0 = until Ctrl-C)\n"
+               "  --chunk-mb N         pre-allocated chunk size (64)\n"
+               "  --queue-mb N         memory for queued messages (1024)\n"
+               "  --rcvhwm N           ZMQ receive high-water mark per topic\n"
+               "  --writer-cpu N       pin the writer thread to CPU N\n";
+}
+
+uint64_t wallClockNs()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count());
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+  std::string output;
+  std::string ip = "127.0.0.1";
+  std::string name = "zlc_record";
+  zlc::NodeOptions node_options;
+  zlc::BagWriterOptions writer_options;
+  zlc::SocketOptions socket_options;
+  int duration_s = 0;
+  std::vector<std::string> topics;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if ((arg == "-o" || arg == "--output") && has_value)
+      output = argv[++i];
+    else if (arg == "--ip" && has_value)
+      ip = argv[++i];
+    else if (arg == "--name" && has_value)
+      name = argv[++i];
+    else if (arg == "--group-name" && has_value)
+      node_options.group_name = argv[++i];
+    else if (arg == "--duration" && has_value)
+      duration_s = std::atoi(argv[++i]);
+    else if (arg == "--chunk-mb" && has_value)
+      writer_options.chunk_size = std::strtoull(argv[++i], nullptr, 10) << 20;
+    else if (arg == "--queue-mb" && has_value)
+      writer_options.queue_bytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+    else if (arg == "--rcvhwm" && has_value)
+      socket_options.rcvhwm = std::atoi(argv[++i]);
+    else if (arg == "--writer-cpu" && has_value)
+      writer_options.thread.cpus = {std::atoi(argv[++i])};
+    else if (!arg.empty() && arg[0] != '-')
+      topics.push_back(arg);
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+  if (output.empty() || topics.empty())
+  {
+    usage();
+    return 1;
+  }
+
+  auto writer = zlc::BagWriter::create(output, writer_options);
+  if (!writer)
+  {
+    return 1;
+  }
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  zlc::init(name, ip, node_options);
+  for (const std::string &topic : topics)
+  {
+    const uint16_t id = writer->addTopic(topic);
+    zlc::setSubscriberSocketOptions(topic, socket_options);
+    // The received frame is queued as is, without a copy
+    zlc::registerRawSubscriber(
+        topic, [&writer, id](zmq::message_t &payload)
+        { writer->write(id, wallClockNs(), std::move(payload)); });
+  }
+  zlc::info("[zlc_record] Recording {} topic(s) to {}", topics.size(), output);
+
+  const auto start = std::chrono::steady_clock::now();
+  zlc::BagWriterStats last = writer->stats();
+  while (!g_stop)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const zlc::BagWriterStats now = writer->stats();
+    zlc::info("[zlc_record] {} msg/s, {:.1f} MB/s, {} dropped",
+              now.messages - last.messages,
+              static_cast<double>(now.bytes - last.bytes) / 1e6, now.dropped);
+    last = now;
+
+    if (duration_s > 0 &&
+        std::chrono::steady_clock::now() - start >= std::chrono::seconds(duration_s))
+    {
+      break;
+    }
+  }
+
+  // Stop receiving before the writer goes away
+  zlc::shutdown();
+  writer->close();
+  const zlc::BagWriterStats stats = writer->stats();
+  std::cout << "Recorded " << stats.messages << " messages (" << stats.bytes
+            << " bytes) in " << stats.chunks << " chunks, " << stats.dropped
+            << " dropped\n";
+  return stats.dropped == 0 ? 0 : 2;
+}